@@ -0,0 +1,931 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    cbor_data.c
+ * \brief   Implements CBOR _data layer_ encoders and decoders [see cbor_data.h]
+ *
+ *    The documents mirror the JSON ones, but the names of the members are
+ *    small integers [see `cbor_key_t`], the timestamps are the seconds since
+ *    the epoch (tag 1) and the values keep their type, an integer takes one to
+ *    five bytes and a float five, where CSV spends twenty eight characters on
+ *    the timestamp and formats the float with `%f`. A datapoint of a feed:
+ *
+ *    {1: 216, 2: 1(1357065861), 3: 423452}
+ *
+ *    and a datastream carries either its current value or a list of them:
+ *
+ *    {0: "temp", 1: 21.5, 2: 1(1357065861)}
+ *    {0: "temp", 4: [{1: 21.5, 2: 1(1357065861)}]}
+ *
+ *    Only the definite lengths are written and read, the keys the decoders
+ *    don't know are skipped.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#include "cbor_data.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_config.h"
+
+static XI_THREAD_LOCAL char XI_CBOR_LOCAL_BUFFER[ XI_CBOR_BUFFER_SIZE ];
+
+/**
+ * \brief   The major types of the items, kept in the top three bits of
+ *          their first byte
+ */
+enum {
+      CBOR_MAJOR_UINT = 0
+    , CBOR_MAJOR_NINT
+    , CBOR_MAJOR_BYTES
+    , CBOR_MAJOR_TEXT
+    , CBOR_MAJOR_ARRAY
+    , CBOR_MAJOR_MAP
+    , CBOR_MAJOR_TAG
+    , CBOR_MAJOR_SIMPLE
+};
+
+#define CBOR_INFO_HALF          25
+#define CBOR_INFO_FLOAT         26
+#define CBOR_INFO_DOUBLE        27
+#define CBOR_TAG_EPOCH          1
+
+//! how deep the decoders go when they skip what they don't know
+#define CBOR_MAX_NESTING        8
+
+//-----------------------------------------------------------------------
+// ENCODERS
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Writes the first byte of the item and its argument, in as few
+ *          bytes as it takes
+ *
+ * \return  Number of bytes written or `-1` if they don't fit.
+ */
+static int cbor_put_head(
+      char* buffer
+    , size_t buffer_size
+    , int major
+    , uint64_t value )
+{
+    unsigned char* dst  = ( unsigned char* ) buffer;
+    size_t width        = 0;
+    unsigned char info  = 0;
+
+    if( value < 24 )                { info = ( unsigned char ) value; }
+    else if( value <= 0xff )        { info = 24; width = 1; }
+    else if( value <= 0xffff )      { info = 25; width = 2; }
+    else if( value <= 0xffffffff )  { info = 26; width = 4; }
+    else                            { info = 27; width = 8; }
+
+    if( buffer_size < 1 + width ) { return -1; }
+
+    dst[ 0 ] = ( unsigned char ) ( major << 5 ) | info;
+
+    // the argument is big endian
+    for( size_t i = 0; i < width; ++i )
+    {
+        dst[ width - i ] = ( unsigned char ) ( value >> ( 8 * i ) );
+    }
+
+    return 1 + width;
+}
+
+/**
+ * \brief   Writes the text string
+ *
+ * \return  Number of bytes written or `-1` if they don't fit.
+ */
+static int cbor_put_text(
+      char* buffer
+    , size_t buffer_size
+    , const char* text )
+{
+    const size_t length = strlen( text );
+    int s = cbor_put_head( buffer, buffer_size, CBOR_MAJOR_TEXT, length );
+
+    if( s == -1 || buffer_size - s < length ) { return -1; }
+
+    memcpy( buffer + s, text, length );
+
+    return s + length;
+}
+
+/**
+ * \brief   Writes the value in its own type, the float as a single precision one
+ *
+ * \return  Number of bytes written or `-1` if they don't fit.
+ */
+static int cbor_put_value(
+      char* buffer
+    , size_t buffer_size
+    , const xi_datapoint_t* p )
+{
+    switch( p->value_type )
+    {
+        case XI_VALUE_TYPE_I32:
+        {
+            const int32_t v = p->value.i32_value;
+
+            return v < 0
+                ? cbor_put_head( buffer, buffer_size
+                    , CBOR_MAJOR_NINT, ( uint64_t ) ( -1 - ( int64_t ) v ) )
+                : cbor_put_head( buffer, buffer_size
+                    , CBOR_MAJOR_UINT, ( uint64_t ) v );
+        }
+        case XI_VALUE_TYPE_F32:
+        {
+            uint32_t bits = 0;
+
+            memcpy( &bits, &p->value.f32_value, sizeof( bits ) );
+
+            if( buffer_size < 5 ) { return -1; }
+
+            buffer[ 0 ] = ( char ) ( ( CBOR_MAJOR_SIMPLE << 5 ) | CBOR_INFO_FLOAT );
+            buffer[ 1 ] = ( char ) ( bits >> 24 );
+            buffer[ 2 ] = ( char ) ( bits >> 16 );
+            buffer[ 3 ] = ( char ) ( bits >> 8 );
+            buffer[ 4 ] = ( char ) bits;
+
+            return 5;
+        }
+        case XI_VALUE_TYPE_STR:
+            return cbor_put_text( buffer, buffer_size, p->value.str_value );
+        default:
+            return -1;
+    }
+}
+
+/**
+ * \brief   Tells how many members the datapoint takes, the timestamp is left
+ *          to the server if it's zero
+ */
+static size_t cbor_datapoint_member_count( const xi_datapoint_t* p )
+{
+    if( p->timestamp.timestamp == 0 ) { return 1; }
+
+    return p->timestamp.micro != 0 ? 3 : 2;
+}
+
+/**
+ * \brief   Writes the value and the timestamp as members of a map, the head
+ *          of which has been written
+ *
+ * \return  Number of bytes written or `-1` if they don't fit.
+ */
+static int cbor_put_datapoint_members(
+      char* buffer
+    , size_t buffer_size
+    , const xi_datapoint_t* p )
+{
+    int s       = 0;
+    int size    = buffer_size;
+    int offset  = 0;
+
+    s = cbor_put_head( buffer, size, CBOR_MAJOR_UINT, CBOR_KEY_VALUE );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_value( buffer + offset, size - offset, p );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    if( p->timestamp.timestamp != 0 )
+    {
+        s = cbor_put_head( buffer + offset, size - offset
+            , CBOR_MAJOR_UINT, CBOR_KEY_AT );
+        XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+        s = cbor_put_head( buffer + offset, size - offset
+            , CBOR_MAJOR_TAG, CBOR_TAG_EPOCH );
+        XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+        s = cbor_put_head( buffer + offset, size - offset
+            , CBOR_MAJOR_UINT, ( uint64_t ) p->timestamp.timestamp );
+        XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+        if( p->timestamp.micro != 0 )
+        {
+            s = cbor_put_head( buffer + offset, size - offset
+                , CBOR_MAJOR_UINT, CBOR_KEY_MICRO );
+            XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+            s = cbor_put_head( buffer + offset, size - offset
+                , CBOR_MAJOR_UINT, ( uint64_t ) p->timestamp.micro );
+            XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+        }
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+/**
+ * \brief   Writes the datastream as an element of the datastreams, a single
+ *          datapoint becomes its current value
+ *
+ * \return  Number of bytes written or `-1` if they don't fit.
+ */
+static int cbor_encode_datastream(
+      char* buffer
+    , size_t buffer_size
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoints
+    , size_t datapoint_count )
+{
+    int s       = 0;
+    int size    = buffer_size;
+    int offset  = 0;
+
+    const size_t members = datapoint_count == 1
+        ? 1 + cbor_datapoint_member_count( datapoints ) : 2;
+
+    s = cbor_put_head( buffer, size, CBOR_MAJOR_MAP, members );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_head( buffer + offset, size - offset, CBOR_MAJOR_UINT, CBOR_KEY_ID );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_text( buffer + offset, size - offset, datastream_id );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    if( datapoint_count == 1 )
+    {
+        s = cbor_put_datapoint_members( buffer + offset, size - offset, datapoints );
+        XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+    }
+    else
+    {
+        s = cbor_put_head( buffer + offset, size - offset
+            , CBOR_MAJOR_UINT, CBOR_KEY_DATAPOINTS );
+        XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+        s = cbor_put_head( buffer + offset, size - offset
+            , CBOR_MAJOR_ARRAY, datapoint_count );
+        XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+        for( size_t i = 0; i < datapoint_count; ++i )
+        {
+            s = cbor_encode_datapoint_in_place( buffer + offset, size - offset
+                , &datapoints[ i ] );
+            XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+        }
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+const char* cbor_encode_datapoint( const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( datapoint != 0 );
+
+    int s = cbor_encode_datapoint_in_place( XI_CBOR_LOCAL_BUFFER
+        , sizeof( XI_CBOR_LOCAL_BUFFER ), datapoint );
+
+    return s == -1 ? 0 : XI_CBOR_LOCAL_BUFFER;
+}
+
+int cbor_encode_datapoint_in_place(
+      char* in, size_t in_size
+    , const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( in != 0 );
+    assert( datapoint != 0 );
+
+    int s       = 0;
+    int size    = in_size;
+    int offset  = 0;
+
+    s = cbor_put_head( in, size, CBOR_MAJOR_MAP
+        , cbor_datapoint_member_count( datapoint ) );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_datapoint_members( in + offset, size - offset, datapoint );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+const char* cbor_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* data )
+{
+    // PRECONDITIONS
+    assert( datastream_id != 0 );
+    assert( data != 0 );
+
+    char* buffer = XI_CBOR_LOCAL_BUFFER;
+    int s       = 0;
+    int size    = sizeof( XI_CBOR_LOCAL_BUFFER );
+    int offset  = 0;
+
+    s = cbor_put_head( buffer, size, CBOR_MAJOR_MAP, 1 );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_head( buffer + offset, size - offset
+        , CBOR_MAJOR_UINT, CBOR_KEY_DATASTREAMS );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_head( buffer + offset, size - offset, CBOR_MAJOR_ARRAY, 1 );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_encode_datastream( buffer + offset, size - offset
+        , datastream_id, data, 1 );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    return XI_CBOR_LOCAL_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+int cbor_encode_feed_in_place(
+      char* in, size_t in_size
+    , const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( in != 0 );
+    assert( feed != 0 );
+
+    int s       = 0;
+    int size    = in_size;
+    int offset  = 0;
+
+    s = cbor_put_head( in, size, CBOR_MAJOR_MAP, 1 );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_head( in + offset, size - offset
+        , CBOR_MAJOR_UINT, CBOR_KEY_DATASTREAMS );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    s = cbor_put_head( in + offset, size - offset
+        , CBOR_MAJOR_ARRAY, feed->datastream_count );
+    XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* d = &feed->datastreams[ i ];
+
+        s = cbor_encode_datastream( in + offset, size - offset
+            , d->datastream_id, d->datapoints, d->datapoint_count );
+        XI_CHECK_S( s, size, offset, XI_CBOR_ENCODE_BUFFER_OVERRUN );
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+//-----------------------------------------------------------------------
+// DECODERS
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Where the decoder is in the data
+ */
+typedef struct {
+    const unsigned char* current;
+    const unsigned char* end;
+} cbor_reader_t;
+
+/**
+ * \brief   Reads the first byte of the item and its argument, for the
+ *          floats the argument holds their bits
+ *
+ * \return  `0` on success or `-1` if the data ends or the length is
+ *          indefinite.
+ */
+static int cbor_read_head(
+      cbor_reader_t* reader
+    , int* major
+    , int* info
+    , uint64_t* value )
+{
+    if( reader->current >= reader->end ) { return -1; }
+
+    const unsigned char first = *reader->current++;
+    size_t width = 0;
+
+    *major  = first >> 5;
+    *info   = first & 0x1f;
+    *value  = 0;
+
+    switch( *info )
+    {
+        case 24: width = 1; break;
+        case 25: width = 2; break;
+        case 26: width = 4; break;
+        case 27: width = 8; break;
+        default:
+            if( *info > 27 ) { return -1; }
+            *value = *info;
+            return 0;
+    }
+
+    if( ( size_t ) ( reader->end - reader->current ) < width ) { return -1; }
+
+    for( size_t i = 0; i < width; ++i )
+    {
+        *value = ( *value << 8 ) | *reader->current++;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief   Skips the item along with whatever is nested in it
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int cbor_skip( cbor_reader_t* reader, int depth )
+{
+    int major, info;
+    uint64_t value;
+
+    if( depth == CBOR_MAX_NESTING ) { return -1; }
+    if( cbor_read_head( reader, &major, &info, &value ) == -1 ) { return -1; }
+
+    switch( major )
+    {
+        case CBOR_MAJOR_BYTES:
+        case CBOR_MAJOR_TEXT:
+            if( ( uint64_t ) ( reader->end - reader->current ) < value ) { return -1; }
+            reader->current += value;
+            return 0;
+        case CBOR_MAJOR_MAP:
+            // it takes as many bytes as it has items at least
+            if( ( uint64_t ) ( reader->end - reader->current ) < value ) { return -1; }
+            value *= 2;
+            // fall through
+        case CBOR_MAJOR_ARRAY:
+            for( uint64_t i = 0; i < value; ++i )
+            {
+                if( cbor_skip( reader, depth + 1 ) == -1 ) { return -1; }
+            }
+            return 0;
+        case CBOR_MAJOR_TAG:
+            return cbor_skip( reader, depth + 1 );
+        default:
+            return 0;
+    }
+}
+
+size_t cbor_encoded_size( const char* data )
+{
+    // PRECONDITIONS
+    assert( data != 0 );
+
+    // it's only given what the encoders have written into their buffer
+    cbor_reader_t reader = {
+          ( const unsigned char* ) data
+        , ( const unsigned char* ) data + XI_CBOR_BUFFER_SIZE };
+
+    if( cbor_skip( &reader, 0 ) == -1 ) { return 0; }
+
+    return ( const char* ) reader.current - data;
+}
+
+/**
+ * \brief   Reads the head of the container of the given type
+ *
+ * \return  Number of its items or `-1` in case of an error.
+ */
+static long cbor_read_container( cbor_reader_t* reader, int type )
+{
+    int major, info;
+    uint64_t value;
+
+    if( cbor_read_head( reader, &major, &info, &value ) == -1
+        || major != type || value > ( uint64_t ) ( reader->end - reader->current ) )
+    {
+        return -1;
+    }
+
+    return ( long ) value;
+}
+
+/**
+ * \brief   Reads the key of the next member, the ones which aren't small
+ *          integers are skipped and their values have to be
+ *
+ * \return  The key, `-2` if it's not one of ours or `-1` in case of an error.
+ */
+static long cbor_read_key( cbor_reader_t* reader )
+{
+    cbor_reader_t peek = *reader;
+    int major, info;
+    uint64_t value;
+
+    if( cbor_read_head( &peek, &major, &info, &value ) == -1 ) { return -1; }
+
+    if( major == CBOR_MAJOR_UINT && value <= CBOR_KEY_DATASTREAMS )
+    {
+        *reader = peek;
+        return ( long ) value;
+    }
+
+    return cbor_skip( reader, 0 ) == -1 ? -1 : -2;
+}
+
+/**
+ * \brief   Widens the half precision float, the servers may shorten the
+ *          values which fit
+ */
+static float cbor_half_to_float( uint16_t half )
+{
+    const uint32_t sign     = ( uint32_t ) ( half >> 15 ) << 31;
+    const uint32_t exponent = ( half >> 10 ) & 0x1f;
+    const uint32_t mantissa = half & 0x3ff;
+    uint32_t bits           = 0;
+    float f                 = 0;
+
+    if( exponent == 0 )
+    {
+        // subnormal, it's the mantissa times 2^-24
+        f = ( float ) mantissa / 16777216.0f;
+        return sign ? -f : f;
+    }
+
+    bits = exponent == 0x1f
+        ? sign | 0x7f800000 | ( mantissa << 13 )
+        : sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+
+    memcpy( &f, &bits, sizeof( f ) );
+
+    return f;
+}
+
+/**
+ * \brief   Decodes the value, its type tells the type of the datapoint
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int cbor_decode_value( cbor_reader_t* reader, xi_datapoint_t* p )
+{
+    int major, info;
+    uint64_t value;
+
+    if( cbor_read_head( reader, &major, &info, &value ) == -1 ) { return -1; }
+
+    switch( major )
+    {
+        case CBOR_MAJOR_UINT:
+            if( value > INT32_MAX ) { return -1; }
+            xi_set_value_i32( p, ( int32_t ) value );
+            return 0;
+        case CBOR_MAJOR_NINT:
+            if( value > INT32_MAX ) { return -1; }
+            xi_set_value_i32( p, ( int32_t ) ( -1 - ( int64_t ) value ) );
+            return 0;
+        case CBOR_MAJOR_TEXT:
+            if( value >= XI_VALUE_STRING_MAX_SIZE
+                || ( uint64_t ) ( reader->end - reader->current ) < value )
+            {
+                return -1;
+            }
+
+            memcpy( p->value.str_value, reader->current, value );
+            p->value.str_value[ value ] = '\0';
+            p->value_type = XI_VALUE_TYPE_STR;
+            reader->current += value;
+            return 0;
+        case CBOR_MAJOR_SIMPLE:
+        {
+            float f     = 0;
+            uint32_t b  = ( uint32_t ) value;
+            double d    = 0;
+
+            switch( info )
+            {
+                case CBOR_INFO_HALF:
+                    f = cbor_half_to_float( ( uint16_t ) value );
+                    break;
+                case CBOR_INFO_FLOAT:
+                    memcpy( &f, &b, sizeof( f ) );
+                    break;
+                case CBOR_INFO_DOUBLE:
+                    memcpy( &d, &value, sizeof( d ) );
+                    f = ( float ) d;
+                    break;
+                default:
+                    return -1;
+            }
+
+            xi_set_value_f32( p, f );
+            return 0;
+        }
+        default:
+            return -1;
+    }
+}
+
+/**
+ * \brief   Decodes the seconds since the epoch, the tag is optional
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int cbor_decode_timestamp( cbor_reader_t* reader, xi_timestamp_t* timestamp )
+{
+    int major, info;
+    uint64_t value;
+
+    if( cbor_read_head( reader, &major, &info, &value ) == -1 ) { return -1; }
+
+    if( major == CBOR_MAJOR_TAG )
+    {
+        if( value != CBOR_TAG_EPOCH
+            || cbor_read_head( reader, &major, &info, &value ) == -1 )
+        {
+            return -1;
+        }
+    }
+
+    if( major != CBOR_MAJOR_UINT || value > ( uint64_t ) LONG_MAX ) { return -1; }
+
+    timestamp->timestamp = ( xi_time_t ) value;
+
+    return 0;
+}
+
+/**
+ * \brief   Decodes the fraction of the second
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int cbor_decode_micro( cbor_reader_t* reader, xi_timestamp_t* timestamp )
+{
+    int major, info;
+    uint64_t value;
+
+    if( cbor_read_head( reader, &major, &info, &value ) == -1
+        || major != CBOR_MAJOR_UINT || value >= 1000000 )
+    {
+        return -1;
+    }
+
+    timestamp->micro = ( xi_time_t ) value;
+
+    return 0;
+}
+
+/**
+ * \brief   Decodes a member of the datapoint, it's shared by the datastream
+ *          which carries its current value
+ *
+ * \return  `1` if the key is one of the datapoint's, `0` if it isn't and
+ *          nothing has been read or `-1` in case of an error.
+ */
+static int cbor_decode_datapoint_member(
+      cbor_reader_t* reader
+    , long key
+    , xi_datapoint_t* p )
+{
+    switch( key )
+    {
+        case CBOR_KEY_VALUE:
+            return cbor_decode_value( reader, p ) == -1 ? -1 : 1;
+        case CBOR_KEY_AT:
+            return cbor_decode_timestamp( reader, &p->timestamp ) == -1 ? -1 : 1;
+        case CBOR_KEY_MICRO:
+            return cbor_decode_micro( reader, &p->timestamp ) == -1 ? -1 : 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * \brief   Decodes an element of the datapoints
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int cbor_decode_datapoint_map( cbor_reader_t* reader, xi_datapoint_t* p )
+{
+    long members = cbor_read_container( reader, CBOR_MAJOR_MAP );
+
+    if( members == -1 ) { return -1; }
+
+    memset( p, 0, sizeof( xi_datapoint_t ) );
+
+    for( long i = 0; i < members; ++i )
+    {
+        long key = cbor_read_key( reader );
+        int r = key == -1 ? -1 : cbor_decode_datapoint_member( reader, key, p );
+
+        if( r == -1 ) { return -1; }
+        if( r == 0 && cbor_skip( reader, 0 ) == -1 ) { return -1; }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief   Decodes the datastream
+ *
+ *    The datapoints, if there are any, take precedence over the current value.
+ *    If `total` is given, it's the history that's asked for: the datapoints
+ *    that don't fit are counted instead of failing the decoder and the current
+ *    value doesn't stand in for them.
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int cbor_decode_datastream_map(
+      cbor_reader_t* reader
+    , xi_datastream_t* d
+    , long* total )
+{
+    xi_datapoint_t current;
+    int has_current = 0;
+    long members    = cbor_read_container( reader, CBOR_MAJOR_MAP );
+
+    if( members == -1 ) { return -1; }
+
+    memset( &current, 0, sizeof( xi_datapoint_t ) );
+
+    d->datastream_id[ 0 ]   = '\0';
+    d->datapoint_count      = 0;
+
+    for( long i = 0; i < members; ++i )
+    {
+        long key = cbor_read_key( reader );
+
+        if( key == -1 ) { return -1; }
+
+        if( key == CBOR_KEY_ID )
+        {
+            int major, info;
+            uint64_t value;
+
+            if( cbor_read_head( reader, &major, &info, &value ) == -1
+                || major != CBOR_MAJOR_TEXT
+                || value >= sizeof( d->datastream_id )
+                || ( uint64_t ) ( reader->end - reader->current ) < value )
+            {
+                return -1;
+            }
+
+            memcpy( d->datastream_id, reader->current, value );
+            d->datastream_id[ value ] = '\0';
+            reader->current += value;
+        }
+        else if( key == CBOR_KEY_DATAPOINTS )
+        {
+            long count = cbor_read_container( reader, CBOR_MAJOR_ARRAY );
+
+            if( count == -1 || ( count > XI_MAX_DATAPOINTS && total == 0 ) ) { return -1; }
+
+            for( long j = 0; j < count; ++j )
+            {
+                int r = j < XI_MAX_DATAPOINTS
+                    ? cbor_decode_datapoint_map( reader, &d->datapoints[ j ] )
+                    : cbor_skip( reader, 0 );
+
+                if( r == -1 ) { return -1; }
+            }
+
+            d->datapoint_count = XI_MIN( count, XI_MAX_DATAPOINTS );
+
+            if( total ) { *total = count; }
+        }
+        else
+        {
+            int r = cbor_decode_datapoint_member( reader, key, &current );
+
+            if( r == -1 ) { return -1; }
+            if( r == 0 && cbor_skip( reader, 0 ) == -1 ) { return -1; }
+
+            has_current |= key == CBOR_KEY_VALUE;
+        }
+    }
+
+    if( d->datapoint_count == 0 && has_current && total == 0 )
+    {
+        d->datapoints[ 0 ]  = current;
+        d->datapoint_count  = 1;
+    }
+
+    return 0;
+}
+
+xi_feed_t* cbor_decode_feed(
+      const char* buffer
+    , size_t buffer_size
+    , xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( feed != 0 );
+
+    cbor_reader_t reader = {
+          ( const unsigned char* ) buffer
+        , ( const unsigned char* ) buffer + buffer_size };
+
+    size_t counter = 0;
+    long members = cbor_read_container( &reader, CBOR_MAJOR_MAP );
+
+    XI_CHECK_CND( members == -1, XI_CBOR_DECODE_FEED_PARSER_ERROR );
+
+    for( long i = 0; i < members; ++i )
+    {
+        long key = cbor_read_key( &reader );
+
+        XI_CHECK_CND( key == -1, XI_CBOR_DECODE_FEED_PARSER_ERROR );
+
+        if( key == CBOR_KEY_DATASTREAMS )
+        {
+            long count = cbor_read_container( &reader, CBOR_MAJOR_ARRAY );
+
+            // the key may be repeated, the arrays share the datastreams
+            XI_CHECK_CND( count == -1
+                || ( size_t ) count > XI_MAX_DATASTREAMS - counter
+                , XI_CBOR_DECODE_FEED_PARSER_ERROR );
+
+            for( long j = 0; j < count; ++j )
+            {
+                XI_CHECK_CND( cbor_decode_datastream_map(
+                      &reader, &feed->datastreams[ counter ], 0 ) == -1
+                    , XI_CBOR_DECODE_FEED_PARSER_ERROR );
+
+                counter += 1;
+            }
+        }
+        else
+        {
+            XI_CHECK_CND( cbor_skip( &reader, 0 ) == -1
+                , XI_CBOR_DECODE_FEED_PARSER_ERROR );
+        }
+    }
+
+    feed->datastream_count = counter;
+    return feed;
+
+err_handling:
+    return 0;
+}
+
+xi_datapoint_t* cbor_decode_datapoint(
+      const char* buffer
+    , size_t buffer_size
+    , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datapoint != 0 );
+
+    cbor_reader_t reader = {
+          ( const unsigned char* ) buffer
+        , ( const unsigned char* ) buffer + buffer_size };
+
+    xi_datastream_t datastream;
+
+    XI_CHECK_CND( cbor_decode_datastream_map( &reader, &datastream, 0 ) == -1
+        , XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR );
+
+    XI_CHECK_CND( datastream.datapoint_count == 0
+        , XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR );
+
+    // the datapoints come oldest first
+    *datapoint = datastream.datapoints[ datastream.datapoint_count - 1 ];
+
+    return datapoint;
+
+err_handling:
+    return 0;
+}
+
+long cbor_decode_datastream_history(
+      const char* buffer
+    , size_t buffer_size
+    , xi_datastream_t* datastream )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datastream != 0 );
+
+    cbor_reader_t reader = {
+          ( const unsigned char* ) buffer
+        , ( const unsigned char* ) buffer + buffer_size };
+
+    long total = 0;
+
+    XI_CHECK_CND( cbor_decode_datastream_map( &reader, datastream, &total ) == -1
+        , XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR );
+
+    return total;
+
+err_handling:
+    return -1;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    cbor_data.h
+ * \brief   Implements CBOR _data layer_ encoders and decoders, a binary format for metered links
+ */
+
+#ifndef __CBOR_DATA_H__
+#define __CBOR_DATA_H__
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   The keys of the maps, integers take a single byte where the names
+ *          of the JSON members take up to fifteen
+ */
+typedef enum {
+      CBOR_KEY_ID = 0           //!< text, the id of the datastream
+    , CBOR_KEY_VALUE            //!< integer, float or text, as it's been set
+    , CBOR_KEY_AT               //!< seconds since the epoch, tagged as such
+    , CBOR_KEY_MICRO            //!< the fraction of the second, left out if it's zero
+    , CBOR_KEY_DATAPOINTS       //!< array of the maps of the datapoints
+    , CBOR_KEY_DATASTREAMS      //!< array of the maps of the datastreams
+} cbor_key_t;
+
+const char* cbor_encode_datapoint( const xi_datapoint_t* dp );
+
+int cbor_encode_datapoint_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_datapoint_t* datapoint );
+
+const char* cbor_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* dp );
+
+int cbor_encode_feed_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_feed_t* feed );
+
+/**
+ * \brief   Measures the item the encoders have returned, it may contain zeros
+ */
+size_t cbor_encoded_size( const char* data );
+
+xi_feed_t* cbor_decode_feed(
+      const char* buffer
+    , size_t buffer_size
+    , xi_feed_t* feed );
+
+xi_datapoint_t* cbor_decode_datapoint(
+      const char* data
+    , size_t data_size
+    , xi_datapoint_t* dp );
+
+long cbor_decode_datastream_history(
+      const char* data
+    , size_t data_size
+    , xi_datastream_t* datastream );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CBOR_DATA_H__
@@ -17,11 +17,42 @@
 #include <stdint.h>
 
 #include "connection.h"
+#include "xi_iovec.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * \brief   Operations that can be submitted to an asynchronous _communication layer_
+ */
+typedef enum
+{
+    XI_COMM_OP_NONE = 0,
+    XI_COMM_OP_CONNECT,
+    XI_COMM_OP_SEND,
+    XI_COMM_OP_RECV
+} xi_comm_op_t;
+
+/**
+ * \brief   What probing a keep-alive connection has found
+ */
+typedef enum
+{
+    XI_CONNECTION_STALE = 0,    //!< closed by the peer, broken or idle for too long
+    XI_CONNECTION_ALIVE,        //!< usable, nothing has arrived since the last read
+    XI_CONNECTION_PENDING       //!< usable, but the peer has sent data that hasn't been read yet
+} xi_connection_state_t;
+
+/**
+ * \brief   Reports an asynchronous operation that has finished
+ */
+typedef struct {
+    void*   user_data;  //!< as given when the operation was submitted
+    int     result;     //!< bytes sent or read (`0` for connect or when the peer has closed the connection) or `-1` in case of an error
+    int     error;      //!< the `xi_err_t` describing the error, if any
+} xi_comm_completion_t;
+
 /**
  * \brief   _The communication layer interface_ - contains function pointers,
  *          that's what we expose to the layers above and below
@@ -38,6 +69,9 @@ typedef struct {
     /**
      * \brief   Connect to a given host using it's address and port
      * \note    It should not reset an existing connection.
+     * \note    Implementations that pool connections may check out an idle
+     *          connection to the same endpoint instead of opening a new one,
+     *          in which case `connection_t::requests` is not zero.
      *
      * \return Pointer to `connection_t` or `0` in case of an error.
      */
@@ -50,6 +84,16 @@ typedef struct {
      */
     int ( *send_data )( connection_t* conn, const char* data, size_t size );
 
+    /**
+     * \brief   Send the segments over the connection at once, in order
+     * \note    This is optional, the library sends the segments one by one
+     *          using `send_data` if a layer leaves it `0`. Like `send_data`,
+     *          it may send fewer bytes than given, the caller sends the rest.
+     *
+     * \return  Number of bytes sent or `-1` in case of an error.
+     */
+    int ( *send_datav )( connection_t* conn, const xi_iovec_t* iov, size_t count );
+
     /**
      * \brief   Read data from a connection
      *
@@ -57,12 +101,81 @@ typedef struct {
      */
     int ( *read_data )( connection_t* conn, char* buffer, size_t buffer_size );
 
+    /**
+     * \brief   Probe whether an open connection can be reused for another request
+     * \note    This is used before sending over a keep-alive connection, so it must
+     *          not block. Implementations should report connections that have been
+     *          closed by the peer or have been idle for longer than the idle timeout
+     *          [see xi_set_connection_pool()] as stale. The unread data is reported
+     *          apart, it's stale for a request but it may be an update the server
+     *          has pushed to a subscriber.
+     *
+     * \return  One of `xi_connection_state_t`.
+     */
+    int ( *is_connection_alive )( connection_t* conn );
+
+    /**
+     * \brief   Check a connection that is still usable back in once a request
+     *          has completed
+     * \note    Implementations that pool connections take it over (and may
+     *          close it if it has served enough requests), others leave it
+     *          to the caller who may keep it for the next request.
+     *
+     * \return  `1` if the layer has taken the connection over or `0` if the
+     *          caller still owns it.
+     */
+    int ( *checkin_connection )( connection_t* conn );
+
     /**
      * \brief   Close connection and free all allocated memory (if any)
      * \note    Some implementations may be stack-based as only limited
      *          number of connections is expected in a typical use-case.
      */
     void ( *close_connection )( connection_t* conn );
+
+    /**
+     * \brief   Create a connection that will be used asynchronously, it isn't
+     *          connected until `XI_COMM_OP_CONNECT` is submitted
+     * \note    The asynchronous functions are optional and left `0` by the
+     *          layers that can only block, the library then runs the requests
+     *          made with `xi_*_async()` one by one from `xi_poll()`.
+     *
+     * \return Pointer to `connection_t` or `0` in case of an error.
+     */
+    connection_t* ( *async_create_connection )( const char* address, int32_t port );
+
+    /**
+     * \brief   Start an operation on the connection, without waiting for it
+     * \note    Only one operation may be in progress on a connection, the
+     *          buffer must stay valid until its completion has been reaped.
+     *          Send and read may complete with fewer bytes than requested.
+     *
+     * \return  `0` on success or `-1` in case of an error.
+     */
+    int ( *async_submit )( connection_t* conn, xi_comm_op_t op
+        , char* buffer, size_t size, void* user_data );
+
+    /**
+     * \brief   Wait up to `timeout` milliseconds for operations to finish
+     * \note    An operation that takes longer than the network timeout
+     *          completes with an error.
+     *
+     * \return  Number of completions stored or `-1` in case of an error.
+     */
+    int ( *async_reap )( xi_comm_completion_t* completions
+        , size_t max_completions, uint32_t timeout );
+
+    /**
+     * \brief   Same as `open_connection`, but the connection is encrypted
+     *          with TLS, the server certificate is verified against the address
+     * \note    This is optional and left `0` by the layers that don't support
+     *          TLS, the secure protocols then fail with `XI_TLS_NOT_SUPPORTED`.
+     *          A session of an earlier connection to the endpoint should be
+     *          resumed if possible [see `connection_t::session_resumed`].
+     *
+     * \return Pointer to `connection_t` or `0` in case of an error.
+     */
+    connection_t* ( *open_secure_connection )( const char* address, int32_t port );
 } comm_layer_t;
 
 
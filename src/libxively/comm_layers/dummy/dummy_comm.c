@@ -20,6 +20,70 @@
 #include "xi_macros.h"
 #include "xi_globals.h"
 
+// the replies the dummy layer answers the requests with in turn, the last
+// one is repeated, it makes the layer a simple stand-in server for the tests
+static const char* dummy_reply = 0;
+static const char* dummy_single_reply[ 2 ] = { 0, 0 };
+static const char* const* dummy_replies = dummy_single_reply;
+static size_t dummy_reply_index = 0;
+// the size of the single binary reply, the others are terminated
+static size_t dummy_reply_size = 0;
+// what the server has sent on its own, it's read ahead of the reply
+static const char* dummy_pushed = 0;
+
+// works out the reply from the request when it can't be given up front
+static const char* ( *dummy_responder )( const char* request, size_t size ) = 0;
+
+// what has been sent since the last read, so tests can check the requests,
+// it's per thread as the contexts of a dispatcher send theirs all at once
+static XI_THREAD_LOCAL char dummy_request[ 2 * XI_QUERY_BUFFER_SIZE ];
+static XI_THREAD_LOCAL size_t dummy_request_size = 0;
+static XI_THREAD_LOCAL int dummy_request_answered = 0;
+
+void dummy_comm_set_reply( const char* reply )
+{
+    dummy_single_reply[ 0 ] = reply;
+    dummy_comm_set_replies( dummy_single_reply );
+}
+
+void dummy_comm_set_binary_reply( const char* reply, size_t size )
+{
+    dummy_comm_set_reply( reply );
+    dummy_reply_size = size;
+}
+
+void dummy_comm_set_replies( const char* const* replies )
+{
+    dummy_replies           = replies ? replies : dummy_single_reply;
+    dummy_reply_index       = 0;
+    dummy_reply             = dummy_replies[ 0 ];
+    dummy_reply_size        = 0;
+    dummy_pushed            = 0;
+    dummy_request_size      = 0;
+    dummy_request_answered  = 0;
+    dummy_request[ 0 ]      = '\0';
+}
+
+void dummy_comm_set_responder(
+    const char* ( *responder )( const char* request, size_t size ) )
+{
+    dummy_responder = responder;
+}
+
+void dummy_comm_push( const char* data )
+{
+    dummy_pushed = data;
+}
+
+const char* dummy_comm_last_request( void )
+{
+    return dummy_request;
+}
+
+size_t dummy_comm_last_request_size( void )
+{
+    return dummy_request_size;
+}
 
 connection_t* dummy_open_connection( const char* address, int32_t port )
 {
@@ -37,6 +101,8 @@ connection_t* dummy_open_connection( const char* address, int32_t port )
 
     XI_CHECK_MEMORY( dummy_comm_data );
 
+    memset( dummy_comm_data, 0, sizeof( dummy_comm_layer_data_specific_t ) );
+
     // allocate memory for the connection layer
     conn
         = ( connection_t* ) xi_alloc(
@@ -44,6 +110,9 @@ connection_t* dummy_open_connection( const char* address, int32_t port )
 
     XI_CHECK_MEMORY( conn );
 
+    // clean the memory before the usage
+    memset( conn, 0, sizeof( connection_t ) );
+
     // make copy of an address
     conn->address = xi_str_dup( address );
     conn->port = port;
@@ -68,6 +137,11 @@ err_handling:
     return 0;
 }
 
+connection_t* dummy_open_secure_connection( const char* address, int32_t port )
+{
+    return dummy_open_connection( address, port );
+}
+
 int dummy_send_data( connection_t* conn, const char* data, size_t size )
 {
     // PRECONDITIONS
@@ -77,8 +151,44 @@ int dummy_send_data( connection_t* conn, const char* data, size_t size )
     assert( size != 0 );
 
     // extract the layer specific data
-    /*dummy_comm_layer_data_specific_t* dummy_comm_data
-        = ( dummy_comm_layer_data_specific_t* ) conn->layer_specific;*/
+    dummy_comm_layer_data_specific_t* dummy_comm_data
+        = ( dummy_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    // every request makes the whole reply readable again
+    dummy_comm_data->reply_offset = 0;
+
+    // a read means the previous request is complete
+    if( dummy_request_answered )
+    {
+        dummy_request_size      = 0;
+        dummy_request_answered  = 0;
+
+        if( dummy_replies[ dummy_reply_index + 1 ] )
+        {
+            dummy_reply = dummy_replies[ ++dummy_reply_index ];
+        }
+    }
+
+    {
+        size_t left = sizeof( dummy_request ) - 1 - dummy_request_size;
+        size_t s    = XI_MIN( left, size );
+
+        memcpy( dummy_request + dummy_request_size, data, s );
+        dummy_request_size += s;
+        dummy_request[ dummy_request_size ] = '\0';
+    }
+
+    if( dummy_responder )
+    {
+        const char* reply = dummy_responder( dummy_request, dummy_request_size );
+
+        // the reply it gives is terminated
+        if( reply )
+        {
+            dummy_reply         = reply;
+            dummy_reply_size    = 0;
+        }
+    }
 
     // store the value
     conn->bytes_sent += size;
@@ -95,14 +205,60 @@ int dummy_read_data( connection_t* conn, char* buffer, size_t buffer_size )
     assert( buffer_size != 0 );
 
     // extract the layer specific data
-    /*dummy_comm_layer_data_specific_t* dummy_comm_data
-        = ( dummy_comm_layer_data_specific_t* ) conn->layer_specific;*/
+    dummy_comm_layer_data_specific_t* dummy_comm_data
+        = ( dummy_comm_layer_data_specific_t* ) conn->layer_specific;
 
     memset( buffer, 0, buffer_size );
 
+    if( dummy_pushed )
+    {
+        size_t size = XI_MIN( strlen( dummy_pushed ), buffer_size );
+
+        memcpy( buffer, dummy_pushed, size );
+        dummy_pushed = dummy_pushed[ size ] ? dummy_pushed + size : 0;
+
+        conn->bytes_received += size;
+
+        return size;
+    }
+
+    dummy_request_answered = 1;
+
+    if( dummy_reply == 0 )
+    {
+        return 0;
+    }
+
+    size_t left = dummy_reply_size
+        ? dummy_reply_size - dummy_comm_data->reply_offset
+        : strlen( dummy_reply + dummy_comm_data->reply_offset );
+    size_t size = XI_MIN( left, buffer_size );
+
+    memcpy( buffer, dummy_reply + dummy_comm_data->reply_offset, size );
+    dummy_comm_data->reply_offset += size;
+
     // store the value
-    conn->bytes_received += 0;
+    conn->bytes_received += size;
+
+    return size;
+}
+
+int dummy_is_connection_alive( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+
+    // the dummy server never drops connections
+    return dummy_pushed ? XI_CONNECTION_PENDING : XI_CONNECTION_ALIVE;
+}
+
+int dummy_checkin_connection( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
 
+    // the dummy layer does not pool connections, the context keeps it
     return 0;
 }
 
@@ -14,10 +14,74 @@
 
 connection_t* dummy_open_connection( const char* address, int32_t port );
 
+/**
+ * \brief   Nothing is encrypted, the secure protocols only get the same
+ *          stand-in server on their own ports
+ */
+connection_t* dummy_open_secure_connection( const char* address, int32_t port );
+
 int dummy_send_data( connection_t* conn, const char* data, size_t size );
 
 int dummy_read_data( connection_t* conn, char* buffer, size_t buffer_size );
 
+int dummy_is_connection_alive( connection_t* conn );
+
+int dummy_checkin_connection( connection_t* conn );
+
 void dummy_close_connection( connection_t* conn );
 
+/**
+ * \brief   Sets the reply that is returned for every request sent over
+ *          the dummy layer, which lets tests use it as a stand-in server
+ *
+ * \note    The string is not copied, pass `0` to go back to empty replies.
+ */
+void dummy_comm_set_reply( const char* reply );
+
+/**
+ * \brief   Sets the reply which may contain zeros, e.g. the one with a CBOR body
+ *
+ * \note    The data is not copied.
+ */
+void dummy_comm_set_binary_reply( const char* reply, size_t size );
+
+/**
+ * \brief   Sets the replies that are returned in turn, a request sent after
+ *          the reply has been read gets the next one and the last one is
+ *          returned from then on
+ *
+ * \note    The array must be terminated with `0` and it is not copied.
+ */
+void dummy_comm_set_replies( const char* const* replies );
+
+/**
+ * \brief   Sets the function which works out the reply from the request that
+ *          has been sent so far, e.g. when it depends on a random key
+ *
+ * \note    The reply it returns replaces the current one unless it's `0`,
+ *          pass `0` to stop asking it.
+ */
+void dummy_comm_set_responder(
+    const char* ( *responder )( const char* request, size_t size ) );
+
+/**
+ * \brief   Makes the data readable before the next request is sent, as an
+ *          update the server pushes in between the requests
+ *
+ * \note    The string is not copied, it's read once.
+ */
+void dummy_comm_push( const char* data );
+
+/**
+ * \brief   Returns everything that has been sent since the last reply
+ *          has been read, that is the request the reply is for
+ */
+const char* dummy_comm_last_request( void );
+
+/**
+ * \brief   Size of the last request, which may contain zeros (e.g. a masked
+ *          WebSocket frame)
+ */
+size_t dummy_comm_last_request_size( void );
+
 #endif // __DUMMY_COMM_H__
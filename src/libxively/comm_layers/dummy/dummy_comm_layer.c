@@ -18,8 +18,15 @@ const comm_layer_t* get_comm_layer()
     {
           &dummy_open_connection
         , &dummy_send_data
+        , 0 // the segments are sent one by one
         , &dummy_read_data
+        , &dummy_is_connection_alive
+        , &dummy_checkin_connection
         , &dummy_close_connection
+        , 0 // no asynchronous operations
+        , 0
+        , 0
+        , &dummy_open_secure_connection
     };
 
     return &__dummy_comm_layer;
@@ -10,8 +10,11 @@
 #ifndef __DUMMY_COMM_LAYER_DATA_SPECIFIC_H__
 #define __DUMMY_COMM_LAYER_DATA_SPECIFIC_H__
 
+#include <stdlib.h>
+
 typedef struct {
-    int socket_fd;
+    int     socket_fd;
+    size_t  reply_offset; //!< how much of the reply has been read so far
 } dummy_comm_layer_data_specific_t;
 
 #endif // __DUMMY_COMM_LAYER_DATA_SPECIFIC_H__
@@ -0,0 +1,43 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    epoll_comm.h
+ * \brief   Implements non-blocking Linux epoll _communication layer_ functions [see comm_layer.h, epoll_comm.c and epoll_comm_async.c]
+ */
+
+#ifndef __EPOLL_COMM_H__
+#define __EPOLL_COMM_H__
+
+#include <stdint.h>
+
+#include "comm_layer.h"
+
+connection_t* epoll_open_connection( const char* address, int32_t port );
+
+int epoll_send_data( connection_t* conn, const char* data, size_t size );
+
+int epoll_send_datav( connection_t* conn, const xi_iovec_t* iov, size_t count );
+
+int epoll_read_data( connection_t* conn, char* buffer, size_t buffer_size );
+
+int epoll_is_connection_alive( connection_t* conn );
+
+int epoll_checkin_connection( connection_t* conn );
+
+void epoll_close_connection( connection_t* conn );
+
+connection_t* epoll_async_create_connection( const char* address, int32_t port );
+
+int epoll_async_submit( connection_t* conn, xi_comm_op_t op
+    , char* buffer, size_t size, void* user_data );
+
+int epoll_async_reap( xi_comm_completion_t* completions
+    , size_t max_completions, uint32_t timeout );
+
+// shared by the blocking and the asynchronous part of the layer
+uint64_t epoll_get_time_ms( void );
+
+void epoll_forget_operation( connection_t* conn );
+
+#endif // __EPOLL_COMM_H__
@@ -0,0 +1,291 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    epoll_comm_async.c
+ * \brief   Implements the asynchronous part of the Linux epoll _communication layer_ [see comm_layer.h]
+ *
+ *    Submitting an operation arms the socket in the epoll set for a single
+ *    event (`EPOLLONESHOT`), the operation itself is then done once the socket
+ *    is ready and reported by `epoll_async_reap()`. The operations in progress
+ *    are kept on a list, so those that take longer than the network timeout
+ *    can be failed.
+ */
+
+#include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "epoll_comm.h"
+#include "comm_layer.h"
+#include "epoll_comm_layer_data_specific.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_macros.h"
+#include "xi_globals.h"
+#include "xi_config.h"
+
+static int              epoll_fd        = -1;
+static connection_t*    epoll_pending   = 0;
+
+static inline epoll_comm_layer_data_specific_t* epoll_data_of( connection_t* conn )
+{
+    return ( epoll_comm_layer_data_specific_t* ) conn->layer_specific;
+}
+
+void epoll_forget_operation( connection_t* conn )
+{
+    epoll_comm_layer_data_specific_t* epoll_data = epoll_data_of( conn );
+
+    if( epoll_data->op == XI_COMM_OP_NONE ) { return; }
+
+    if( epoll_data->prev_pending )
+    {
+        epoll_data_of( epoll_data->prev_pending )->next_pending = epoll_data->next_pending;
+    }
+    else
+    {
+        epoll_pending = epoll_data->next_pending;
+    }
+
+    if( epoll_data->next_pending )
+    {
+        epoll_data_of( epoll_data->next_pending )->prev_pending = epoll_data->prev_pending;
+    }
+
+    epoll_data->op              = XI_COMM_OP_NONE;
+    epoll_data->prev_pending    = 0;
+    epoll_data->next_pending    = 0;
+}
+
+/**
+ * \brief   Arms the socket for the single event the operation waits for
+ */
+static int epoll_arm( connection_t* conn )
+{
+    epoll_comm_layer_data_specific_t* epoll_data = epoll_data_of( conn );
+
+    struct epoll_event event;
+
+    memset( &event, 0, sizeof( event ) );
+    event.events    = ( epoll_data->op == XI_COMM_OP_RECV ? EPOLLIN : EPOLLOUT ) | EPOLLONESHOT;
+    event.data.ptr  = conn;
+
+    if( epoll_ctl( epoll_fd
+        , epoll_data->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD
+        , epoll_data->socket_fd, &event ) == -1 )
+    {
+        return -1;
+    }
+
+    epoll_data->registered = 1;
+
+    return 0;
+}
+
+int epoll_async_submit( connection_t* conn, xi_comm_op_t op
+    , char* buffer, size_t size, void* user_data )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+    assert( op != XI_COMM_OP_NONE );
+
+    epoll_comm_layer_data_specific_t* epoll_data = epoll_data_of( conn );
+
+    assert( epoll_data->op == XI_COMM_OP_NONE );
+
+    if( epoll_fd == -1 )
+    {
+        epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+        XI_CHECK_CND( epoll_fd == -1, XI_SOCKET_INITIALIZATION_ERROR );
+    }
+
+    if( op == XI_COMM_OP_CONNECT
+        && connect( epoll_data->socket_fd
+            , &epoll_data->peer.address.sa, epoll_data->peer.size ) == -1
+        && errno != EINPROGRESS )
+    {
+        xi_set_err( XI_SOCKET_CONNECTION_ERROR );
+        goto err_handling;
+    }
+
+    epoll_data->op          = op;
+    epoll_data->buffer      = buffer;
+    epoll_data->size        = size;
+    epoll_data->user_data   = user_data;
+    epoll_data->deadline    = epoll_get_time_ms() + xi_globals.network_timeout;
+
+    if( epoll_arm( conn ) == -1 )
+    {
+        epoll_data->op = XI_COMM_OP_NONE;
+        xi_set_err( XI_SOCKET_INITIALIZATION_ERROR );
+        goto err_handling;
+    }
+
+    // put it on the list of operations in progress
+    epoll_data->prev_pending = 0;
+    epoll_data->next_pending = epoll_pending;
+
+    if( epoll_pending ) { epoll_data_of( epoll_pending )->prev_pending = conn; }
+
+    epoll_pending = conn;
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+/**
+ * \brief   Does the operation the socket has become ready for
+ *
+ * \return  The result of the operation or `-2` if it would still block.
+ */
+static int epoll_perform( connection_t* conn )
+{
+    epoll_comm_layer_data_specific_t* epoll_data = epoll_data_of( conn );
+
+    int result = -1;
+
+    switch( epoll_data->op )
+    {
+        case XI_COMM_OP_CONNECT:
+        {
+            int error = 0;
+            socklen_t error_size = sizeof( error );
+
+            if( getsockopt( epoll_data->socket_fd, SOL_SOCKET, SO_ERROR
+                    , &error, &error_size ) == 0 && error == 0 )
+            {
+                return 0;
+            }
+
+            xi_set_err( XI_SOCKET_CONNECTION_ERROR );
+            return -1;
+        }
+        case XI_COMM_OP_SEND:
+            result = write( epoll_data->socket_fd, epoll_data->buffer, epoll_data->size );
+            if( result >= 0 ) { conn->bytes_sent += result; }
+            break;
+        case XI_COMM_OP_RECV:
+            result = read( epoll_data->socket_fd, epoll_data->buffer, epoll_data->size );
+            if( result >= 0 ) { conn->bytes_received += result; }
+            break;
+        default:
+            return -2;
+    }
+
+    if( result == -1 )
+    {
+        if( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) { return -2; }
+
+        xi_set_err( epoll_data->op == XI_COMM_OP_SEND
+            ? XI_SOCKET_WRITE_ERROR : XI_SOCKET_READ_ERROR );
+    }
+    else
+    {
+        epoll_data->last_activity = time( 0 );
+    }
+
+    return result;
+}
+
+static void epoll_complete(
+      connection_t* conn
+    , int result
+    , xi_comm_completion_t* completion )
+{
+    completion->user_data   = epoll_data_of( conn )->user_data;
+    completion->result      = result;
+    completion->error       = result == -1 ? xi_get_last_error() : XI_NO_ERR;
+
+    epoll_forget_operation( conn );
+}
+
+int epoll_async_reap( xi_comm_completion_t* completions
+    , size_t max_completions, uint32_t timeout )
+{
+    // PRECONDITIONS
+    assert( completions != 0 );
+
+    size_t count    = 0;
+    uint64_t now    = epoll_get_time_ms();
+    int wait        = ( int ) timeout;
+
+    // fail the operations which are taking too long
+    connection_t* conn = epoll_pending;
+
+    while( conn && count < max_completions )
+    {
+        connection_t* next = epoll_data_of( conn )->next_pending;
+        uint64_t deadline  = epoll_data_of( conn )->deadline;
+
+        if( deadline <= now )
+        {
+            switch( epoll_data_of( conn )->op )
+            {
+                case XI_COMM_OP_CONNECT:
+                    xi_set_err( XI_SOCKET_CONNECTION_ERROR );
+                    break;
+                case XI_COMM_OP_SEND:
+                    xi_set_err( XI_SOCKET_WRITE_ERROR );
+                    break;
+                default:
+                    xi_set_err( XI_SOCKET_READ_ERROR );
+                    break;
+            }
+
+            epoll_complete( conn, -1, &completions[ count++ ] );
+        }
+        else if( deadline - now < ( uint64_t ) wait )
+        {
+            wait = ( int ) ( deadline - now );
+        }
+
+        conn = next;
+    }
+
+    if( count == max_completions || epoll_fd == -1 ) { return ( int ) count; }
+
+    if( count > 0 ) { wait = 0; }
+
+    struct epoll_event events[ XI_ASYNC_MAX_COMPLETIONS ];
+
+    int ready = epoll_wait( epoll_fd, events
+        , ( int ) XI_MIN( max_completions - count, XI_ASYNC_MAX_COMPLETIONS ), wait );
+
+    if( ready == -1 )
+    {
+        if( errno == EINTR ) { return ( int ) count; }
+
+        xi_set_err( XI_SOCKET_READ_ERROR );
+        return -1;
+    }
+
+    for( int i = 0; i < ready; ++i )
+    {
+        conn = ( connection_t* ) events[ i ].data.ptr;
+
+        if( epoll_data_of( conn )->op == XI_COMM_OP_NONE ) { continue; }
+
+        int result = epoll_perform( conn );
+
+        if( result == -2 )
+        {
+            // spurious wake up, wait for the next one
+            if( epoll_arm( conn ) == 0 ) { continue; }
+
+            xi_set_err( XI_SOCKET_READ_ERROR );
+            result = -1;
+        }
+
+        epoll_complete( conn, result, &completions[ count++ ] );
+    }
+
+    return ( int ) count;
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+#include "comm_layer.h"
+#include "epoll_comm.h"
+
+/**
+ * \file    epoll_comm_layer.c
+ * \brief   Implements Linux epoll _communication layer_ functions [see comm_layer.h]
+ */
+
+ /**
+  * \brief   Initialise epoll implementation of the _communication layer_
+  */
+const comm_layer_t* get_comm_layer()
+{
+    static comm_layer_t __epoll_comm_layer =
+    {
+          &epoll_open_connection
+        , &epoll_send_data
+        , &epoll_send_datav
+        , &epoll_read_data
+        , &epoll_is_connection_alive
+        , &epoll_checkin_connection
+        , &epoll_close_connection
+        , &epoll_async_create_connection
+        , &epoll_async_submit
+        , &epoll_async_reap
+        , 0 // no TLS
+    };
+
+    return &__epoll_comm_layer;
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    epoll_comm_layer_data_specific.h
+ * \brief   Declares layer-specific data structure
+ */
+
+#ifndef __EPOLL_COMM_LAYER_DATA_SPECIFIC_H__
+#define __EPOLL_COMM_LAYER_DATA_SPECIFIC_H__
+
+#include <stdint.h>
+#include <time.h>
+#include <netinet/in.h>
+
+#include "comm_layer.h"
+#include "posix_dns_cache.h"
+
+typedef struct {
+    int                 socket_fd;
+    posix_dns_address_t peer;          //!< resolved when the connection is created
+    time_t              last_activity; //!< when the socket was last used, for idle connection eviction
+    int                 registered;    //!< the socket has been added to the epoll set
+    xi_comm_op_t        op;            //!< the asynchronous operation in progress
+    char*               buffer;
+    size_t              size;
+    void*               user_data;
+    uint64_t            deadline;      //!< milliseconds, when the operation times out
+    connection_t*       prev_pending;  //!< neighbours on the list of operations in progress
+    connection_t*       next_pending;
+} epoll_comm_layer_data_specific_t;
+
+#endif // __EPOLL_COMM_LAYER_DATA_SPECIFIC_H__
@@ -0,0 +1,359 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    io_uring_comm.c
+ * \brief   Implements the blocking part of the Linux io_uring _communication layer_ [see comm_layer.h]
+ *
+ *    All sockets are non-blocking, so the same connection can be used by both
+ *    the blocking functions below, which wait with `poll()` for up to the
+ *    network timeout, and the asynchronous ones [see io_uring_comm_async.c].
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "io_uring_comm.h"
+#include "comm_layer.h"
+#include "xi_helpers.h"
+#include "xi_allocator.h"
+#include "io_uring_comm_layer_data_specific.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_macros.h"
+#include "xi_globals.h"
+
+uint64_t io_uring_get_time_ms( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( uint64_t ) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * \brief   Waits for the socket to become ready for the given events
+ *
+ * \return  `1` if ready, `0` on timeout or `-1` in case of an error.
+ */
+static int io_uring_wait_for( int fd, short events )
+{
+    struct pollfd pfd = { fd, events, 0 };
+
+    int r = 0;
+
+    do
+    {
+        r = poll( &pfd, 1, ( int ) xi_globals.network_timeout );
+    } while( r == -1 && errno == EINTR );
+
+    return r;
+}
+
+connection_t* io_uring_async_create_connection( const char* address, int32_t port )
+{
+    // PRECONDITIONS
+    assert( address != 0 );
+
+    // variables
+    io_uring_comm_layer_data_specific_t* uring_data    = 0;
+    connection_t* conn                              = 0;
+
+    uring_data
+        = ( io_uring_comm_layer_data_specific_t* ) xi_alloc(
+                sizeof( io_uring_comm_layer_data_specific_t ) );
+
+    XI_CHECK_MEMORY( uring_data );
+
+    memset( uring_data, 0, sizeof( io_uring_comm_layer_data_specific_t ) );
+    uring_data->socket_fd = -1;
+
+    conn = ( connection_t* ) xi_alloc( sizeof( connection_t ) );
+
+    XI_CHECK_MEMORY( conn );
+
+    memset( conn, 0, sizeof( connection_t ) );
+
+    conn->address = xi_str_dup( address );
+    conn->port = port;
+
+    XI_CHECK_MEMORY( conn->address );
+
+    // resolve the address, which still blocks the first time the host is
+    // looked up, the cache of the POSIX layer serves it from then on, only
+    // the first address is tried as the connect isn't waited for here
+    if( posix_dns_cache_resolve( conn->address, port, &uring_data->peer, 1 ) == 0 )
+    {
+        xi_set_err( XI_SOCKET_GETHOSTBYNAME_ERROR );
+        goto err_handling;
+    }
+
+    uring_data->socket_fd = socket( uring_data->peer.address.sa.sa_family
+        , SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+
+    if( uring_data->socket_fd == -1 )
+    {
+        xi_set_err( XI_SOCKET_INITIALIZATION_ERROR );
+        goto err_handling;
+    }
+
+    uring_data->last_activity = time( 0 );
+
+    uring_data->conn     = conn;
+    conn->layer_specific = ( void* ) uring_data;
+
+    return conn;
+
+err_handling:
+    if( uring_data && uring_data->socket_fd != -1 )
+    {
+        close( uring_data->socket_fd );
+    }
+    XI_SAFE_FREE( uring_data );
+    if( conn ) { XI_SAFE_FREE( conn->address ); }
+    XI_SAFE_FREE( conn );
+
+    return 0;
+}
+
+connection_t* io_uring_open_connection( const char* address, int32_t port )
+{
+    // PRECONDITIONS
+    assert( address != 0 );
+
+    connection_t* conn = io_uring_async_create_connection( address, port );
+
+    if( conn == 0 ) { return 0; }
+
+    io_uring_comm_layer_data_specific_t* uring_data
+        = ( io_uring_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    if( connect( uring_data->socket_fd
+        , &uring_data->peer.address.sa, uring_data->peer.size ) == -1 )
+    {
+        int error = 0;
+        socklen_t error_size = sizeof( error );
+
+        if( errno != EINPROGRESS
+            || io_uring_wait_for( uring_data->socket_fd, POLLOUT ) != 1
+            || getsockopt( uring_data->socket_fd, SOL_SOCKET, SO_ERROR
+                , &error, &error_size ) == -1
+            || error != 0 )
+        {
+            xi_set_err( XI_SOCKET_CONNECTION_ERROR );
+            io_uring_close_connection( conn );
+
+            return 0;
+        }
+    }
+
+    return conn;
+}
+
+int io_uring_send_data( connection_t* conn, const char* data, size_t size )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+    assert( data != 0 );
+    assert( size != 0 );
+
+    io_uring_comm_layer_data_specific_t* uring_data
+        = ( io_uring_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    size_t sent = 0;
+
+    while( sent < size )
+    {
+        int bytes_written = write( uring_data->socket_fd, data + sent, size - sent );
+
+        if( bytes_written == -1 )
+        {
+            if( ( errno == EAGAIN || errno == EWOULDBLOCK )
+                && io_uring_wait_for( uring_data->socket_fd, POLLOUT ) == 1 )
+            {
+                continue;
+            }
+
+            if( errno == EINTR ) { continue; }
+
+            xi_set_err( XI_SOCKET_WRITE_ERROR );
+            return -1;
+        }
+
+        sent += bytes_written;
+    }
+
+    conn->bytes_sent += sent;
+    uring_data->last_activity = time( 0 );
+
+    return ( int ) sent;
+}
+
+int io_uring_send_datav( connection_t* conn, const xi_iovec_t* iov, size_t count )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+    assert( iov != 0 );
+    assert( count != 0 );
+
+    io_uring_comm_layer_data_specific_t* uring_data
+        = ( io_uring_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    // whatever doesn't fit is sent by the next call
+    struct iovec vec[ XI_REQUEST_MAX_SEGMENTS ];
+
+    if( count > XI_REQUEST_MAX_SEGMENTS ) { count = XI_REQUEST_MAX_SEGMENTS; }
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        vec[ i ].iov_base   = ( void* ) iov[ i ].data;
+        vec[ i ].iov_len    = iov[ i ].size;
+    }
+
+    for( ;; )
+    {
+        int bytes_written = writev( uring_data->socket_fd, vec, count );
+
+        if( bytes_written == -1 )
+        {
+            if( ( errno == EAGAIN || errno == EWOULDBLOCK )
+                && io_uring_wait_for( uring_data->socket_fd, POLLOUT ) == 1 )
+            {
+                continue;
+            }
+
+            if( errno == EINTR ) { continue; }
+
+            xi_set_err( XI_SOCKET_WRITE_ERROR );
+            return -1;
+        }
+
+        conn->bytes_sent += bytes_written;
+        uring_data->last_activity = time( 0 );
+
+        return bytes_written;
+    }
+}
+
+int io_uring_read_data( connection_t* conn, char* buffer, size_t buffer_size )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+    assert( buffer != 0 );
+    assert( buffer_size != 0 );
+
+    io_uring_comm_layer_data_specific_t* uring_data
+        = ( io_uring_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    memset( buffer, 0, buffer_size );
+
+    for( ;; )
+    {
+        int bytes_read = read( uring_data->socket_fd, buffer, buffer_size );
+
+        if( bytes_read >= 0 )
+        {
+            conn->bytes_received += bytes_read;
+            uring_data->last_activity = time( 0 );
+
+            return bytes_read;
+        }
+
+        if( errno == EINTR ) { continue; }
+
+        if( errno == EAGAIN || errno == EWOULDBLOCK )
+        {
+            int ready = io_uring_wait_for( uring_data->socket_fd, POLLIN );
+
+            if( ready == 1 ) { continue; }
+
+            if( ready == 0 )
+            {
+                // nothing has arrived within the timeout, the connection is fine
+                xi_set_err( XI_SOCKET_TIMEOUT_ERROR );
+                return -1;
+            }
+        }
+
+        xi_set_err( XI_SOCKET_READ_ERROR );
+        return -1;
+    }
+}
+
+int io_uring_is_connection_alive( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+
+    io_uring_comm_layer_data_specific_t* uring_data
+        = ( io_uring_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    // there should be nothing to read in between the requests but the
+    // updates pushed by the server
+    char c;
+    int r = recv( uring_data->socket_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT );
+
+    if( r == 1 ) { return XI_CONNECTION_PENDING; }
+
+    if( r == 0 || ( errno != EAGAIN && errno != EWOULDBLOCK ) )
+    {
+        return XI_CONNECTION_STALE;
+    }
+
+    // the server is likely to have dropped a connection that has been
+    // idle for that long, so it's cheaper to open a new one
+    if( time( 0 ) - uring_data->last_activity
+        > ( time_t ) xi_globals.connection_idle_timeout )
+    {
+        return XI_CONNECTION_STALE;
+    }
+
+    return XI_CONNECTION_ALIVE;
+}
+
+int io_uring_checkin_connection( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+
+    // connections aren't pooled by this layer
+    return 0;
+}
+
+void io_uring_close_connection( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+
+    io_uring_comm_layer_data_specific_t* uring_data
+        = ( io_uring_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    if( uring_data )
+    {
+        // an operation still in the ring keeps the data until it completes
+        io_uring_cancel_operation( conn );
+
+        if( uring_data->socket_fd != -1 && close( uring_data->socket_fd ) == -1 )
+        {
+            xi_set_err( XI_SOCKET_CLOSE_ERROR );
+        }
+    }
+
+    XI_SAFE_FREE( conn->layer_specific );
+    XI_SAFE_FREE( conn->address );
+    XI_SAFE_FREE( conn );
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    io_uring_comm.h
+ * \brief   Implements Linux io_uring _communication layer_ functions [see comm_layer.h, io_uring_comm.c and io_uring_comm_async.c]
+ */
+
+#ifndef __IO_URING_COMM_H__
+#define __IO_URING_COMM_H__
+
+#include <stdint.h>
+
+#include "comm_layer.h"
+
+connection_t* io_uring_open_connection( const char* address, int32_t port );
+
+int io_uring_send_data( connection_t* conn, const char* data, size_t size );
+
+int io_uring_send_datav( connection_t* conn, const xi_iovec_t* iov, size_t count );
+
+int io_uring_read_data( connection_t* conn, char* buffer, size_t buffer_size );
+
+int io_uring_is_connection_alive( connection_t* conn );
+
+int io_uring_checkin_connection( connection_t* conn );
+
+void io_uring_close_connection( connection_t* conn );
+
+connection_t* io_uring_async_create_connection( const char* address, int32_t port );
+
+int io_uring_async_submit( connection_t* conn, xi_comm_op_t op
+    , char* buffer, size_t size, void* user_data );
+
+int io_uring_async_reap( xi_comm_completion_t* completions
+    , size_t max_completions, uint32_t timeout );
+
+// shared by the blocking and the asynchronous part of the layer
+uint64_t io_uring_get_time_ms( void );
+
+void io_uring_cancel_operation( connection_t* conn );
+
+#endif // __IO_URING_COMM_H__
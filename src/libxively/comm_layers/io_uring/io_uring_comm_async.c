@@ -0,0 +1,365 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    io_uring_comm_async.c
+ * \brief   Implements the asynchronous part of the Linux io_uring _communication layer_ [see comm_layer.h]
+ *
+ *    Submitting an operation only queues it in the submission ring, linked to
+ *    a timeout of the network timeout length. Everything queued since the
+ *    last call is handed over to the kernel by `io_uring_async_reap()` in the
+ *    same system call that waits for the completions, which are then reaped
+ *    from the completion ring without any further system calls. So one call
+ *    serves any number of connections.
+ *
+ *    The ring is set up with raw system calls, the layer doesn't depend on
+ *    liburing, but it needs Linux 5.11 for the wait with a timeout.
+ */
+
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+#include <linux/io_uring.h>
+
+#include "io_uring_comm.h"
+#include "comm_layer.h"
+#include "io_uring_comm_layer_data_specific.h"
+#include "xi_allocator.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_macros.h"
+#include "xi_globals.h"
+#include "xi_config.h"
+
+typedef struct {
+    int                     fd;
+    unsigned*               sq_head;
+    unsigned*               sq_tail;
+    unsigned*               sq_mask;
+    unsigned*               sq_array;
+    unsigned                sq_entries;
+    unsigned                sq_queued;  //!< our tail, ahead of the shared one by what is yet to be submitted
+    struct io_uring_sqe*    sqes;
+    unsigned*               cq_head;
+    unsigned*               cq_tail;
+    unsigned*               cq_mask;
+    struct io_uring_cqe*    cqes;
+} io_uring_ring_t;
+
+static io_uring_ring_t io_uring_ring = { .fd = -1 };
+
+static inline io_uring_comm_layer_data_specific_t* io_uring_data_of( connection_t* conn )
+{
+    return ( io_uring_comm_layer_data_specific_t* ) conn->layer_specific;
+}
+
+static int io_uring_ring_init( void )
+{
+    struct io_uring_params params;
+
+    memset( &params, 0, sizeof( params ) );
+
+    int fd = ( int ) syscall( __NR_io_uring_setup, XI_IO_URING_ENTRIES, &params );
+
+    if( fd == -1 ) { return -1; }
+
+    // the wait with a timeout needs the extended arguments of io_uring_enter()
+    if( !( params.features & IORING_FEAT_EXT_ARG ) )
+    {
+        close( fd );
+        return -1;
+    }
+
+    // both rings share a single mapping on any kernel with the feature above
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof( struct io_uring_cqe );
+
+    char* rings = ( char* ) mmap( 0, XI_MAX( sq_size, cq_size )
+        , PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+
+    if( rings == MAP_FAILED )
+    {
+        close( fd );
+        return -1;
+    }
+
+    struct io_uring_sqe* sqes = ( struct io_uring_sqe* ) mmap( 0
+        , params.sq_entries * sizeof( struct io_uring_sqe )
+        , PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+
+    if( sqes == MAP_FAILED )
+    {
+        munmap( rings, XI_MAX( sq_size, cq_size ) );
+        close( fd );
+        return -1;
+    }
+
+    io_uring_ring.sq_head       = ( unsigned* ) ( rings + params.sq_off.head );
+    io_uring_ring.sq_tail       = ( unsigned* ) ( rings + params.sq_off.tail );
+    io_uring_ring.sq_mask       = ( unsigned* ) ( rings + params.sq_off.ring_mask );
+    io_uring_ring.sq_array      = ( unsigned* ) ( rings + params.sq_off.array );
+    io_uring_ring.sq_entries    = params.sq_entries;
+    io_uring_ring.sq_queued     = *io_uring_ring.sq_tail;
+    io_uring_ring.sqes          = sqes;
+    io_uring_ring.cq_head       = ( unsigned* ) ( rings + params.cq_off.head );
+    io_uring_ring.cq_tail       = ( unsigned* ) ( rings + params.cq_off.tail );
+    io_uring_ring.cq_mask       = ( unsigned* ) ( rings + params.cq_off.ring_mask );
+    io_uring_ring.cqes          = ( struct io_uring_cqe* ) ( rings + params.cq_off.cqes );
+    io_uring_ring.fd            = fd;
+
+    return 0;
+}
+
+/**
+ * \brief   Submits the queued entries and waits for up to `timeout`
+ *          milliseconds for `min_complete` completions
+ *
+ * \return  `0` on success, even if nothing has completed in time,
+ *          `-1` in case of an error.
+ */
+static int io_uring_enter_ring( unsigned min_complete, uint32_t timeout )
+{
+    __atomic_store_n( io_uring_ring.sq_tail, io_uring_ring.sq_queued, __ATOMIC_RELEASE );
+
+    unsigned to_submit = io_uring_ring.sq_queued
+        - __atomic_load_n( io_uring_ring.sq_head, __ATOMIC_ACQUIRE );
+
+    if( to_submit == 0 && min_complete == 0 ) { return 0; }
+
+    struct __kernel_timespec ts = { timeout / 1000, ( timeout % 1000 ) * 1000000 };
+    struct io_uring_getevents_arg arg;
+
+    memset( &arg, 0, sizeof( arg ) );
+    arg.ts = ( uint64_t ) ( uintptr_t ) &ts;
+
+    long r = min_complete
+        ? syscall( __NR_io_uring_enter, io_uring_ring.fd, to_submit, min_complete
+            , IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof( arg ) )
+        : syscall( __NR_io_uring_enter, io_uring_ring.fd, to_submit, 0, 0, 0, 0 );
+
+    // the completion ring being full is sorted out by reaping it
+    if( r == -1 && errno != ETIME && errno != EINTR
+        && errno != EBUSY && errno != EAGAIN )
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief   Makes room for `count` more submission queue entries
+ */
+static int io_uring_reserve( unsigned count )
+{
+    if( io_uring_ring.sq_queued - __atomic_load_n( io_uring_ring.sq_head, __ATOMIC_ACQUIRE )
+        + count <= io_uring_ring.sq_entries )
+    {
+        return 0;
+    }
+
+    // the queue is full, hand it over to the kernel earlier than usual
+    if( io_uring_enter_ring( 0, 0 ) == -1 ) { return -1; }
+
+    return io_uring_ring.sq_queued - __atomic_load_n( io_uring_ring.sq_head, __ATOMIC_ACQUIRE )
+        + count <= io_uring_ring.sq_entries ? 0 : -1;
+}
+
+/**
+ * \brief   Takes the next submission queue entry, there must be room for it
+ */
+static struct io_uring_sqe* io_uring_next_sqe( void )
+{
+    unsigned index              = io_uring_ring.sq_queued & *io_uring_ring.sq_mask;
+    struct io_uring_sqe* sqe    = &io_uring_ring.sqes[ index ];
+
+    io_uring_ring.sq_array[ index ] = index;
+    ++io_uring_ring.sq_queued;
+
+    memset( sqe, 0, sizeof( struct io_uring_sqe ) );
+
+    return sqe;
+}
+
+void io_uring_cancel_operation( connection_t* conn )
+{
+    io_uring_comm_layer_data_specific_t* uring_data = io_uring_data_of( conn );
+
+    if( uring_data->op == XI_COMM_OP_NONE ) { return; }
+
+    // the kernel may still use the buffer, so the cancellation is
+    // submitted right away instead of with the next reap
+    if( io_uring_reserve( 1 ) == 0 )
+    {
+        struct io_uring_sqe* sqe = io_uring_next_sqe();
+
+        sqe->opcode     = IORING_OP_ASYNC_CANCEL;
+        sqe->fd         = -1;
+        sqe->addr       = ( uint64_t ) ( uintptr_t ) uring_data;
+
+        io_uring_enter_ring( 0, 0 );
+    }
+
+    // its completion is yet to come, the reaper frees the data then
+    uring_data->conn        = 0;
+    conn->layer_specific    = 0;
+}
+
+int io_uring_async_submit( connection_t* conn, xi_comm_op_t op
+    , char* buffer, size_t size, void* user_data )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+    assert( op != XI_COMM_OP_NONE );
+
+    io_uring_comm_layer_data_specific_t* uring_data = io_uring_data_of( conn );
+
+    assert( uring_data->op == XI_COMM_OP_NONE );
+
+    if( io_uring_ring.fd == -1 )
+    {
+        XI_CHECK_CND( io_uring_ring_init() == -1, XI_SOCKET_INITIALIZATION_ERROR );
+    }
+
+    // the operation and its timeout have to be queued together
+    XI_CHECK_CND( io_uring_reserve( 2 ) == -1, XI_SOCKET_INITIALIZATION_ERROR );
+
+    struct io_uring_sqe* sqe = io_uring_next_sqe();
+
+    sqe->fd         = uring_data->socket_fd;
+    sqe->flags      = IOSQE_IO_LINK;
+    sqe->user_data  = ( uint64_t ) ( uintptr_t ) uring_data;
+
+    switch( op )
+    {
+        case XI_COMM_OP_CONNECT:
+            sqe->opcode     = IORING_OP_CONNECT;
+            sqe->addr       = ( uint64_t ) ( uintptr_t ) &uring_data->peer.address;
+            sqe->off        = uring_data->peer.size;
+            break;
+        case XI_COMM_OP_SEND:
+            sqe->opcode     = IORING_OP_SEND;
+            sqe->addr       = ( uint64_t ) ( uintptr_t ) buffer;
+            sqe->len        = ( uint32_t ) size;
+            sqe->msg_flags  = MSG_NOSIGNAL;
+            break;
+        default:
+            sqe->opcode     = IORING_OP_RECV;
+            sqe->addr       = ( uint64_t ) ( uintptr_t ) buffer;
+            sqe->len        = ( uint32_t ) size;
+            break;
+    }
+
+    uring_data->timeout.tv_sec  = xi_globals.network_timeout / 1000;
+    uring_data->timeout.tv_nsec = ( xi_globals.network_timeout % 1000 ) * 1000000;
+
+    sqe = io_uring_next_sqe();
+
+    // its own completion carries no user data and is skipped by the reaper
+    sqe->opcode     = IORING_OP_LINK_TIMEOUT;
+    sqe->fd         = -1;
+    sqe->addr       = ( uint64_t ) ( uintptr_t ) &uring_data->timeout;
+    sqe->len        = 1;
+
+    uring_data->op          = op;
+    uring_data->user_data   = user_data;
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+static void io_uring_complete(
+      io_uring_comm_layer_data_specific_t* uring_data
+    , int res
+    , xi_comm_completion_t* completion )
+{
+    connection_t* conn = uring_data->conn;
+
+    completion->user_data   = uring_data->user_data;
+    completion->result      = res < 0 ? -1 : res;
+    completion->error       = XI_NO_ERR;
+
+    // a cancellation by the linked timeout fails the operation as well
+    if( res < 0 )
+    {
+        switch( uring_data->op )
+        {
+            case XI_COMM_OP_CONNECT:
+                completion->error = XI_SOCKET_CONNECTION_ERROR;
+                break;
+            case XI_COMM_OP_SEND:
+                completion->error = XI_SOCKET_WRITE_ERROR;
+                break;
+            default:
+                completion->error = XI_SOCKET_READ_ERROR;
+                break;
+        }
+    }
+    else
+    {
+        if( uring_data->op == XI_COMM_OP_SEND ) { conn->bytes_sent += res; }
+        if( uring_data->op == XI_COMM_OP_RECV ) { conn->bytes_received += res; }
+
+        uring_data->last_activity = time( 0 );
+    }
+
+    uring_data->op = XI_COMM_OP_NONE;
+}
+
+int io_uring_async_reap( xi_comm_completion_t* completions
+    , size_t max_completions, uint32_t timeout )
+{
+    // PRECONDITIONS
+    assert( completions != 0 );
+
+    if( io_uring_ring.fd == -1 ) { return 0; }
+
+    unsigned head   = *io_uring_ring.cq_head;
+    unsigned tail   = __atomic_load_n( io_uring_ring.cq_tail, __ATOMIC_ACQUIRE );
+
+    // submit whatever has been queued and, unless there is something
+    // to reap already, wait for it in the same system call
+    if( io_uring_enter_ring( head == tail ? 1 : 0, timeout ) == -1 )
+    {
+        xi_set_err( XI_SOCKET_READ_ERROR );
+        return -1;
+    }
+
+    tail = __atomic_load_n( io_uring_ring.cq_tail, __ATOMIC_ACQUIRE );
+
+    size_t count = 0;
+
+    while( head != tail && count < max_completions )
+    {
+        struct io_uring_cqe* cqe = &io_uring_ring.cqes[ head & *io_uring_ring.cq_mask ];
+
+        io_uring_comm_layer_data_specific_t* uring_data
+            = ( io_uring_comm_layer_data_specific_t* ) ( uintptr_t ) cqe->user_data;
+
+        ++head;
+
+        // linked timeouts and cancellations
+        if( uring_data == 0 ) { continue; }
+
+        // the connection has been closed in the meantime
+        if( uring_data->conn == 0 )
+        {
+            XI_SAFE_FREE( uring_data );
+            continue;
+        }
+
+        io_uring_complete( uring_data, cqe->res, &completions[ count++ ] );
+    }
+
+    __atomic_store_n( io_uring_ring.cq_head, head, __ATOMIC_RELEASE );
+
+    return ( int ) count;
+}
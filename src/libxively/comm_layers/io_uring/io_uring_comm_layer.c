@@ -0,0 +1,32 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+#include "comm_layer.h"
+#include "io_uring_comm.h"
+
+/**
+ * \file    io_uring_comm_layer.c
+ * \brief   Implements Linux io_uring _communication layer_ functions [see comm_layer.h]
+ */
+
+ /**
+  * \brief   Initialise io_uring implementation of the _communication layer_
+  */
+const comm_layer_t* get_comm_layer()
+{
+    static comm_layer_t __io_uring_comm_layer =
+    {
+          &io_uring_open_connection
+        , &io_uring_send_data
+        , &io_uring_send_datav
+        , &io_uring_read_data
+        , &io_uring_is_connection_alive
+        , &io_uring_checkin_connection
+        , &io_uring_close_connection
+        , &io_uring_async_create_connection
+        , &io_uring_async_submit
+        , &io_uring_async_reap
+        , 0 // no TLS
+    };
+
+    return &__io_uring_comm_layer;
+}
@@ -0,0 +1,29 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    io_uring_comm_layer_data_specific.h
+ * \brief   Declares layer-specific data structure
+ */
+
+#ifndef __IO_URING_COMM_LAYER_DATA_SPECIFIC_H__
+#define __IO_URING_COMM_LAYER_DATA_SPECIFIC_H__
+
+#include <time.h>
+#include <netinet/in.h>
+#include <linux/time_types.h>
+
+#include "comm_layer.h"
+#include "posix_dns_cache.h"
+
+typedef struct {
+    int                     socket_fd;
+    posix_dns_address_t     peer;          //!< resolved when the connection is created
+    time_t                  last_activity; //!< when the socket was last used, for idle connection eviction
+    connection_t*           conn;          //!< the owner, `0` once it has been closed with an operation in the ring
+    xi_comm_op_t            op;            //!< the asynchronous operation in progress
+    void*                   user_data;
+    struct __kernel_timespec timeout;      //!< read by the kernel when the linked timeout is submitted
+} io_uring_comm_layer_data_specific_t;
+
+#endif // __IO_URING_COMM_LAYER_DATA_SPECIFIC_H__
@@ -149,6 +149,29 @@ int mbed_read_data( connection_t* conn, char* buffer, size_t buffer_size )
     return bytes_read;
 }
 
+int mbed_is_connection_alive( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+
+    // extract the layer specific data
+    mbed_comm_layer_data_specific_t* pos_comm_data
+        = ( mbed_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    return pos_comm_data->socket_ptr->is_connected()
+        ? XI_CONNECTION_ALIVE : XI_CONNECTION_STALE;
+}
+
+int mbed_checkin_connection( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+
+    // no pooling on mbed, the context keeps the connection for itself
+    return 0;
+}
+
 void mbed_close_connection( connection_t* conn )
 {
     // PRECONDITIONS
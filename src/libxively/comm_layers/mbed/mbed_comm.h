@@ -22,6 +22,10 @@ int mbed_send_data( connection_t* conn, const char* data, size_t size );
 
 int mbed_read_data( connection_t* conn, char* buffer, size_t buffer_size );
 
+int mbed_is_connection_alive( connection_t* conn );
+
+int mbed_checkin_connection( connection_t* conn );
+
 void mbed_close_connection( connection_t* conn );
 
 #ifdef __cplusplus
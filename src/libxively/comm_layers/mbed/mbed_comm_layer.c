@@ -19,8 +19,15 @@ const comm_layer_t* get_comm_layer()
     {
           &mbed_open_connection
         , &mbed_send_data
+        , 0 // the segments are sent one by one
         , &mbed_read_data
+        , &mbed_is_connection_alive
+        , &mbed_checkin_connection
         , &mbed_close_connection
+        , 0 // no asynchronous operations
+        , 0
+        , 0
+        , 0 // no TLS
     };
 
     return &__mbed_comm_layer;
@@ -8,10 +8,13 @@
  */
 
 #include <stdio.h>
+#include <errno.h>
+#include <time.h>
 #if (!defined(XI_COMM_LAYER_POSIX_COMPAT)) || (XI_COMM_LAYER_POSIX_COMPAT == 0)
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #elif XI_COMM_LAYER_POSIX_COMPAT == 1
 #define LWIP_COMPAT_SOCKETS 1
@@ -23,6 +26,9 @@
 #include <stdint.h>
 
 #include "posix_comm.h"
+#include "posix_connection_pool.h"
+#include "posix_dns_cache.h"
+#include "posix_tls.h"
 #include "comm_layer.h"
 #include "xi_helpers.h"
 #include "xi_allocator.h"
@@ -31,13 +37,80 @@
 #include "xi_err.h"
 #include "xi_macros.h"
 #include "xi_globals.h"
+#include "xi_time.h"
 
+time_t posix_get_time( void )
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if( clock_gettime( CLOCK_MONOTONIC, &ts ) == 0 )
+    {
+        return ts.tv_sec;
+    }
+#endif
+    return time( 0 );
+}
+
+/**
+ * \brief   Makes sure neither send nor receive block for longer than the
+ *          network timeout
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int posix_set_timeouts( int socket_fd )
+{
+#ifndef XI_COMM_LAYER_POSIX_DISABLE_TIMEOUT
+    struct timeval timeout;
+    timeout.tv_sec  = xi_globals.network_timeout / 1000;
+    timeout.tv_usec = ( xi_globals.network_timeout - timeout.tv_sec * 1000 ) * 1000;
+
+    if ( setsockopt( socket_fd, SOL_SOCKET
+            , SO_RCVTIMEO, ( char * )&timeout,
+              sizeof( timeout ) ) < 0 )
+    {
+        return -1;
+    }
+
+    if ( setsockopt( socket_fd, SOL_SOCKET
+            , SO_SNDTIMEO, ( char * )&timeout,
+              sizeof( timeout ) ) < 0 )
+    {
+        return -1;
+    }
+#else
+    XI_UNUSED( socket_fd );
+#endif
+
+    return 0;
+}
 
 connection_t* posix_open_connection( const char* address, int32_t port )
 {
     // PRECONDITIONS
     assert( address != 0 );
 
+    return posix_connection_pool_checkout( address, port, 0 );
+}
+
+connection_t* posix_open_secure_connection( const char* address, int32_t port )
+{
+    // PRECONDITIONS
+    assert( address != 0 );
+
+    return posix_connection_pool_checkout( address, port, 1 );
+}
+
+int posix_is_secure( const connection_t* conn )
+{
+    return ( ( const posix_comm_layer_data_specific_t* ) conn->layer_specific )->tls != 0;
+}
+
+connection_t* posix_create_connection( const char* address, int32_t port, int secure )
+{
+    // PRECONDITIONS
+    assert( address != 0 );
+
     // variables
     posix_comm_layer_data_specific_t* pos_comm_data = 0;
     connection_t* conn                              = 0;
@@ -49,6 +122,9 @@ connection_t* posix_open_connection( const char* address, int32_t port )
 
     XI_CHECK_MEMORY( pos_comm_data );
 
+    memset( pos_comm_data, 0, sizeof( posix_comm_layer_data_specific_t ) );
+    pos_comm_data->socket_fd = -1;
+
     // allocate memory for the connection layer
     conn
         = ( connection_t* ) xi_alloc(
@@ -56,74 +132,81 @@ connection_t* posix_open_connection( const char* address, int32_t port )
 
     XI_CHECK_MEMORY( conn );
 
+    // clean the memory before the usage
+    memset( conn, 0, sizeof( connection_t ) );
+
     // make copy of an address
     conn->address = xi_str_dup( address );
     conn->port = port;
 
     XI_CHECK_MEMORY( conn->address );
 
-    // initialze the fd for the TCP/IP socket
-    pos_comm_data->socket_fd = socket( AF_INET, SOCK_STREAM, 0 );
-    if( pos_comm_data->socket_fd == -1 )
+    // remember the layer specific part
+    conn->layer_specific = ( void* ) pos_comm_data;
+
+    // the addresses come from the cache, so only the first lookup blocks
+    posix_dns_address_t addresses[ XI_DNS_CACHE_MAX_ADDRESSES ];
+
+    uint64_t lookup_began = xi_get_time_us();
+
+    size_t address_count = posix_dns_cache_resolve(
+        conn->address, port, addresses, XI_DNS_CACHE_MAX_ADDRESSES );
+
+    conn->dns_us = ( uint32_t ) ( xi_get_time_us() - lookup_began );
+
+    // if zero it means that the address has not been found
+    if( address_count == 0 )
     {
-        xi_set_err( XI_SOCKET_INITIALIZATION_ERROR );
-        return 0;
+        xi_set_err( XI_SOCKET_GETHOSTBYNAME_ERROR );
+        goto err_handling;
     }
 
-    #ifndef XI_COMM_LAYER_POSIX_DISABLE_TIMEOUT
+    // try the addresses in turn until one of them accepts the connection
+    for( size_t i = 0; i < address_count; ++i )
     {
-        struct timeval timeout;
-        timeout.tv_sec  = xi_globals.network_timeout / 1000;
-        timeout.tv_usec = ( xi_globals.network_timeout - timeout.tv_sec * 1000 ) * 1000;
+        pos_comm_data->socket_fd = socket(
+            addresses[ i ].address.sa.sa_family, SOCK_STREAM, 0 );
 
-        if ( setsockopt( pos_comm_data->socket_fd, SOL_SOCKET
-                , SO_RCVTIMEO, ( char * )&timeout,
-                  sizeof( timeout ) ) < 0 )
+        if( pos_comm_data->socket_fd == -1 )
         {
             xi_set_err( XI_SOCKET_INITIALIZATION_ERROR );
-            goto err_handling;
+            continue;
         }
 
-        if ( setsockopt( pos_comm_data->socket_fd, SOL_SOCKET
-                , SO_SNDTIMEO, ( char * )&timeout,
-                  sizeof( timeout ) ) < 0 )
+        if( posix_set_timeouts( pos_comm_data->socket_fd ) == -1 )
         {
             xi_set_err( XI_SOCKET_INITIALIZATION_ERROR );
-            goto err_handling;
         }
-    }
-   #endif
-
-
-    // remember the layer specific part
-    conn->layer_specific = ( void* ) pos_comm_data;
-
-    // socket specific data
-    struct sockaddr_in name;
-    struct hostent* hostinfo;
-
-    // get the hostaddress
-    hostinfo = gethostbyname( conn->address );
+        else if( connect( pos_comm_data->socket_fd
+            , &addresses[ i ].address.sa, addresses[ i ].size ) == -1 )
+        {
+            xi_set_err( XI_SOCKET_CONNECTION_ERROR );
+        }
+        else
+        {
+            // an earlier address may have failed
+            xi_set_err( XI_NO_ERR );
+            break;
+        }
 
-    // if null it means that the address has not been founded
-    if( hostinfo == NULL )
-    {
-        xi_set_err( XI_SOCKET_GETHOSTBYNAME_ERROR );
-        goto err_handling;
+        close( pos_comm_data->socket_fd );
+        pos_comm_data->socket_fd = -1;
     }
 
-    // set the address and the port for further connection attempt
-    memset( &name, 0, sizeof( struct sockaddr_in ) );
-    name.sin_family = AF_INET;
-    name.sin_addr = *( ( struct in_addr* ) hostinfo->h_addr );
-    name.sin_port = htons( port );
+    if( pos_comm_data->socket_fd == -1 ) { goto err_handling; }
 
-    if( connect( pos_comm_data->socket_fd, ( struct sockaddr* ) &name, sizeof( struct sockaddr ) ) == -1 )
+    if( secure )
     {
-        xi_set_err( XI_SOCKET_CONNECTION_ERROR );
+#ifdef XI_TLS_OPENSSL
+        if( posix_tls_connect( conn ) == -1 ) { goto err_handling; }
+#else
+        xi_set_err( XI_TLS_NOT_SUPPORTED );
         goto err_handling;
+#endif
     }
 
+    pos_comm_data->last_activity = posix_get_time();
+
     // POSTCONDITIONS
     assert( conn != 0 );
     assert( pos_comm_data->socket_fd != -1 );
@@ -132,6 +215,10 @@ connection_t* posix_open_connection( const char* address, int32_t port )
 
 err_handling:
     // cleanup the memory
+    if( pos_comm_data && pos_comm_data->socket_fd != -1 )
+    {
+        close( pos_comm_data->socket_fd );
+    }
     if( pos_comm_data ) { XI_SAFE_FREE( pos_comm_data ); }
     if( conn ) { XI_SAFE_FREE( conn->address ); }
     XI_SAFE_FREE( conn );
@@ -151,15 +238,76 @@ int posix_send_data( connection_t* conn, const char* data, size_t size )
     posix_comm_layer_data_specific_t* pos_comm_data
         = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
 
+#ifdef XI_TLS_OPENSSL
+    int bytes_written = pos_comm_data->tls
+        ? posix_tls_send_data( conn, data, size )
+        : write( pos_comm_data->socket_fd, data, size );
+#else
     int bytes_written = write( pos_comm_data->socket_fd, data, size );
+#endif
+
+    if( bytes_written == - 1 )
+    {
+        // the TLS layer tells the timeouts apart
+        if( !pos_comm_data->tls ) { xi_set_err( XI_SOCKET_WRITE_ERROR ); }
+        return -1;
+    }
+
+    // store the value
+    conn->bytes_sent += bytes_written;
+    pos_comm_data->last_activity = posix_get_time();
+
+    return bytes_written;
+}
+
+int posix_send_datav( connection_t* conn, const xi_iovec_t* iov, size_t count )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+    assert( iov != 0 );
+    assert( count != 0 );
+
+    // extract the layer specific data
+    posix_comm_layer_data_specific_t* pos_comm_data
+        = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
+
+#ifdef XI_TLS_OPENSSL
+    if( pos_comm_data->tls )
+    {
+        int bytes_written = posix_tls_send_datav( conn, iov, count );
+
+        if( bytes_written == -1 ) { return -1; }
+
+        conn->bytes_sent += bytes_written;
+        pos_comm_data->last_activity = posix_get_time();
+
+        return bytes_written;
+    }
+#endif
+
+    // whatever doesn't fit is sent by the next call
+    struct iovec vec[ XI_REQUEST_MAX_SEGMENTS ];
+
+    if( count > XI_REQUEST_MAX_SEGMENTS ) { count = XI_REQUEST_MAX_SEGMENTS; }
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        vec[ i ].iov_base   = ( void* ) iov[ i ].data;
+        vec[ i ].iov_len    = iov[ i ].size;
+    }
+
+    int bytes_written = writev( pos_comm_data->socket_fd, vec, count );
 
     if( bytes_written == - 1 )
     {
         xi_set_err( XI_SOCKET_WRITE_ERROR );
+        return -1;
     }
 
     // store the value
     conn->bytes_sent += bytes_written;
+    pos_comm_data->last_activity = posix_get_time();
 
     return bytes_written;
 }
@@ -177,28 +325,112 @@ int posix_read_data( connection_t* conn, char* buffer, size_t buffer_size )
         = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
 
     memset( buffer, 0, buffer_size );
+
+#ifdef XI_TLS_OPENSSL
+    if( pos_comm_data->tls )
+    {
+        int bytes_read = posix_tls_read_data( conn, buffer, buffer_size );
+
+        if( bytes_read == -1 ) { return -1; }
+
+        conn->bytes_received += bytes_read;
+        pos_comm_data->last_activity = posix_get_time();
+
+        return bytes_read;
+    }
+#endif
+
     int bytes_read = read( pos_comm_data->socket_fd, buffer, buffer_size );
 
     if( bytes_read == -1 )
     {
-        xi_set_err( XI_SOCKET_READ_ERROR );
+        // nothing has arrived within the timeout, the connection is fine
+        xi_set_err( errno == EAGAIN || errno == EWOULDBLOCK
+            ? XI_SOCKET_TIMEOUT_ERROR : XI_SOCKET_READ_ERROR );
+        return -1;
     }
 
     // store the value
     conn->bytes_received += bytes_read;
+    pos_comm_data->last_activity = posix_get_time();
 
     return bytes_read;
 }
 
+int posix_is_connection_alive( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+
+    // extract the layer specific data
+    posix_comm_layer_data_specific_t* pos_comm_data
+        = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    // peek without blocking, there should be nothing to read in between
+    // the requests but the updates pushed by the server
+    char c;
+    int r = recv( pos_comm_data->socket_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT );
+
+    // zero means it has been closed by the peer and anything else than
+    // "would block" is an error
+    if( r == 0 ) { return XI_CONNECTION_STALE; }
+    if( r == -1 && errno != EAGAIN && errno != EWOULDBLOCK ) { return XI_CONNECTION_STALE; }
+
+    if( r == 1 )
+    {
+#ifdef XI_TLS_OPENSSL
+        // the records which aren't data are fine, e.g. session tickets
+        r = pos_comm_data->tls
+            ? posix_tls_is_connection_alive( conn ) : XI_CONNECTION_PENDING;
+
+        if( r != XI_CONNECTION_ALIVE ) { return r; }
+#else
+        return XI_CONNECTION_PENDING;
+#endif
+    }
+
+    // the server is likely to have dropped a connection that has been
+    // idle for that long, so it's cheaper to open a new one
+    if( posix_get_time() - pos_comm_data->last_activity
+        > ( time_t ) xi_globals.connection_idle_timeout )
+    {
+        return XI_CONNECTION_STALE;
+    }
+
+    return XI_CONNECTION_ALIVE;
+}
+
+int posix_checkin_connection( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+
+    return posix_connection_pool_checkin( conn );
+}
+
 void posix_close_connection( connection_t* conn )
 {
     // PRECONDITIONS
     assert( conn != 0 );
 
+    posix_connection_pool_forget( conn );
+    posix_destroy_connection( conn );
+}
+
+void posix_destroy_connection( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+
     // extract the layer specific data
     posix_comm_layer_data_specific_t* pos_comm_data
         = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
 
+#ifdef XI_TLS_OPENSSL
+    if( pos_comm_data->tls ) { posix_tls_close( conn ); }
+#endif
+
     // shutdown the communication
     if( shutdown( pos_comm_data->socket_fd, SHUT_RDWR ) == -1 )
     {
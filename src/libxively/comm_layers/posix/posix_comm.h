@@ -10,14 +10,41 @@
 #ifndef __POSIX_COMM_H__
 #define __POSIX_COMM_H__
 
+#include <time.h>
+
 #include "connection.h"
+#include "xi_iovec.h"
 
 connection_t* posix_open_connection( const char* address, int32_t port );
 
+connection_t* posix_open_secure_connection( const char* address, int32_t port );
+
 int posix_send_data( connection_t* conn, const char* data, size_t size );
 
+int posix_send_datav( connection_t* conn, const xi_iovec_t* iov, size_t count );
+
 int posix_read_data( connection_t* conn, char* buffer, size_t buffer_size );
 
+int posix_is_connection_alive( connection_t* conn );
+
+int posix_checkin_connection( connection_t* conn );
+
 void posix_close_connection( connection_t* conn );
 
+// used by the connection pool to manage the actual sockets
+connection_t* posix_create_connection( const char* address, int32_t port, int secure );
+
+/**
+ * \brief   Tells whether the connection is encrypted
+ */
+int posix_is_secure( const connection_t* conn );
+
+void posix_destroy_connection( connection_t* conn );
+
+/**
+ * \brief   Seconds from an arbitrary point, used to track idle connections
+ *          and the age of cached addresses
+ */
+time_t posix_get_time( void );
+
 #endif // __POSIX_COMM_H__
@@ -18,8 +18,19 @@ const comm_layer_t* get_comm_layer()
     {
           &posix_open_connection
         , &posix_send_data
+        , &posix_send_datav
         , &posix_read_data
+        , &posix_is_connection_alive
+        , &posix_checkin_connection
         , &posix_close_connection
+        , 0 // no asynchronous operations
+        , 0
+        , 0
+#ifdef XI_TLS_OPENSSL
+        , &posix_open_secure_connection
+#else
+        , 0 // built without TLS
+#endif
     };
 
     return &__posix_comm_layer;
@@ -10,8 +10,15 @@
 #ifndef __POSIX_COMM_LAYER_DATA_SPECIFIC_H__
 #define __POSIX_COMM_LAYER_DATA_SPECIFIC_H__
 
+#include <time.h>
+
+#include "connection.h"
+
 typedef struct {
-    int socket_fd;
+    int             socket_fd;
+    time_t          last_activity; //!< when the socket was last used, for idle connection eviction
+    connection_t*   next_idle;     //!< next connection on the idle list of the pool
+    void*           tls;           //!< the `SSL` of an encrypted connection, `0` otherwise
 } posix_comm_layer_data_specific_t;
 
 #endif // __POSIX_COMM_LAYER_DATA_SPECIFIC_H__
@@ -0,0 +1,200 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    posix_connection_pool.c
+ * \brief   Pool of keep-alive connections shared by all the contexts
+ *
+ *    A gateway usually serves many feeds from one process and each of them
+ *    has it's own context. Instead of every context keeping a socket open,
+ *    they check a connection out of the pool for the duration of a request
+ *    and check it back in once the reply has been read. The idle connections
+ *    are kept on a list, the most recently used one first, and are reused
+ *    for any request to the same host and port.
+ *
+ *    The limits are taken from `xi_globals` [see xi_set_connection_pool()].
+ *    The pool is locked, as the contexts may run on several threads [see
+ *    xi_create_dispatcher()], but not while a new connection is being opened.
+ */
+
+#include <string.h>
+#if (!defined(XI_COMM_LAYER_POSIX_COMPAT)) || (XI_COMM_LAYER_POSIX_COMPAT == 0)
+#include <pthread.h>
+#define XI_CONNECTION_POOL_LOCKED 1
+#else
+#define XI_CONNECTION_POOL_LOCKED 0
+#endif
+
+#include "posix_connection_pool.h"
+#include "posix_comm.h"
+#include "comm_layer.h"
+#include "posix_comm_layer_data_specific.h"
+#include "xi_globals.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+//!< idle connections, the most recently used one first
+static connection_t* posix_pool_idle = 0;
+
+//!< all the connections opened through the pool, idle or checked out
+static size_t posix_pool_open = 0;
+
+#if XI_CONNECTION_POOL_LOCKED
+static pthread_mutex_t posix_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define POSIX_POOL_LOCK()   pthread_mutex_lock( &posix_pool_mutex )
+#define POSIX_POOL_UNLOCK() pthread_mutex_unlock( &posix_pool_mutex )
+#else
+#define POSIX_POOL_LOCK()
+#define POSIX_POOL_UNLOCK()
+#endif
+
+static inline connection_t** posix_pool_next( connection_t* conn )
+{
+    return &( ( posix_comm_layer_data_specific_t* ) conn->layer_specific )->next_idle;
+}
+
+/**
+ * \brief   Closes all the idle connections that are no longer usable
+ */
+static void posix_pool_sweep( void )
+{
+    connection_t** it = &posix_pool_idle;
+
+    while( *it )
+    {
+        connection_t* conn = *it;
+
+        // nobody would read what's arrived on an idle connection
+        if( posix_is_connection_alive( conn ) == XI_CONNECTION_ALIVE )
+        {
+            it = posix_pool_next( conn );
+            continue;
+        }
+
+        *it = *posix_pool_next( conn );
+        posix_pool_open -= 1;
+        posix_destroy_connection( conn );
+    }
+}
+
+/**
+ * \brief   Closes the least recently used idle connection to make room for
+ *          a new one
+ *
+ * \return  `1` if one has been closed or `0` if there are no idle connections.
+ */
+static int posix_pool_evict( void )
+{
+    connection_t** it = &posix_pool_idle;
+
+    if( *it == 0 ) { return 0; }
+
+    while( *posix_pool_next( *it ) )
+    {
+        it = posix_pool_next( *it );
+    }
+
+    connection_t* conn = *it;
+    *it = 0;
+    posix_pool_open -= 1;
+    posix_destroy_connection( conn );
+
+    return 1;
+}
+
+connection_t* posix_connection_pool_checkout( const char* address, int32_t port, int secure )
+{
+    // PRECONDITIONS
+    assert( address != 0 );
+
+    POSIX_POOL_LOCK();
+
+    posix_pool_sweep();
+
+    connection_t** it = &posix_pool_idle;
+
+    for( ; *it; it = posix_pool_next( *it ) )
+    {
+        connection_t* conn = *it;
+
+        if( conn->port == port && strcmp( conn->address, address ) == 0
+            && posix_is_secure( conn ) == secure )
+        {
+            *it = *posix_pool_next( conn );
+            *posix_pool_next( conn ) = 0;
+
+            POSIX_POOL_UNLOCK();
+
+            xi_debug_logger( "Checked out a pooled connection..." );
+
+            return conn;
+        }
+    }
+
+    if( xi_globals.connection_pool_size
+        && posix_pool_open >= xi_globals.connection_pool_size
+        && !posix_pool_evict() )
+    {
+        POSIX_POOL_UNLOCK();
+        xi_set_err( XI_CONNECTION_POOL_EXHAUSTED );
+        return 0;
+    }
+
+    // the place is taken before connecting, which is done unlocked
+    posix_pool_open += 1;
+
+    POSIX_POOL_UNLOCK();
+
+    connection_t* conn = posix_create_connection( address, port, secure );
+
+    if( conn == 0 )
+    {
+        POSIX_POOL_LOCK();
+        posix_pool_open -= 1;
+        POSIX_POOL_UNLOCK();
+    }
+
+    return conn;
+}
+
+int posix_connection_pool_checkin( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+
+    if( xi_globals.connection_pool_size == 0 ) { return 0; }
+
+    if( xi_globals.connection_max_requests
+        && conn->requests >= xi_globals.connection_max_requests )
+    {
+        xi_debug_logger( "The connection has served enough requests, closing..." );
+
+        POSIX_POOL_LOCK();
+        posix_pool_open -= 1;
+        POSIX_POOL_UNLOCK();
+
+        posix_destroy_connection( conn );
+
+        return 1;
+    }
+
+    POSIX_POOL_LOCK();
+
+    *posix_pool_next( conn ) = posix_pool_idle;
+    posix_pool_idle = conn;
+
+    POSIX_POOL_UNLOCK();
+
+    return 1;
+}
+
+void posix_connection_pool_forget( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( posix_pool_open > 0 );
+
+    POSIX_POOL_LOCK();
+    posix_pool_open -= 1;
+    POSIX_POOL_UNLOCK();
+}
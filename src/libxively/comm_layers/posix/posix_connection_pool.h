@@ -0,0 +1,44 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    posix_connection_pool.h
+ * \brief   Pool of keep-alive connections shared by all the contexts [see posix_connection_pool.c]
+ */
+
+#ifndef __POSIX_CONNECTION_POOL_H__
+#define __POSIX_CONNECTION_POOL_H__
+
+#include "connection.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Checks out an idle connection to the given endpoint or opens a
+ *          new one if there is none
+ *
+ * \return  Pointer to `connection_t` or `0` in case of an error.
+ */
+connection_t* posix_connection_pool_checkout( const char* address, int32_t port, int secure );
+
+/**
+ * \brief   Checks a connection back in, so it can be reused by any context
+ *
+ * \return  `1` if the pool has taken the connection over or `0` if pooling
+ *          is disabled and the caller still owns it.
+ */
+int posix_connection_pool_checkin( connection_t* conn );
+
+/**
+ * \brief   Removes a checked out connection from the pool accounting, must be
+ *          called before the connection is destroyed
+ */
+void posix_connection_pool_forget( connection_t* conn );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __POSIX_CONNECTION_POOL_H__
@@ -0,0 +1,360 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    posix_dns_cache.c
+ * \brief   Caches the addresses of the hosts we connect to [see posix_dns_cache.h]
+ *
+ *    The resolver is only waited for on the first connection to a host.
+ *    Afterwards the cached addresses are used and refreshed by a background
+ *    thread before they expire. Should the refresh fail, the old addresses
+ *    are used for up to another `XI_DNS_CACHE_TTL` seconds and the refresh
+ *    is retried every `XI_DNS_CACHE_NEGATIVE_TTL` seconds. Failed lookups
+ *    are remembered for `XI_DNS_CACHE_NEGATIVE_TTL` seconds too, so a broken
+ *    resolver doesn't stall every request.
+ *
+ * \note    `getaddrinfo()` doesn't tell the TTL of the records, hence the one
+ *          from `xi_config.h` is used.
+ * \note    There are no threads with lwIP, the addresses are refreshed by
+ *          the request that finds them about to expire instead.
+ */
+
+#include <string.h>
+#include <time.h>
+#if (!defined(XI_COMM_LAYER_POSIX_COMPAT)) || (XI_COMM_LAYER_POSIX_COMPAT == 0)
+#include <netdb.h>
+#include <pthread.h>
+#define XI_DNS_CACHE_BACKGROUND_REFRESH 1
+#elif XI_COMM_LAYER_POSIX_COMPAT == 1
+#define LWIP_COMPAT_SOCKETS 1
+#define LWIP_POSIX_SOCKETS_IO_NAMES 1
+#include <lwip/netdb.h>
+#define XI_DNS_CACHE_BACKGROUND_REFRESH 0
+#endif
+
+#include "posix_dns_cache.h"
+#include "xi_time.h"
+#include "xi_allocator.h"
+#include "xi_helpers.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+
+/**
+ * \brief   Seconds from an arbitrary point, the cache is shared with the
+ *          non-blocking layers which don't have `posix_get_time()`
+ */
+static time_t posix_dns_now( void )
+{
+    return ( time_t ) ( xi_get_time_us() / 1000000 );
+}
+
+typedef struct {
+    char                host[ XI_DNS_CACHE_HOST_MAX_SIZE ]; //!< empty if the slot is free
+    posix_dns_address_t addresses[ XI_DNS_CACHE_MAX_ADDRESSES ];
+    size_t              address_count;  //!< `0` if the lookup has failed
+    time_t              expires;        //!< when the addresses should no longer be used
+    time_t              refresh_at;     //!< when a refresh should be started
+    time_t              last_used;
+    int                 refreshing;     //!< a refresh is in progress
+} posix_dns_entry_t;
+
+static posix_dns_entry_t        posix_dns_cache[ XI_DNS_CACHE_SIZE ];
+static posix_dns_cache_stats_t  posix_dns_stats;
+
+#if XI_DNS_CACHE_BACKGROUND_REFRESH
+static pthread_mutex_t posix_dns_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define POSIX_DNS_LOCK()    pthread_mutex_lock( &posix_dns_mutex )
+#define POSIX_DNS_UNLOCK()  pthread_mutex_unlock( &posix_dns_mutex )
+#else
+#define POSIX_DNS_LOCK()
+#define POSIX_DNS_UNLOCK()
+#endif
+
+/**
+ * \brief   Asks the resolver for the addresses of the host, it blocks
+ *
+ * \return  Number of addresses found.
+ */
+static size_t posix_dns_lookup(
+      const char* host
+    , posix_dns_address_t* addresses
+    , size_t max_addresses )
+{
+    struct addrinfo hints;
+    struct addrinfo* result = 0;
+
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family     = AF_UNSPEC;
+    hints.ai_socktype   = SOCK_STREAM;
+
+    if( getaddrinfo( host, 0, &hints, &result ) != 0 ) { return 0; }
+
+    size_t count = 0;
+
+    for( struct addrinfo* it = result; it && count < max_addresses; it = it->ai_next )
+    {
+        if( it->ai_addrlen > sizeof( addresses[ count ].address ) ) { continue; }
+
+        memset( &addresses[ count ], 0, sizeof( posix_dns_address_t ) );
+        memcpy( &addresses[ count ].address, it->ai_addr, it->ai_addrlen );
+        addresses[ count ].size = ( socklen_t ) it->ai_addrlen;
+        count += 1;
+    }
+
+    freeaddrinfo( result );
+
+    return count;
+}
+
+static posix_dns_entry_t* posix_dns_find( const char* host )
+{
+    for( size_t i = 0; i < XI_DNS_CACHE_SIZE; ++i )
+    {
+        if( strcmp( posix_dns_cache[ i ].host, host ) == 0 )
+        {
+            return &posix_dns_cache[ i ];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief   Finds a slot for the host, the least recently used one is
+ *          replaced if there are no free ones
+ */
+static posix_dns_entry_t* posix_dns_slot( const char* host )
+{
+    posix_dns_entry_t* entry = posix_dns_find( host );
+
+    if( entry ) { return entry; }
+
+    entry = &posix_dns_cache[ 0 ];
+
+    for( size_t i = 0; i < XI_DNS_CACHE_SIZE; ++i )
+    {
+        if( posix_dns_cache[ i ].host[ 0 ] == '\0' )
+        {
+            entry = &posix_dns_cache[ i ];
+            break;
+        }
+
+        if( posix_dns_cache[ i ].last_used < entry->last_used )
+        {
+            entry = &posix_dns_cache[ i ];
+        }
+    }
+
+    // a refresh of the old host would find it gone
+    memset( entry, 0, sizeof( posix_dns_entry_t ) );
+    xi_str_copy_untiln( entry->host, sizeof( entry->host ), host, '\0' );
+
+    return entry;
+}
+
+/**
+ * \brief   Stores the result of a lookup, old addresses are kept if it has
+ *          failed and there are any
+ */
+static void posix_dns_store(
+      posix_dns_entry_t* entry
+    , const posix_dns_address_t* addresses
+    , size_t count )
+{
+    time_t now = posix_dns_now();
+
+    entry->refreshing = 0;
+
+    if( count )
+    {
+        memcpy( entry->addresses, addresses, count * sizeof( posix_dns_address_t ) );
+        entry->address_count    = count;
+        entry->expires          = now + XI_DNS_CACHE_TTL;
+        entry->refresh_at       = entry->expires - XI_DNS_CACHE_REFRESH_AHEAD;
+        return;
+    }
+
+    posix_dns_stats.failures += 1;
+
+    // keep the old addresses until they get too stale
+    if( entry->address_count == 0 || now >= entry->expires + XI_DNS_CACHE_TTL )
+    {
+        entry->address_count    = 0;
+        entry->expires          = now + XI_DNS_CACHE_NEGATIVE_TTL;
+    }
+
+    // try again later
+    entry->refresh_at = now + XI_DNS_CACHE_NEGATIVE_TTL;
+}
+
+/**
+ * \brief   Looks the host up again and updates its entry, if it's still cached
+ */
+static void posix_dns_refresh( const char* host )
+{
+    posix_dns_address_t addresses[ XI_DNS_CACHE_MAX_ADDRESSES ];
+
+    size_t count = posix_dns_lookup( host, addresses, XI_DNS_CACHE_MAX_ADDRESSES );
+
+    POSIX_DNS_LOCK();
+
+    posix_dns_entry_t* entry = posix_dns_find( host );
+
+    if( entry ) { posix_dns_store( entry, addresses, count ); }
+
+    POSIX_DNS_UNLOCK();
+}
+
+#if XI_DNS_CACHE_BACKGROUND_REFRESH
+static void* posix_dns_refresh_thread( void* host )
+{
+    posix_dns_refresh( ( const char* ) host );
+    XI_SAFE_FREE( host );
+
+    return 0;
+}
+#endif
+
+/**
+ * \brief   Starts refreshing the entry, it must be called with the lock held
+ */
+static void posix_dns_start_refresh( posix_dns_entry_t* entry )
+{
+    entry->refreshing = 1;
+    posix_dns_stats.refreshes += 1;
+
+#if XI_DNS_CACHE_BACKGROUND_REFRESH
+    char* host = xi_str_dup( entry->host );
+
+    if( host )
+    {
+        pthread_t thread;
+        pthread_attr_t attr;
+
+        pthread_attr_init( &attr );
+        pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+
+        int started = pthread_create( &thread, &attr, &posix_dns_refresh_thread, host ) == 0;
+
+        pthread_attr_destroy( &attr );
+
+        if( started ) { return; }
+
+        XI_SAFE_FREE( host );
+    }
+
+    // it will be retried by the next request
+    entry->refreshing = 0;
+#else
+    char host[ XI_DNS_CACHE_HOST_MAX_SIZE ];
+
+    memcpy( host, entry->host, sizeof( host ) );
+    posix_dns_refresh( host );
+#endif
+}
+
+static size_t posix_dns_copy(
+      const posix_dns_entry_t* entry
+    , int32_t port
+    , posix_dns_address_t* addresses
+    , size_t max_addresses )
+{
+    size_t count = XI_MIN( entry->address_count, max_addresses );
+
+    memcpy( addresses, entry->addresses, count * sizeof( posix_dns_address_t ) );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        if( addresses[ i ].address.sa.sa_family == AF_INET )
+        {
+            addresses[ i ].address.in.sin_port = htons( port );
+        }
+#if (!defined(XI_COMM_LAYER_POSIX_COMPAT)) || (XI_COMM_LAYER_POSIX_COMPAT == 0)
+        else if( addresses[ i ].address.sa.sa_family == AF_INET6 )
+        {
+            addresses[ i ].address.in6.sin6_port = htons( port );
+        }
+#endif
+    }
+
+    return count;
+}
+
+size_t posix_dns_cache_resolve(
+      const char* host
+    , int32_t port
+    , posix_dns_address_t* addresses
+    , size_t max_addresses )
+{
+    // PRECONDITIONS
+    assert( host != 0 );
+    assert( addresses != 0 );
+
+    size_t count    = 0;
+    time_t now      = posix_dns_now();
+
+    POSIX_DNS_LOCK();
+
+    posix_dns_entry_t* entry = posix_dns_find( host );
+
+    // stale addresses are only used for so long
+    if( entry && now < entry->expires
+        + ( entry->address_count ? XI_DNS_CACHE_TTL : 0 ) )
+    {
+        posix_dns_stats.hits += 1;
+        entry->last_used = now;
+
+        if( entry->address_count && now >= entry->refresh_at && !entry->refreshing )
+        {
+            xi_debug_logger( "Refreshing the cached addresses..." );
+            posix_dns_start_refresh( entry );
+        }
+
+        count = posix_dns_copy( entry, port, addresses, max_addresses );
+
+        POSIX_DNS_UNLOCK();
+
+        return count;
+    }
+
+    posix_dns_stats.misses += 1;
+
+    POSIX_DNS_UNLOCK();
+
+    // the resolver may take a while, don't hold the others up
+    xi_debug_logger( "Resolving the address..." );
+
+    posix_dns_address_t found[ XI_DNS_CACHE_MAX_ADDRESSES ];
+
+    size_t found_count = posix_dns_lookup( host, found, XI_DNS_CACHE_MAX_ADDRESSES );
+
+    POSIX_DNS_LOCK();
+
+    entry = posix_dns_slot( host );
+    entry->last_used = now;
+    posix_dns_store( entry, found, found_count );
+
+    count = posix_dns_copy( entry, port, addresses, max_addresses );
+
+    POSIX_DNS_UNLOCK();
+
+    return count;
+}
+
+void posix_dns_cache_get_stats( posix_dns_cache_stats_t* stats )
+{
+    // PRECONDITIONS
+    assert( stats != 0 );
+
+    POSIX_DNS_LOCK();
+    *stats = posix_dns_stats;
+    POSIX_DNS_UNLOCK();
+}
+
+void posix_dns_cache_flush( void )
+{
+    POSIX_DNS_LOCK();
+    memset( posix_dns_cache, 0, sizeof( posix_dns_cache ) );
+    memset( &posix_dns_stats, 0, sizeof( posix_dns_stats ) );
+    POSIX_DNS_UNLOCK();
+}
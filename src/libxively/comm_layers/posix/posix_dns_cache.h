@@ -0,0 +1,83 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    posix_dns_cache.h
+ * \brief   Caches the addresses of the hosts we connect to [see posix_dns_cache.c]
+ */
+
+#ifndef __POSIX_DNS_CACHE_H__
+#define __POSIX_DNS_CACHE_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+#if (!defined(XI_COMM_LAYER_POSIX_COMPAT)) || (XI_COMM_LAYER_POSIX_COMPAT == 0)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#elif XI_COMM_LAYER_POSIX_COMPAT == 1
+#define LWIP_COMPAT_SOCKETS 1
+#define LWIP_POSIX_SOCKETS_IO_NAMES 1
+#include <lwip/sockets.h>
+#endif
+
+#include "xi_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   A single address of a host, ready to be passed to `connect()`
+ */
+typedef struct {
+    union {
+        struct sockaddr     sa;
+        struct sockaddr_in  in;
+#if (!defined(XI_COMM_LAYER_POSIX_COMPAT)) || (XI_COMM_LAYER_POSIX_COMPAT == 0)
+        struct sockaddr_in6 in6;
+#endif
+    } address;
+    socklen_t size;
+} posix_dns_address_t;
+
+/**
+ * \brief   Counters of the cache usage
+ */
+typedef struct {
+    size_t hits;        //!< lookups served from the cache
+    size_t misses;      //!< lookups that had to wait for the resolver
+    size_t refreshes;   //!< refreshes started before the addresses expired
+    size_t failures;    //!< lookups and refreshes the resolver has failed
+} posix_dns_cache_stats_t;
+
+/**
+ * \brief   Gets the addresses of the host with the given port filled in
+ *
+ *    Only the first lookup of a host waits for the resolver. The cached
+ *    addresses are refreshed in the background `XI_DNS_CACHE_REFRESH_AHEAD`
+ *    seconds before their `XI_DNS_CACHE_TTL` runs out, in the meantime, and
+ *    should the resolver be unavailable for a while, the old ones are used.
+ *
+ * \return  Number of addresses stored, `0` if the host couldn't be resolved.
+ */
+size_t posix_dns_cache_resolve(
+      const char* host
+    , int32_t port
+    , posix_dns_address_t* addresses
+    , size_t max_addresses );
+
+/**
+ * \brief   Copies the current counters into `stats`
+ */
+void posix_dns_cache_get_stats( posix_dns_cache_stats_t* stats );
+
+/**
+ * \brief   Forgets all cached addresses and resets the counters
+ */
+void posix_dns_cache_flush( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __POSIX_DNS_CACHE_H__
@@ -0,0 +1,362 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    posix_tls.c
+ * \brief   Encrypts the POSIX connections with OpenSSL [see posix_tls.h]
+ *
+ *    A full handshake costs a couple of round trips and the public key
+ *    operations, which take a long time on small devices. The last session
+ *    of each endpoint is kept (be it a session ID or a ticket) and offered
+ *    by the next connection to it, so that only the first one pays the full
+ *    price. The sessions are kept for `XI_TLS_SESSION_CACHE_SIZE` endpoints,
+ *    the least recently used one makes room for a new one.
+ *
+ *    The sessions are taken from the new session callback, since with
+ *    TLS 1.3 the tickets arrive after the handshake, along with the first
+ *    reply.
+ */
+
+#ifdef XI_TLS_OPENSSL
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "posix_tls.h"
+#include "posix_comm.h"
+#include "comm_layer.h"
+#include "posix_comm_layer_data_specific.h"
+#include "xi_allocator.h"
+#include "xi_helpers.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+typedef struct {
+    char            host[ XI_DNS_CACHE_HOST_MAX_SIZE ]; //!< empty if the slot is free
+    int32_t         port;
+    SSL_SESSION*    session;
+    time_t          last_used;
+} posix_tls_session_t;
+
+static posix_tls_session_t  posix_tls_sessions[ XI_TLS_SESSION_CACHE_SIZE ];
+static SSL_CTX*             posix_tls_ctx = 0;
+
+// the sessions arrive while any context reads its reply
+static pthread_mutex_t posix_tls_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * \return  The slot of the endpoint or, if `create` is set, the one it
+ *          can be stored in, `0` otherwise.
+ */
+static posix_tls_session_t* posix_tls_find_session(
+      const char* host
+    , int32_t port
+    , int create )
+{
+    posix_tls_session_t* lru = &posix_tls_sessions[ 0 ];
+
+    for( size_t i = 0; i < XI_TLS_SESSION_CACHE_SIZE; ++i )
+    {
+        posix_tls_session_t* entry = &posix_tls_sessions[ i ];
+
+        if( entry->port == port && strcmp( entry->host, host ) == 0 )
+        {
+            return entry;
+        }
+
+        if( entry->last_used < lru->last_used ) { lru = entry; }
+    }
+
+    if( !create || strlen( host ) >= XI_DNS_CACHE_HOST_MAX_SIZE ) { return 0; }
+
+    if( lru->session ) { SSL_SESSION_free( lru->session ); }
+
+    memset( lru, 0, sizeof( posix_tls_session_t ) );
+    strcpy( lru->host, host );
+    lru->port = port;
+
+    return lru;
+}
+
+/**
+ * \brief   Keeps the session for the next connection to the endpoint
+ *
+ * \return  `1` as the reference to the session is taken over.
+ */
+static int posix_tls_new_session( SSL* ssl, SSL_SESSION* session )
+{
+    const connection_t* conn = ( const connection_t* ) SSL_get_app_data( ssl );
+
+    pthread_mutex_lock( &posix_tls_mutex );
+
+    posix_tls_session_t* entry
+        = posix_tls_find_session( conn->address, conn->port, 1 );
+
+    if( entry == 0 )
+    {
+        pthread_mutex_unlock( &posix_tls_mutex );
+        return 0;
+    }
+
+    if( entry->session ) { SSL_SESSION_free( entry->session ); }
+
+    entry->session      = session;
+    entry->last_used    = posix_get_time();
+
+    pthread_mutex_unlock( &posix_tls_mutex );
+
+    xi_debug_logger( "Got a TLS session to resume..." );
+
+    return 1;
+}
+
+static SSL_CTX* posix_tls_get_ctx( void )
+{
+    pthread_mutex_lock( &posix_tls_mutex );
+
+    if( posix_tls_ctx == 0 )
+    {
+        SSL_CTX* ctx = SSL_CTX_new( TLS_client_method() );
+
+        if( ctx
+            && SSL_CTX_set_min_proto_version( ctx, TLS1_2_VERSION )
+#ifdef XI_TLS_CA_FILE
+            && SSL_CTX_load_verify_locations( ctx, XI_TLS_CA_FILE, 0 ) )
+#else
+            && SSL_CTX_set_default_verify_paths( ctx ) )
+#endif
+        {
+            SSL_CTX_set_verify( ctx, XI_TLS_VERIFY_PEER
+                ? SSL_VERIFY_PEER : SSL_VERIFY_NONE, 0 );
+
+            // the sessions are kept by us, per endpoint
+            SSL_CTX_set_session_cache_mode( ctx
+                , SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE );
+            SSL_CTX_sess_set_new_cb( ctx, &posix_tls_new_session );
+
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+            // plenty of servers close the connection without the alert
+            SSL_CTX_set_options( ctx, SSL_OP_IGNORE_UNEXPECTED_EOF );
+#endif
+
+            posix_tls_ctx = ctx;
+        }
+        else if( ctx )
+        {
+            SSL_CTX_free( ctx );
+        }
+    }
+
+    pthread_mutex_unlock( &posix_tls_mutex );
+
+    return posix_tls_ctx;
+}
+
+/**
+ * \brief   Turns the result of an OpenSSL call into our error
+ *
+ * \return  `-1` always.
+ */
+static int posix_tls_error( SSL* ssl, int result, xi_err_t err )
+{
+    int ssl_err = SSL_get_error( ssl, result );
+
+    // the socket timeouts surface as a want, the connection is fine
+    if( ssl_err == SSL_ERROR_WANT_READ || ssl_err == SSL_ERROR_WANT_WRITE
+        || ( ssl_err == SSL_ERROR_SYSCALL
+            && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) )
+    {
+        err = XI_SOCKET_TIMEOUT_ERROR;
+    }
+
+    ERR_clear_error();
+    xi_set_err( err );
+
+    return -1;
+}
+
+int posix_tls_connect( connection_t* conn )
+{
+    // PRECONDITIONS
+    assert( conn != 0 );
+    assert( conn->layer_specific != 0 );
+
+    posix_comm_layer_data_specific_t* pos_comm_data
+        = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    SSL_CTX* ctx    = posix_tls_get_ctx();
+    SSL* ssl        = 0;
+
+    XI_CHECK_CND( ctx == 0, XI_TLS_INITIALIZATION_ERROR );
+
+    ssl = SSL_new( ctx );
+
+    XI_CHECK_CND( ssl == 0, XI_TLS_INITIALIZATION_ERROR );
+
+    SSL_set_app_data( ssl, conn );
+
+    // the handshake is a series of small writes (e.g. the finished message of
+    // a resumed session and the request right after it), Nagle would hold
+    // the second one back until the server acknowledges the first
+    {
+        int one = 1;
+        setsockopt( pos_comm_data->socket_fd, IPPROTO_TCP, TCP_NODELAY
+            , ( char* ) &one, sizeof( one ) );
+    }
+
+    // the name is sent for the virtual hosts and checked against the certificate
+    XI_CHECK_CND( SSL_set_fd( ssl, pos_comm_data->socket_fd ) != 1
+        || SSL_set_tlsext_host_name( ssl, conn->address ) != 1
+        || SSL_set1_host( ssl, conn->address ) != 1
+        , XI_TLS_INITIALIZATION_ERROR );
+
+    pthread_mutex_lock( &posix_tls_mutex );
+    {
+        posix_tls_session_t* entry
+            = posix_tls_find_session( conn->address, conn->port, 0 );
+
+        if( entry && entry->session )
+        {
+            SSL_set_session( ssl, entry->session );
+            entry->last_used = posix_get_time();
+        }
+    }
+    pthread_mutex_unlock( &posix_tls_mutex );
+
+    {
+        int r = SSL_connect( ssl );
+
+        if( r != 1 )
+        {
+            xi_debug_printf( "TLS handshake failed: %s\r\n"
+                , ERR_error_string( ERR_peek_error(), 0 ) );
+            ERR_clear_error();
+
+            // a timeout isn't any different here
+            xi_set_err( XI_TLS_HANDSHAKE_ERROR );
+            goto err_handling;
+        }
+    }
+
+    conn->session_resumed   = SSL_session_reused( ssl );
+    pos_comm_data->tls      = ssl;
+
+    xi_debug_logger( conn->session_resumed
+        ? "Resumed the TLS session..." : "Done the full TLS handshake..." );
+
+    return 0;
+
+err_handling:
+    if( ssl ) { SSL_free( ssl ); }
+
+    return -1;
+}
+
+int posix_tls_send_data( connection_t* conn, const char* data, size_t size )
+{
+    posix_comm_layer_data_specific_t* pos_comm_data
+        = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    SSL* ssl    = ( SSL* ) pos_comm_data->tls;
+    int r       = SSL_write( ssl, data, ( int ) size );
+
+    if( r <= 0 ) { return posix_tls_error( ssl, r, XI_SOCKET_WRITE_ERROR ); }
+
+    return r;
+}
+
+int posix_tls_send_datav( connection_t* conn, const xi_iovec_t* iov, size_t count )
+{
+    char record[ XI_TLS_RECORD_BUFFER_SIZE ];
+    size_t size = 0;
+
+    // a segment which doesn't fit goes on its own
+    if( iov[ 0 ].size >= sizeof( record ) )
+    {
+        return posix_tls_send_data( conn, iov[ 0 ].data, iov[ 0 ].size );
+    }
+
+    for( size_t i = 0; i < count && size < sizeof( record ); ++i )
+    {
+        size_t s = XI_MIN( iov[ i ].size, sizeof( record ) - size );
+
+        memcpy( record + size, iov[ i ].data, s );
+        size += s;
+    }
+
+    return posix_tls_send_data( conn, record, size );
+}
+
+int posix_tls_read_data( connection_t* conn, char* buffer, size_t buffer_size )
+{
+    posix_comm_layer_data_specific_t* pos_comm_data
+        = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    SSL* ssl    = ( SSL* ) pos_comm_data->tls;
+    int r       = SSL_read( ssl, buffer, ( int ) buffer_size );
+
+    if( r > 0 ) { return r; }
+
+    // the server has closed the connection, cleanly or not
+    if( SSL_get_error( ssl, r ) == SSL_ERROR_ZERO_RETURN
+        || ( SSL_get_error( ssl, r ) == SSL_ERROR_SYSCALL && errno == 0 ) )
+    {
+        ERR_clear_error();
+        return 0;
+    }
+
+    return posix_tls_error( ssl, r, XI_SOCKET_READ_ERROR );
+}
+
+int posix_tls_is_connection_alive( connection_t* conn )
+{
+    posix_comm_layer_data_specific_t* pos_comm_data
+        = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    SSL* ssl    = ( SSL* ) pos_comm_data->tls;
+    int flags   = fcntl( pos_comm_data->socket_fd, F_GETFL );
+
+    if( flags == -1 ) { return XI_CONNECTION_STALE; }
+    if( SSL_pending( ssl ) > 0 ) { return XI_CONNECTION_PENDING; }
+
+    // whatever records have arrived are processed without blocking, only
+    // the application data is left to be read
+    fcntl( pos_comm_data->socket_fd, F_SETFL, flags | O_NONBLOCK );
+
+    char c;
+    int r       = SSL_peek( ssl, &c, 1 );
+    int state   = r > 0 ? XI_CONNECTION_PENDING
+        : SSL_get_error( ssl, r ) == SSL_ERROR_WANT_READ
+        ? XI_CONNECTION_ALIVE : XI_CONNECTION_STALE;
+
+    fcntl( pos_comm_data->socket_fd, F_SETFL, flags );
+    ERR_clear_error();
+
+    return state;
+}
+
+void posix_tls_close( connection_t* conn )
+{
+    posix_comm_layer_data_specific_t* pos_comm_data
+        = ( posix_comm_layer_data_specific_t* ) conn->layer_specific;
+
+    SSL* ssl = ( SSL* ) pos_comm_data->tls;
+
+    // the session stays resumable only if the connection is closed properly
+    SSL_shutdown( ssl );
+    SSL_free( ssl );
+    ERR_clear_error();
+
+    pos_comm_data->tls = 0;
+}
+
+#endif // XI_TLS_OPENSSL
@@ -0,0 +1,57 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    posix_tls.h
+ * \brief   Encrypts the POSIX connections with OpenSSL [see posix_tls.c]
+ *
+ *    It's only built with `XI_TLS=openssl`, which defines `XI_TLS_OPENSSL`.
+ */
+
+#ifndef __POSIX_TLS_H__
+#define __POSIX_TLS_H__
+
+#include "connection.h"
+#include "xi_iovec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Runs the TLS handshake over the connected socket, the session
+ *          last used with the endpoint is offered to be resumed
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+int posix_tls_connect( connection_t* conn );
+
+int posix_tls_send_data( connection_t* conn, const char* data, size_t size );
+
+/**
+ * \brief   The segments are gathered into as few records as possible, as
+ *          each `SSL_write()` makes a record of its own
+ */
+int posix_tls_send_datav( connection_t* conn, const xi_iovec_t* iov, size_t count );
+
+int posix_tls_read_data( connection_t* conn, char* buffer, size_t buffer_size );
+
+/**
+ * \brief   Tells whether the socket, known to be readable, only had the
+ *          records the server sends on their own in between the requests
+ *          (e.g. TLS 1.3 session tickets) or some data
+ *
+ * \return  One of `xi_connection_state_t`.
+ */
+int posix_tls_is_connection_alive( connection_t* conn );
+
+/**
+ * \brief   Sends the closure alert and frees the TLS state of the connection
+ */
+void posix_tls_close( connection_t* conn );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __POSIX_TLS_H__
@@ -16,6 +16,7 @@
 #define __CONNECTION_H__
 
 #include "stdlib.h"
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,6 +41,9 @@ typedef struct {
     int      port;           //!< here we store server's port
     size_t   bytes_sent;     //!< the data sent counter, just for testing and statistics
     size_t   bytes_received; //!< the data receive counter, just for tests and statistics
+    size_t   requests;       //!< how many requests have been sent over this connection
+    int      session_resumed; //!< the TLS handshake has resumed an earlier session
+    uint32_t dns_us;         //!< how long resolving the address has taken in microseconds, if the layer tells
 } connection_t;
 
 #ifdef __cplusplus
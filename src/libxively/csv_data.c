@@ -9,15 +9,20 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <float.h>
 
 #include "csv_data.h"
+#include "xi_fmt.h"
+#include "xi_iso8601.h"
+#include "xi_scan.h"
 #include "xi_macros.h"
 #include "xi_helpers.h"
 #include "xi_debug.h"
 #include "xi_err.h"
 #include "xi_config.h"
 
-static char XI_CSV_LOCAL_BUFFER[ XI_CSV_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_CSV_LOCAL_BUFFER[ XI_CSV_BUFFER_SIZE ];
 
 inline static int csv_encode_value(
       char* buffer
@@ -32,9 +37,9 @@ inline static int csv_encode_value(
     switch( p->value_type )
     {
         case XI_VALUE_TYPE_I32:
-            return snprintf( buffer, buffer_size, "%d", p->value.i32_value );
+            return xi_fmt_i32( buffer, buffer_size, p->value.i32_value );
         case XI_VALUE_TYPE_F32:
-            return snprintf( buffer, buffer_size, "%f", p->value.f32_value );
+            return xi_fmt_f32( buffer, buffer_size, p->value.f32_value );
         case XI_VALUE_TYPE_STR:
             return snprintf( buffer, buffer_size, "%s", p->value.str_value );
         default:
@@ -46,65 +51,11 @@ typedef enum
 {
     XI_CHAR_UNKNOWN = 0,
     XI_CHAR_NUMBER,
-    XI_CHAR_LETTER,
     XI_CHAR_DOT,
-    XI_CHAR_SPACE,
-    XI_CHAR_NEWLINE,
-    XI_CHAR_TAB,
-    XI_CHAR_MINUS
+    XI_CHAR_MINUS,
+    XI_CHAR_NEWLINE
 } xi_char_type_t;
 
-inline static xi_char_type_t csv_classify_char( char c )
-{
-    switch( c )
-    {
-        case 13:
-        case 11:
-            return XI_CHAR_NEWLINE;
-        case 9:
-            return XI_CHAR_TAB;
-        case 32:
-            return XI_CHAR_SPACE;
-        case 33: case 34: case 35: case 36: case 37: case 38: case 39:
-        case 40: case 41: case 42: case 43: case 44:
-            return XI_CHAR_UNKNOWN;
-        case 45:
-            return XI_CHAR_MINUS;
-        case 46:
-            return XI_CHAR_DOT;
-        case 47:
-            return XI_CHAR_UNKNOWN;
-        case 48: case 49: case 50: case 51: case 52: case 53: case 54:
-        case 55: case 56:
-        case 57:
-            return XI_CHAR_NUMBER;
-        case 58: case 59: case 60: case 61: case 62: case 63:
-        case 64:
-            return XI_CHAR_UNKNOWN;
-        case 65: case 66: case 67: case 68: case 69: case 70: case 71:
-        case 72: case 73: case 74: case 75: case 76: case 77: case 78:
-        case 79: case 80: case 81: case 82: case 83: case 84: case 85:
-        case 86: case 87: case 88: case 89:
-        case 90:
-            return XI_CHAR_LETTER;
-        case 91: case 92: case 93: case 94: case 95:
-        case 96:
-            return XI_CHAR_UNKNOWN;
-        case 97: case 98: case 99: case 100: case 101: case 102: case 103:
-        case 104: case 105: case 106: case 107: case 108: case 109: case 110:
-        case 111: case 112: case 113: case 114: case 115: case 116: case 117:
-        case 118: case 119: case 120: case 121:
-        case 122:
-            return XI_CHAR_LETTER;
-        case 123:
-        case 124:
-        case 125:
-            return XI_CHAR_UNKNOWN;
-        default:
-            return XI_CHAR_UNKNOWN;
-    }
-}
-
 typedef enum
 {
     XI_STATE_INITIAL = 0,
@@ -112,9 +63,67 @@ typedef enum
     XI_STATE_NUMBER,
     XI_STATE_FLOAT,
     XI_STATE_DOT,
-    XI_STATE_STRING
+    XI_STATE_STRING,
+    XI_STATE_COUNT
 } xi_dfa_state_t;
 
+// the rules of the value, the tables below are expanded from them by the
+// preprocessor: `-?[0-9]+` is an integer, `-?[0-9]*\.[0-9]+` a float and
+// anything else a string, the value ends with the line or the text
+#define XI_CSV_CLASS( c ) \
+    ( ( c ) >= '0' && ( c ) <= '9'                  ? XI_CHAR_NUMBER \
+    : ( c ) == '.'                                  ? XI_CHAR_DOT \
+    : ( c ) == '-'                                  ? XI_CHAR_MINUS \
+    : ( c ) == '\n' || ( c ) == '\r' || ( c ) == 0  ? XI_CHAR_NEWLINE \
+    : XI_CHAR_UNKNOWN )
+
+#define XI_CSV_NEXT( s, ct ) \
+    ( ( ct ) == XI_CHAR_NUMBER \
+        ? ( ( s ) == XI_STATE_DOT || ( s ) == XI_STATE_FLOAT ? XI_STATE_FLOAT \
+          : ( s ) == XI_STATE_STRING ? XI_STATE_STRING : XI_STATE_NUMBER ) \
+    : ( ct ) == XI_CHAR_DOT \
+        ? ( ( s ) == XI_STATE_INITIAL || ( s ) == XI_STATE_MINUS \
+            || ( s ) == XI_STATE_NUMBER ? XI_STATE_DOT : XI_STATE_STRING ) \
+    : ( ct ) == XI_CHAR_MINUS \
+        ? ( ( s ) == XI_STATE_INITIAL ? XI_STATE_MINUS : XI_STATE_STRING ) \
+    : XI_STATE_STRING )
+
+#define XI_CSV_CLASS_4( c ) \
+    XI_CSV_CLASS( c ), XI_CSV_CLASS( c + 1 ), XI_CSV_CLASS( c + 2 ), XI_CSV_CLASS( c + 3 )
+#define XI_CSV_CLASS_16( c ) \
+    XI_CSV_CLASS_4( c ), XI_CSV_CLASS_4( c + 4 ), XI_CSV_CLASS_4( c + 8 ), XI_CSV_CLASS_4( c + 12 )
+#define XI_CSV_CLASS_64( c ) \
+    XI_CSV_CLASS_16( c ), XI_CSV_CLASS_16( c + 16 ), XI_CSV_CLASS_16( c + 32 ), XI_CSV_CLASS_16( c + 48 )
+
+#define XI_CSV_NEXT_ROW( s ) \
+    { XI_CSV_NEXT( s, XI_CHAR_UNKNOWN ), XI_CSV_NEXT( s, XI_CHAR_NUMBER ) \
+    , XI_CSV_NEXT( s, XI_CHAR_DOT ), XI_CSV_NEXT( s, XI_CHAR_MINUS ) }
+
+//! the class of each character, indexed by its unsigned value
+static const uint8_t XI_CSV_CLASSES[ 256 ] =
+{
+      XI_CSV_CLASS_64( 0 ), XI_CSV_CLASS_64( 64 )
+    , XI_CSV_CLASS_64( 128 ), XI_CSV_CLASS_64( 192 )
+};
+
+//! the transition function, the newline ends the value before it's looked up
+static const uint8_t XI_CSV_STATES[ XI_STATE_COUNT ][ XI_CHAR_NEWLINE ] =
+{
+      XI_CSV_NEXT_ROW( XI_STATE_INITIAL )
+    , XI_CSV_NEXT_ROW( XI_STATE_MINUS )
+    , XI_CSV_NEXT_ROW( XI_STATE_NUMBER )
+    , XI_CSV_NEXT_ROW( XI_STATE_FLOAT )
+    , XI_CSV_NEXT_ROW( XI_STATE_DOT )
+    , XI_CSV_NEXT_ROW( XI_STATE_STRING )
+};
+
+//! the powers of ten which are exact as doubles
+static const double XI_CSV_POW10[] =
+{
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11
+    , 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
 xi_datapoint_t* csv_decode_value(
     const char* buffer, xi_datapoint_t* p )
 {
@@ -125,77 +134,73 @@ xi_datapoint_t* csv_decode_value(
     // secure the output buffer
     XI_GUARD_EOS( p->value.str_value, XI_VALUE_STRING_MAX_SIZE );
 
-    // clean the counter
-    size_t  counter = 0;
+    const char* c       = buffer;
+    uint8_t     s       = XI_STATE_INITIAL;
+    uint8_t     ct      = 0;
 
-    // the transition function
-    static const short states[][6][2] =
-    {
-          // state initial                          // state minus                            // state number                           // state float                            // state dot                              // string
-        { { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  }, { XI_CHAR_UNKNOWN   , XI_STATE_STRING  } },
-        { { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_NUMBER  }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT   }, { XI_CHAR_NUMBER    , XI_STATE_FLOAT   }, { XI_CHAR_NUMBER    , XI_STATE_STRING  } },
-        { { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  }, { XI_CHAR_LETTER    , XI_STATE_STRING  } },
-        { { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_DOT     }, { XI_CHAR_DOT       , XI_STATE_STRING  }, { XI_CHAR_DOT       , XI_STATE_STRING  }, { XI_CHAR_DOT       , XI_STATE_STRING  } },
-        { { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  }, { XI_CHAR_SPACE     , XI_STATE_STRING  } },
-        { { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL }, { XI_CHAR_NEWLINE   , XI_STATE_INITIAL } },
-        { { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  }, { XI_CHAR_TAB       , XI_STATE_STRING  } },
-        { { XI_CHAR_MINUS     , XI_STATE_MINUS   }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  }, { XI_CHAR_MINUS     , XI_STATE_STRING  } }
-    };
-
-    char    c = *buffer;
-    short   s = XI_STATE_INITIAL;
-
-    while( c != '\n' && c !='\0' && c!='\r' )
-    {
-        if( counter >= XI_VALUE_STRING_MAX_SIZE - 1 )
-        {
-            xi_set_err( XI_DATAPOINT_VALUE_BUFFER_OVERFLOW );
-            return 0;
-        }
+    // the digits are added up while the value still may be a number
+    uint64_t    digits      = 0;
+    size_t      count       = 0;
+    size_t      fraction    = 0;
 
-        xi_char_type_t ct = csv_classify_char( c );
-        s = states[ ct ][ s ][ 1 ];
+    while( s != XI_STATE_STRING
+        && ( ct = XI_CSV_CLASSES[ ( unsigned char ) *c ] ) != XI_CHAR_NEWLINE )
+    {
+        s = XI_CSV_STATES[ s ][ ct ];
 
-        switch( s )
+        if( ct == XI_CHAR_NUMBER )
         {
-            case XI_STATE_MINUS:
-            case XI_STATE_NUMBER:
-            case XI_STATE_FLOAT:
-            case XI_STATE_DOT:
-            case XI_STATE_STRING:
-                p->value.str_value[ counter ] = c;
-                break;
+            digits      = digits * 10 + ( uint64_t ) ( *c - '0' );
+            count      += 1;
+            fraction   += ( s == XI_STATE_FLOAT );
         }
 
-        c = *( ++buffer );
-        ++counter;
+        ++c;
     }
 
-    // set the guard
-    p->value.str_value[ counter ] = '\0';
+    // the rest of the string is only looked through for its end
+    while( XI_CSV_CLASSES[ ( unsigned char ) *c ] != XI_CHAR_NEWLINE ) { ++c; }
 
-    // update of the state for loose states...
-    switch( s )
+    const size_t size = c - buffer;
+
+    if( size > XI_VALUE_STRING_MAX_SIZE - 1 )
     {
-        case XI_STATE_MINUS:
-        case XI_STATE_DOT:
-        case XI_STATE_INITIAL:
-            s = XI_STATE_STRING;
-            break;
+        xi_set_err( XI_DATAPOINT_VALUE_BUFFER_OVERFLOW );
+        return 0;
     }
 
+    const int negative = ( buffer[ 0 ] == '-' );
+
     switch( s )
     {
         case XI_STATE_NUMBER:
-            p->value.i32_value  = atoi( p->value.str_value );
+            // longer ones are left to the libc, to overflow the way it does
+            p->value.i32_value  = count <= 9
+                ? ( negative ? -( int32_t ) digits : ( int32_t ) digits )
+                : atoi( buffer );
             p->value_type       = XI_VALUE_TYPE_I32;
             break;
         case XI_STATE_FLOAT:
-            p->value.f32_value  = ( float ) atof( p->value.str_value );
+            // the digits and the power of ten are exact as doubles, so their
+            // quotient is rounded once, as atof rounds, unless the division
+            // is done in a wider type and rounded twice
+#if defined( FLT_EVAL_METHOD ) && FLT_EVAL_METHOD == 0
+            if( count <= 15 && fraction <= 22 )
+            {
+                const double value  = ( double ) digits / XI_CSV_POW10[ fraction ];
+                p->value.f32_value  = ( float ) ( negative ? -value : value );
+            }
+            else
+#endif
+            {
+                p->value.f32_value  = ( float ) atof( buffer );
+            }
             p->value_type       = XI_VALUE_TYPE_F32;
             break;
-        case XI_STATE_STRING:
         default:
+            // with a loose minus or dot, or nothing at all, it's a string too
+            memcpy( p->value.str_value, buffer, size );
+            p->value.str_value[ size ] = '\0';
             p->value_type       = XI_VALUE_TYPE_STR;
     }
 
@@ -225,20 +230,11 @@ int csv_encode_datapoint_in_place(
 
     if( datapoint->timestamp.timestamp != 0 )
     {
-        xi_time_t stamp = datapoint->timestamp.timestamp;
-        struct xi_tm* gmtinfo = xi_gmtime( &stamp );
-
-        s = snprintf( in, size
-            , "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ,"
-            , gmtinfo->tm_year + 1900
-            , gmtinfo->tm_mon + 1
-            , gmtinfo->tm_mday
-            , gmtinfo->tm_hour
-            , gmtinfo->tm_min
-            , gmtinfo->tm_sec
-            , ( int ) datapoint->timestamp.micro );
-
+        s = xi_iso8601_encode( in, size, &datapoint->timestamp );
         XI_CHECK_S( s, size, offset, XI_CSV_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+
+        XI_CHECK_CND( size - offset < 2, XI_CSV_ENCODE_DATAPOINT_BUFFER_OVERRUN );
+        in[ offset++ ] = ',';
     }
 
     s = csv_encode_value( in + offset, size - offset, datapoint );
@@ -277,47 +273,99 @@ err_handling:
     return 0;
 }
 
+int csv_encode_feed_in_place(
+      char* in, size_t in_size
+    , const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( in != 0 );
+    assert( feed != 0 );
+
+    int s       = 0;
+    int size    = in_size;
+    int offset  = 0;
+
+    // each datapoint of each datastream goes on its own line
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
+
+        for( size_t j = 0; j < curr_datastream->datapoint_count; ++j )
+        {
+            s = snprintf( in + offset, size - offset
+                , "%s,", curr_datastream->datastream_id );
+            XI_CHECK_S( s, size, offset, XI_CSV_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+
+            s = csv_encode_datapoint_in_place( in + offset, size - offset
+                , &curr_datastream->datapoints[ j ] );
+            XI_CHECK_S( s, size, offset, XI_CSV_ENCODE_DATASTREAM_BUFFER_OVERRUN );
+        }
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
 xi_feed_t* csv_decode_feed(
       const char* buffer
+    , size_t buffer_size
     , xi_feed_t* feed )
 {
     const char* current     = buffer;
+    const char* end         = buffer + buffer_size;
     int32_t counter         = 0;
 
-    // find occurence of newline
-    char* end_of_line = ( char* ) 1;
+    // a single scan finds the commas and the ends of the lines
+    xi_scan_t scan;
+    xi_scan_init( &scan, buffer, buffer_size, ',', '\n' );
 
-    // while we didn't jump out of the buffer
-    while( end_of_line )
+    // a datastream per line, the last one doesn't have to be terminated
+    while( current < end && *current != '\0' )
     {
+        XI_CHECK_CND( counter == XI_MAX_DATASTREAMS
+            , XI_CSV_DECODE_FEED_PARSER_ERROR );
+
         // get current datapoint
         xi_datastream_t* d    = &feed->datastreams[ counter ];
         d->datapoint_count    = 0;
         xi_datapoint_t* p     = &d->datapoints[ 0 ];
         memset( p, 0, sizeof( xi_datapoint_t ) );
 
-        end_of_line = strstr( current, "\n" );
+        const char* end_of_datastream_id = xi_scan_next( &scan );
+
+        XI_CHECK_CND( end_of_datastream_id == end || *end_of_datastream_id != ','
+            , XI_CSV_DECODE_FEED_PARSER_ERROR );
+
+        {
+            int size = sizeof( d->datastream_id );
 
-        const char* end_of_datastream_id  = strstr( current, "," );
-        const char* beg_of_datapoint      = end_of_datastream_id + 1;
+            XI_CHECK_CND( end_of_datastream_id - current > size - 1
+                , XI_CSV_DECODE_FEED_PARSER_ERROR );
 
-        XI_CHECK_ZERO( beg_of_datapoint, XI_CSV_DECODE_FEED_PARSER_ERROR );
-        XI_CHECK_ZERO( end_of_datastream_id, XI_CSV_DECODE_FEED_PARSER_ERROR );
+            memcpy( d->datastream_id, current, end_of_datastream_id - current );
+            d->datastream_id[ end_of_datastream_id - current ] = '\0';
+        }
 
-        int size = sizeof( d->datastream_id );
+        // the rest of the line is the datapoint, the commas in it are passed
+        const char* beg_of_datapoint    = end_of_datastream_id + 1;
+        const char* end_of_line         = xi_scan_next( &scan );
 
-        int s = xi_str_copy_untiln( d->datastream_id, size
-            , current, ',' );
-        XI_CHECK_SIZE( s, size, XI_CSV_DECODE_FEED_PARSER_ERROR );
+        while( end_of_line != end && *end_of_line == ',' )
+        {
+            end_of_line = xi_scan_next( &scan );
+        }
 
-        xi_datapoint_t* ret = csv_decode_datapoint( beg_of_datapoint, p );
+        xi_datapoint_t* ret = csv_decode_datapoint( beg_of_datapoint
+            , end_of_line - beg_of_datapoint, p );
         XI_CHECK_ZERO( ret, XI_CSV_DECODE_FEED_PARSER_ERROR )
 
         d->datapoint_count = 1;
-        current = end_of_line + 1;
+        ++counter;
 
-        XI_CHECK_CND( ++counter == XI_MAX_DATASTREAMS
-            , XI_CSV_DECODE_FEED_PARSER_ERROR );
+        current = ( end_of_line == end || *end_of_line == '\0' )
+            ? end_of_line : end_of_line + 1;
     }
 
     feed->datastream_count = counter;
@@ -329,58 +377,85 @@ err_handling:
 
 xi_datapoint_t* csv_decode_datapoint(
       const char* buffer
+    , size_t buffer_size
     , xi_datapoint_t* datapoint )
 {
     // PRECONDITIONS
     assert( buffer != 0 );
     assert( datapoint != 0 );
 
-    int ye, mo, da, h, m, s, ms;
+    int s = xi_iso8601_decode( buffer, buffer_size, &datapoint->timestamp );
 
-    const char* beg_of_value = strstr( buffer, "," );
+    XI_CHECK_CND( s == -2, XI_CSV_TIME_CONVERTION_ERROR );
 
-    // check continuation condition
-    XI_CHECK_ZERO( beg_of_value, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+    // the timestamps are written in full, with the microseconds and the zone
+    XI_CHECK_CND( s < 0 || buffer[ s - 1 ] != 'Z'
+        || ( size_t ) s >= buffer_size || buffer[ s ] != ','
+        , XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
 
-    // move to pointer to the proper position
-    beg_of_value += 1;
+    const char* beg_of_value = buffer + s + 1;
 
-    {
-        int n = sscanf( buffer
-            , "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ"
-            , &ye, &mo, &da, &h, &m, &s, &ms );
+    xi_datapoint_t* r = csv_decode_value( beg_of_value
+        , datapoint );
 
-        // check if the parser worked correctly
-        XI_CHECK_CND( n != 7, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
 
-        // copy parsed data
-        {
-            struct xi_tm timeinfo;
+    XI_CHECK_ZERO( r, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
 
-            timeinfo.tm_year   = ye - 1900;
-            timeinfo.tm_mon    = mo - 1;
-            timeinfo.tm_mday   = da;
-            timeinfo.tm_hour   = h;
-            timeinfo.tm_min    = m;
-            timeinfo.tm_sec    = s;
+    return datapoint;
 
-            xi_time_t timestamp = xi_mktime( &timeinfo );
+err_handling:
+    return 0;
+}
 
-            XI_CHECK_CND( ( int )timestamp == -1, XI_CSV_TIME_CONVERTION_ERROR );
+long csv_decode_datastream_history(
+      const char* buffer
+    , size_t buffer_size
+    , xi_datastream_t* datastream )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datastream != 0 );
+
+    const char* current = buffer;
+    const char* end     = buffer + buffer_size;
+    long total          = 0;
+
+    datastream->datapoint_count = 0;
 
-            datapoint->timestamp.timestamp  = timestamp;
-            datapoint->timestamp.micro      = ms;
+    // a datapoint per line, the last one doesn't have to be terminated
+    while( current < end )
+    {
+        const char* end_of_line = memchr( current, '\n', end - current );
+        const char* next        = end_of_line ? end_of_line + 1 : end;
+
+        if( *current == '\n' || *current == '\r' )
+        {
+            current = next;
+            continue;
         }
-    }
 
-    xi_datapoint_t* r = csv_decode_value( beg_of_value
-        , datapoint );
+        // the lines past the room in the datastream are only counted
+        if( datastream->datapoint_count < XI_MAX_DATAPOINTS )
+        {
+            xi_datapoint_t* p = &datastream->datapoints[ datastream->datapoint_count ];
 
+            memset( p, 0, sizeof( xi_datapoint_t ) );
 
-    XI_CHECK_ZERO( r, XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+            XI_CHECK_ZERO( memchr( current, ',', next - current )
+                , XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
 
-    return datapoint;
+            XI_CHECK_ZERO( csv_decode_datapoint( current, next - current, p )
+                , XI_CSV_DECODE_DATAPOINT_PARSER_ERROR );
+
+            datastream->datapoint_count += 1;
+        }
+
+        total   += 1;
+        current  = next;
+    }
+
+    return total;
 
 err_handling:
-    return 0;
+    return -1;
 }
@@ -27,11 +27,30 @@ const char* csv_encode_create_datastream(
           const char* buffer
         , const xi_datapoint_t* dp );
 
+int csv_encode_feed_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_feed_t* feed );
+
 xi_feed_t* csv_decode_feed(
       const char* buffer
+    , size_t buffer_size
     , xi_feed_t* feed );
 
-xi_datapoint_t* csv_decode_datapoint( const char* data, xi_datapoint_t* dp );
+xi_datapoint_t* csv_decode_datapoint(
+      const char* data
+    , size_t data_size
+    , xi_datapoint_t* dp );
+
+long csv_decode_datastream_history(
+      const char* data
+    , size_t data_size
+    , xi_datastream_t* datastream );
+
+/**
+ * \brief   Tells the type of the value from its text and stores it, the
+ *          text ends with the line
+ */
+xi_datapoint_t* csv_decode_value( const char* buffer, xi_datapoint_t* p );
 
 #ifdef __cplusplus
 }
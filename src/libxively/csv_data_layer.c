@@ -7,6 +7,8 @@
  * \brief 	Implements CSV _data layer_ abstration interface [see csv_data_layer.h and data_layer.h]
  */
 
+#include <string.h>
+
 #include "csv_data_layer.h"
 
 const data_layer_t* get_csv_data_layer()
@@ -15,8 +17,13 @@ const data_layer_t* get_csv_data_layer()
           csv_encode_datapoint
         , csv_encode_datapoint_in_place
         , csv_encode_create_datastream
+        , csv_encode_feed_in_place
+        , strlen
         , csv_decode_feed
         , csv_decode_datapoint
+        , csv_decode_datastream_history
+        , "csv"
+        , "text/plain"
     };
 
     return &__csv_data_layer;
@@ -22,15 +22,13 @@ extern "C" {
  *    * All encoders take a given data type (e.g. `xi_feed_t`, `xi_datapoint_t`) and produce
  *    an encoded string in a buffer, which can be wrapped as payload to _transport layer_
  *    or any other layer, such as _gzip_.
- *    * All decoders take a given data buffer and convert to an appropriate data type.
+ *    * All decoders take a given data buffer and its size and convert to an appropriate
+ *    data type, the size is what tells where binary data ends.
  *
- * \note    The encoders and decoders do not have to be paired, e.g. `encode_feed` is actually
- *          implemented using `encode_datapoint_in_place` in a loop (see `http_encode_update_feed`),
- *          so we only need `decode_feed`. However, this presumption had been made with CSV _data_
- *          _layer_ implementation and the interface may need to change if other data formats are
- *          to be implemented, but it is currently more important to have it the way it is.
- *          The layering model should allow for simple way of integrating anything, even if there
- *          might seem to be some inconsistency right now.
+ * \note    The encoders and decoders do not have to be paired, e.g. there's no `encode_datastream`
+ *          nor `decode_create_datastream`. The feed used to be encoded by the _transport layer_ out
+ *          of `encode_datapoint_in_place` in a loop, which only works for line based formats, such
+ *          as CSV, so it's been given its own encoder once JSON came along.
  */
 typedef struct {
     /**
@@ -61,13 +59,33 @@ typedef struct {
           const char* data
         , const xi_datapoint_t* dp );
 
+    /**
+     * \brief   This function converts the datapoints of all the datastreams of `xi_feed_t`
+     *          into an implementation-specific format for a feed with output buffer given
+     *          as an argument.
+     *
+     * \return  Offset or -1 if an error occurred.
+     */
+    int ( *encode_feed_in_place )(
+          char* buffer, size_t buffer_size
+        , const xi_feed_t* feed );
+
+    /**
+     * \brief   Measures what `encode_datapoint` or `encode_create_datastream` have returned,
+     *          the text formats are terminated, so it's `strlen`, the binary ones may
+     *          contain zeros, so they have to walk the encoded item.
+     *
+     * \return  Number of bytes of the encoded data.
+     */
+    size_t ( *encoded_size )( const char* data );
+
     /**
      * \brief   This function converts from an implementation-specific format for a feed
      *          into `xi_feed_t` that is given as an argument.
      *
      * \return  Pointer to feed structure or null if an error occurred.
      */
-    xi_feed_t* ( *decode_feed )( const char* data, xi_feed_t* feed );
+    xi_feed_t* ( *decode_feed )( const char* data, size_t data_size, xi_feed_t* feed );
 
     /**
      * \brief   This function converts from an implementation-specific format for a datapoint
@@ -76,7 +94,26 @@ typedef struct {
      * \return  Pointer to datastream structure or null if an error occurred.
 
      */
-    xi_datapoint_t* ( *decode_datapoint )( const char* data, xi_datapoint_t* dp );
+    xi_datapoint_t* ( *decode_datapoint )(
+          const char* data
+        , size_t data_size
+        , xi_datapoint_t* dp );
+
+    /**
+     * \brief   This function converts from an implementation-specific format for the history
+     *          of a datastream into the datapoints of `xi_datastream_t`, oldest first, as many
+     *          of them as there is room for.
+     *
+     * \return  Number of the datapoints in the data, more than `datapoint_count` if they haven't
+     *          all fit, or -1 if an error occurred.
+     */
+    long ( *decode_datastream_history )(
+          const char* data
+        , size_t data_size
+        , xi_datastream_t* datastream );
+
+    const char* format; //!< the extension of the resources in that format, e.g. `csv`
+    const char* content_type; //!< the media type of the bodies that are sent
 } data_layer_t;
 
 #ifdef __cplusplus
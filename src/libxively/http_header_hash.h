@@ -0,0 +1,56 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    http_header_hash.h
+ * \brief   The perfect hash of the known HTTP headers, generated by
+ *          `make -C src http_headers` [see src/tools/http_header_hash.c]
+ */
+
+#ifndef __HTTP_HEADER_HASH_H__
+#define __HTTP_HEADER_HASH_H__
+
+#define XI_HTTP_HEADER_HASH_SIZE       17
+#define XI_HTTP_HEADER_HASH_LENGTH     16
+#define XI_HTTP_HEADER_HASH_FIRST      1
+
+//! the header in each slot of the hash
+static const unsigned char XI_HTTP_HEADER_HASH_SLOTS[ XI_HTTP_HEADER_HASH_SIZE ] =
+{
+      12
+    ,  1  // content-type
+    ,  2  // content-length
+    , 12
+    ,  4  // x-request-id
+    , 12
+    ,  7  // count
+    ,  5  // cache-control
+    ,  8  // age
+    , 12
+    ,  0  // date
+    , 12
+    ,  3  // connection
+    , 11  // etag
+    ,  6  // vary
+    ,  9  // transfer-encoding
+    , 10  // content-encoding
+};
+
+//! the names of the headers, case folded
+static const char* const XI_HTTP_HEADER_NAMES[ XI_HTTP_HEADER_UNKNOWN ] =
+{
+      "date"
+    , "content-type"
+    , "content-length"
+    , "connection"
+    , "x-request-id"
+    , "cache-control"
+    , "vary"
+    , "count"
+    , "age"
+    , "transfer-encoding"
+    , "content-encoding"
+    , "etag"
+};
+
+#endif // __HTTP_HEADER_HASH_H__
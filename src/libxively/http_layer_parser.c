@@ -17,43 +17,73 @@
 #include "http_layer_parser.h"
 #include "xi_debug.h"
 #include "xi_err.h"
+#include "xi_scan.h"
+#include "http_header_hash.h"
 
 static const char XI_HTTP_STATUS_PATTERN[] =
     "HTTP/%d.%d %d %" XI_STR(XI_HTTP_STATUS_STRING_SIZE) "[^\r\n]\r\n"; //!< the match pattern
 
 #define SET_HTTP_STATUS_PATTERN(a,b,c,d) XI_HTTP_STATUS_PATTERN, &a, &b, &c, d
 
-static const char XI_HTTP_TOKEN_NAMES[ XI_HTTP_HEADERS_COUNT ][ XI_HTTP_HEADER_NAME_MAX_SIZE ] =
-    {
-          "date"            // XI_HTTP_HEADER_DATE
-        , "content-type"    // XI_HTTP_HEADER_CONTENT_TYPE
-        , "content-length"  // XI_HTTP_HEADER_CONTENT_LENGTH
-        , "connection"      // XI_HTTP_HEADER_CONNECTION
-        , "x-request-id"    // XI_HTTP_HEADER_X_REQUEST_ID
-        , "cache-control"   // XI_HTTP_HEADER_CACHE_CONTROL
-        , "age"             // XI_HTTP_HEADER_AGE
-        , "vary"            // XI_HTTP_HEADER_VARY
-        , "unknown"         // XI_HTTP_HEADER_UNKNOWN, //!< !!!! this must be always on the last position
-    };
+static inline char http_fold_char( char c )
+{
+    return ( c >= 'A' && c <= 'Z' ) ? ( char ) ( c + ( 'a' - 'A' ) ) : c;
+}
 
-static inline http_header_type_t classify_header( const char* header )
+/**
+ * \brief   Tells which of the known headers the name is, its length and its
+ *          ends pick the only one it can be, which is compared with it once
+ */
+static inline http_header_type_t classify_header( const char* header, size_t size )
 {
-    for( unsigned short i = 0; i < XI_HTTP_HEADER_COUNT - 1; ++i )
-    {
-        if( strcasecmp( header, XI_HTTP_TOKEN_NAMES[ i ] ) == 0 )
-            return ( http_header_type_t ) i;
-    }
+    if( size == 0 ) { return XI_HTTP_HEADER_UNKNOWN; }
+
+    const unsigned slot = ( ( unsigned ) size * XI_HTTP_HEADER_HASH_LENGTH
+        + ( unsigned char ) http_fold_char( header[ 0 ] ) * XI_HTTP_HEADER_HASH_FIRST
+        + ( unsigned char ) http_fold_char( header[ size - 1 ] ) ) % XI_HTTP_HEADER_HASH_SIZE;
+
+    const http_header_type_t ht = ( http_header_type_t ) XI_HTTP_HEADER_HASH_SLOTS[ slot ];
 
-    return XI_HTTP_HEADER_UNKNOWN;
+    if( ht == XI_HTTP_HEADER_UNKNOWN ) { return XI_HTTP_HEADER_UNKNOWN; }
+
+    const char* name = XI_HTTP_HEADER_NAMES[ ht ];
+    size_t i = 0;
+
+    for( ; i < size && http_fold_char( header[ i ] ) == name[ i ]; ++i ) { ; }
+
+    return ( i == size && name[ i ] == '\0' ) ? ht : XI_HTTP_HEADER_UNKNOWN;
 }
 
-const char* parse_http_status( http_response_t* response, const char* content )
+/**
+ * \brief   Finds the end of the line the scan is in, the `:` on the way are
+ *          passed over
+ *
+ * \return  Pointer to the `CRLF` or null if the text ends before it.
+ */
+static const char* http_find_line_end( xi_scan_t* scan )
+{
+    const char* p = xi_scan_next( scan );
+
+    while( *p == ':' ) { p = xi_scan_next( scan ); }
+
+    if( *p != '\n' || p == scan->data || p[ -1 ] != '\r' ) { return 0; }
+
+    return p - 1;
+}
+
+/**
+ * \brief   Parses the status line, the scan for `\n` and `:` begins with it
+ */
+static const char* http_parse_status_line(
+      http_response_t* response
+    , const char* content
+    , xi_scan_t* scan )
 {
     // variables
     int c = 0;
 
     // find the first occurrence of CRLF
-    const char* header_end_ptr = strstr( content, XI_HTTP_CRLF );
+    const char* header_end_ptr = http_find_line_end( scan );
 
     // check continuation condition
     XI_CHECK_ZERO( header_end_ptr, XI_HTTP_STATUS_PARSE_ERROR );
@@ -79,17 +109,26 @@ err_handling:
     return 0;
 }
 
-const char* parse_http_header( http_response_t* response
-    , const char* content )
+/**
+ * \brief   Parses the header line the scan is at the beginning of, the `:`
+ *          after the name and the `CRLF` are taken from the scan
+ */
+static const char* http_parse_header_line(
+      http_response_t* response
+    , const char* content
+    , xi_scan_t* scan )
 {
-    // find the first occurrence of CRLF
-    const char* header_end_ptr      = strstr( content, XI_HTTP_CRLF );
-    const char* header_name_end_ptr = strstr( content, ":" );
+    const char* header_name_end_ptr = xi_scan_next( scan );
+
+    // the header without a name ends the line where the name should end
+    XI_CHECK_CND( *header_name_end_ptr != ':', XI_HTTP_HEADER_PARSE_ERROR );
+
+    const size_t name_size = header_name_end_ptr - content;
+
+    const char* header_end_ptr = http_find_line_end( scan );
 
     // check continuation condition
     XI_CHECK_ZERO( header_end_ptr, XI_HTTP_HEADER_PARSE_ERROR );
-    XI_CHECK_ZERO( header_name_end_ptr, XI_HTTP_HEADER_PARSE_ERROR );
-    XI_CHECK_CND( header_name_end_ptr > header_end_ptr, XI_HTTP_HEADER_PARSE_ERROR );
 
     {
         int size = sizeof( response->http_headers[ response->http_headers_size ].name );
@@ -103,8 +142,14 @@ const char* parse_http_header( http_response_t* response
         XI_GUARD_EOS( response->http_headers[ response->http_headers_size ].name, size );
     }
 
-    // update the pointer
-    header_name_end_ptr += 2;
+    // update the pointer, past the whitespace before the value
+    header_name_end_ptr += 1;
+
+    while( header_name_end_ptr < header_end_ptr
+        && ( *header_name_end_ptr == ' ' || *header_name_end_ptr == '\t' ) )
+    {
+        header_name_end_ptr += 1;
+    }
 
     {
         int size = sizeof( response->http_headers[ response->http_headers_size ].value );
@@ -118,16 +163,11 @@ const char* parse_http_header( http_response_t* response
         XI_GUARD_EOS( response->http_headers[ response->http_headers_size ].value, size );
     }
 
-    // @TODO change the complexity of the classify header
-    // implementation now it's O( n*m ) it can be done in O( n )
-    // using some sort of simple DFA
-    // I'm working on a very simple Python DFA generator for C
-    // but still this is a w.i.p. at the moment
-
     // parse the header name
     {
         http_header_type_t ht = classify_header(
-            response->http_headers[ response->http_headers_size ].name );
+              response->http_headers[ response->http_headers_size ].name
+            , name_size );
 
         // accept headers that differs from unknown
         if( ht != XI_HTTP_HEADER_UNKNOWN )
@@ -155,42 +195,558 @@ err_handling:
     return 0;
 }
 
-http_response_t* parse_http( http_response_t* response, const char* content )
+const char* parse_http_status( http_response_t* response, const char* content )
 {
-    memset( response, 0, sizeof( http_response_t ) );
+    xi_scan_t scan;
+    xi_scan_init( &scan, content, XI_SCAN_TERMINATED, '\n', ':' );
 
-    // remember where is the end of header section
-    const char* ptr_to_headers_end = strstr( content, XI_HTTP_CRLFX2 );
+    return http_parse_status_line( response, content, &scan );
+}
 
-    // check the continuation condition
-    XI_CHECK_ZERO( ptr_to_headers_end, XI_HTTP_PARSE_ERROR );
+const char* parse_http_header( http_response_t* response
+    , const char* content )
+{
+    xi_scan_t scan;
+    xi_scan_init( &scan, content, XI_SCAN_TERMINATED, '\n', ':' );
 
-    // update the pointer
-    ptr_to_headers_end += sizeof( XI_HTTP_CRLF ) - 1;
+    return http_parse_header_line( response, content, &scan );
+}
 
-    const char* payload_begin = ptr_to_headers_end + sizeof( XI_HTTP_CRLF ) - 1;
+//! the parts of a chunk the parser can be in
+enum
+{
+    XI_HTTP_CHUNK_SIZE = 0,     //!< the line of its size
+    XI_HTTP_CHUNK_DATA,
+    XI_HTTP_CHUNK_END,          //!< the `CRLF` after its data
+    XI_HTTP_CHUNK_TRAILERS      //!< the headers after the last one
+};
 
-    XI_CHECK_ZERO( payload_begin, XI_HTTP_PARSE_ERROR );
+/**
+ * \brief   Reads the size of the chunk from its line, `CRLF` included, the
+ *          extensions after the size are skipped
+ *
+ * \return  `0` on success or `-1` if the line is malformed.
+ */
+static int http_parse_chunk_size( const char* line, size_t size, size_t* chunk )
+{
+    size_t i        = 0;
+    size_t value    = 0;
 
-    // parse status
-    const char* ptr = parse_http_status( response, content );
+    for( ; i < size; ++i )
+    {
+        const char c = http_fold_char( line[ i ] );
+        const int digit = ( c >= '0' && c <= '9' ) ? c - '0'
+            : ( c >= 'a' && c <= 'f' ) ? c - 'a' + 10 : -1;
 
-    // check the continuation condition
-    XI_CHECK_ZERO( ptr, XI_HTTP_PARSE_ERROR );
+        if( digit == -1 ) { break; }
+
+        // more than a response can hold anyway
+        if( value > ( size_t ) XI_HTTP_MAX_RESPONSE_SIZE ) { return -1; }
+
+        value = value * 16 + digit;
+    }
+
+    if( i == 0 || size < i + 2 ) { return -1; }
+
+    if( line[ i ] != ';' && line[ i ] != ' ' && line[ i ] != '\r' ) { return -1; }
+
+    if( line[ size - 2 ] != '\r' || line[ size - 1 ] != '\n' ) { return -1; }
+
+    *chunk = value;
+    return 0;
+}
+
+/**
+ * \brief   Tells whether the value of `Transfer-Encoding` ends with the
+ *          chunked coding, which is applied last, after any other
+ */
+static int http_is_chunked_coding( const char* value, size_t size )
+{
+    static const char chunked[] = "chunked";
+    const size_t chunked_size   = sizeof( chunked ) - 1;
+
+    return size >= chunked_size
+        && strncasecmp( value + size - chunked_size, chunked, chunked_size ) == 0;
+}
 
-    // read the headers
-    while( ( ptr = parse_http_header( response, ptr ) ) != '\0'
-        && ptr != ptr_to_headers_end );
+int http_is_chunked( const http_response_t* response )
+{
+    // PRECONDITIONS
+    assert( response != 0 );
+
+    return response->http_chunked;
+}
+
+long http_dechunk( char* content, size_t size )
+{
+    // PRECONDITIONS
+    assert( content != 0 );
+
+    const char* p   = content;
+    const char* end = content + size;
+    char* out       = content;
+
+    for( ;; )
+    {
+        const char* eol = memchr( p, '\n', end - p );
+        size_t chunk    = 0;
+
+        XI_CHECK_CND( eol == 0
+            || http_parse_chunk_size( p, eol + 1 - p, &chunk ) == -1
+            , XI_HTTP_PARSE_ERROR );
+
+        p = eol + 1;
+
+        if( chunk == 0 ) { break; }
+
+        XI_CHECK_CND( ( size_t ) ( end - p ) < chunk + 2
+            || p[ chunk ] != '\r' || p[ chunk + 1 ] != '\n'
+            , XI_HTTP_PARSE_ERROR );
+
+        // the data only ever moves back, past the sizes already read
+        memmove( out, p, chunk );
+        out += chunk;
+        p   += chunk + 2;
+    }
+
+    *out = '\0';
+
+    return out - content;
+
+err_handling:
+    return -1;
+}
+
+http_response_t* parse_http( http_response_t* response, const char* content )
+{
+    http_parser_t parser;
+    http_parser_init( &parser, response );
+
+    const size_t size = strlen( content );
 
     // if there was an error, forward it
-    xi_err_t e = xi_get_last_error();
-    XI_CHECK_CND( e != XI_NO_ERR, e );
+    if( http_parser_feed( &parser, content, size ) == -1 ) { goto err_handling; }
+
+    // check the continuation condition
+    XI_CHECK_CND( parser.state < XI_HTTP_PARSER_BODY, XI_HTTP_PARSE_ERROR );
 
-    // just copy the content
-    strncpy( response->http_content, payload_begin, sizeof( response->http_content ) );
+    // the content stays where it's been received, the binary one may
+    // contain zeros, so its length is taken from the header if there's one,
+    // the whole message has been read into the buffer by then, the chunks
+    // override the header
+    response->http_content      = content + parser.head_size;
+
+    response->http_content_size = ( parser.has_length && !parser.chunked )
+        ? parser.length : size - parser.head_size;
 
     return response;
 
 err_handling:
     return 0;
 }
+
+void http_parser_init( http_parser_t* parser, http_response_t* response )
+{
+    // PRECONDITIONS
+    assert( parser != 0 );
+
+    memset( parser, 0, sizeof( http_parser_t ) );
+
+    if( response ) { memset( response, 0, sizeof( http_response_t ) ); }
+
+    parser->response    = response;
+    parser->state       = XI_HTTP_PARSER_STATUS;
+}
+
+/**
+ * \brief   Takes what tells where the body ends from the value of the header
+ */
+static void http_parser_header( http_parser_t* parser
+    , http_header_type_t ht, const char* value, size_t size )
+{
+    size_t i = 0;
+
+    switch( ht )
+    {
+        case XI_HTTP_HEADER_CONTENT_LENGTH:
+            parser->has_length  = 1;
+            parser->length      = 0;
+
+            // more than a response can hold is as good as any
+            for( ; i < size && value[ i ] >= '0' && value[ i ] <= '9'; ++i )
+            {
+                if( parser->length <= ( size_t ) XI_HTTP_MAX_RESPONSE_SIZE )
+                {
+                    parser->length = parser->length * 10 + ( value[ i ] - '0' );
+                }
+            }
+            break;
+        case XI_HTTP_HEADER_TRANSFER_ENCODING:
+            parser->chunked = http_is_chunked_coding( value, size );
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * \brief   Reads the status code from the line, the rest of it is only of
+ *          interest to the response
+ *
+ * \return  The code or `-1` if the line is malformed.
+ */
+static int http_parse_status_code( const char* line, size_t size )
+{
+    static const char version[] = "HTTP/";
+    const size_t version_size   = sizeof( version ) - 1;
+
+    const char* space = memchr( line, ' ', size );
+
+    if( size < version_size || memcmp( line, version, version_size ) != 0
+        || space == 0 || line + size - space < 5
+        || ( space[ 4 ] != ' ' && space[ 4 ] != '\r' ) )
+    {
+        return -1;
+    }
+
+    int status  = 0;
+    int i       = 1;
+
+    for( ; i < 4; ++i )
+    {
+        if( space[ i ] < '0' || space[ i ] > '9' ) { return -1; }
+
+        status = status * 10 + ( space[ i ] - '0' );
+    }
+
+    return status;
+}
+
+/**
+ * \brief   Takes what tells where the body ends from the header line, `CRLF`
+ *          included, without keeping the header
+ *
+ * \return  `0` on success or `-1` if the line is malformed.
+ */
+static int http_parser_frame_header( http_parser_t* parser, const char* line, size_t size )
+{
+    const char* colon   = memchr( line, ':', size );
+    const char* end     = line + size - ( sizeof( XI_HTTP_CRLF ) - 1 );
+
+    XI_CHECK_CND( colon == 0 || colon == line || end < colon || *end != '\r'
+        , XI_HTTP_HEADER_PARSE_ERROR );
+
+    const char* value = colon + 1;
+
+    while( value < end && ( *value == ' ' || *value == '\t' ) ) { value += 1; }
+
+    http_parser_header( parser
+        , classify_header( line, colon - line ), value, end - value );
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+/**
+ * \brief   Works out where the body ends once the headers are complete
+ */
+static void http_parser_head_done( http_parser_t* parser )
+{
+    // informational, 204 and 304 responses never have a body
+    if( parser->status / 100 == 1
+        || parser->status == 204 || parser->status == 304 )
+    {
+        parser->chunked         = 0;
+        parser->state           = XI_HTTP_PARSER_DONE;
+    }
+    else if( parser->chunked )
+    {
+        parser->chunk_state     = XI_HTTP_CHUNK_SIZE;
+        parser->state           = XI_HTTP_PARSER_BODY;
+    }
+    else if( parser->has_length )
+    {
+        parser->body_left       = parser->length;
+        parser->state           = parser->body_left
+            ? XI_HTTP_PARSER_BODY : XI_HTTP_PARSER_DONE;
+
+        if( parser->response ) { parser->response->http_content_size = parser->length; }
+    }
+    else
+    {
+        parser->until_close     = 1;
+        parser->state           = XI_HTTP_PARSER_BODY;
+    }
+
+    // what the body turns out to be, not what the header says
+    if( parser->response ) { parser->response->http_chunked = parser->chunked; }
+}
+
+/**
+ * \brief   Parses the line of the size of a chunk, the one after its data or
+ *          a trailer
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int http_parser_chunk_line( http_parser_t* parser, const char* line, size_t size )
+{
+    const int blank = ( size == sizeof( XI_HTTP_CRLF ) - 1 && line[ 0 ] == '\r' );
+
+    switch( parser->chunk_state )
+    {
+        case XI_HTTP_CHUNK_SIZE:
+            XI_CHECK_CND( http_parse_chunk_size( line, size, &parser->body_left ) == -1
+                , XI_HTTP_PARSE_ERROR );
+
+            parser->chunk_state = parser->body_left
+                ? XI_HTTP_CHUNK_DATA : XI_HTTP_CHUNK_TRAILERS;
+            break;
+        case XI_HTTP_CHUNK_END:
+            XI_CHECK_CND( !blank, XI_HTTP_PARSE_ERROR );
+
+            parser->chunk_state = XI_HTTP_CHUNK_SIZE;
+            break;
+        default:
+            // the trailers are skipped up to the blank line after them
+            if( blank ) { parser->state = XI_HTTP_PARSER_DONE; }
+    }
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+/**
+ * \brief   Tells whether the parser is in a line, as opposed to the body
+ */
+static inline int http_parser_in_line( const http_parser_t* parser )
+{
+    return parser->state < XI_HTTP_PARSER_BODY
+        || ( parser->state == XI_HTTP_PARSER_BODY
+            && parser->chunked && parser->chunk_state != XI_HTTP_CHUNK_DATA );
+}
+
+/**
+ * \brief   Parses the complete line of the status or a header, `CRLF`
+ *          included
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int http_parser_line( http_parser_t* parser, const char* line, size_t size )
+{
+    if( parser->state == XI_HTTP_PARSER_BODY )
+    {
+        return http_parser_chunk_line( parser, line, size );
+    }
+
+    http_response_t* response = parser->response;
+
+    xi_scan_t scan;
+    xi_scan_init( &scan, line, size, '\n', ':' );
+
+    parser->head_size += size;
+
+    if( parser->state == XI_HTTP_PARSER_STATUS )
+    {
+        XI_CHECK_CND( size > XI_HTTP_PARSER_LINE_SIZE, XI_HTTP_STATUS_PARSE_ERROR );
+
+        if( response && http_parse_status_line( response, line, &scan ) == 0 ) { goto err_handling; }
+
+        parser->status = http_parse_status_code( line, size );
+
+        XI_CHECK_CND( parser->status == -1, XI_HTTP_STATUS_PARSE_ERROR );
+
+        parser->state = XI_HTTP_PARSER_HEADERS;
+        return 0;
+    }
+
+    // the blank line ends the headers
+    if( size == sizeof( XI_HTTP_CRLF ) - 1 && line[ 0 ] == '\r' )
+    {
+        http_parser_head_done( parser );
+        return 0;
+    }
+
+    XI_CHECK_CND( size > XI_HTTP_PARSER_LINE_SIZE, XI_HTTP_HEADER_PARSE_ERROR );
+
+    if( response == 0 ) { return http_parser_frame_header( parser, line, size ); }
+
+    if( http_parse_header_line( response, line, &scan ) == 0 ) { goto err_handling; }
+
+    {
+        const http_header_t* header
+            = &response->http_headers[ response->http_headers_size - 1 ];
+
+        http_parser_header( parser
+            , header->header_type, header->value, strlen( header->value ) );
+    }
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+long http_parser_feed( http_parser_t* parser, const char* data, size_t size )
+{
+    // PRECONDITIONS
+    assert( parser != 0 );
+    assert( data != 0 || size == 0 );
+
+    const char* p   = data;
+    const char* end = data + size;
+
+    XI_CHECK_CND( parser->state == XI_HTTP_PARSER_ERROR, XI_HTTP_PARSE_ERROR );
+
+    while( p < end && parser->state < XI_HTTP_PARSER_DONE )
+    {
+        if( !http_parser_in_line( parser ) )
+        {
+            size_t body = end - p;
+
+            if( !parser->until_close && body > parser->body_left )
+            {
+                body = parser->body_left;
+            }
+
+            if( parser->on_body ) { parser->on_body( parser->user, p, body ); }
+
+            p += body;
+
+            if( parser->until_close ) { continue; }
+
+            parser->body_left -= body;
+
+            if( parser->chunked )
+            {
+                if( parser->response ) { parser->response->http_content_size += body; }
+
+                if( parser->body_left == 0 ) { parser->chunk_state = XI_HTTP_CHUNK_END; }
+            }
+            else if( parser->body_left == 0 )
+            {
+                parser->state = XI_HTTP_PARSER_DONE;
+            }
+
+            continue;
+        }
+
+        const char* eol     = memchr( p, '\n', end - p );
+        const char* next    = eol ? eol + 1 : end;
+
+        // the line that's complete in the data is parsed where it is, the
+        // pieces of the one that isn't are kept until it is
+        if( eol && parser->line_size == 0 )
+        {
+            if( http_parser_line( parser, p, next - p ) == -1 ) { goto err_handling; }
+
+            p = next;
+            continue;
+        }
+
+        XI_CHECK_CND( parser->line_size + ( next - p ) > XI_HTTP_PARSER_LINE_SIZE
+            , parser->state == XI_HTTP_PARSER_STATUS ? XI_HTTP_STATUS_PARSE_ERROR
+            : parser->state == XI_HTTP_PARSER_HEADERS ? XI_HTTP_HEADER_PARSE_ERROR
+            : XI_HTTP_PARSE_ERROR );
+
+        memcpy( parser->line + parser->line_size, p, next - p );
+        parser->line_size += next - p;
+        parser->line[ parser->line_size ] = '\0';
+        p = next;
+
+        if( eol )
+        {
+            const size_t line_size = parser->line_size;
+            parser->line_size = 0;
+
+            if( http_parser_line( parser, parser->line, line_size ) == -1 ) { goto err_handling; }
+        }
+    }
+
+    parser->size += p - data;
+
+    return p - data;
+
+err_handling:
+    parser->state = XI_HTTP_PARSER_ERROR;
+    return -1;
+}
+
+int http_parser_finish( http_parser_t* parser )
+{
+    // PRECONDITIONS
+    assert( parser != 0 );
+
+    if( parser->state == XI_HTTP_PARSER_BODY && parser->until_close )
+    {
+        parser->state = XI_HTTP_PARSER_DONE;
+    }
+
+    XI_CHECK_CND( parser->state != XI_HTTP_PARSER_DONE, XI_HTTP_PARSE_ERROR );
+
+    return 0;
+
+err_handling:
+    parser->state = XI_HTTP_PARSER_ERROR;
+    return -1;
+}
+
+long http_response_size( http_parser_t* parser, const char* data, size_t size )
+{
+    // PRECONDITIONS
+    assert( parser != 0 );
+    assert( data != 0 );
+    assert( parser->size <= size );
+
+    if( parser->state < XI_HTTP_PARSER_DONE )
+    {
+        http_parser_feed( parser, data + parser->size, size - parser->size );
+    }
+
+    switch( parser->state )
+    {
+        case XI_HTTP_PARSER_DONE:
+            return ( long ) parser->size;
+        case XI_HTTP_PARSER_ERROR:
+            return ( long ) size;
+        case XI_HTTP_PARSER_BODY:
+            if( parser->until_close ) { return 0; }
+
+            // the length is known before the body arrives, the one of
+            // the chunks only when the last of them does
+            return parser->chunked ? -1 : ( long ) ( parser->head_size + parser->length );
+        default:
+            return -1;
+    }
+}
+
+int http_is_response_complete( const char* data, size_t size )
+{
+    http_parser_t parser;
+    http_parser_init( &parser, 0 );
+
+    long total = http_response_size( &parser, data, size );
+
+    return total > 0 && size >= ( size_t ) total;
+}
+
+int http_is_keep_alive( const http_response_t* response )
+{
+    // PRECONDITIONS
+    assert( response != 0 );
+
+    const http_header_t* connection
+        = response->http_headers_checklist[ XI_HTTP_HEADER_CONNECTION ];
+
+    if( connection )
+    {
+        return strcasecmp( connection->value, "close" ) != 0;
+    }
+
+    // persistent connections are the default since HTTP/1.1
+    return response->http_version1 > 1
+        || ( response->http_version1 == 1 && response->http_version2 >= 1 );
+}
@@ -10,6 +10,7 @@
 #ifndef __HTTP_LAYER_PARSER_H__
 #define __HTTP_LAYER_PARSER_H__
 
+#include "xively.h"
 #include "xi_macros.h"
 
 #ifdef __cplusplus
@@ -25,10 +26,131 @@ extern "C" {
  *
  * \return Pointer or null if an error occurred.
  *
- * \note   It currently won't work against partial data.
+ * \note   The whole response has to be in the terminated buffer, the parts
+ *         of one that's still arriving are given to `http_parser_feed`.
  */
 http_response_t* parse_http( http_response_t* response, const char* data );
 
+/**
+ * \brief  Where the parser is in the response
+ */
+typedef enum
+{
+    XI_HTTP_PARSER_STATUS = 0,      //!< in the status line
+    XI_HTTP_PARSER_HEADERS,         //!< in the headers
+    XI_HTTP_PARSER_BODY,            //!< in the body, the headers are complete
+    XI_HTTP_PARSER_DONE,            //!< past the end of the response
+    XI_HTTP_PARSER_ERROR
+} http_parser_state_t;
+
+/**
+ * \brief  The parser of a response which is given the data as it arrives
+ *
+ *    The status and the headers are parsed into the response, the line each
+ *    of them is on is kept until it's complete if it arrives in pieces. The
+ *    body is handed to `on_body`, if it's set, and isn't kept. The chunked
+ *    one is handed over without the sizes of its chunks.
+ *
+ *    Without the response only what tells where it ends is looked at, the
+ *    parser that's been zeroed is the same as the one initialized so.
+ */
+typedef struct
+{
+    http_response_t*    response;
+    http_parser_state_t state;
+    void ( *on_body )( void* user, const char* data, size_t size );
+    void*               user;           //!< given back to `on_body`
+    size_t              size;           //!< size of the response parsed so far
+    size_t              head_size;      //!< size of the status line and the headers read so far
+    int                 status;
+    int                 has_length;     //!< `Content-Length` has been given
+    size_t              length;         //!< the one it gives
+    size_t              body_left;      //!< what's left of the body if its length is known
+    int                 until_close;    //!< the body ends when the connection is closed
+    int                 chunked;        //!< the body is sent in chunks, `body_left` is of the current one
+    int                 chunk_state;    //!< which part of the chunk the parser is in
+    size_t              line_size;
+    char                line[ XI_HTTP_PARSER_LINE_SIZE + 1 ];
+} http_parser_t;
+
+/**
+ * \brief  Prepares the parser for the next response, which is parsed into
+ *         the given structure, if there's one
+ */
+void http_parser_init( http_parser_t* parser, http_response_t* response );
+
+/**
+ * \brief  Parses the next part of the response, the parts before it are
+ *         never looked at again
+ *
+ *    The parser stops at the end of the response, what's past it belongs to
+ *    the next one, e.g. when the responses are pipelined.
+ *
+ * \return Number of bytes taken from the data or `-1` if an error occurred.
+ */
+long http_parser_feed( http_parser_t* parser, const char* data, size_t size );
+
+/**
+ * \brief  Tells the parser that the connection has been closed
+ *
+ * \return `0` if the response is complete, as the one whose body ends with
+ *         the connection, or `-1` if it's been cut short.
+ */
+int http_parser_finish( http_parser_t* parser );
+
+/**
+ * \brief  Works out the size of the whole response as it arrives, the
+ *         buffer holds it from its beginning
+ *
+ *    The parser is given what's been received since the last call only, so
+ *    each byte is looked at once however many reads the response takes. It's
+ *    the size of the headers plus `Content-Length`, or the size of all the
+ *    chunks once the last one has been received. The length of a response
+ *    without either is only known once the server closes the connection.
+ *    The malformed response ends where it's been received up to, so that it
+ *    fails to be decoded.
+ *
+ * \return Size of the response in bytes, `0` if it's delimited by closing
+ *         the connection or `-1` if it's not known yet.
+ */
+long http_response_size( http_parser_t* parser, const char* data, size_t size );
+
+/**
+ * \brief  Tells whether the given buffer holds a complete response
+ *
+ *    The headers have to be complete and, if `Content-Length` is given, so has
+ *    to be the body. The length of a response without it is only known once
+ *    the server closes the connection, so it's never complete.
+ *
+ * \return 1 if the whole response has been received, 0 otherwise.
+ */
+int http_is_response_complete( const char* data, size_t size );
+
+/**
+ * \brief  Tells whether the body of the response is sent in chunks
+ *
+ *    It's what the parser has found, the responses which never have a body
+ *    (e.g. 204 or 304) aren't chunked even if `Transfer-Encoding` says so.
+ */
+int http_is_chunked( const http_response_t* response );
+
+/**
+ * \brief  Removes the sizes of the chunks from the body, in place
+ *
+ *    The data of the chunks is moved to the beginning of the body and is
+ *    terminated, the trailers are dropped.
+ *
+ * \return Size of the data or `-1` if the chunks are malformed or the last
+ *         one is missing.
+ */
+long http_dechunk( char* content, size_t size );
+
+/**
+ * \brief  Tells whether the server allows to keep the connection open
+ *         after the given response
+ */
+int http_is_keep_alive( const http_response_t* response );
+
 #ifdef __cplusplus
 }
 #endif
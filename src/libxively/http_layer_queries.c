@@ -17,7 +17,7 @@
 #include "xively.h"
 
 
-static const char XI_HTTP_TEMPLATE_FEED[] = "%s /v2/feeds%s.csv%s HTTP/1.1\r\n"
+static const char XI_HTTP_TEMPLATE_FEED[] = "%s /v2/feeds%s.%s%s HTTP/1.1\r\n"
                                   "Host: %s\r\n"
                                   "User-Agent: %s\r\n"
                                   "Accept: */*\r\n"
@@ -26,12 +26,12 @@ static const char XI_HTTP_TEMPLATE_FEED[] = "%s /v2/feeds%s.csv%s HTTP/1.1\r\n"
 static const char XI_HTTP_ID_TEMPLATE[]    = "/%s";
 static const char XI_HTTP_ID_TEMPLATE_D[]  = "/%d";
 
-static const char XI_HTTP_CONTENT_TEMPLATE[] = "Content-Type: text/plain\r\n"
+static const char XI_HTTP_CONTENT_TEMPLATE[] = "Content-Type: %s\r\n"
                                             "Content-Length: %d\r\n";
 
-static char XI_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE ];
-static char XI_CONTENT_BUFFER[ XI_CONTENT_BUFFER_SIZE ];
-static char XI_ID_BUFFER[ XI_ID_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_CONTENT_BUFFER[ XI_CONTENT_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_ID_BUFFER[ XI_ID_BUFFER_SIZE ];
 
 inline static int http_construct_string(
       char* buffer, size_t buffer_size
@@ -171,15 +171,17 @@ err_handling:
 inline static const char* http_construct_http_query(
       const char* http_method
     , const char* id
+    , const char* format
     , const char* query_suffix
     , const char* x_api_key )
 {
     // PRECONDITIONS
     assert( http_method     != 0 );
+    assert( format      != 0 );
     assert( x_api_key   != 0 );
 
     int s = snprintf( XI_QUERY_BUFFER, XI_QUERY_BUFFER_SIZE, XI_HTTP_TEMPLATE_FEED
-        , http_method, id == 0 ? "" : id, query_suffix == 0 ? "" : query_suffix
+        , http_method, id == 0 ? "" : id, format, query_suffix == 0 ? "" : query_suffix
         , XI_HOST, XI_USER_AGENT, x_api_key );
 
     XI_CHECK_SIZE( s, XI_QUERY_BUFFER_SIZE
@@ -196,6 +198,7 @@ const char* http_construct_request_datapoint(
         , const xi_feed_id_t* feed_id
         , const char* datastream
         , const char* datapoint
+        , const char* format
         , const char* x_api_key )
 {
     // PRECONDITIONS
@@ -210,7 +213,7 @@ const char* http_construct_request_datapoint(
     XI_CHECK_SIZE( s, XI_ID_BUFFER_SIZE
         , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN );
 
-    return http_construct_http_query( http_method, XI_ID_BUFFER, 0, x_api_key );
+    return http_construct_http_query( http_method, XI_ID_BUFFER, format, 0, x_api_key );
 
 err_handling:
     return 0;
@@ -220,7 +223,9 @@ const char* http_construct_request_datastream(
           const char* http_method
         , const xi_feed_id_t* feed_id
         , const char* datastream
-        , const char* x_api_key )
+        , const char* format
+        , const char* x_api_key
+        , const char* query_suffix )
 {
     // PRECONDITIONS
     assert( http_method != 0 );
@@ -233,7 +238,7 @@ const char* http_construct_request_datastream(
     XI_CHECK_SIZE( s, XI_ID_BUFFER_SIZE
         , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN )
 
-    return http_construct_http_query( http_method, XI_ID_BUFFER, 0, x_api_key );
+    return http_construct_http_query( http_method, XI_ID_BUFFER, format, query_suffix, x_api_key );
 
 err_handling:
     return 0;
@@ -242,6 +247,7 @@ err_handling:
 const char* http_construct_request_feed(
           const char* http_method
         , const xi_feed_id_t* feed_id
+        , const char* format
         , const char* x_api_key
         , const char* query_suffix )
 {
@@ -254,18 +260,21 @@ const char* http_construct_request_feed(
     XI_CHECK_SIZE( s, XI_ID_BUFFER_SIZE
         , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN );
 
-    return http_construct_http_query( http_method, XI_ID_BUFFER, query_suffix, x_api_key );
+    return http_construct_http_query( http_method, XI_ID_BUFFER, format, query_suffix, x_api_key );
 
 err_handling:
     return 0;
 }
 
 const char* http_construct_content(
-          int32_t content_size )
+          const char* content_type
+        , int32_t content_size )
 {
+    // PRECONDITIONS
+    assert( content_type != 0 );
 
     int s = snprintf( XI_CONTENT_BUFFER, XI_CONTENT_BUFFER_SIZE
-      , XI_HTTP_CONTENT_TEMPLATE, content_size );
+      , XI_HTTP_CONTENT_TEMPLATE, content_type, content_size );
 
     XI_CHECK_SIZE( s, XI_CONTENT_BUFFER_SIZE
         , XI_HTTP_CONSTRUCT_CONTENT_BUFFER_OVERRUN );
@@ -28,22 +28,27 @@ const char* http_construct_request_datapoint(
         , const xi_feed_id_t* feed_id
         , const char* datastream_id
         , const char* dp_ts_str
+        , const char* format
         , const char* x_api_key );
 
 const char* http_construct_request_datastream(
           const char* http_method
         , const xi_feed_id_t* feed_id
         , const char* datastream_id
-        , const char* x_api_key );
+        , const char* format
+        , const char* x_api_key
+        , const char* query_suffix );
 
 const char* http_construct_request_feed(
           const char* http_method
         , const xi_feed_id_t* feed_id
+        , const char* format
         , const char* x_api_key
         , const char* query_suffix );
 
 const char* http_construct_content(
-          int32_t content_size );
+          const char* content_type
+        , int32_t content_size );
 
 #ifdef __cplusplus
 }
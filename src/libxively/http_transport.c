@@ -9,6 +9,7 @@
 
 #include "http_transport_layer.h"
 #include "http_transport.h"
+#include "http_layer_parser.h"
 
 transport_layer_t* get_http_transport_layer( void )
 {
@@ -19,11 +20,47 @@ transport_layer_t* get_http_transport_layer( void )
         , &http_encode_create_datastream
         , &http_encode_update_datastream
         , &http_encode_get_datastream
+        , &http_encode_get_datastream_history
         , &http_encode_delete_datastream
         , &http_encode_delete_datapoint
         , &http_encode_datapoint_delete_range
+        , 0 // there are no subscriptions over HTTP
         , &http_decode_reply
+        , 0
+        , 0
+        , &http_reply_size
+        , 0 // no handshake
+        , 0
+        , XI_PORT
+        , 0
     };
 
     return &__http_transport_layer;
 }
+
+transport_layer_t* get_https_transport_layer( void )
+{
+    static transport_layer_t __https_transport_layer =
+    {
+          &http_encode_update_feed
+        , &http_encode_get_feed
+        , &http_encode_create_datastream
+        , &http_encode_update_datastream
+        , &http_encode_get_datastream
+        , &http_encode_get_datastream_history
+        , &http_encode_delete_datastream
+        , &http_encode_delete_datapoint
+        , &http_encode_datapoint_delete_range
+        , 0 // there are no subscriptions over HTTP
+        , &http_decode_reply
+        , 0
+        , 0
+        , &http_reply_size
+        , 0 // no handshake
+        , 0
+        , XI_HTTPS_PORT
+        , 1 // over TLS
+    };
+
+    return &__https_transport_layer;
+}
@@ -28,6 +28,12 @@ extern "C" {
  */
 transport_layer_t* get_http_transport_layer( void );
 
+/**
+ * \brief   Same as `get_http_transport_layer()`, but the connections are
+ *          encrypted and go to `XI_HTTPS_PORT`
+ */
+transport_layer_t* get_https_transport_layer( void );
+
 #ifdef __cplusplus
 }
 #endif
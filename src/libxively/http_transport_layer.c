@@ -11,63 +11,58 @@
 #include <stdio.h>
 
 #include "http_transport.h"
+#include "http_transport_layer.h"
 #include "http_layer_queries.h"
 #include "http_consts.h"
 #include "http_layer_parser.h"
 #include "xi_macros.h"
 #include "xi_helpers.h"
+#include "xi_iso8601.h"
 #include "xi_debug.h"
 #include "xi_err.h"
 
-static char XI_HTTP_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE + XI_CONTENT_BUFFER_SIZE ];
-static char XI_HTTP_QUERY_DATA[ XI_CONTENT_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_HTTP_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_HTTP_QUERY_DATA[ XI_CONTENT_BUFFER_SIZE ];
+static XI_THREAD_LOCAL xi_request_t XI_HTTP_REQUEST;
 
-
-inline static char* http_encode_concat( char* buffer, size_t buffer_size
-    , const char* query, const char* content, const char* data )
+/**
+ * \brief   Puts the request together, the parts stay in the buffers they've
+ *          been encoded into, so nothing is copied until they're sent
+ */
+inline static const xi_request_t* http_encode_request(
+    const char* query, const char* content, const char* data, size_t data_size )
 {
-    int offset  = 0;
-    int size    = ( int ) buffer_size;
-    int s       = 0;
+    XI_HTTP_REQUEST.count = 0;
 
-    s = snprintf( buffer, size, "%s", query );
-    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
-
-    if( content != 0 )
+    if( xi_request_append( &XI_HTTP_REQUEST, query, strlen( query ) ) == -1 )
     {
-        s = snprintf( buffer + offset
-                          , XI_MAX( size - offset, 0 )
-                          , "%s", content );
-        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
+        return 0;
     }
 
-    s = snprintf( buffer + offset
-                      , XI_MAX( size - offset, 0 )
-                      , "%s", XI_HTTP_CRLF );
-    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
-
-
-    if( content != 0 && data != 0 )
+    if( content != 0 && xi_request_append(
+        &XI_HTTP_REQUEST, content, strlen( content ) ) == -1 )
     {
-        s = snprintf( buffer + offset
-                          , XI_MAX( size - offset, 0 )
-                          , "%s", data );
-        XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
+        return 0;
     }
 
-    s = snprintf( buffer + offset
-                      , XI_MAX( size - offset, 0 )
-                      , "%s", XI_HTTP_CRLF );
-
-    XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_CREATE_DATASTREAM );
+    if( xi_request_append( &XI_HTTP_REQUEST
+        , XI_HTTP_CRLF, sizeof( XI_HTTP_CRLF ) - 1 ) == -1 )
+    {
+        return 0;
+    }
 
-    return buffer;
+    // nothing may follow the body, otherwise the server would take
+    // it as the beginning of the next request on a keep-alive connection
+    if( content != 0 && data != 0 && xi_request_append(
+        &XI_HTTP_REQUEST, data, data_size ) == -1 )
+    {
+        return 0;
+    }
 
-err_handling:
-    return 0;
+    return &XI_HTTP_REQUEST;
 }
 
-const char* http_encode_create_datastream(
+const xi_request_t* http_encode_create_datastream(
           const data_layer_t* data_transport
         , const char* x_api_key
         , xi_feed_id_t feed_id
@@ -82,18 +77,19 @@ const char* http_encode_create_datastream(
 
     const char* query = http_construct_request_datastream(
               XI_HTTP_QUERY_POST, &feed_id
-            , 0, x_api_key
+            , 0, data_transport->format, x_api_key, 0
     );
 
     if( query == 0 ) { return 0; }
 
-    const char* content = http_construct_content( strlen( data ) );
+    const size_t data_size  = data_transport->encoded_size( data );
+    const char* content     = http_construct_content(
+        data_transport->content_type, data_size );
 
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, content, data );
+    return http_encode_request( query, content, data, data_size );
 }
 
-const char* http_encode_update_datastream(
+const xi_request_t* http_encode_update_datastream(
           const data_layer_t* data_layer
         , const char* x_api_key
         , xi_feed_id_t feed_id
@@ -109,82 +105,129 @@ const char* http_encode_update_datastream(
               XI_HTTP_QUERY_PUT
             , &feed_id
             , datastream_id
+            , data_layer->format
             , x_api_key
+            , 0
     );
 
     if( query == 0 ) { return 0; }
 
-    const char* content = http_construct_content( strlen( data ) );
+    const size_t data_size  = data_layer->encoded_size( data );
+    const char* content     = http_construct_content(
+        data_layer->content_type, data_size );
 
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, content, data );
+    return http_encode_request( query, content, data, data_size );
 }
 
-const char* http_encode_get_datastream(
+const xi_request_t* http_encode_get_datastream(
           const data_layer_t* data_layer
         , const char* x_api_key
         , xi_feed_id_t feed_id
         , const char *datastream_id )
 {
-    XI_UNUSED( data_layer );
-
     // prepare parts
     const char* query = http_construct_request_datastream(
               XI_HTTP_QUERY_GET
             , &feed_id
             , datastream_id
-            , x_api_key );
+            , data_layer->format
+            , x_api_key
+            , 0 );
 
     if( query == 0 ) { return 0; }
 
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, 0, 0 );
+    return http_encode_request( query, 0, 0, 0 );
 }
 
-const char* http_encode_delete_datastream(
+const xi_request_t* http_encode_get_datastream_history(
           const data_layer_t* data_layer
         , const char* x_api_key
         , xi_feed_id_t feed_id
-        , const char *datastream_id )
+        , const char *datastream_id
+        , const xi_timestamp_t* after
+        , size_t limit )
 {
-    XI_UNUSED( data_layer );
+    // PRECONDITIONS
+    assert( data_layer != 0 );
+    assert( after != 0 );
+
+    // the start is inclusive, the timestamps have microseconds at most,
+    // so the next one is where the datapoints after the given one begin
+    xi_timestamp_t start = *after;
+
+    if( ++start.micro == 1000000 ) { start.timestamp += 1; start.micro = 0; }
+
+    char start_text[ XI_ISO8601_SIZE + 1 ];
+
+    XI_CHECK_CND( xi_iso8601_encode( start_text, sizeof( start_text ), &start ) == -1
+        , XI_HTTP_ENCODE_GET_DATASTREAM_HISTORY );
+
+    // every datapoint is asked for, not the averages over an interval
+    int s = snprintf( XI_HTTP_QUERY_DATA
+        , sizeof( XI_HTTP_QUERY_DATA )
+        , "?start=%s&interval=0&limit=%lu"
+        , start_text
+        , ( unsigned long ) limit );
+
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_HTTP_QUERY_DATA )
+        , XI_HTTP_ENCODE_GET_DATASTREAM_HISTORY );
+
+    {
+        // prepare parts
+        const char* query = http_construct_request_datastream(
+                  XI_HTTP_QUERY_GET
+                , &feed_id
+                , datastream_id
+                , data_layer->format
+                , x_api_key
+                , XI_HTTP_QUERY_DATA );
+
+        if( query == 0 ) { return 0; }
+
+        return http_encode_request( query, 0, 0, 0 );
+    }
+
+err_handling:
+    return 0;
+}
 
+const xi_request_t* http_encode_delete_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id )
+{
     // prepare parts
     const char* query = http_construct_request_datastream(
               XI_HTTP_QUERY_DELETE
             , &feed_id
             , datastream_id
-            , x_api_key );
+            , data_layer->format
+            , x_api_key
+            , 0 );
 
     if( query == 0 ) { return 0; }
 
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, 0, 0 );
+    return http_encode_request( query, 0, 0, 0 );
 }
 
-const char* http_encode_delete_datapoint(
-          const data_layer_t* data_transport
+const xi_request_t* http_encode_delete_datapoint(
+          const data_layer_t* data_layer
         , const char* x_api_key
         , xi_feed_id_t feed_id
         , const char *datastream_id
         , const xi_datapoint_t* o )
 {
-    XI_UNUSED( data_transport );
+    char at_text[ XI_ISO8601_SIZE + 1 ];
 
-    struct xi_tm* ptm = xi_gmtime(
-        ( xi_time_t* ) &o->timestamp.timestamp );
+    XI_CHECK_CND( xi_iso8601_encode( at_text, sizeof( at_text ), &o->timestamp ) == -1
+        , XI_HTTP_ENCODE_DELETE_DATAPOINT );
 
     int s = snprintf( XI_HTTP_QUERY_BUFFER
         , sizeof( XI_HTTP_QUERY_BUFFER )
-        , "%s/datapoints/%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
+        , "%s/datapoints/%s"
         , datastream_id
-        , ptm->tm_year + 1900
-        , ptm->tm_mon + 1
-        , ptm->tm_mday
-        , ptm->tm_hour
-        , ptm->tm_min
-        , ptm->tm_sec
-        , o->timestamp.micro );
+        , at_text );
 
     XI_CHECK_SIZE( s, ( int ) sizeof( XI_HTTP_QUERY_BUFFER )
         , XI_HTTP_ENCODE_DELETE_DATAPOINT );
@@ -195,19 +238,20 @@ const char* http_encode_delete_datapoint(
                   XI_HTTP_QUERY_DELETE
                 , &feed_id
                 , XI_HTTP_QUERY_BUFFER
-                , x_api_key );
+                , data_layer->format
+                , x_api_key
+                , 0 );
 
         if( query == 0 ) { return 0; }
 
-        return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-            , query, 0, 0 );
+        return http_encode_request( query, 0, 0, 0 );
     }
 
 err_handling:
     return 0;
 }
 
-const char* http_encode_update_feed(
+const xi_request_t* http_encode_update_feed(
           const data_layer_t* data_layer
         , const char* x_api_key
         , const xi_feed_t* feed )
@@ -223,60 +267,35 @@ const char* http_encode_update_feed(
     // variables initialization
     const char* content = 0;
     const char* query = 0;
+    int data_size = 0;
 
     { // data part preparation
-        int offset  = 0;
-        int size    = sizeof( XI_HTTP_QUERY_DATA );
-        int s       = 0;
-
-        // for each datastream
-        //      generate the list of datapoints that you want to update
-        for( size_t i = 0; i < feed->datastream_count; ++i )
-        {
-            const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
-
-            // for each datapoint
-            for( size_t j = 0; j < curr_datastream->datapoint_count; ++j )
-            {
-                const xi_datapoint_t* curr_datapoint
-                    = &curr_datastream->datapoints[ j ];
-
-                // add the datastream id to the buffer
-                s = snprintf(
-                      XI_HTTP_QUERY_DATA + offset, XI_MAX( size - offset, 0 ), "%s,"
-                    , curr_datastream->datastream_id );
-
-                XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_UPDATE_FEED );
-
-                // add the datapoint data to the buffer
-                s = data_layer->encode_datapoint_in_place(
-                      XI_HTTP_QUERY_DATA + offset, XI_MAX( size - offset, 0 )
-                    , curr_datapoint );
+        data_size = data_layer->encode_feed_in_place(
+            XI_HTTP_QUERY_DATA, sizeof( XI_HTTP_QUERY_DATA ), feed );
 
-                XI_CHECK_S( s, size, offset, XI_HTTP_ENCODE_UPDATE_FEED );
-            }
-        }
+        XI_CHECK_SIZE( data_size, ( int ) sizeof( XI_HTTP_QUERY_DATA )
+            , XI_HTTP_ENCODE_UPDATE_FEED );
     }
 
     query = http_construct_request_feed(
           XI_HTTP_QUERY_PUT
         , &feed->feed_id
+        , data_layer->format
         , x_api_key
         , 0
     );
 
     if( query == 0 ) { goto err_handling; }
 
-    content = http_construct_content( strlen( XI_HTTP_QUERY_DATA ) );
+    content = http_construct_content( data_layer->content_type, data_size );
 
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, content, XI_HTTP_QUERY_DATA );
+    return http_encode_request( query, content, XI_HTTP_QUERY_DATA, data_size );
 
 err_handling:
     return 0;
 }
 
-const char* http_encode_get_feed(
+const xi_request_t* http_encode_get_feed(
         const data_layer_t* data_layer
       , const char* x_api_key
       , const xi_feed_t* feed )
@@ -315,20 +334,20 @@ const char* http_encode_get_feed(
     query = http_construct_request_feed(
           XI_HTTP_QUERY_GET
         , &feed->feed_id
+        , data_layer->format
         , x_api_key
         , XI_HTTP_QUERY_DATA
     );
 
     if( query == 0 ) { goto err_handling; }
 
-    return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-        , query, 0, 0 );
+    return http_encode_request( query, 0, 0, 0 );
 
 err_handling:
     return 0;
 }
 
-const char* http_encode_datapoint_delete_range(
+const xi_request_t* http_encode_datapoint_delete_range(
         const data_layer_t* data_layer
       , const char* x_api_key
       , xi_feed_id_t feed_id
@@ -336,22 +355,13 @@ const char* http_encode_datapoint_delete_range(
       , const xi_timestamp_t* start
       , const xi_timestamp_t* end )
 {
-    XI_UNUSED( data_layer );
-
-    struct xi_tm stm;
-    struct xi_tm etm;
-
-    {
-        struct xi_tm* tmp = start ? xi_gmtime(
-            ( xi_time_t* ) &start->timestamp ) : 0;
-        memcpy( &stm, tmp, sizeof( struct xi_tm ) );
-    }
+    char start_text[ XI_ISO8601_SIZE + 1 ];
+    char end_text[ XI_ISO8601_SIZE + 1 ];
 
-    {
-        struct xi_tm* tmp = end ? xi_gmtime(
-            ( xi_time_t* ) &end->timestamp ) : 0;
-        memcpy( &etm, tmp, sizeof( struct xi_tm ) );
-    }
+    XI_CHECK_CND( start && xi_iso8601_encode( start_text, sizeof( start_text ), start ) == -1
+        , XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
+    XI_CHECK_CND( end && xi_iso8601_encode( end_text, sizeof( end_text ), end ) == -1
+        , XI_HTTP_ENCODE_DELETE_RANGE_DATAPOINT );
 
     int s = 0;
 
@@ -359,30 +369,22 @@ const char* http_encode_datapoint_delete_range(
     {
         s = snprintf( XI_HTTP_QUERY_BUFFER
             , sizeof( XI_HTTP_QUERY_BUFFER )
-            , "%s/datapoints?start=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ&end=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
-            , datastream_id
-            , stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday
-            , stm.tm_hour, stm.tm_min, stm.tm_sec, start->micro
-            , etm.tm_year + 1900, etm.tm_mon + 1, etm.tm_mday
-            , etm.tm_hour, etm.tm_min, etm.tm_sec, end->micro );
+            , "%s/datapoints?start=%s&end=%s"
+            , datastream_id, start_text, end_text );
     }
     else if( start )
     {
         s = snprintf( XI_HTTP_QUERY_BUFFER
             , sizeof( XI_HTTP_QUERY_BUFFER )
-            , "%s/datapoints?start=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
-            , datastream_id
-            , stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday
-            , stm.tm_hour, stm.tm_min, stm.tm_sec, start->micro );
+            , "%s/datapoints?start=%s"
+            , datastream_id, start_text );
     }
     else if( end )
     {
         s = snprintf( XI_HTTP_QUERY_BUFFER
             , sizeof( XI_HTTP_QUERY_BUFFER )
-            , "%s/datapoints?end=%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ"
-            , datastream_id
-            , etm.tm_year + 1900, etm.tm_mon + 1, etm.tm_mday
-            , etm.tm_hour, etm.tm_min, etm.tm_sec, end->micro );
+            , "%s/datapoints?end=%s"
+            , datastream_id, end_text );
     }
     else
     {
@@ -399,12 +401,13 @@ const char* http_encode_datapoint_delete_range(
                   XI_HTTP_QUERY_DELETE
                 , &feed_id
                 , XI_HTTP_QUERY_BUFFER
-                , x_api_key );
+                , data_layer->format
+                , x_api_key
+                , 0 );
 
         if( query == 0 ) { return 0; }
 
-        return http_encode_concat( XI_HTTP_QUERY_BUFFER, sizeof( XI_HTTP_QUERY_BUFFER )
-            , query, 0, 0 );
+        return http_encode_request( query, 0, 0, 0 );
     }
 
 err_handling:
@@ -414,12 +417,12 @@ err_handling:
 
 const xi_response_t* http_decode_reply(
           const data_layer_t* data_layer
-        , const char* response )
+        , char* response )
 {
     XI_UNUSED( data_layer );
 
-    static xi_response_t  __tmp;
-    static http_response_t* __response = &__tmp.http;
+    static XI_THREAD_LOCAL xi_response_t __tmp;
+    http_response_t* __response = &__tmp.http;
 
     // just pass it further
     if( parse_http( __response, response ) == 0 )
@@ -427,6 +430,22 @@ const xi_response_t* http_decode_reply(
         return 0;
     }
 
+    // the chunks are joined where they are, the data layer gets the data only
+    if( http_is_chunked( __response ) )
+    {
+        char* content = response + ( __response->http_content - response );
+        long size = http_dechunk( content, __response->http_content_size );
+
+        if( size == -1 ) { return 0; }
+
+        __response->http_content_size = size;
+    }
+
     // pass it to the data_layer
     return &__tmp;
 }
+
+long http_reply_size( xi_frame_t* frame, const char* data, size_t size )
+{
+    return http_response_size( &frame->http, data, size );
+}
@@ -12,55 +12,65 @@
 
 #include "xively.h"
 #include "data_layer.h"
+#include "xi_iovec.h"
+#include "transport_layer.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-const char* http_encode_create_datastream(
+const xi_request_t* http_encode_create_datastream(
           const data_layer_t*
         , const char* x_api_key
         , xi_feed_id_t feed_id
         , const char *datastream_id
         , const xi_datapoint_t* value );
 
-const char* http_encode_update_datastream(
+const xi_request_t* http_encode_update_datastream(
           const data_layer_t*
         , const char* x_api_key
         , xi_feed_id_t feed_id
         , const char *datastream_id
         , const xi_datapoint_t* value );
 
-const char* http_encode_get_datastream(
+const xi_request_t* http_encode_get_datastream(
           const data_layer_t*
         , const char* x_api_key
         , xi_feed_id_t feed_id
         , const char *datastream_id );
 
-const char* http_encode_delete_datastream(
+const xi_request_t* http_encode_get_datastream_history(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_timestamp_t* after
+        , size_t limit );
+
+const xi_request_t* http_encode_delete_datastream(
           const data_layer_t*
         , const char* x_api_key
         , xi_feed_id_t feed_id
         , const char *datastream_id );
 
-const char* http_encode_delete_datapoint(
+const xi_request_t* http_encode_delete_datapoint(
           const data_layer_t*
         , const char* x_api_key
         , xi_feed_id_t feed_id
         , const char *datastream_id
         , const xi_datapoint_t* o );
 
-const char* http_encode_update_feed(
+const xi_request_t* http_encode_update_feed(
           const data_layer_t*
         , const char* x_api_key
         , const xi_feed_t* feed );
 
-const char* http_encode_get_feed(
+const xi_request_t* http_encode_get_feed(
         const data_layer_t*
       , const char* x_api_key
       , const xi_feed_t* feed );
 
-const char* http_encode_datapoint_delete_range(
+const xi_request_t* http_encode_datapoint_delete_range(
         const data_layer_t*
       , const char* x_api_key
       , xi_feed_id_t feed_id
@@ -70,7 +80,12 @@ const char* http_encode_datapoint_delete_range(
 
 const xi_response_t* http_decode_reply(
           const data_layer_t*
-        , const char* data );
+        , char* data );
+
+/**
+ * \brief   Tells the size of the reply, it's framed by the parser of the frame
+ */
+long http_reply_size( xi_frame_t* frame, const char* data, size_t size );
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,662 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_data.c
+ * \brief   Implements JSON _data layer_ encoders and decoders specific to Xively JSON data format [see json_data.h]
+ *
+ *    The decoders walk the document token by token and store what they're
+ *    interested in straight into the structures given, the members they don't
+ *    know are skipped. Nothing is allocated and no tree is built, so a whole
+ *    feed can be read in one go, with the history of each datastream.
+ *
+ *    A datastream carries either its current value:
+ *
+ *    {"id":"temp","current_value":"21.5","at":"2013-01-01T18:44:21.423452Z"}
+ *
+ *    or a list of datapoints:
+ *
+ *    {"id":"temp","datapoints":[{"at":"2013-01-01T18:44:21.423452Z","value":"21.5"}]}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "json_data.h"
+#include "json_lexer.h"
+#include "xi_fmt.h"
+#include "xi_iso8601.h"
+#include "csv_data.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_config.h"
+
+static XI_THREAD_LOCAL char XI_JSON_LOCAL_BUFFER[ XI_JSON_BUFFER_SIZE ];
+
+static const char XI_JSON_VERSION[] = "\"version\":\"1.0.0\"";
+
+//-----------------------------------------------------------------------
+// ENCODERS
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Writes the string in quotes, escaping whatever needs to be
+ *
+ * \return  Number of characters written or `-1` if they don't fit.
+ */
+static int json_encode_string(
+      char* buffer
+    , size_t buffer_size
+    , const char* string )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( string != 0 );
+
+    char* dst       = buffer;
+    // leave room for the closing quote and the terminator
+    const char* end = buffer + buffer_size - 2;
+
+    if( buffer_size < 3 ) { return -1; }
+
+    *dst++ = '"';
+
+    for( const char* p = string; *p != '\0'; ++p )
+    {
+        const unsigned char c = ( unsigned char ) *p;
+        char escaped          = 0;
+
+        switch( c )
+        {
+            case '"':   escaped = '"';  break;
+            case '\\':  escaped = '\\'; break;
+            case '\n':  escaped = 'n';  break;
+            case '\r':  escaped = 'r';  break;
+            case '\t':  escaped = 't';  break;
+            default:                    break;
+        }
+
+        if( escaped )
+        {
+            if( end - dst < 2 ) { return -1; }
+            *dst++ = '\\';
+            *dst++ = escaped;
+        }
+        else if( c < 0x20 )
+        {
+            if( end - dst < 6 ) { return -1; }
+            dst += sprintf( dst, "\\u%04x", c );
+        }
+        else
+        {
+            if( end - dst < 1 ) { return -1; }
+            *dst++ = ( char ) c;
+        }
+    }
+
+    *dst++ = '"';
+    *dst   = '\0';
+
+    return dst - buffer;
+}
+
+/**
+ * \brief   Writes the value, Xively keeps all of them as strings
+ *
+ * \return  Number of characters written or `-1` if they don't fit.
+ */
+static int json_encode_value(
+      char* buffer
+    , size_t buffer_size
+    , const xi_datapoint_t* p )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( p != 0 );
+
+    int s = 0;
+
+    switch( p->value_type )
+    {
+        case XI_VALUE_TYPE_I32:
+            // leaves the room for the quotes
+            s = buffer_size < 2 ? -1
+              : xi_fmt_i32( buffer + 1, buffer_size - 2, p->value.i32_value );
+            break;
+        case XI_VALUE_TYPE_F32:
+            s = buffer_size < 2 ? -1
+              : xi_fmt_f32( buffer + 1, buffer_size - 2, p->value.f32_value );
+            break;
+        case XI_VALUE_TYPE_STR:
+            return json_encode_string( buffer, buffer_size, p->value.str_value );
+        default:
+            return -1;
+    }
+
+    if( s < 0 ) { return -1; }
+
+    buffer[ 0 ]     = '"';
+    buffer[ s + 1 ] = '"';
+    buffer[ s + 2 ] = '\0';
+
+    return s + 2;
+}
+
+/**
+ * \brief   Writes the value and the timestamp, unless it's left to the
+ *          server, as members of an object
+ *
+ * \return  Number of characters written or `-1` if they don't fit.
+ */
+static int json_encode_datapoint_members(
+      char* buffer
+    , size_t buffer_size
+    , const xi_datapoint_t* datapoint
+    , const char* value_name )
+{
+    int s       = 0;
+    int size    = buffer_size;
+    int offset  = 0;
+
+    s = snprintf( buffer, size, "\"%s\":", value_name );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = json_encode_value( buffer + offset, size - offset, datapoint );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    if( datapoint->timestamp.timestamp != 0 )
+    {
+        static const char at[] = ",\"at\":\"";
+
+        XI_CHECK_CND( size - offset < ( int ) sizeof( at ), XI_JSON_ENCODE_BUFFER_OVERRUN );
+        memcpy( buffer + offset, at, sizeof( at ) - 1 );
+        offset += sizeof( at ) - 1;
+
+        s = xi_iso8601_encode( buffer + offset, size - offset, &datapoint->timestamp );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+        XI_CHECK_CND( size - offset < 2, XI_JSON_ENCODE_BUFFER_OVERRUN );
+        buffer[ offset++ ] = '"';
+        buffer[ offset ]   = '\0';
+    }
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+/**
+ * \brief   Writes the datastream as an element of `"datastreams"`, a single
+ *          datapoint becomes its current value
+ *
+ * \return  Number of characters written or `-1` if they don't fit.
+ */
+static int json_encode_datastream(
+      char* buffer
+    , size_t buffer_size
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoints
+    , size_t datapoint_count )
+{
+    int s       = 0;
+    int size    = buffer_size;
+    int offset  = 0;
+
+    s = snprintf( buffer, size, "{\"id\":" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = json_encode_string( buffer + offset, size - offset, datastream_id );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    if( datapoint_count == 1 )
+    {
+        s = snprintf( buffer + offset, size - offset, "," );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+        s = json_encode_datapoint_members( buffer + offset, size - offset
+            , datapoints, "current_value" );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+    }
+    else
+    {
+        s = snprintf( buffer + offset, size - offset, ",\"datapoints\":[" );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+        for( size_t i = 0; i < datapoint_count; ++i )
+        {
+            if( i > 0 )
+            {
+                s = snprintf( buffer + offset, size - offset, "," );
+                XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+            }
+
+            s = json_encode_datapoint_in_place( buffer + offset, size - offset
+                , &datapoints[ i ] );
+            XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+        }
+
+        s = snprintf( buffer + offset, size - offset, "]" );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+    }
+
+    s = snprintf( buffer + offset, size - offset, "}" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+const char* json_encode_datapoint( const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( datapoint != 0 );
+
+    int s       = 0;
+    int size    = sizeof( XI_JSON_LOCAL_BUFFER );
+    int offset  = 0;
+
+    s = snprintf( XI_JSON_LOCAL_BUFFER, size, "{" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = json_encode_datapoint_members( XI_JSON_LOCAL_BUFFER + offset
+        , size - offset, datapoint, "current_value" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = snprintf( XI_JSON_LOCAL_BUFFER + offset, size - offset, "}" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    return XI_JSON_LOCAL_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+int json_encode_datapoint_in_place(
+      char* in, size_t in_size
+    , const xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( in != 0 );
+    assert( datapoint != 0 );
+
+    int s       = 0;
+    int size    = in_size;
+    int offset  = 0;
+
+    s = snprintf( in, size, "{" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = json_encode_datapoint_members( in + offset, size - offset
+        , datapoint, "value" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = snprintf( in + offset, size - offset, "}" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+const char* json_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* data )
+{
+    // PRECONDITIONS
+    assert( datastream_id != 0 );
+    assert( data != 0 );
+
+    int s       = 0;
+    int size    = sizeof( XI_JSON_LOCAL_BUFFER );
+    int offset  = 0;
+
+    s = snprintf( XI_JSON_LOCAL_BUFFER, size
+        , "{%s,\"datastreams\":[", XI_JSON_VERSION );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = json_encode_datastream( XI_JSON_LOCAL_BUFFER + offset, size - offset
+        , datastream_id, data, 1 );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    s = snprintf( XI_JSON_LOCAL_BUFFER + offset, size - offset, "]}" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    return XI_JSON_LOCAL_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+int json_encode_feed_in_place(
+      char* in, size_t in_size
+    , const xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( in != 0 );
+    assert( feed != 0 );
+
+    int s       = 0;
+    int size    = in_size;
+    int offset  = 0;
+
+    s = snprintf( in, size, "{%s,\"datastreams\":[", XI_JSON_VERSION );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    for( size_t i = 0; i < feed->datastream_count; ++i )
+    {
+        const xi_datastream_t* d = &feed->datastreams[ i ];
+
+        if( i > 0 )
+        {
+            s = snprintf( in + offset, size - offset, "," );
+            XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+        }
+
+        s = json_encode_datastream( in + offset, size - offset
+            , d->datastream_id, d->datapoints, d->datapoint_count );
+        XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+    }
+
+    s = snprintf( in + offset, size - offset, "]}" );
+    XI_CHECK_S( s, size, offset, XI_JSON_ENCODE_BUFFER_OVERRUN );
+
+    return offset;
+
+err_handling:
+    return -1;
+}
+
+//-----------------------------------------------------------------------
+// DECODERS
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Decodes the value, it tells its type the same way CSV does
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int json_decode_value( const json_token_t* token, xi_datapoint_t* p )
+{
+    char value[ XI_VALUE_STRING_MAX_SIZE ];
+
+    if( json_token_copy( value, sizeof( value ), token ) == -1 ) { return -1; }
+
+    return csv_decode_value( value, p ) == 0 ? -1 : 0;
+}
+
+/**
+ * \brief   Decodes the timestamp, the fraction of the second is optional
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int json_decode_timestamp( const json_token_t* token, xi_timestamp_t* timestamp )
+{
+    if( token->type != JSON_TOKEN_STRING ) { return -1; }
+
+    // the timestamps don't have escapes, the text is read where it is
+    return xi_iso8601_decode( token->data, token->size, timestamp ) < 0 ? -1 : 0;
+}
+
+/**
+ * \brief   Reads the name of the next member of the object and the token
+ *          its value begins with
+ *
+ * \return  `1` if there's a member, `0` if the object has ended or `-1` in
+ *          case of an error.
+ */
+static int json_next_member(
+      json_lexer_t* lexer
+    , json_token_t* name
+    , json_token_t* value )
+{
+    json_token_type_t type = json_next_token( lexer, name );
+
+    if( type == JSON_TOKEN_OBJECT_END ) { return 0; }
+    if( type != JSON_TOKEN_STRING ) { return -1; }
+
+    type = json_next_token( lexer, value );
+
+    if( type == JSON_TOKEN_ERROR || type == JSON_TOKEN_END
+        || type == JSON_TOKEN_OBJECT_END || type == JSON_TOKEN_ARRAY_END )
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * \brief   Decodes an element of `"datapoints"`, the object has been opened
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int json_decode_datapoint_object( json_lexer_t* lexer, xi_datapoint_t* p )
+{
+    json_token_t name, value;
+    int r = 0;
+
+    memset( p, 0, sizeof( xi_datapoint_t ) );
+
+    while( ( r = json_next_member( lexer, &name, &value ) ) == 1 )
+    {
+        if( json_token_equals( &name, "value" ) )
+        {
+            if( json_decode_value( &value, p ) == -1 ) { return -1; }
+        }
+        else if( json_token_equals( &name, "at" ) )
+        {
+            if( json_decode_timestamp( &value, &p->timestamp ) == -1 ) { return -1; }
+        }
+        else if( json_skip_value( lexer, &value ) == -1 )
+        {
+            return -1;
+        }
+    }
+
+    return r;
+}
+
+/**
+ * \brief   Decodes the datastream, the object has been opened
+ *
+ *    The datapoints, if there are any, take precedence over the current value.
+ *    If `total` is given, it's the history that's asked for: the datapoints
+ *    that don't fit are counted instead of failing the decoder and the current
+ *    value doesn't stand in for them.
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int json_decode_datastream_object(
+      json_lexer_t* lexer
+    , xi_datastream_t* d
+    , long* total )
+{
+    json_token_t name, value;
+    xi_datapoint_t current;
+    int has_current = 0;
+    int r = 0;
+
+    memset( &current, 0, sizeof( xi_datapoint_t ) );
+
+    d->datastream_id[ 0 ]   = '\0';
+    d->datapoint_count      = 0;
+
+    while( ( r = json_next_member( lexer, &name, &value ) ) == 1 )
+    {
+        if( json_token_equals( &name, "id" ) )
+        {
+            if( json_token_copy( d->datastream_id
+                , sizeof( d->datastream_id ), &value ) == -1 )
+            {
+                return -1;
+            }
+        }
+        else if( json_token_equals( &name, "current_value" ) )
+        {
+            if( json_decode_value( &value, &current ) == -1 ) { return -1; }
+            has_current = 1;
+        }
+        else if( json_token_equals( &name, "at" ) )
+        {
+            if( json_decode_timestamp( &value, &current.timestamp ) == -1 ) { return -1; }
+        }
+        else if( json_token_equals( &name, "datapoints" )
+            && value.type == JSON_TOKEN_ARRAY_BEGIN )
+        {
+            while( json_next_token( lexer, &value ) == JSON_TOKEN_OBJECT_BEGIN )
+            {
+                if( total ) { *total += 1; }
+
+                if( d->datapoint_count == XI_MAX_DATAPOINTS )
+                {
+                    if( total == 0 || json_skip_value( lexer, &value ) == -1 ) { return -1; }
+                    continue;
+                }
+
+                if( json_decode_datapoint_object( lexer
+                    , &d->datapoints[ d->datapoint_count ] ) == -1 )
+                {
+                    return -1;
+                }
+
+                d->datapoint_count += 1;
+            }
+
+            if( value.type != JSON_TOKEN_ARRAY_END ) { return -1; }
+        }
+        else if( json_skip_value( lexer, &value ) == -1 )
+        {
+            return -1;
+        }
+    }
+
+    if( r == -1 ) { return -1; }
+
+    if( d->datapoint_count == 0 && has_current && total == 0 )
+    {
+        d->datapoints[ 0 ]  = current;
+        d->datapoint_count  = 1;
+    }
+
+    return 0;
+}
+
+xi_feed_t* json_decode_feed(
+      const char* buffer
+    , size_t buffer_size
+    , xi_feed_t* feed )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( feed != 0 );
+
+    json_lexer_t lexer;
+    json_token_t name, value;
+    size_t counter = 0;
+    int r = 0;
+
+    json_lexer_init( &lexer, buffer, buffer_size );
+
+    XI_CHECK_CND( json_next_token( &lexer, &value ) != JSON_TOKEN_OBJECT_BEGIN
+        , XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+    while( ( r = json_next_member( &lexer, &name, &value ) ) == 1 )
+    {
+        if( json_token_equals( &name, "datastreams" )
+            && value.type == JSON_TOKEN_ARRAY_BEGIN )
+        {
+            while( json_next_token( &lexer, &value ) == JSON_TOKEN_OBJECT_BEGIN )
+            {
+                XI_CHECK_CND( counter == XI_MAX_DATASTREAMS
+                    , XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+                XI_CHECK_CND( json_decode_datastream_object(
+                      &lexer, &feed->datastreams[ counter ], 0 ) == -1
+                    , XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+                counter += 1;
+            }
+
+            XI_CHECK_CND( value.type != JSON_TOKEN_ARRAY_END
+                , XI_JSON_DECODE_FEED_PARSER_ERROR );
+        }
+        else
+        {
+            XI_CHECK_CND( json_skip_value( &lexer, &value ) == -1
+                , XI_JSON_DECODE_FEED_PARSER_ERROR );
+        }
+    }
+
+    XI_CHECK_CND( r == -1, XI_JSON_DECODE_FEED_PARSER_ERROR );
+
+    feed->datastream_count = counter;
+    return feed;
+
+err_handling:
+    return 0;
+}
+
+xi_datapoint_t* json_decode_datapoint(
+      const char* buffer
+    , size_t buffer_size
+    , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datapoint != 0 );
+
+    json_lexer_t lexer;
+    json_token_t token;
+    xi_datastream_t datastream;
+
+    json_lexer_init( &lexer, buffer, buffer_size );
+
+    XI_CHECK_CND( json_next_token( &lexer, &token ) != JSON_TOKEN_OBJECT_BEGIN
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    XI_CHECK_CND( json_decode_datastream_object( &lexer, &datastream, 0 ) == -1
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    XI_CHECK_CND( datastream.datapoint_count == 0
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    // the datapoints come oldest first
+    *datapoint = datastream.datapoints[ datastream.datapoint_count - 1 ];
+
+    return datapoint;
+
+err_handling:
+    return 0;
+}
+
+long json_decode_datastream_history(
+      const char* buffer
+    , size_t buffer_size
+    , xi_datastream_t* datastream )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( datastream != 0 );
+
+    json_lexer_t lexer;
+    json_token_t token;
+    long total = 0;
+
+    json_lexer_init( &lexer, buffer, buffer_size );
+
+    XI_CHECK_CND( json_next_token( &lexer, &token ) != JSON_TOKEN_OBJECT_BEGIN
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    XI_CHECK_CND( json_decode_datastream_object( &lexer, datastream, &total ) == -1
+        , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR );
+
+    return total;
+
+err_handling:
+    return -1;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_data.h
+ * \brief   Implements JSON _data layer_ encoders and decoders specific to Xively JSON data format
+ */
+
+#ifndef __JSON_DATA_H__
+#define __JSON_DATA_H__
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* json_encode_datapoint( const xi_datapoint_t* dp );
+
+int json_encode_datapoint_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_datapoint_t* datapoint );
+
+const char* json_encode_create_datastream(
+          const char* datastream_id
+        , const xi_datapoint_t* dp );
+
+int json_encode_feed_in_place(
+      char* buffer, size_t buffer_size
+    , const xi_feed_t* feed );
+
+xi_feed_t* json_decode_feed(
+      const char* buffer
+    , size_t buffer_size
+    , xi_feed_t* feed );
+
+xi_datapoint_t* json_decode_datapoint(
+      const char* data
+    , size_t data_size
+    , xi_datapoint_t* dp );
+
+long json_decode_datastream_history(
+      const char* data
+    , size_t data_size
+    , xi_datastream_t* datastream );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __JSON_DATA_H__
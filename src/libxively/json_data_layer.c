@@ -0,0 +1,29 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_data_layer.c
+ * \brief   Implements JSON _data layer_ abstration interface [see json_data_layer.h and data_layer.h]
+ */
+
+#include <string.h>
+
+#include "json_data_layer.h"
+
+const data_layer_t* get_json_data_layer()
+{
+    static const data_layer_t __json_data_layer = {
+          json_encode_datapoint
+        , json_encode_datapoint_in_place
+        , json_encode_create_datastream
+        , json_encode_feed_in_place
+        , strlen
+        , json_decode_feed
+        , json_decode_datapoint
+        , json_decode_datastream_history
+        , "json"
+        , "application/json"
+    };
+
+    return &__json_data_layer;
+}
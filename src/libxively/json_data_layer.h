@@ -0,0 +1,32 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_data_layer.h
+ * \brief   Implements JSON _data layer_ abstration interface
+ */
+
+#ifndef __JSON_DATA_LAYER_H__
+#define __JSON_DATA_LAYER_H__
+
+#include "xively.h"
+#include "data_layer.h"
+#include "json_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Initialise JSON implementation of the _data layer_
+ *
+ * \return  Structure with function pointers for JSON encoders and decoders
+ *          which had been implemented in `json_data.c`.
+ */
+const data_layer_t* get_json_data_layer( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __JSON_DATA_LAYER_H__
@@ -0,0 +1,328 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_lexer.c
+ * \brief   Splits JSON text into tokens, one at a time [see json_lexer.h]
+ */
+
+#include <string.h>
+
+#include "json_lexer.h"
+#include "xi_debug.h"
+
+void json_lexer_init( json_lexer_t* lexer, const char* data, size_t size )
+{
+    // PRECONDITIONS
+    assert( lexer != 0 );
+    assert( data != 0 );
+
+    lexer->current  = data;
+    lexer->end      = data + size;
+}
+
+/**
+ * \brief   Reads the rest of the string, the opening quote has been read
+ */
+static json_token_type_t json_read_string( json_lexer_t* lexer, json_token_t* token )
+{
+    const char* p = lexer->current;
+
+    token->data = p;
+
+    while( p < lexer->end && *p != '"' )
+    {
+        // whatever follows the backslash can't end the string
+        if( *p == '\\' ) { ++p; }
+        else if( ( unsigned char ) *p < 0x20 ) { return JSON_TOKEN_ERROR; }
+
+        ++p;
+    }
+
+    if( p >= lexer->end ) { return JSON_TOKEN_ERROR; }
+
+    token->size     = p - token->data;
+    lexer->current  = p + 1;
+
+    return JSON_TOKEN_STRING;
+}
+
+/**
+ * \brief   Reads a number or a literal, the validation is left to whoever
+ *          converts it
+ */
+static json_token_type_t json_read_word(
+      json_lexer_t* lexer
+    , json_token_t* token
+    , json_token_type_t type )
+{
+    const char* p = lexer->current;
+
+    token->data = p;
+
+    while( p < lexer->end )
+    {
+        char c = *p;
+
+        if( c == ',' || c == ':' || c == ']' || c == '}' || c == '"'
+            || c == ' ' || c == '\t' || c == '\r' || c == '\n' )
+        {
+            break;
+        }
+
+        ++p;
+    }
+
+    token->size     = p - token->data;
+    lexer->current  = p;
+
+    return type;
+}
+
+json_token_type_t json_next_token( json_lexer_t* lexer, json_token_t* token )
+{
+    // PRECONDITIONS
+    assert( lexer != 0 );
+    assert( token != 0 );
+
+    token->data = 0;
+    token->size = 0;
+
+    while( lexer->current < lexer->end )
+    {
+        char c = *lexer->current++;
+
+        switch( c )
+        {
+            case ' ': case '\t': case '\r': case '\n':
+            case ',': case ':':
+                continue;
+            case '{':
+                token->type = JSON_TOKEN_OBJECT_BEGIN;
+                return token->type;
+            case '}':
+                token->type = JSON_TOKEN_OBJECT_END;
+                return token->type;
+            case '[':
+                token->type = JSON_TOKEN_ARRAY_BEGIN;
+                return token->type;
+            case ']':
+                token->type = JSON_TOKEN_ARRAY_END;
+                return token->type;
+            case '"':
+                token->type = json_read_string( lexer, token );
+                return token->type;
+            case '-':
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                lexer->current -= 1;
+                token->type = json_read_word( lexer, token, JSON_TOKEN_NUMBER );
+                return token->type;
+            case 't': case 'f': case 'n':
+                lexer->current -= 1;
+                token->type = json_read_word( lexer, token, JSON_TOKEN_LITERAL );
+                return token->type;
+            case '\0':
+                // the buffers the layers pass are terminated
+                lexer->current = lexer->end;
+                break;
+            default:
+                token->type = JSON_TOKEN_ERROR;
+                return token->type;
+        }
+    }
+
+    token->type = JSON_TOKEN_END;
+    return token->type;
+}
+
+int json_skip_value( json_lexer_t* lexer, const json_token_t* token )
+{
+    // PRECONDITIONS
+    assert( lexer != 0 );
+    assert( token != 0 );
+
+    size_t depth = 0;
+    json_token_t next = *token;
+
+    for( ;; )
+    {
+        switch( next.type )
+        {
+            case JSON_TOKEN_OBJECT_BEGIN:
+            case JSON_TOKEN_ARRAY_BEGIN:
+                depth += 1;
+                break;
+            case JSON_TOKEN_OBJECT_END:
+            case JSON_TOKEN_ARRAY_END:
+                if( depth == 0 ) { return -1; }
+                depth -= 1;
+                break;
+            case JSON_TOKEN_STRING:
+            case JSON_TOKEN_NUMBER:
+            case JSON_TOKEN_LITERAL:
+                break;
+            default:
+                return -1;
+        }
+
+        if( depth == 0 ) { return 0; }
+
+        json_next_token( lexer, &next );
+    }
+}
+
+int json_token_equals( const json_token_t* token, const char* string )
+{
+    // PRECONDITIONS
+    assert( token != 0 );
+    assert( string != 0 );
+
+    return token->type == JSON_TOKEN_STRING
+        && strlen( string ) == token->size
+        && memcmp( token->data, string, token->size ) == 0;
+}
+
+/**
+ * \brief   Reads the four hex digits of `\u` escape
+ *
+ * \return  The code unit or `-1` if the digits are invalid.
+ */
+static long json_read_hex4( const char* p, const char* end )
+{
+    long value = 0;
+
+    if( end - p < 4 ) { return -1; }
+
+    for( int i = 0; i < 4; ++i )
+    {
+        char c = p[ i ];
+
+        value <<= 4;
+
+        if( c >= '0' && c <= '9' )      { value |= c - '0'; }
+        else if( c >= 'a' && c <= 'f' ) { value |= c - 'a' + 10; }
+        else if( c >= 'A' && c <= 'F' ) { value |= c - 'A' + 10; }
+        else { return -1; }
+    }
+
+    return value;
+}
+
+/**
+ * \brief   Writes the code point as UTF-8
+ *
+ * \return  Number of bytes written or `0` if they don't fit.
+ */
+static size_t json_put_utf8( char* dst, size_t left, long cp )
+{
+    if( cp < 0x80 )
+    {
+        if( left < 1 ) { return 0; }
+        dst[ 0 ] = ( char ) cp;
+        return 1;
+    }
+
+    if( cp < 0x800 )
+    {
+        if( left < 2 ) { return 0; }
+        dst[ 0 ] = ( char ) ( 0xc0 | ( cp >> 6 ) );
+        dst[ 1 ] = ( char ) ( 0x80 | ( cp & 0x3f ) );
+        return 2;
+    }
+
+    if( cp < 0x10000 )
+    {
+        if( left < 3 ) { return 0; }
+        dst[ 0 ] = ( char ) ( 0xe0 | ( cp >> 12 ) );
+        dst[ 1 ] = ( char ) ( 0x80 | ( ( cp >> 6 ) & 0x3f ) );
+        dst[ 2 ] = ( char ) ( 0x80 | ( cp & 0x3f ) );
+        return 3;
+    }
+
+    if( left < 4 ) { return 0; }
+    dst[ 0 ] = ( char ) ( 0xf0 | ( cp >> 18 ) );
+    dst[ 1 ] = ( char ) ( 0x80 | ( ( cp >> 12 ) & 0x3f ) );
+    dst[ 2 ] = ( char ) ( 0x80 | ( ( cp >> 6 ) & 0x3f ) );
+    dst[ 3 ] = ( char ) ( 0x80 | ( cp & 0x3f ) );
+    return 4;
+}
+
+int json_token_copy( char* buffer, size_t buffer_size, const json_token_t* token )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( buffer_size != 0 );
+    assert( token != 0 );
+
+    if( token->type != JSON_TOKEN_STRING && token->type != JSON_TOKEN_NUMBER
+        && token->type != JSON_TOKEN_LITERAL )
+    {
+        return -1;
+    }
+
+    const char* p   = token->data;
+    const char* end = token->data + token->size;
+    size_t size     = 0;
+
+    // leave room for the terminator
+    const size_t capacity = buffer_size - 1;
+
+    while( p < end )
+    {
+        if( *p != '\\' )
+        {
+            if( size == capacity ) { return -1; }
+            buffer[ size++ ] = *p++;
+            continue;
+        }
+
+        if( ++p == end ) { return -1; }
+
+        char c = *p++;
+        long cp = 0;
+
+        switch( c )
+        {
+            case '"':   cp = '"';   break;
+            case '\\':  cp = '\\';  break;
+            case '/':   cp = '/';   break;
+            case 'b':   cp = '\b';  break;
+            case 'f':   cp = '\f';  break;
+            case 'n':   cp = '\n';  break;
+            case 'r':   cp = '\r';  break;
+            case 't':   cp = '\t';  break;
+            case 'u':
+                cp = json_read_hex4( p, end );
+                if( cp == -1 ) { return -1; }
+                p += 4;
+
+                // the characters past the BMP come in surrogate pairs
+                if( cp >= 0xd800 && cp < 0xdc00 )
+                {
+                    if( end - p < 6 || p[ 0 ] != '\\' || p[ 1 ] != 'u' ) { return -1; }
+
+                    long low = json_read_hex4( p + 2, end );
+                    if( low < 0xdc00 || low >= 0xe000 ) { return -1; }
+                    p += 6;
+
+                    cp = 0x10000 + ( ( cp - 0xd800 ) << 10 ) + ( low - 0xdc00 );
+                }
+                else if( cp >= 0xdc00 && cp < 0xe000 )
+                {
+                    return -1;
+                }
+                break;
+            default:
+                return -1;
+        }
+
+        size_t s = json_put_utf8( buffer + size, capacity - size, cp );
+        if( s == 0 ) { return -1; }
+        size += s;
+    }
+
+    buffer[ size ] = '\0';
+
+    return ( int ) size;
+}
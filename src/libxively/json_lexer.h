@@ -0,0 +1,88 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    json_lexer.h
+ * \brief   Splits JSON text into tokens, one at a time, without allocating
+ *
+ *    The tokens point into the text, so nothing is copied until the decoder
+ *    knows where the value goes (e.g. straight into `xi_datapoint_t`) and
+ *    there's no tree built for the whole document.
+ */
+
+#ifndef __JSON_LEXER_H__
+#define __JSON_LEXER_H__
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+      JSON_TOKEN_ERROR = -1     //!< the text isn't valid JSON
+    , JSON_TOKEN_END            //!< nothing but white space is left
+    , JSON_TOKEN_OBJECT_BEGIN
+    , JSON_TOKEN_OBJECT_END
+    , JSON_TOKEN_ARRAY_BEGIN
+    , JSON_TOKEN_ARRAY_END
+    , JSON_TOKEN_STRING         //!< the quotes are left out, the escapes are not decoded
+    , JSON_TOKEN_NUMBER
+    , JSON_TOKEN_LITERAL        //!< `true`, `false` or `null`
+} json_token_type_t;
+
+typedef struct {
+    json_token_type_t   type;
+    const char*         data;
+    size_t              size;
+} json_token_t;
+
+/**
+ * \brief   Where the lexer is in the text
+ */
+typedef struct {
+    const char* current;
+    const char* end;
+} json_lexer_t;
+
+/**
+ * \brief   Prepares the lexer for the text, which doesn't have to be terminated
+ */
+void json_lexer_init( json_lexer_t* lexer, const char* data, size_t size );
+
+/**
+ * \brief   Reads the next token
+ *
+ * \note    The separators (`:` and `,`) are skipped as white space, it's up to
+ *          the decoder to tell the names of the members from their values.
+ *
+ * \return  The type of the token.
+ */
+json_token_type_t json_next_token( json_lexer_t* lexer, json_token_t* token );
+
+/**
+ * \brief   Skips the value which begins with the token that has been read,
+ *          along with whatever is nested in it
+ *
+ * \return  `0` on success or `-1` if the text ends or isn't valid.
+ */
+int json_skip_value( json_lexer_t* lexer, const json_token_t* token );
+
+/**
+ * \brief   Tells whether the token is the given string
+ */
+int json_token_equals( const json_token_t* token, const char* string );
+
+/**
+ * \brief   Copies the string, the number or the literal into the buffer and
+ *          terminates it, the escapes are decoded on the way
+ *
+ * \return  Length of the copy or `-1` if it doesn't fit or is invalid.
+ */
+int json_token_copy( char* buffer, size_t buffer_size, const json_token_t* token );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __JSON_LEXER_H__
@@ -0,0 +1,64 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    tcp_transport.c
+ * \brief   Implements TCP socket _transport layer_ abstraction interface [see tcp_transport.h and transport_layer.h]
+ */
+
+#include "tcp_transport_layer.h"
+#include "tcp_transport.h"
+
+transport_layer_t* get_tcp_transport_layer( void )
+{
+    static transport_layer_t __tcp_transport_layer =
+    {
+          &tcp_encode_update_feed
+        , &tcp_encode_get_feed
+        , &tcp_encode_create_datastream
+        , &tcp_encode_update_datastream
+        , &tcp_encode_get_datastream
+        , 0 // the history is only asked for over HTTP
+        , &tcp_encode_delete_datastream
+        , &tcp_encode_delete_datapoint
+        , &tcp_encode_datapoint_delete_range
+        , &tcp_encode_subscribe
+        , &tcp_decode_reply
+        , &tcp_decode_update
+        , 0 // no pings
+        , &tcp_response_size
+        , 0 // no handshake
+        , 0
+        , XI_TCP_PORT
+        , 0
+    };
+
+    return &__tcp_transport_layer;
+}
+
+transport_layer_t* get_tcps_transport_layer( void )
+{
+    static transport_layer_t __tcps_transport_layer =
+    {
+          &tcp_encode_update_feed
+        , &tcp_encode_get_feed
+        , &tcp_encode_create_datastream
+        , &tcp_encode_update_datastream
+        , &tcp_encode_get_datastream
+        , 0 // the history is only asked for over HTTP
+        , &tcp_encode_delete_datastream
+        , &tcp_encode_delete_datapoint
+        , &tcp_encode_datapoint_delete_range
+        , &tcp_encode_subscribe
+        , &tcp_decode_reply
+        , &tcp_decode_update
+        , 0 // no pings
+        , &tcp_response_size
+        , 0 // no handshake
+        , 0
+        , XI_TCPS_PORT
+        , 1 // over TLS
+    };
+
+    return &__tcps_transport_layer;
+}
@@ -0,0 +1,716 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    tcp_transport_layer.c
+ * \brief   Implements TCP _transport layer_ encoders and decoders specific to Xively socket API [see tcp_transport_layer.h]
+ *
+ *    Each request is a single line of JSON, which names the method and the
+ *    resource the same way the REST API does, e.g.:
+ *
+ *    {"method":"put","resource":"/feeds/128/datastreams/temp.csv","headers":{"X-ApiKey":"key"},"body":"21.5\n"}
+ *
+ *    and the server answers with a line of JSON as well, that carries the
+ *    status and the body of the response, e.g.:
+ *
+ *    {"status":200,"resource":"/feeds/128/datastreams/temp.csv","body":"2013-01-01T18:44:21.423452Z,21.5\n"}
+ *
+ *    The body is whatever the _data layer_ produces, it only gets escaped to
+ *    become a JSON string, so the data layers don't need to know about it.
+ *
+ *    Once subscribed to a datastream, the server pushes it's updates in the
+ *    same form, only without the status:
+ *
+ *    {"resource":"/feeds/128/datastreams/temp.csv","body":"2013-01-01T18:44:21.423452Z,21.5\n"}
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tcp_transport_layer.h"
+#include "xi_macros.h"
+#include "xi_helpers.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_time.h"
+#include "xi_iso8601.h"
+
+static const char XI_TCP_TEMPLATE_REQUEST[] =
+    "{\"method\":\"%s\",\"resource\":\"/feeds%s.csv%s\",\"headers\":{\"X-ApiKey\":\"%s\"}";
+
+static const char XI_TCP_BODY_BEGIN[]   = ",\"body\":\"";
+static const char XI_TCP_REQUEST_END[]  = "}\n";
+
+static const char XI_TCP_QUERY_GET[]            = "get";
+static const char XI_TCP_QUERY_PUT[]            = "put";
+static const char XI_TCP_QUERY_POST[]           = "post";
+static const char XI_TCP_QUERY_DELETE[]         = "delete";
+static const char XI_TCP_QUERY_SUBSCRIBE[]      = "subscribe";
+static const char XI_TCP_QUERY_UNSUBSCRIBE[]    = "unsubscribe";
+
+static const char XI_TCP_RESOURCE_FEEDS[]       = "/feeds/";
+static const char XI_TCP_RESOURCE_DATASTREAMS[] = "/datastreams/";
+static const char XI_TCP_RESOURCE_SUFFIX[]      = ".csv";
+
+static XI_THREAD_LOCAL char XI_TCP_QUERY_BUFFER[ XI_QUERY_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_TCP_ID_BUFFER[ XI_ID_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_TCP_QUERY_DATA[ XI_CONTENT_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_TCP_BODY_BUFFER[ 2 * XI_CONTENT_BUFFER_SIZE ];
+static XI_THREAD_LOCAL xi_request_t XI_TCP_REQUEST;
+
+/**
+ * \brief   Writes the body as the `"body"` member of the request
+ *
+ * \return  Number of characters written or `-1` if it doesn't fit.
+ */
+static int tcp_encode_body( const char* data )
+{
+    char* dst       = XI_TCP_BODY_BUFFER;
+    // leave room for the closing quote
+    const char* end = XI_TCP_BODY_BUFFER + sizeof( XI_TCP_BODY_BUFFER ) - 1;
+
+    memcpy( dst, XI_TCP_BODY_BEGIN, sizeof( XI_TCP_BODY_BEGIN ) - 1 );
+    dst += sizeof( XI_TCP_BODY_BEGIN ) - 1;
+
+    for( const char* p = data; *p != '\0'; ++p )
+    {
+        const unsigned char c = ( unsigned char ) *p;
+        char escaped          = 0;
+
+        switch( c )
+        {
+            case '"':   escaped = '"';  break;
+            case '\\':  escaped = '\\'; break;
+            case '\n':  escaped = 'n';  break;
+            case '\r':  escaped = 'r';  break;
+            case '\t':  escaped = 't';  break;
+            default:                    break;
+        }
+
+        if( escaped )
+        {
+            if( end - dst < 2 ) { return -1; }
+            *dst++ = '\\';
+            *dst++ = escaped;
+        }
+        else if( c < 0x20 )
+        {
+            if( end - dst < 6 ) { return -1; }
+            dst += sprintf( dst, "\\u%04x", c );
+        }
+        else
+        {
+            if( end - dst < 1 ) { return -1; }
+            *dst++ = ( char ) c;
+        }
+    }
+
+    *dst++ = '"';
+
+    return dst - XI_TCP_BODY_BUFFER;
+}
+
+/**
+ * \brief   Puts the request together out of the header, the body and the
+ *          end of the frame, nothing is copied until they're sent
+ */
+static const xi_request_t* tcp_encode_request(
+      const char* method
+    , const char* id
+    , const char* suffix
+    , const char* x_api_key
+    , const char* data )
+{
+    // PRECONDITIONS
+    assert( method != 0 );
+    assert( x_api_key != 0 );
+
+    int s = snprintf( XI_TCP_QUERY_BUFFER, sizeof( XI_TCP_QUERY_BUFFER )
+        , XI_TCP_TEMPLATE_REQUEST, method, id ? id : "", suffix ? suffix : ""
+        , x_api_key );
+
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_TCP_QUERY_BUFFER ), XI_TCP_ENCODE_REQUEST );
+
+    XI_TCP_REQUEST.count = 0;
+
+    if( xi_request_append( &XI_TCP_REQUEST, XI_TCP_QUERY_BUFFER, s ) == -1 )
+    {
+        return 0;
+    }
+
+    if( data != 0 )
+    {
+        int body_size = tcp_encode_body( data );
+
+        XI_CHECK_CND( body_size < 0, XI_TCP_ENCODE_REQUEST );
+
+        if( xi_request_append( &XI_TCP_REQUEST, XI_TCP_BODY_BUFFER, body_size ) == -1 )
+        {
+            return 0;
+        }
+    }
+
+    if( xi_request_append( &XI_TCP_REQUEST
+        , XI_TCP_REQUEST_END, sizeof( XI_TCP_REQUEST_END ) - 1 ) == -1 )
+    {
+        return 0;
+    }
+
+    return &XI_TCP_REQUEST;
+
+err_handling:
+    return 0;
+}
+
+/**
+ * \brief   Formats the id of a datastream, or of the collection of them if
+ *          there's no `datastream_id`
+ */
+static const char* tcp_construct_datastream_id(
+      xi_feed_id_t feed_id
+    , const char* datastream_id )
+{
+    int s = datastream_id
+        ? snprintf( XI_TCP_ID_BUFFER, sizeof( XI_TCP_ID_BUFFER )
+            , "/%u/datastreams/%s", ( unsigned ) feed_id, datastream_id )
+        : snprintf( XI_TCP_ID_BUFFER, sizeof( XI_TCP_ID_BUFFER )
+            , "/%u/datastreams", ( unsigned ) feed_id );
+
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_TCP_ID_BUFFER ), XI_TCP_ENCODE_REQUEST );
+
+    return XI_TCP_ID_BUFFER;
+
+err_handling:
+    return 0;
+}
+
+
+const xi_request_t* tcp_encode_create_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    const char* data = data_layer->encode_create_datastream(
+        datastream_id, datapoint );
+
+    if( data == 0 ) { return 0; }
+
+    const char* id = tcp_construct_datastream_id( feed_id, 0 );
+
+    if( id == 0 ) { return 0; }
+
+    return tcp_encode_request( XI_TCP_QUERY_POST, id, 0, x_api_key, data );
+}
+
+const xi_request_t* tcp_encode_update_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    const char* data = data_layer->encode_datapoint( datapoint );
+
+    if( data == 0 ) { return 0; }
+
+    const char* id = tcp_construct_datastream_id( feed_id, datastream_id );
+
+    if( id == 0 ) { return 0; }
+
+    return tcp_encode_request( XI_TCP_QUERY_PUT, id, 0, x_api_key, data );
+}
+
+const xi_request_t* tcp_encode_get_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id )
+{
+    XI_UNUSED( data_layer );
+
+    const char* id = tcp_construct_datastream_id( feed_id, datastream_id );
+
+    if( id == 0 ) { return 0; }
+
+    return tcp_encode_request( XI_TCP_QUERY_GET, id, 0, x_api_key, 0 );
+}
+
+const xi_request_t* tcp_encode_delete_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id )
+{
+    XI_UNUSED( data_layer );
+
+    const char* id = tcp_construct_datastream_id( feed_id, datastream_id );
+
+    if( id == 0 ) { return 0; }
+
+    return tcp_encode_request( XI_TCP_QUERY_DELETE, id, 0, x_api_key, 0 );
+}
+
+const xi_request_t* tcp_encode_delete_datapoint(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o )
+{
+    XI_UNUSED( data_layer );
+
+    const char* id = tcp_construct_datastream_id( feed_id, datastream_id );
+
+    if( id == 0 ) { return 0; }
+
+    {
+        int offset  = strlen( XI_TCP_ID_BUFFER );
+        int size    = sizeof( XI_TCP_ID_BUFFER );
+        int s       = snprintf( XI_TCP_ID_BUFFER + offset, size - offset, "/datapoints/" );
+
+        XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+
+        s = xi_iso8601_encode( XI_TCP_ID_BUFFER + offset, size - offset, &o->timestamp );
+
+        XI_CHECK_CND( s < 0, XI_TCP_ENCODE_REQUEST );
+    }
+
+    return tcp_encode_request( XI_TCP_QUERY_DELETE, id, 0, x_api_key, 0 );
+
+err_handling:
+    return 0;
+}
+
+const xi_request_t* tcp_encode_update_feed(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , const xi_feed_t* feed )
+{
+    // prepare buffer
+    XI_CLEAR_STATIC_BUFFER( XI_TCP_QUERY_DATA );
+
+    // PRECONDITIONS
+    assert( data_layer != 0 );
+    assert( x_api_key != 0 );
+    assert( feed != 0 );
+
+    { // data part preparation
+        int offset  = 0;
+        int size    = sizeof( XI_TCP_QUERY_DATA );
+        int s       = 0;
+
+        // for each datastream
+        //      generate the list of datapoints that you want to update
+        for( size_t i = 0; i < feed->datastream_count; ++i )
+        {
+            const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
+
+            // for each datapoint
+            for( size_t j = 0; j < curr_datastream->datapoint_count; ++j )
+            {
+                const xi_datapoint_t* curr_datapoint
+                    = &curr_datastream->datapoints[ j ];
+
+                // add the datastream id to the buffer
+                s = snprintf(
+                      XI_TCP_QUERY_DATA + offset, XI_MAX( size - offset, 0 ), "%s,"
+                    , curr_datastream->datastream_id );
+
+                XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+
+                // add the datapoint data to the buffer
+                s = data_layer->encode_datapoint_in_place(
+                      XI_TCP_QUERY_DATA + offset, XI_MAX( size - offset, 0 )
+                    , curr_datapoint );
+
+                XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+            }
+        }
+    }
+
+    {
+        int s = snprintf( XI_TCP_ID_BUFFER, sizeof( XI_TCP_ID_BUFFER )
+            , "/%u", ( unsigned ) feed->feed_id );
+
+        XI_CHECK_SIZE( s, ( int ) sizeof( XI_TCP_ID_BUFFER ), XI_TCP_ENCODE_REQUEST );
+    }
+
+    return tcp_encode_request( XI_TCP_QUERY_PUT
+        , XI_TCP_ID_BUFFER, 0, x_api_key, XI_TCP_QUERY_DATA );
+
+err_handling:
+    return 0;
+}
+
+const xi_request_t* tcp_encode_get_feed(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , const xi_feed_t* feed )
+{
+    // prepare buffer
+    XI_CLEAR_STATIC_BUFFER( XI_TCP_QUERY_DATA );
+
+    // PRECONDITIONS
+    assert( data_layer != 0 );
+    assert( x_api_key != 0 );
+    assert( feed != 0 );
+
+    { // data part preparation
+        int offset  = 0;
+        int size    = sizeof( XI_TCP_QUERY_DATA );
+        int s       = 0;
+
+        // for each datastream
+        //      generate the list of datastreams that you want to get
+        for( size_t i = 0; i < feed->datastream_count; ++i )
+        {
+            const xi_datastream_t* curr_datastream = &feed->datastreams[ i ];
+
+            s = snprintf(
+                  XI_TCP_QUERY_DATA + offset, XI_MAX( size - offset, 0 ), i == 0 ? "?datastreams=%s" : ",%s"
+                , curr_datastream->datastream_id );
+
+            XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+        }
+    }
+
+    {
+        int s = snprintf( XI_TCP_ID_BUFFER, sizeof( XI_TCP_ID_BUFFER )
+            , "/%u", ( unsigned ) feed->feed_id );
+
+        XI_CHECK_SIZE( s, ( int ) sizeof( XI_TCP_ID_BUFFER ), XI_TCP_ENCODE_REQUEST );
+    }
+
+    return tcp_encode_request( XI_TCP_QUERY_GET
+        , XI_TCP_ID_BUFFER, XI_TCP_QUERY_DATA, x_api_key, 0 );
+
+err_handling:
+    return 0;
+}
+
+const xi_request_t* tcp_encode_datapoint_delete_range(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end )
+{
+    XI_UNUSED( data_layer );
+
+    // just set an error
+    XI_CHECK_CND( start == 0 && end == 0, XI_TCP_ENCODE_REQUEST );
+
+    {
+        int offset  = 0;
+        int size    = sizeof( XI_TCP_QUERY_DATA );
+        int s       = 0;
+
+        if( start )
+        {
+            s = snprintf( XI_TCP_QUERY_DATA, size, "?start=" );
+
+            XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+
+            s = xi_iso8601_encode( XI_TCP_QUERY_DATA + offset, size - offset, start );
+
+            XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+        }
+
+        if( end )
+        {
+            s = snprintf( XI_TCP_QUERY_DATA + offset, size - offset
+                , start ? "&end=" : "?end=" );
+
+            XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+
+            s = xi_iso8601_encode( XI_TCP_QUERY_DATA + offset, size - offset, end );
+
+            XI_CHECK_S( s, size, offset, XI_TCP_ENCODE_REQUEST );
+        }
+    }
+
+    {
+        int s = snprintf( XI_TCP_ID_BUFFER, sizeof( XI_TCP_ID_BUFFER )
+            , "/%u/datastreams/%s/datapoints", ( unsigned ) feed_id, datastream_id );
+
+        XI_CHECK_SIZE( s, ( int ) sizeof( XI_TCP_ID_BUFFER ), XI_TCP_ENCODE_REQUEST );
+    }
+
+    return tcp_encode_request( XI_TCP_QUERY_DELETE
+        , XI_TCP_ID_BUFFER, XI_TCP_QUERY_DATA, x_api_key, 0 );
+
+err_handling:
+    return 0;
+}
+
+const xi_request_t* tcp_encode_subscribe(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , int subscribe )
+{
+    XI_UNUSED( data_layer );
+
+    const char* id = tcp_construct_datastream_id( feed_id, datastream_id );
+
+    if( id == 0 ) { return 0; }
+
+    return tcp_encode_request( subscribe ? XI_TCP_QUERY_SUBSCRIBE : XI_TCP_QUERY_UNSUBSCRIBE
+        , id, 0, x_api_key, 0 );
+}
+
+/**
+ * \brief   Finds the value of the `name` member
+ *
+ * \note    The members we look for are never nested, and a key can't match
+ *          within a string value as the quotes there are escaped.
+ */
+static char* tcp_find_member( char* data, const char* name )
+{
+    char* p = strstr( data, name );
+
+    if( p == 0 ) { return 0; }
+
+    p += strlen( name );
+
+    while( *p == ' ' || *p == '\t' ) { ++p; }
+
+    if( *p != ':' ) { return 0; }
+
+    ++p;
+
+    while( *p == ' ' || *p == '\t' ) { ++p; }
+
+    return p;
+}
+
+/**
+ * \brief   Unescapes the JSON string which begins after the opening quote
+ *          in place and terminates it
+ *
+ * \return  Size of the unescaped string or `-1` if it's malformed.
+ */
+static long tcp_unescape_string( char* data )
+{
+    char* dst = data;
+
+    for( const char* p = data; *p != '\0'; ++p )
+    {
+        if( *p == '"' )
+        {
+            *dst = '\0';
+            return dst - data;
+        }
+
+        if( *p != '\\' )
+        {
+            *dst++ = *p;
+            continue;
+        }
+
+        switch( *++p )
+        {
+            case '"':   *dst++ = '"';   break;
+            case '\\':  *dst++ = '\\';  break;
+            case '/':   *dst++ = '/';   break;
+            case 'b':   *dst++ = '\b';  break;
+            case 'f':   *dst++ = '\f';  break;
+            case 'n':   *dst++ = '\n';  break;
+            case 'r':   *dst++ = '\r';  break;
+            case 't':   *dst++ = '\t';  break;
+            case 'u':
+            {
+                char hex[ 5 ] = { 0 };
+                char* hex_end = 0;
+
+                if( strlen( p + 1 ) < 4 ) { return -1; }
+
+                memcpy( hex, p + 1, 4 );
+                long c = strtol( hex, &hex_end, 16 );
+
+                if( hex_end != hex + 4 ) { return -1; }
+
+                // the data layers only deal with ASCII
+                *dst++ = c < 0x80 ? ( char ) c : '?';
+                p += 4;
+                break;
+            }
+            default:
+                return -1;
+        }
+    }
+
+    // no closing quote
+    return -1;
+}
+
+const xi_response_t* tcp_decode_reply(
+          const data_layer_t* data_layer
+        , char* data )
+{
+    XI_UNUSED( data_layer );
+
+    static XI_THREAD_LOCAL xi_response_t __tmp;
+    http_response_t* response = &__tmp.http;
+
+    memset( &__tmp, 0, sizeof( __tmp ) );
+
+    // the connection stays open between the requests, which is what
+    // HTTP/1.1 does by default
+    response->http_version1 = 1;
+    response->http_version2 = 1;
+
+    {
+        const char* status = tcp_find_member( data, "\"status\"" );
+
+        XI_CHECK_ZERO( status, XI_TCP_PARSE_ERROR );
+
+        char* status_end = 0;
+        response->http_status = strtol( status, &status_end, 10 );
+
+        XI_CHECK_CND( status_end == status, XI_TCP_PARSE_ERROR );
+    }
+
+    {
+        char* body = tcp_find_member( data, "\"body\"" );
+
+        // the content stays where it's been received
+        if( body != 0 && *body == '"' )
+        {
+            long size = tcp_unescape_string( body + 1 );
+
+            XI_CHECK_CND( size < 0, XI_TCP_PARSE_ERROR );
+
+            response->http_content      = body + 1;
+            response->http_content_size = size;
+        }
+        else
+        {
+            response->http_content      = "";
+            response->http_content_size = 0;
+        }
+    }
+
+    return &__tmp;
+
+err_handling:
+    return 0;
+}
+
+/**
+ * \brief   Takes the feed and the datastream out of the resource
+ *
+ * \return  `0` on success or `-1` if it's not a datastream.
+ */
+static int tcp_parse_resource(
+      const char* resource
+    , xi_feed_id_t* feed_id
+    , char* datastream_id
+    , size_t datastream_id_size )
+{
+    const size_t feeds_size         = sizeof( XI_TCP_RESOURCE_FEEDS ) - 1;
+    const size_t datastreams_size   = sizeof( XI_TCP_RESOURCE_DATASTREAMS ) - 1;
+    const size_t suffix_size        = sizeof( XI_TCP_RESOURCE_SUFFIX ) - 1;
+
+    if( strncmp( resource, XI_TCP_RESOURCE_FEEDS, feeds_size ) != 0 ) { return -1; }
+
+    resource += feeds_size;
+
+    char* end   = 0;
+    *feed_id    = ( xi_feed_id_t ) strtoul( resource, &end, 10 );
+
+    if( end == resource ) { return -1; }
+
+    resource = end;
+
+    if( strncmp( resource, XI_TCP_RESOURCE_DATASTREAMS, datastreams_size ) != 0 ) { return -1; }
+
+    resource += datastreams_size;
+
+    // the id goes up to the suffix, which is followed by the closing quote
+    const char* id_end = strchr( resource, '"' );
+
+    if( id_end == 0 || ( size_t ) ( id_end - resource ) <= suffix_size
+        || memcmp( id_end - suffix_size, XI_TCP_RESOURCE_SUFFIX, suffix_size ) != 0 )
+    {
+        return -1;
+    }
+
+    size_t size = id_end - suffix_size - resource;
+
+    if( size >= datastream_id_size ) { return -1; }
+
+    memcpy( datastream_id, resource, size );
+    datastream_id[ size ] = '\0';
+
+    return 0;
+}
+
+xi_message_type_t tcp_decode_update(
+          const data_layer_t* data_layer
+        , char* data
+        , xi_feed_id_t* feed_id
+        , char* datastream_id
+        , size_t datastream_id_size
+        , xi_datapoint_t* datapoint )
+{
+    // PRECONDITIONS
+    assert( data_layer != 0 );
+    assert( data != 0 );
+
+    const char* resource    = tcp_find_member( data, "\"resource\"" );
+    char* body              = tcp_find_member( data, "\"body\"" );
+
+    // only the replies have the status, anything else without a resource is
+    // left to tcp_decode_reply() to complain about
+    if( tcp_find_member( data, "\"status\"" ) != 0 || resource == 0 )
+    {
+        return XI_MESSAGE_REPLY;
+    }
+
+    if( *resource != '"' || body == 0 || *body != '"' )
+    {
+        return XI_MESSAGE_OTHER;
+    }
+
+    if( tcp_parse_resource( resource + 1, feed_id
+        , datastream_id, datastream_id_size ) == -1 )
+    {
+        return XI_MESSAGE_OTHER;
+    }
+
+    if( tcp_unescape_string( body + 1 ) < 0 ) { return XI_MESSAGE_OTHER; }
+
+    if( data_layer->decode_datapoint( body + 1, strlen( body + 1 ), datapoint ) == 0 )
+    {
+        return XI_MESSAGE_OTHER;
+    }
+
+    return XI_MESSAGE_UPDATE;
+}
+
+long tcp_response_size( xi_frame_t* frame, const char* data, size_t size )
+{
+    // PRECONDITIONS
+    assert( frame != 0 );
+    assert( data != 0 );
+    assert( frame->scanned <= size );
+
+    if( frame->size ) { return ( long ) frame->size; }
+
+    // the newline can't be in what's been looked at before
+    const char* end = memchr( data + frame->scanned, '\n', size - frame->scanned );
+
+    frame->scanned = size;
+
+    if( end == 0 ) { return -1; }
+
+    frame->size = ( end - data ) + 1;
+
+    return ( long ) frame->size;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    tcp_transport_layer.h
+ * \brief   Implements TCP _transport layer_ encoders and decoders specific to Xively socket API
+ */
+
+#ifndef __TCP_TRANSPORT_LAYER_H__
+#define __TCP_TRANSPORT_LAYER_H__
+
+#include "xively.h"
+#include "data_layer.h"
+#include "xi_iovec.h"
+#include "transport_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const xi_request_t* tcp_encode_create_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const xi_request_t* tcp_encode_update_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const xi_request_t* tcp_encode_get_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id );
+
+const xi_request_t* tcp_encode_delete_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id );
+
+const xi_request_t* tcp_encode_delete_datapoint(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o );
+
+const xi_request_t* tcp_encode_update_feed(
+          const data_layer_t*
+        , const char* x_api_key
+        , const xi_feed_t* feed );
+
+const xi_request_t* tcp_encode_get_feed(
+        const data_layer_t*
+      , const char* x_api_key
+      , const xi_feed_t* feed );
+
+const xi_request_t* tcp_encode_datapoint_delete_range(
+        const data_layer_t*
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end );
+
+const xi_request_t* tcp_encode_subscribe(
+        const data_layer_t*
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , int subscribe );
+
+const xi_response_t* tcp_decode_reply(
+          const data_layer_t*
+        , char* data );
+
+xi_message_type_t tcp_decode_update(
+          const data_layer_t*
+        , char* data
+        , xi_feed_id_t* feed_id
+        , char* datastream_id
+        , size_t datastream_id_size
+        , xi_datapoint_t* datapoint );
+
+/**
+ * \brief   Every reply is terminated with a newline, since JSON strings
+ *          can't contain a raw one
+ */
+long tcp_response_size( xi_frame_t* frame, const char* data, size_t size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TCP_TRANSPORT_LAYER_H__
@@ -12,11 +12,35 @@
 
 #include "xively.h"
 #include "data_layer.h"
+#include "xi_iovec.h"
+#include "http_layer_parser.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * \brief   What a message the server has sent turns out to be
+ */
+typedef enum {
+      XI_MESSAGE_REPLY      //!< the reply to the request that has been sent
+    , XI_MESSAGE_UPDATE     //!< an update of a datastream the client has subscribed to
+    , XI_MESSAGE_PING       //!< the server checks the connection, it's answered [see transport_layer_t::encode_pong]
+    , XI_MESSAGE_CLOSE      //!< the server closes the connection, it's dropped
+    , XI_MESSAGE_OTHER      //!< anything else the server sends on its own, it's skipped
+} xi_message_type_t;
+
+/**
+ * \brief   How far the message that's being read has been looked at, it's
+ *          kept between the reads so that none of them starts over
+ * \note    The one that's been zeroed is ready for the next message.
+ */
+typedef struct xi_frame_s {
+    http_parser_t   http;       //!< the replies and the handshakes which are HTTP responses
+    size_t          scanned;    //!< what the other protocols have looked at
+    size_t          size;       //!< of the message once they've found its end
+} xi_frame_t;
+
 /**
  * \brief   _The transport layer interface_ - contains function pointers,
  *          that's what we expose to the layers above and below
@@ -24,6 +48,7 @@ extern "C" {
  *    It is effectively a class that holds declarations of pure virtual functions.
  *    * All functions take `data_layer_t` as the first argument.
  *    * Most encoders convert the result from data layer to an implementation-specific representaion.
+ *    * Encoders return the request in segments, which are sent without being copied together.
  *
  * \note    It depends on the implementation whether any given _transport layer_ method will call upon
  *          the _data layer_. In `http_transport_layer.c` you can see that `http_encode_datapoint_delete_range()`
@@ -32,47 +57,110 @@ extern "C" {
  *          top of the function definition, that is a macro that casts the pointer to unused _data layer_ to void.
  * \note    Similarly to the _data layer_ (see notes in `data_layer.h`), there no symmetry needed and we only have
  *          one decoder.
+ * \note    The protocols which can't push updates, can't ask for the history, aren't pinged or
+ *          don't need a handshake leave the respective members set to `0`.
  */
 typedef struct {
-    const char* ( *encode_update_feed )(
+    const xi_request_t* ( *encode_update_feed )(
           const data_layer_t*, const char* api_key
         , const xi_feed_t* feed );
 
-    const char* ( *encode_get_feed )(
+    const xi_request_t* ( *encode_get_feed )(
           const data_layer_t*, const char* api_key
         , const xi_feed_t* feed );
 
-    const char* ( *encode_create_datastream )(
+    const xi_request_t* ( *encode_create_datastream )(
           const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
         , const char* datastream_id
         , const xi_datapoint_t* dp );
 
-    const char* ( *encode_update_datastream )(
+    const xi_request_t* ( *encode_update_datastream )(
           const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
         , const char* datastream_id
         , const xi_datapoint_t* value );
 
-    const char* ( *encode_get_datastream )(
+    const xi_request_t* ( *encode_get_datastream )(
           const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
         , const char* datastream_id );
 
-    const char* ( *encode_delete_datastream )(
+    /**
+     * \brief   Asks for up to `limit` datapoints of the datastream, the ones
+     *          newer than `after`
+     */
+    const xi_request_t* ( *encode_get_datastream_history )(
+          const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
+        , const char* datastream_id
+        , const xi_timestamp_t* after
+        , size_t limit );
+
+    const xi_request_t* ( *encode_delete_datastream )(
           const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
         , const char* datastream_id );
 
-    const char* ( *encode_delete_datapoint )(
+    const xi_request_t* ( *encode_delete_datapoint )(
           const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
         , const char* datastream_id
         , const xi_datapoint_t* datapoint );
 
-    const char* ( *encode_datapoint_delete_range )(
+    const xi_request_t* ( *encode_datapoint_delete_range )(
           const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
         , const char* datastream_id
         , const xi_timestamp_t* start
         , const xi_timestamp_t* end );
 
+    const xi_request_t* ( *encode_subscribe )(
+          const data_layer_t*, const char* api_key, xi_feed_id_t feed_id
+        , const char* datastream_id
+        , int subscribe );
+
+    /**
+     * \brief   Decodes the response, which may be modified in place
+     */
     const xi_response_t* ( *decode_reply )(
-        const data_layer_t*, const char* data );
+        const data_layer_t*, char* data );
+
+    /**
+     * \brief   Tells the updates apart from the replies and decodes them
+     * \note    The message is only modified if it's not a reply.
+     */
+    xi_message_type_t ( *decode_update )(
+          const data_layer_t*, char* data
+        , xi_feed_id_t* feed_id
+        , char* datastream_id, size_t datastream_id_size
+        , xi_datapoint_t* datapoint );
+
+    /**
+     * \brief   Encodes the answer to the ping the server has sent, it's
+     *          the complete message `decode_update` has told apart
+     */
+    const xi_request_t* ( *encode_pong )( const char* ping );
+
+    /**
+     * \brief   Tells how long the response at the beginning of `data` is,
+     *          only what's arrived since the last call with the same frame
+     *          is looked at
+     *
+     * \return  Size of the response, `-1` if that's not known yet or `0`
+     *          if it ends when the server closes the connection.
+     */
+    long ( *response_size )( xi_frame_t* frame, const char* data, size_t size );
+
+    /**
+     * \brief   Encodes the request that has to be sent over each new
+     *          connection before any other
+     */
+    const xi_request_t* ( *encode_handshake )( const char* host );
+
+    /**
+     * \brief   Checks the reply to the handshake that's been sent, which is
+     *          read using `response_size` as any other
+     *
+     * \return  `0` if the server has accepted it or `-1` otherwise.
+     */
+    int ( *decode_handshake )( const xi_request_t* handshake, char* data );
+
+    int32_t port; //!< the port of the endpoint which speaks the protocol
+    int secure; //!< the connections have to be encrypted [see comm_layer_t::open_secure_connection]
 } transport_layer_t;
 
 #ifdef __cplusplus
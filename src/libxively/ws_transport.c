@@ -0,0 +1,64 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_transport.c
+ * \brief   Implements WebSocket _transport layer_ abstraction interface [see ws_transport.h and transport_layer.h]
+ */
+
+#include "ws_transport_layer.h"
+#include "ws_transport.h"
+
+transport_layer_t* get_ws_transport_layer( void )
+{
+    static transport_layer_t __ws_transport_layer =
+    {
+          &ws_encode_update_feed
+        , &ws_encode_get_feed
+        , &ws_encode_create_datastream
+        , &ws_encode_update_datastream
+        , &ws_encode_get_datastream
+        , 0 // the history is only asked for over HTTP
+        , &ws_encode_delete_datastream
+        , &ws_encode_delete_datapoint
+        , &ws_encode_datapoint_delete_range
+        , &ws_encode_subscribe
+        , &ws_decode_reply
+        , &ws_decode_update
+        , &ws_encode_pong
+        , &ws_response_size
+        , &ws_encode_handshake
+        , &ws_decode_handshake
+        , XI_WS_PORT
+        , 0
+    };
+
+    return &__ws_transport_layer;
+}
+
+transport_layer_t* get_wss_transport_layer( void )
+{
+    static transport_layer_t __wss_transport_layer =
+    {
+          &ws_encode_update_feed
+        , &ws_encode_get_feed
+        , &ws_encode_create_datastream
+        , &ws_encode_update_datastream
+        , &ws_encode_get_datastream
+        , 0 // the history is only asked for over HTTP
+        , &ws_encode_delete_datastream
+        , &ws_encode_delete_datapoint
+        , &ws_encode_datapoint_delete_range
+        , &ws_encode_subscribe
+        , &ws_decode_reply
+        , &ws_decode_update
+        , &ws_encode_pong
+        , &ws_response_size
+        , &ws_encode_handshake
+        , &ws_decode_handshake
+        , XI_WSS_PORT
+        , 1 // over TLS
+    };
+
+    return &__wss_transport_layer;
+}
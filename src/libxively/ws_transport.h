@@ -0,0 +1,38 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_transport.h
+ * \brief   Implements WebSocket _transport layer_ abstraction interface
+ */
+
+#ifndef __WS_TRANSPORT_H__
+#define __WS_TRANSPORT_H__
+
+#include "transport_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ /**
+ * \brief   Initialise WebSocket implementation of the _transport layer_
+ *
+ *    Same static function variable trick as in `get_http_transport_layer()`.
+ *
+ * \return  Structure with function pointers for WebSocket encoders and decoders
+ *          which had been implemented in `ws_transport_layer.c`.
+ */
+transport_layer_t* get_ws_transport_layer( void );
+
+/**
+ * \brief   Same as `get_ws_transport_layer()`, but the connections are
+ *          encrypted and go to `XI_WSS_PORT`
+ */
+transport_layer_t* get_wss_transport_layer( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WS_TRANSPORT_H__
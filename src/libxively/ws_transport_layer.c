@@ -0,0 +1,611 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_transport_layer.c
+ * \brief   Implements WebSocket _transport layer_ encoders and decoders specific to Xively socket API [see ws_transport_layer.h]
+ *
+ *    The connection is upgraded to a WebSocket once, right after it's been
+ *    opened, and from then on the messages are the same as those of the TCP
+ *    socket API [see tcp_transport_layer.c], each carried by a text frame.
+ *
+ *    The frames sent by the client have to be masked, those sent by the server
+ *    must not be. Fragmented messages aren't supported, the server sends each
+ *    one as a single frame. The pings of the server are answered with pongs
+ *    and its close frame ends the connection [see xi_dispatch_update].
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ws_transport_layer.h"
+#include "tcp_transport_layer.h"
+#include "http_layer_parser.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+static const char XI_WS_TEMPLATE_HANDSHAKE[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: %s\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Key: %s\r\n"
+    "Sec-WebSocket-Version: 13\r\n\r\n";
+
+static const char XI_WS_BASE64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char XI_WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static const char XI_WS_KEY_HEADER[] = "Sec-WebSocket-Key: ";
+
+#define XI_WS_FIN               0x80
+#define XI_WS_MASK              0x80
+#define XI_WS_OPCODE            0x0f
+#define XI_WS_OPCODE_TEXT       0x1
+#define XI_WS_OPCODE_CLOSE      0x8
+#define XI_WS_OPCODE_PING       0x9
+#define XI_WS_OPCODE_PONG       0xa
+#define XI_WS_MAX_CONTROL_SIZE  125
+#define XI_WS_LENGTH            0x7f
+#define XI_WS_LENGTH_16         126
+#define XI_WS_LENGTH_64         127
+#define XI_WS_MASK_SIZE         4
+#define XI_WS_MAX_HEADER_SIZE   ( 4 + XI_WS_MASK_SIZE )
+#define XI_WS_KEY_SIZE          16
+#define XI_WS_ENCODED_KEY_SIZE  ( ( XI_WS_KEY_SIZE + 2 ) / 3 * 4 )
+#define XI_WS_SHA1_SIZE         20
+
+static XI_THREAD_LOCAL char XI_WS_HANDSHAKE_BUFFER[ XI_QUERY_BUFFER_SIZE ];
+static XI_THREAD_LOCAL char XI_WS_FRAME_BUFFER[ XI_WS_MAX_HEADER_SIZE
+    + XI_QUERY_BUFFER_SIZE + 2 * XI_CONTENT_BUFFER_SIZE + 2 ];
+static XI_THREAD_LOCAL xi_request_t XI_WS_REQUEST;
+static XI_THREAD_LOCAL xi_request_t XI_WS_HANDSHAKE; //!< the request waiting for the handshake stays intact
+static XI_THREAD_LOCAL xi_request_t XI_WS_PONG; //!< the payload of the ping to send back
+
+/**
+ * \brief   The masking keys only have to keep proxies from mistaking the
+ *          frames for something else, they don't protect anything
+ */
+static void ws_random_bytes( unsigned char* data, size_t size )
+{
+    for( size_t i = 0; i < size; ++i )
+    {
+        data[ i ] = ( unsigned char ) ( rand() >> 3 );
+    }
+}
+
+/**
+ * \brief   Encodes the data as base64, the output is terminated
+ */
+static void ws_base64( const unsigned char* data, size_t size, char* out )
+{
+    for( size_t i = 0; i < size; i += 3 )
+    {
+        unsigned long n = ( unsigned long ) data[ i ] << 16;
+
+        if( i + 1 < size ) { n |= ( unsigned long ) data[ i + 1 ] << 8; }
+        if( i + 2 < size ) { n |= data[ i + 2 ]; }
+
+        *out++ = XI_WS_BASE64[ ( n >> 18 ) & 0x3f ];
+        *out++ = XI_WS_BASE64[ ( n >> 12 ) & 0x3f ];
+        *out++ = i + 1 < size ? XI_WS_BASE64[ ( n >> 6 ) & 0x3f ] : '=';
+        *out++ = i + 2 < size ? XI_WS_BASE64[ n & 0x3f ] : '=';
+    }
+
+    *out = '\0';
+}
+
+static inline uint32_t ws_rotate( uint32_t x, int n )
+{
+    return ( x << n ) | ( x >> ( 32 - n ) );
+}
+
+/**
+ * \brief   SHA-1 of the data [see RFC 3174], it's only what the handshake
+ *          asks for, it doesn't protect anything either
+ */
+static void ws_sha1( const unsigned char* data, size_t size
+    , unsigned char digest[ XI_WS_SHA1_SIZE ] )
+{
+    uint32_t h[ 5 ] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    unsigned char block[ 64 ];
+
+    // the data, the bit `1`, the zeros and the length in bits fill the blocks
+    const size_t blocks = ( size + 8 ) / 64 + 1;
+
+    for( size_t b = 0; b < blocks; ++b )
+    {
+        uint32_t w[ 80 ];
+
+        for( size_t i = 0; i < 64; ++i )
+        {
+            const size_t at = b * 64 + i;
+
+            block[ i ] = at < size ? data[ at ] : at == size ? 0x80 : 0;
+        }
+
+        if( b == blocks - 1 )
+        {
+            const uint64_t bits = ( uint64_t ) size * 8;
+
+            for( int i = 0; i < 8; ++i )
+            {
+                block[ 63 - i ] = ( unsigned char ) ( bits >> ( 8 * i ) );
+            }
+        }
+
+        for( int i = 0; i < 16; ++i )
+        {
+            w[ i ] = ( ( uint32_t ) block[ 4 * i ] << 24 )
+                | ( ( uint32_t ) block[ 4 * i + 1 ] << 16 )
+                | ( ( uint32_t ) block[ 4 * i + 2 ] << 8 )
+                | block[ 4 * i + 3 ];
+        }
+
+        for( int i = 16; i < 80; ++i )
+        {
+            w[ i ] = ws_rotate( w[ i - 3 ] ^ w[ i - 8 ] ^ w[ i - 14 ] ^ w[ i - 16 ], 1 );
+        }
+
+        uint32_t a = h[ 0 ], bb = h[ 1 ], c = h[ 2 ], d = h[ 3 ], e = h[ 4 ];
+
+        for( int i = 0; i < 80; ++i )
+        {
+            uint32_t f, k;
+
+            if( i < 20 )        { f = ( bb & c ) | ( ~bb & d );             k = 0x5a827999; }
+            else if( i < 40 )   { f = bb ^ c ^ d;                           k = 0x6ed9eba1; }
+            else if( i < 60 )   { f = ( bb & c ) | ( bb & d ) | ( c & d );  k = 0x8f1bbcdc; }
+            else                { f = bb ^ c ^ d;                           k = 0xca62c1d6; }
+
+            const uint32_t t = ws_rotate( a, 5 ) + f + e + k + w[ i ];
+
+            e   = d;
+            d   = c;
+            c   = ws_rotate( bb, 30 );
+            bb  = a;
+            a   = t;
+        }
+
+        h[ 0 ] += a;
+        h[ 1 ] += bb;
+        h[ 2 ] += c;
+        h[ 3 ] += d;
+        h[ 4 ] += e;
+    }
+
+    for( int i = 0; i < XI_WS_SHA1_SIZE; ++i )
+    {
+        digest[ i ] = ( unsigned char ) ( h[ i / 4 ] >> ( 24 - 8 * ( i % 4 ) ) );
+    }
+}
+
+/**
+ * \brief   Wraps the request into a masked frame of the given kind, the
+ *          messages are encoded by the TCP layer
+ */
+static const xi_request_t* ws_encode_frame( unsigned char opcode, const xi_request_t* request )
+{
+    if( request == 0 ) { return 0; }
+
+    size_t size = xi_iovec_size( request->segments, request->count );
+
+    XI_CHECK_CND( size > sizeof( XI_WS_FRAME_BUFFER ) - XI_WS_MAX_HEADER_SIZE
+        , XI_WS_FRAME_ERROR );
+
+    {
+        unsigned char* p = ( unsigned char* ) XI_WS_FRAME_BUFFER;
+        unsigned char mask[ XI_WS_MASK_SIZE ];
+
+        *p++ = XI_WS_FIN | opcode;
+
+        if( size < XI_WS_LENGTH_16 )
+        {
+            *p++ = XI_WS_MASK | ( unsigned char ) size;
+        }
+        else
+        {
+            *p++ = XI_WS_MASK | XI_WS_LENGTH_16;
+            *p++ = ( unsigned char ) ( size >> 8 );
+            *p++ = ( unsigned char ) ( size & 0xff );
+        }
+
+        ws_random_bytes( mask, XI_WS_MASK_SIZE );
+        memcpy( p, mask, XI_WS_MASK_SIZE );
+        p += XI_WS_MASK_SIZE;
+
+        size_t j = 0;
+
+        for( size_t i = 0; i < request->count; ++i )
+        {
+            const char* data = request->segments[ i ].data;
+
+            for( size_t k = 0; k < request->segments[ i ].size; ++k, ++j )
+            {
+                *p++ = ( unsigned char ) data[ k ] ^ mask[ j % XI_WS_MASK_SIZE ];
+            }
+        }
+
+        XI_WS_REQUEST.count = 0;
+
+        if( xi_request_append( &XI_WS_REQUEST, XI_WS_FRAME_BUFFER
+            , ( char* ) p - XI_WS_FRAME_BUFFER ) == -1 )
+        {
+            return 0;
+        }
+    }
+
+    return &XI_WS_REQUEST;
+
+err_handling:
+    return 0;
+}
+
+/**
+ * \brief   Reads the header of the frame
+ *
+ * \return  Size of the header or `-1` if it hasn't been received yet.
+ */
+static long ws_frame_header(
+      const unsigned char* data
+    , size_t size
+    , size_t* payload_size )
+{
+    if( size < 2 ) { return -1; }
+
+    long header     = 2;
+    size_t length   = data[ 1 ] & XI_WS_LENGTH;
+
+    if( length == XI_WS_LENGTH_16 )
+    {
+        if( size < 4 ) { return -1; }
+
+        length = ( ( size_t ) data[ 2 ] << 8 ) | data[ 3 ];
+        header = 4;
+    }
+    else if( length == XI_WS_LENGTH_64 )
+    {
+        if( size < 10 ) { return -1; }
+
+        length = 0;
+
+        for( int i = 2; i < 10; ++i )
+        {
+            // anything that big can't be read anyway
+            if( length > XI_HTTP_MAX_RESPONSE_SIZE ) { break; }
+
+            length = ( length << 8 ) | data[ i ];
+        }
+
+        header = 10;
+    }
+
+    if( data[ 1 ] & XI_WS_MASK ) { header += XI_WS_MASK_SIZE; }
+
+    *payload_size = XI_MIN( length, ( size_t ) XI_HTTP_MAX_RESPONSE_SIZE + 1 );
+
+    return header;
+}
+
+/**
+ * \brief   Finds the payload of a complete text frame sent by the server
+ *
+ * \return  The payload or `0` if it's a frame of any other kind.
+ */
+static char* ws_frame_payload( char* data )
+{
+    const unsigned char* header = ( const unsigned char* ) data;
+    size_t payload_size         = 0;
+
+    // the frame is known to be complete at this point
+    long header_size = ws_frame_header( header, ( size_t ) -1, &payload_size );
+
+    if( ( header[ 0 ] & XI_WS_OPCODE ) != XI_WS_OPCODE_TEXT
+        || ( header[ 1 ] & XI_WS_MASK ) )
+    {
+        return 0;
+    }
+
+    return data + header_size;
+}
+
+const xi_request_t* ws_encode_create_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_create_datastream(
+        data_layer, x_api_key, feed_id, datastream_id, datapoint ) );
+}
+
+const xi_request_t* ws_encode_update_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* datapoint )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_update_datastream(
+        data_layer, x_api_key, feed_id, datastream_id, datapoint ) );
+}
+
+const xi_request_t* ws_encode_get_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_get_datastream(
+        data_layer, x_api_key, feed_id, datastream_id ) );
+}
+
+const xi_request_t* ws_encode_delete_datastream(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_delete_datastream(
+        data_layer, x_api_key, feed_id, datastream_id ) );
+}
+
+const xi_request_t* ws_encode_delete_datapoint(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_delete_datapoint(
+        data_layer, x_api_key, feed_id, datastream_id, o ) );
+}
+
+const xi_request_t* ws_encode_update_feed(
+          const data_layer_t* data_layer
+        , const char* x_api_key
+        , const xi_feed_t* feed )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_update_feed(
+        data_layer, x_api_key, feed ) );
+}
+
+const xi_request_t* ws_encode_get_feed(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , const xi_feed_t* feed )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_get_feed(
+        data_layer, x_api_key, feed ) );
+}
+
+const xi_request_t* ws_encode_datapoint_delete_range(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_datapoint_delete_range(
+        data_layer, x_api_key, feed_id, datastream_id, start, end ) );
+}
+
+const xi_request_t* ws_encode_subscribe(
+        const data_layer_t* data_layer
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , int subscribe )
+{
+    return ws_encode_frame( XI_WS_OPCODE_TEXT, tcp_encode_subscribe(
+        data_layer, x_api_key, feed_id, datastream_id, subscribe ) );
+}
+
+const xi_response_t* ws_decode_reply(
+          const data_layer_t* data_layer
+        , char* data )
+{
+    char* payload = ws_frame_payload( data );
+
+    XI_CHECK_ZERO( payload, XI_WS_FRAME_ERROR );
+
+    return tcp_decode_reply( data_layer, payload );
+
+err_handling:
+    return 0;
+}
+
+xi_message_type_t ws_decode_update(
+          const data_layer_t* data_layer
+        , char* data
+        , xi_feed_id_t* feed_id
+        , char* datastream_id
+        , size_t datastream_id_size
+        , xi_datapoint_t* datapoint )
+{
+    const unsigned char opcode = ( unsigned char ) data[ 0 ] & XI_WS_OPCODE;
+
+    // the context answers them [see xi_dispatch_update]
+    if( opcode == XI_WS_OPCODE_PING )   { return XI_MESSAGE_PING; }
+    if( opcode == XI_WS_OPCODE_CLOSE )  { return XI_MESSAGE_CLOSE; }
+
+    char* payload = ws_frame_payload( data );
+
+    // pongs and such don't need an answer from us
+    if( payload == 0 ) { return XI_MESSAGE_OTHER; }
+
+    return tcp_decode_update( data_layer, payload
+        , feed_id, datastream_id, datastream_id_size, datapoint );
+}
+
+long ws_response_size( xi_frame_t* frame, const char* data, size_t size )
+{
+    // PRECONDITIONS
+    assert( frame != 0 );
+    assert( data != 0 );
+
+    // the reply to the handshake is the only message which isn't framed
+    if( frame->http.size > 0 || ( size >= 5 && memcmp( data, "HTTP/", 5 ) == 0 ) )
+    {
+        return http_response_size( &frame->http, data, size );
+    }
+
+    size_t payload_size = 0;
+    long header_size    = ws_frame_header(
+        ( const unsigned char* ) data, size, &payload_size );
+
+    return header_size == -1 ? -1 : header_size + ( long ) payload_size;
+}
+
+const xi_request_t* ws_encode_pong( const char* ping )
+{
+    // PRECONDITIONS
+    assert( ping != 0 );
+
+    const unsigned char* header = ( const unsigned char* ) ping;
+    size_t payload_size         = 0;
+
+    // the frame is known to be complete at this point
+    long header_size = ws_frame_header( header, ( size_t ) -1, &payload_size );
+
+    XI_CHECK_CND( ( header[ 1 ] & XI_WS_MASK )
+        || payload_size > XI_WS_MAX_CONTROL_SIZE, XI_WS_FRAME_ERROR );
+
+    XI_WS_PONG.count = 0;
+
+    if( xi_request_append( &XI_WS_PONG, ping + header_size, payload_size ) == -1 )
+    {
+        return 0;
+    }
+
+    return ws_encode_frame( XI_WS_OPCODE_PONG, &XI_WS_PONG );
+
+err_handling:
+    return 0;
+}
+
+void ws_accept_key( const char* key, size_t key_size, char* accept )
+{
+    // PRECONDITIONS
+    assert( key != 0 );
+    assert( accept != 0 );
+
+    unsigned char data[ XI_WS_ENCODED_KEY_SIZE + sizeof( XI_WS_GUID ) ];
+    unsigned char digest[ XI_WS_SHA1_SIZE ];
+
+    key_size = XI_MIN( key_size, ( size_t ) XI_WS_ENCODED_KEY_SIZE );
+
+    memcpy( data, key, key_size );
+    memcpy( data + key_size, XI_WS_GUID, sizeof( XI_WS_GUID ) - 1 );
+
+    ws_sha1( data, key_size + sizeof( XI_WS_GUID ) - 1, digest );
+    ws_base64( digest, XI_WS_SHA1_SIZE, accept );
+}
+
+const xi_request_t* ws_encode_handshake( const char* host )
+{
+    // PRECONDITIONS
+    assert( host != 0 );
+
+    unsigned char key[ XI_WS_KEY_SIZE ];
+    char encoded_key[ XI_WS_ENCODED_KEY_SIZE + 1 ];
+
+    ws_random_bytes( key, XI_WS_KEY_SIZE );
+    ws_base64( key, XI_WS_KEY_SIZE, encoded_key );
+
+    int s = snprintf( XI_WS_HANDSHAKE_BUFFER, sizeof( XI_WS_HANDSHAKE_BUFFER )
+        , XI_WS_TEMPLATE_HANDSHAKE, host, encoded_key );
+
+    XI_CHECK_SIZE( s, ( int ) sizeof( XI_WS_HANDSHAKE_BUFFER ), XI_WS_HANDSHAKE_ERROR );
+
+    XI_WS_HANDSHAKE.count = 0;
+
+    if( xi_request_append( &XI_WS_HANDSHAKE, XI_WS_HANDSHAKE_BUFFER, s ) == -1 )
+    {
+        return 0;
+    }
+
+    return &XI_WS_HANDSHAKE;
+
+err_handling:
+    return 0;
+}
+
+/**
+ * \brief   Finds the key the handshake has been sent with
+ *
+ * \return  The key, which isn't terminated, or `0` if there's none.
+ */
+static const char* ws_handshake_key( const xi_request_t* handshake, size_t* key_size )
+{
+    const size_t header_size = sizeof( XI_WS_KEY_HEADER ) - 1;
+
+    for( size_t i = 0; i < handshake->count; ++i )
+    {
+        const char* data    = handshake->segments[ i ].data;
+        const size_t size   = handshake->segments[ i ].size;
+
+        for( size_t j = 0; j + header_size < size; ++j )
+        {
+            if( memcmp( data + j, XI_WS_KEY_HEADER, header_size ) != 0 ) { continue; }
+
+            const char* key = data + j + header_size;
+            const char* end = memchr( key, '\r', size - j - header_size );
+
+            if( end == 0 ) { return 0; }
+
+            *key_size = end - key;
+            return key;
+        }
+    }
+
+    return 0;
+}
+
+int ws_decode_handshake( const xi_request_t* handshake, char* data )
+{
+    // PRECONDITIONS
+    assert( handshake != 0 );
+    assert( data != 0 );
+
+    static XI_THREAD_LOCAL http_response_t response;
+
+    XI_CHECK_ZERO( parse_http( &response, data ), XI_WS_HANDSHAKE_ERROR );
+
+    // anything but switching protocols means the server refuses to upgrade
+    XI_CHECK_CND( response.http_status != 101, XI_WS_HANDSHAKE_ERROR );
+
+    {
+        size_t key_size = 0;
+        const char* key = ws_handshake_key( handshake, &key_size );
+        const char* accepted = 0;
+        char accept[ XI_WS_ACCEPT_SIZE ];
+
+        XI_CHECK_ZERO( key, XI_WS_HANDSHAKE_ERROR );
+
+        for( size_t i = 0; i < response.http_headers_size; ++i )
+        {
+            if( strcasecmp( response.http_headers[ i ].name, "Sec-WebSocket-Accept" ) == 0 )
+            {
+                accepted = response.http_headers[ i ].value;
+            }
+        }
+
+        // the server has to prove it's read the handshake, not just
+        // anything that looks like a reply to it
+        ws_accept_key( key, key_size, accept );
+
+        XI_CHECK_CND( accepted == 0 || strcmp( accepted, accept ) != 0
+            , XI_WS_HANDSHAKE_ERROR );
+    }
+
+    return 0;
+
+err_handling:
+    return -1;
+}
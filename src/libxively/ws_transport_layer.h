@@ -0,0 +1,122 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    ws_transport_layer.h
+ * \brief   Implements WebSocket _transport layer_ encoders and decoders specific to Xively socket API
+ */
+
+#ifndef __WS_TRANSPORT_LAYER_H__
+#define __WS_TRANSPORT_LAYER_H__
+
+#include "xively.h"
+#include "data_layer.h"
+#include "xi_iovec.h"
+#include "transport_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const xi_request_t* ws_encode_create_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const xi_request_t* ws_encode_update_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* value );
+
+const xi_request_t* ws_encode_get_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id );
+
+const xi_request_t* ws_encode_delete_datastream(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id );
+
+const xi_request_t* ws_encode_delete_datapoint(
+          const data_layer_t*
+        , const char* x_api_key
+        , xi_feed_id_t feed_id
+        , const char *datastream_id
+        , const xi_datapoint_t* o );
+
+const xi_request_t* ws_encode_update_feed(
+          const data_layer_t*
+        , const char* x_api_key
+        , const xi_feed_t* feed );
+
+const xi_request_t* ws_encode_get_feed(
+        const data_layer_t*
+      , const char* x_api_key
+      , const xi_feed_t* feed );
+
+const xi_request_t* ws_encode_datapoint_delete_range(
+        const data_layer_t*
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , const xi_timestamp_t* start
+      , const xi_timestamp_t* end );
+
+const xi_request_t* ws_encode_subscribe(
+        const data_layer_t*
+      , const char* x_api_key
+      , xi_feed_id_t feed_id
+      , const char* datastream_id
+      , int subscribe );
+
+const xi_response_t* ws_decode_reply(
+          const data_layer_t*
+        , char* data );
+
+xi_message_type_t ws_decode_update(
+          const data_layer_t*
+        , char* data
+        , xi_feed_id_t* feed_id
+        , char* datastream_id
+        , size_t datastream_id_size
+        , xi_datapoint_t* datapoint );
+
+/**
+ * \brief   Tells the size of the frame, or of the reply to the handshake
+ */
+long ws_response_size( xi_frame_t* frame, const char* data, size_t size );
+
+/**
+ * \brief   Answers the ping with a pong which carries the same payload
+ */
+const xi_request_t* ws_encode_pong( const char* ping );
+
+const xi_request_t* ws_encode_handshake( const char* host );
+
+/**
+ * \brief   Checks the server has switched protocols and has answered the
+ *          key of the handshake as it should
+ */
+int ws_decode_handshake( const xi_request_t* handshake, char* data );
+
+//! size of `Sec-WebSocket-Accept`, terminated
+#define XI_WS_ACCEPT_SIZE   29
+
+/**
+ * \brief   Computes `Sec-WebSocket-Accept`, which the server sends back
+ *          for the given `Sec-WebSocket-Key` [see RFC 6455 4.2.2]
+ */
+void ws_accept_key( const char* key, size_t key_size, char* accept );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __WS_TRANSPORT_LAYER_H__
@@ -0,0 +1,627 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_async.c
+ * \brief   Runs the requests made with `xi_*_async()` functions [see xi_async.h]
+ *
+ *    Every request is a small state machine (connect, send, receive) driven
+ *    by the completions of the _communication layer_. Layers which can only
+ *    block don't implement the asynchronous functions, their requests are
+ *    queued and run one by one from `xi_async_poll()` using the very same
+ *    state machine.
+ *
+ *    Each request in progress has a connection of it's own. Those which can
+ *    be kept alive are checked back in to the layer or, if it doesn't pool
+ *    them, kept here for the next request. A new connection starts with the
+ *    handshake of the protocol, if it has one.
+ *
+ *    The queue, the idle connections and the count of requests in flight
+ *    below are shared by all the contexts and aren't guarded by any lock, so
+ *    all of the requests have to be made and polled from a single thread.
+ */
+
+#include <string.h>
+
+#include "xi_async.h"
+#include "xi_allocator.h"
+#include "xi_globals.h"
+#include "xi_helpers.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "http_layer_parser.h"
+
+typedef struct xi_async_request_s
+{
+    struct xi_async_request_s*  next; //!< next on the queue of the blocking layers
+    xi_context_t*               xi;
+    const comm_layer_t*         comm_layer;
+    const transport_layer_t*    transport_layer;
+    const data_layer_t*         data_layer;
+    xi_async_decode_t           decode;
+    void*                       output;
+    xi_response_callback_t      callback;
+    void*                       user_data;
+    connection_t*               conn;
+    int                         reused;     //!< the connection has carried other requests before
+    int                         retried;    //!< the request is being sent for the second time
+    int                         peer_closed; //!< the server has closed the connection after replying
+    int                         handshaking; //!< the handshake of a new connection is in progress
+    xi_comm_op_t                op;         //!< the operation in progress
+    char*                       op_buffer;  //!< what the operation in progress sends or reads into
+    size_t                      op_size;
+    char*                       data;
+    size_t                      data_size;
+    char*                       handshake;  //!< sent over a new connection before the request
+    size_t                      handshake_size;
+    size_t                      sent;
+    size_t                      received;
+    char*                       buffer;     //!< grows up to `XI_HTTP_MAX_RESPONSE_SIZE`
+    size_t                      buffer_size;
+    xi_frame_t                  frame;      //!< how far what's been received has been looked at
+} xi_async_request_t;
+
+//!< requests waiting to be run by a blocking layer
+static xi_async_request_t*  xi_async_queue_head = 0;
+static xi_async_request_t*  xi_async_queue_tail = 0;
+
+//!< all requests that have not finished yet
+static size_t               xi_async_in_flight = 0;
+
+//!< idle keep-alive connections, the most recently used one last
+static connection_t*        xi_async_idle[ XI_CONNECTION_POOL_SIZE ];
+static size_t               xi_async_idle_count = 0;
+
+/**
+ * \brief   Takes the most recently used idle connection to the port, as
+ *          each transport layer speaks to a port of its own
+ */
+static connection_t* xi_async_take_idle(
+      const comm_layer_t* comm_layer
+    , int port )
+{
+    size_t i = xi_async_idle_count;
+
+    while( i-- )
+    {
+        connection_t* conn = xi_async_idle[ i ];
+
+        if( conn->port != port ) { continue; }
+
+        memmove( xi_async_idle + i, xi_async_idle + i + 1
+            , ( xi_async_idle_count - i - 1 ) * sizeof( connection_t* ) );
+        xi_async_idle_count -= 1;
+
+        if( comm_layer->is_connection_alive( conn ) == XI_CONNECTION_ALIVE )
+        {
+            return conn;
+        }
+
+        comm_layer->close_connection( conn );
+    }
+
+    return 0;
+}
+
+/**
+ * \brief   Copies the segments of the request into a single buffer, they
+ *          point to the buffers of the transport layer which the next request
+ *          is encoded into
+ *
+ * \return  The buffer, terminated, or `0` in case of an error.
+ */
+static char* xi_async_flatten( const xi_request_t* request, size_t* size )
+{
+    *size = xi_iovec_size( request->segments, request->count );
+
+    char* ret = ( char* ) xi_alloc( *size + 1 );
+
+    XI_CHECK_MEMORY( ret );
+
+    {
+        size_t offset = 0;
+
+        for( size_t i = 0; i < request->count; ++i )
+        {
+            memcpy( ret + offset
+                , request->segments[ i ].data, request->segments[ i ].size );
+            offset += request->segments[ i ].size;
+        }
+
+        ret[ offset ] = '\0';
+    }
+
+    return ret;
+
+err_handling:
+    return 0;
+}
+
+static void xi_async_park( const comm_layer_t* comm_layer, connection_t* conn )
+{
+    if( comm_layer->checkin_connection( conn ) ) { return; }
+
+    if( xi_async_idle_count < ( XI_MIN( xi_globals.connection_pool_size, XI_CONNECTION_POOL_SIZE ) )
+        && ( xi_globals.connection_max_requests == 0
+            || conn->requests < xi_globals.connection_max_requests ) )
+    {
+        xi_async_idle[ xi_async_idle_count++ ] = conn;
+        return;
+    }
+
+    comm_layer->close_connection( conn );
+}
+
+connection_t* xi_open_connection(
+      const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer )
+{
+    if( !transport_layer->secure )
+    {
+        return comm_layer->open_connection( XI_HOST, transport_layer->port );
+    }
+
+    XI_CHECK_ZERO( comm_layer->open_secure_connection, XI_TLS_NOT_SUPPORTED );
+
+    return comm_layer->open_secure_connection( XI_HOST, transport_layer->port );
+
+err_handling:
+    return 0;
+}
+
+/**
+ * \brief   Records the next operation and submits it to the layer, the
+ *          blocking layers get it from `xi_async_run_blocking()`
+ */
+static int xi_async_next(
+      xi_async_request_t* req
+    , xi_comm_op_t op
+    , char* buffer
+    , size_t size )
+{
+    req->op         = op;
+    req->op_buffer  = buffer;
+    req->op_size    = size;
+
+    if( req->comm_layer->async_submit == 0 ) { return 0; }
+
+    return req->comm_layer->async_submit( req->conn, op, buffer, size, req );
+}
+
+static int xi_async_send( xi_async_request_t* req )
+{
+    if( req->handshaking )
+    {
+        return xi_async_next( req, XI_COMM_OP_SEND
+            , req->handshake + req->sent, req->handshake_size - req->sent );
+    }
+
+    return xi_async_next( req, XI_COMM_OP_SEND
+        , req->data + req->sent, req->data_size - req->sent );
+}
+
+/**
+ * \brief   Prepares the handshake the protocol needs over a new connection,
+ *          it's sent before the request
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int xi_async_begin_handshake( xi_async_request_t* req )
+{
+    if( req->transport_layer->encode_handshake == 0 ) { return 0; }
+
+    if( req->handshake == 0 )
+    {
+        const xi_request_t* request
+            = req->transport_layer->encode_handshake( XI_HOST );
+
+        if( request == 0 ) { return -1; }
+
+        req->handshake = xi_async_flatten( request, &req->handshake_size );
+
+        if( req->handshake == 0 ) { return -1; }
+    }
+
+    req->handshaking = 1;
+
+    return 0;
+}
+
+/**
+ * \brief   Gets a connection for the request and starts sending it
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int xi_async_start( xi_async_request_t* req )
+{
+    const comm_layer_t* comm_layer = req->comm_layer;
+
+    req->sent           = 0;
+    req->received       = 0;
+    req->handshaking    = 0;
+    memset( &req->frame, 0, sizeof( xi_frame_t ) );
+    req->conn           = xi_async_take_idle( comm_layer, req->transport_layer->port );
+
+    if( req->conn == 0 )
+    {
+        // the handshake of TLS is left to the blocking layer
+        if( comm_layer->async_create_connection && !req->transport_layer->secure )
+        {
+            req->conn = comm_layer->async_create_connection( XI_HOST, req->transport_layer->port );
+            if( req->conn == 0 ) { return -1; }
+
+            req->reused = 0;
+            req->xi->connections_opened += 1;
+            req->conn->requests += 1;
+
+            if( xi_async_begin_handshake( req ) == -1 ) { return -1; }
+
+            return xi_async_next( req, XI_COMM_OP_CONNECT, 0, 0 );
+        }
+
+        req->conn = xi_open_connection( comm_layer, req->transport_layer );
+        if( req->conn == 0 ) { return -1; }
+    }
+
+    req->reused = req->conn->requests > 0;
+
+    if( req->reused )   { req->xi->connections_reused += 1; }
+    else                { req->xi->connections_opened += 1; }
+
+    if( !req->reused && req->conn->session_resumed )
+    {
+        req->xi->sessions_resumed += 1;
+    }
+
+    req->conn->requests += 1;
+
+    if( !req->reused && xi_async_begin_handshake( req ) == -1 ) { return -1; }
+
+    return xi_async_send( req );
+}
+
+const xi_response_t* xi_async_decode(
+      const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , char* buffer
+    , xi_async_decode_t decode
+    , void* output )
+{
+    xi_debug_logger( "Response:" );
+    xi_debug_printf( "%s\r\n", buffer );
+
+    // an error left by another request must not fail the parser
+    xi_set_err( XI_NO_ERR );
+
+    const xi_response_t* response
+        = transport_layer->decode_reply( data_layer, buffer );
+
+    if( response && decode == XI_ASYNC_DECODE_FEED )
+    {
+        if( data_layer->decode_feed( response->http.http_content
+            , response->http.http_content_size
+            , ( xi_feed_t* ) output ) == 0 ) { response = 0; }
+    }
+    else if( response && decode == XI_ASYNC_DECODE_DATAPOINT )
+    {
+        if( data_layer->decode_datapoint( response->http.http_content
+            , response->http.http_content_size
+            , ( xi_datapoint_t* ) output ) == 0 ) { response = 0; }
+    }
+
+    return response;
+}
+
+/**
+ * \brief   Decodes the response and passes it to the callback, then
+ *          releases the request
+ */
+static void xi_async_finish( xi_async_request_t* req, int ok )
+{
+    const xi_response_t* response = 0;
+
+    if( ok )
+    {
+        response = xi_async_decode( req->transport_layer, req->data_layer
+            , req->buffer, req->decode, req->output );
+    }
+
+    if( req->conn )
+    {
+        if( response && !req->peer_closed
+            && http_is_keep_alive( &response->http ) )
+        {
+            xi_async_park( req->comm_layer, req->conn );
+        }
+        else
+        {
+            req->comm_layer->close_connection( req->conn );
+        }
+    }
+
+    xi_async_in_flight -= 1;
+
+    req->callback( req->xi, response, req->user_data );
+
+    XI_SAFE_FREE( req->data );
+    XI_SAFE_FREE( req->handshake );
+    XI_SAFE_FREE( req->buffer );
+    XI_SAFE_FREE( req );
+}
+
+/**
+ * \brief   Handles a failed operation, a request sent over a reused
+ *          connection is repeated once over a fresh one
+ *
+ * \return  `1` if the request is still in progress or `0` if it's finished.
+ */
+static int xi_async_fail( xi_async_request_t* req )
+{
+    req->comm_layer->close_connection( req->conn );
+    req->conn = 0;
+
+    // once the server has replied there's no point in asking again
+    if( req->reused && !req->retried && req->received == 0 )
+    {
+        xi_debug_logger( "The keep-alive connection has gone, retrying..." );
+        xi_set_err( XI_NO_ERR );
+
+        req->retried = 1;
+
+        if( xi_async_start( req ) == 0 ) { return 1; }
+    }
+
+    xi_async_finish( req, 0 );
+
+    return 0;
+}
+
+/**
+ * \brief   Reads the rest of the response or finishes the request if
+ *          it's complete
+ *
+ * \return  `1` if the request is still in progress or `0` if it's finished.
+ */
+static int xi_async_receive( xi_async_request_t* req )
+{
+    long wanted = xi_prepare_read( &req->buffer, &req->buffer_size
+        , 0, req->received, req->transport_layer->response_size, &req->frame );
+
+    if( wanted == -1 ) { return xi_async_fail( req ); }
+
+    if( wanted == 0 && req->handshaking )
+    {
+        // the key of the handshake is checked against the one sent
+        xi_request_t handshake;
+        handshake.count = 0;
+        xi_request_append( &handshake, req->handshake, req->handshake_size );
+
+        if( req->transport_layer->decode_handshake(
+            &handshake, req->buffer ) == -1 )
+        {
+            return xi_async_fail( req );
+        }
+
+        // the connection is ready for the request now
+        req->handshaking    = 0;
+        req->sent           = 0;
+        req->received       = 0;
+        memset( &req->frame, 0, sizeof( xi_frame_t ) );
+
+        if( xi_async_send( req ) == -1 ) { return xi_async_fail( req ); }
+
+        return 1;
+    }
+
+    if( wanted == 0 )
+    {
+        xi_async_finish( req, 1 );
+        return 0;
+    }
+
+    if( xi_async_next( req, XI_COMM_OP_RECV
+        , req->buffer + req->received, wanted ) == -1 )
+    {
+        return xi_async_fail( req );
+    }
+
+    return 1;
+}
+
+/**
+ * \brief   Moves the request forward once the operation in progress has
+ *          completed with the given result
+ *
+ * \return  `1` if the request is still in progress or `0` if it's finished.
+ */
+static int xi_async_complete( xi_async_request_t* req, int result )
+{
+    xi_comm_op_t op = req->op;
+
+    req->op = XI_COMM_OP_NONE;
+
+    if( result == -1 ) { return xi_async_fail( req ); }
+
+    switch( op )
+    {
+        case XI_COMM_OP_CONNECT:
+            if( xi_async_send( req ) == -1 ) { return xi_async_fail( req ); }
+            break;
+        case XI_COMM_OP_SEND:
+            req->sent += result;
+
+            if( req->sent == ( req->handshaking
+                ? req->handshake_size : req->data_size ) )
+            {
+                return xi_async_receive( req );
+            }
+
+            if( xi_async_send( req ) == -1 ) { return xi_async_fail( req ); }
+            break;
+        case XI_COMM_OP_RECV:
+            if( result == 0 )
+            {
+                // the peer has closed the connection
+                if( req->received == 0 || req->handshaking )
+                {
+                    xi_set_err( XI_SOCKET_READ_ERROR );
+                    return xi_async_fail( req );
+                }
+
+                req->peer_closed = 1;
+                xi_async_finish( req, 1 );
+                return 0;
+            }
+
+            req->received += result;
+            req->buffer[ req->received ] = '\0';
+
+            return xi_async_receive( req );
+        default:
+            assert( 0 && "unexpected completion" );
+            break;
+    }
+
+    return 1;
+}
+
+/**
+ * \brief   Runs a request to completion on a layer that can only block
+ */
+static void xi_async_run_blocking( xi_async_request_t* req )
+{
+    if( xi_async_start( req ) == -1 )
+    {
+        xi_async_finish( req, 0 );
+        return;
+    }
+
+    int result = 0;
+
+    do
+    {
+        if( req->op == XI_COMM_OP_SEND )
+        {
+            result = req->comm_layer->send_data(
+                req->conn, req->op_buffer, req->op_size );
+        }
+        else
+        {
+            result = req->comm_layer->read_data(
+                req->conn, req->op_buffer, req->op_size );
+        }
+    } while( xi_async_complete( req, result ) );
+}
+
+int xi_async_submit(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , const xi_request_t* request
+    , xi_async_decode_t decode
+    , void* output
+    , xi_response_callback_t callback
+    , void* user_data )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( comm_layer != 0 );
+    assert( request != 0 );
+    assert( callback != 0 );
+
+    xi_async_request_t* req
+        = ( xi_async_request_t* ) xi_alloc( sizeof( xi_async_request_t ) );
+
+    XI_CHECK_MEMORY( req );
+
+    memset( req, 0, sizeof( xi_async_request_t ) );
+
+    req->xi                 = xi;
+    req->comm_layer         = comm_layer;
+    req->transport_layer    = transport_layer;
+    req->data_layer         = data_layer;
+    req->decode             = decode;
+    req->output             = output;
+    req->callback           = callback;
+    req->user_data          = user_data;
+    req->data               = xi_async_flatten( request, &req->data_size );
+
+    if( req->data == 0 ) { goto err_handling; }
+
+    if( comm_layer->async_submit == 0 )
+    {
+        // the blocking layers will run it from the poll
+        if( xi_async_queue_tail )   { xi_async_queue_tail->next = req; }
+        else                        { xi_async_queue_head = req; }
+
+        xi_async_queue_tail = req;
+    }
+    else if( xi_async_start( req ) == -1 )
+    {
+        if( req->conn ) { comm_layer->close_connection( req->conn ); }
+        goto err_handling;
+    }
+
+    xi_async_in_flight += 1;
+
+    return 0;
+
+err_handling:
+    if( req )
+    {
+        XI_SAFE_FREE( req->data );
+        XI_SAFE_FREE( req->handshake );
+    }
+    XI_SAFE_FREE( req );
+
+    return -1;
+}
+
+int xi_async_poll( const comm_layer_t* comm_layer, uint32_t timeout )
+{
+    // PRECONDITIONS
+    assert( comm_layer != 0 );
+
+    if( comm_layer->async_reap == 0 )
+    {
+        // the callbacks may queue more requests, those are left for the next poll
+        xi_async_request_t* req = xi_async_queue_head;
+
+        xi_async_queue_head = 0;
+        xi_async_queue_tail = 0;
+
+        while( req )
+        {
+            xi_async_request_t* next = req->next;
+            xi_async_run_blocking( req );
+            req = next;
+        }
+
+        return ( int ) xi_async_in_flight;
+    }
+
+    if( xi_async_in_flight == 0 ) { return 0; }
+
+    xi_comm_completion_t completions[ XI_ASYNC_MAX_COMPLETIONS ];
+
+    int count = comm_layer->async_reap(
+        completions, XI_ASYNC_MAX_COMPLETIONS, timeout );
+
+    if( count == -1 ) { return -1; }
+
+    for( int i = 0; i < count; ++i )
+    {
+        if( completions[ i ].result == -1 )
+        {
+            xi_set_err( ( xi_err_t ) completions[ i ].error );
+        }
+
+        xi_async_complete(
+              ( xi_async_request_t* ) completions[ i ].user_data
+            , completions[ i ].result );
+    }
+
+    return ( int ) xi_async_in_flight;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_async.h
+ * \brief   Runs the requests made with `xi_*_async()` functions [see xi_async.c]
+ */
+
+#ifndef __XI_ASYNC_H__
+#define __XI_ASYNC_H__
+
+#include "xively.h"
+#include "comm_layer.h"
+#include "transport_layer.h"
+#include "data_layer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   What needs to be decoded from the body of the response
+ */
+typedef enum
+{
+    XI_ASYNC_DECODE_NONE = 0,
+    XI_ASYNC_DECODE_FEED,       //!< into `xi_feed_t`
+    XI_ASYNC_DECODE_DATAPOINT   //!< into `xi_datapoint_t`
+} xi_async_decode_t;
+
+/**
+ * \brief   Opens a blocking connection to the endpoint of the transport
+ *          layer, encrypted if it's a secure one
+ * \note    It's shared with the synchronous functions.
+ *
+ * \return  Pointer to `connection_t` or `0` in case of an error.
+ */
+connection_t* xi_open_connection(
+      const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer );
+
+/**
+ * \brief   Takes a copy of the encoded request and starts sending it
+ * \note    The requests in progress are kept in unguarded state shared by
+ *          all the contexts, so it must only be called from the thread
+ *          calling `xi_async_poll()`, never from the workers of a dispatcher.
+ *
+ * \return  `0` on success or `-1` in case of an error, in which case the
+ *          callback is never called.
+ */
+int xi_async_submit(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , const xi_request_t* request
+    , xi_async_decode_t decode
+    , void* output
+    , xi_response_callback_t callback
+    , void* user_data );
+
+/**
+ * \brief   Decodes the response and, if asked to, it's body into `output`
+ *
+ * \return  The response or `0` in case of an error.
+ */
+const xi_response_t* xi_async_decode(
+      const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , char* buffer
+    , xi_async_decode_t decode
+    , void* output );
+
+/**
+ * \brief   Moves the requests forward and calls the callbacks of those
+ *          which have finished
+ * \note    Only a single thread may poll [see xi_async_submit()].
+ *
+ * \return  Number of requests still in progress or `-1` in case of an error.
+ */
+int xi_async_poll( const comm_layer_t* comm_layer, uint32_t timeout );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_ASYNC_H__
@@ -38,10 +38,24 @@
 #define XI_HTTP_HEADER_VALUE_MAX_SIZE      64
 #endif
 
+// the longest line of the status or a header which the parser keeps while
+// the rest of it arrives, the longer ones can't be stored anyway
+#ifndef XI_HTTP_PARSER_LINE_SIZE
+#define XI_HTTP_PARSER_LINE_SIZE           ( XI_HTTP_HEADER_NAME_MAX_SIZE + XI_HTTP_HEADER_VALUE_MAX_SIZE + 16 )
+#endif
+
 #ifndef XI_HTTP_MAX_CONTENT_SIZE
 #define XI_HTTP_MAX_CONTENT_SIZE           512
 #endif
 
+#ifndef XI_HTTP_MAX_RESPONSE_SIZE
+#define XI_HTTP_MAX_RESPONSE_SIZE          16384
+#endif
+
+#ifndef XI_REQUEST_MAX_SEGMENTS
+#define XI_REQUEST_MAX_SEGMENTS            4
+#endif
+
 #ifndef XI_MAX_DATASTREAMS
 #define XI_MAX_DATASTREAMS                 16
 #endif
@@ -74,6 +88,72 @@
 #define XI_CSV_BUFFER_SIZE                 128
 #endif
 
+#ifndef XI_JSON_BUFFER_SIZE
+#define XI_JSON_BUFFER_SIZE                256
+#endif
+
+#ifndef XI_CBOR_BUFFER_SIZE
+#define XI_CBOR_BUFFER_SIZE                96
+#endif
+
+#ifndef XI_CONNECTION_IDLE_TIMEOUT
+#define XI_CONNECTION_IDLE_TIMEOUT         20
+#endif
+
+#ifndef XI_CONNECTION_POOL_SIZE
+#define XI_CONNECTION_POOL_SIZE            16
+#endif
+
+#ifndef XI_CONNECTION_MAX_REQUESTS
+#define XI_CONNECTION_MAX_REQUESTS         100
+#endif
+
+#ifndef XI_DNS_CACHE_SIZE
+#define XI_DNS_CACHE_SIZE                  8
+#endif
+
+#ifndef XI_DNS_CACHE_MAX_ADDRESSES
+#define XI_DNS_CACHE_MAX_ADDRESSES         4
+#endif
+
+#ifndef XI_DNS_CACHE_HOST_MAX_SIZE
+#define XI_DNS_CACHE_HOST_MAX_SIZE         128
+#endif
+
+#ifndef XI_DNS_CACHE_TTL
+#define XI_DNS_CACHE_TTL                   300
+#endif
+
+#ifndef XI_DNS_CACHE_REFRESH_AHEAD
+#define XI_DNS_CACHE_REFRESH_AHEAD         30
+#endif
+
+#ifndef XI_DNS_CACHE_NEGATIVE_TTL
+#define XI_DNS_CACHE_NEGATIVE_TTL          10
+#endif
+
+#ifndef XI_ASYNC_MAX_COMPLETIONS
+#define XI_ASYNC_MAX_COMPLETIONS           32
+#endif
+
+// submission queue size of the io_uring comm layer, each operation takes two
+// entries, itself and its linked timeout
+#ifndef XI_IO_URING_ENTRIES
+#define XI_IO_URING_ENTRIES                256
+#endif
+
+#ifndef XI_PIPELINE_MAX_REQUESTS
+#define XI_PIPELINE_MAX_REQUESTS           16
+#endif
+
+#ifndef XI_MAX_SUBSCRIPTIONS
+#define XI_MAX_SUBSCRIPTIONS               8
+#endif
+
+#ifndef XI_DISPATCHER_QUEUE_SIZE
+#define XI_DISPATCHER_QUEUE_SIZE           256
+#endif
+
 #ifndef XI_HOST
 #define XI_HOST                            "api.xively.com"
 #endif
@@ -82,4 +162,59 @@
 #define XI_PORT                            80
 #endif
 
+#ifndef XI_TCP_PORT
+#define XI_TCP_PORT                        8081
+#endif
+
+#ifndef XI_WS_PORT
+#define XI_WS_PORT                         8080
+#endif
+
+#ifndef XI_HTTPS_PORT
+#define XI_HTTPS_PORT                      443
+#endif
+
+#ifndef XI_TCPS_PORT
+#define XI_TCPS_PORT                       8091
+#endif
+
+#ifndef XI_WSS_PORT
+#define XI_WSS_PORT                        8090
+#endif
+
+// how many endpoints the TLS sessions are kept for, to be resumed
+#ifndef XI_TLS_SESSION_CACHE_SIZE
+#define XI_TLS_SESSION_CACHE_SIZE          4
+#endif
+
+// the segments of a request are gathered into a single TLS record up to it
+#ifndef XI_TLS_RECORD_BUFFER_SIZE
+#define XI_TLS_RECORD_BUFFER_SIZE          2048
+#endif
+
+// set to 0 only for testing against a server with a self-signed certificate
+#ifndef XI_TLS_VERIFY_PEER
+#define XI_TLS_VERIFY_PEER                 1
+#endif
+
+// the certificates are looked up in the default paths of OpenSSL unless
+// XI_TLS_CA_FILE is defined
+
+// the parsers look for their delimiters with the vector instructions the
+// compiler has been allowed to use (SSE2, AVX2 or NEON), set to 0 to scan
+// byte by byte, as on the targets which have none
+#ifndef XI_SCAN_SIMD
+#define XI_SCAN_SIMD                       1
+#endif
+
+// the scratch buffers of the layers and the last error are kept per thread
+// where there are threads, so contexts can be used by several at once
+#ifndef XI_THREAD_LOCAL
+#if defined( __GNUC__ ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+#define XI_THREAD_LOCAL                    __thread
+#else
+#define XI_THREAD_LOCAL
+#endif
+#endif
+
 #endif // __XI_CONFIG_H__
@@ -0,0 +1,588 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_dispatcher.c
+ * \brief   Runs the requests on a pool of worker threads [see xively.h]
+ *
+ *    Every worker has a queue of its own, guarded by its own lock. The
+ *    requests are added to the back of the queue of the worker their feed
+ *    belongs to, which runs them from the front. A worker with nothing left
+ *    to run takes the newest request of another one, so the lock of the
+ *    owner is only contended while there's stealing going on.
+ *
+ *    The updates of a feed have to be applied in the order they've been
+ *    made, so only a request of a feed which has nothing in flight and
+ *    nothing queued ahead of it can be stolen. The queue keeps the feed its
+ *    worker is running and the one lent to a thief, one at a time, the
+ *    owner skips the requests of the latter until the thief is done.
+ *
+ *    The dispatcher lock is only taken to put the workers to sleep, to wake
+ *    them up and to count the requests which haven't finished yet. A request
+ *    wakes the worker it's queued to if that one is asleep, or any other that
+ *    is, which then steals it. A worker which finds more requests queued once
+ *    it has taken one wakes another, so a burst spreads over all of them.
+ *    The requests a worker can't take yet don't keep it awake, it sleeps
+ *    until a request is queued or finished.
+ *
+ *    The workers don't share anything else, the layers keep their scratch
+ *    buffers per thread (see `XI_THREAD_LOCAL`), so the requests run in
+ *    parallel.
+ */
+
+#ifdef XI_DISPATCHER_PTHREAD
+
+#include <string.h>
+#include <pthread.h>
+
+#include "xively.h"
+#include "xi_allocator.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+#include "xi_macros.h"
+#include "xi_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+      XI_DISPATCH_FEED_UPDATE
+    , XI_DISPATCH_DATASTREAM_UPDATE
+} xi_dispatch_kind_t;
+
+typedef struct
+{
+    xi_dispatch_kind_t      kind;
+    xi_feed_id_t            feed_id;
+    xi_response_callback_t  callback;
+    void*                   user_data;
+    char                    datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_datapoint_t          value;
+    xi_feed_t*              feed; //!< a copy, only the feed updates have one
+} xi_dispatch_request_t;
+
+typedef struct xi_dispatcher_worker_s
+{
+    struct xi_dispatcher_s* dispatcher;
+    pthread_t               thread;
+    pthread_mutex_t         lock;   //!< guards the queue and the feeds in flight
+    pthread_cond_t          wake;   //!< waited on with the dispatcher lock
+    int                     idle;   //!< asleep and not woken up yet
+    xi_context_t*           context;
+    xi_dispatch_request_t*  queue[ XI_DISPATCHER_QUEUE_SIZE ];
+    size_t                  front;
+    size_t                  count;
+    int                     running;        //!< the worker runs a request of its own
+    xi_feed_id_t            running_feed;
+    int                     lent;           //!< a thief runs a request of the queue
+    xi_feed_id_t            lent_feed;
+    struct xi_dispatcher_worker_s* lender;  //!< whose request the worker runs, if it's stolen
+} xi_dispatcher_worker_t;
+
+struct xi_dispatcher_s
+{
+    pthread_mutex_t         lock;
+    pthread_cond_t          done;       //!< signalled once nothing is unfinished
+    size_t                  queued;     //!< atomic, changed with the lock of the queue held
+    size_t                  unfinished; //!< queued or running
+    size_t                  events;     //!< requests queued or finished so far
+    size_t                  stolen;     //!< atomic
+    int                     stopping;
+    size_t                  worker_count;   //!< set up
+    size_t                  started_count;  //!< with a thread running
+    xi_dispatcher_worker_t* workers;
+};
+
+/**
+ * \brief   Takes the request which is `at` places from the front out of
+ *          the queue, the ones behind it move up
+ * \note    Must be called with the lock of the queue held.
+ */
+static xi_dispatch_request_t* xi_dispatcher_remove( xi_dispatcher_worker_t* worker, size_t at )
+{
+    xi_dispatch_request_t* req
+        = worker->queue[ ( worker->front + at ) % XI_DISPATCHER_QUEUE_SIZE ];
+
+    for( size_t i = at + 1; i < worker->count; ++i )
+    {
+        worker->queue[ ( worker->front + i - 1 ) % XI_DISPATCHER_QUEUE_SIZE ]
+            = worker->queue[ ( worker->front + i ) % XI_DISPATCHER_QUEUE_SIZE ];
+    }
+
+    worker->count -= 1;
+
+    __atomic_sub_fetch( &worker->dispatcher->queued, 1, __ATOMIC_ACQ_REL );
+
+    return req;
+}
+
+/**
+ * \brief   Takes the oldest request of the worker whose feed isn't lent to
+ *          a thief, the ones skipped are all of that feed
+ */
+static xi_dispatch_request_t* xi_dispatcher_pop_front( xi_dispatcher_worker_t* worker )
+{
+    xi_dispatch_request_t* req = 0;
+
+    pthread_mutex_lock( &worker->lock );
+
+    for( size_t i = 0; req == 0 && i < worker->count; ++i )
+    {
+        const xi_dispatch_request_t* next
+            = worker->queue[ ( worker->front + i ) % XI_DISPATCHER_QUEUE_SIZE ];
+
+        if( worker->lent && next->feed_id == worker->lent_feed ) { continue; }
+
+        req                     = xi_dispatcher_remove( worker, i );
+        worker->running         = 1;
+        worker->running_feed    = req->feed_id;
+    }
+
+    pthread_mutex_unlock( &worker->lock );
+
+    return req;
+}
+
+/**
+ * \brief   Takes the newest request of the worker whose feed has nothing
+ *          in flight and nothing queued ahead of it
+ */
+static xi_dispatch_request_t* xi_dispatcher_steal( xi_dispatcher_worker_t* worker )
+{
+    xi_dispatch_request_t* req = 0;
+
+    pthread_mutex_lock( &worker->lock );
+
+    for( size_t i = worker->count; !worker->lent && req == 0 && i-- > 0; )
+    {
+        const xi_feed_id_t feed_id
+            = worker->queue[ ( worker->front + i ) % XI_DISPATCHER_QUEUE_SIZE ]->feed_id;
+
+        if( worker->running && feed_id == worker->running_feed ) { continue; }
+
+        size_t ahead = 0;
+
+        while( ahead < i && worker->queue[ ( worker->front + ahead )
+            % XI_DISPATCHER_QUEUE_SIZE ]->feed_id != feed_id )
+        {
+            ++ahead;
+        }
+
+        if( ahead < i ) { continue; }
+
+        req                 = xi_dispatcher_remove( worker, i );
+        worker->lent        = 1;
+        worker->lent_feed   = feed_id;
+    }
+
+    pthread_mutex_unlock( &worker->lock );
+
+    return req;
+}
+
+/**
+ * \brief   Takes the next request of the worker or, if there's none, steals
+ *          one from the others, starting with its neighbour
+ */
+static xi_dispatch_request_t* xi_dispatcher_take( xi_dispatcher_worker_t* worker )
+{
+    struct xi_dispatcher_s* dispatcher = worker->dispatcher;
+
+    xi_dispatch_request_t* req = xi_dispatcher_pop_front( worker );
+
+    size_t self = ( size_t ) ( worker - dispatcher->workers );
+
+    worker->lender = 0;
+
+    for( size_t i = 1; req == 0 && i < dispatcher->worker_count; ++i )
+    {
+        xi_dispatcher_worker_t* owner
+            = &dispatcher->workers[ ( self + i ) % dispatcher->worker_count ];
+
+        req = xi_dispatcher_steal( owner );
+
+        if( req )
+        {
+            worker->lender = owner;
+            __atomic_add_fetch( &dispatcher->stolen, 1, __ATOMIC_RELAXED );
+        }
+    }
+
+    return req;
+}
+
+/**
+ * \brief   Lets the feed of the request that has finished be run again,
+ *          by the owner of the queue if it's been stolen
+ */
+static void xi_dispatcher_release( xi_dispatcher_worker_t* worker )
+{
+    xi_dispatcher_worker_t* owner = worker->lender ? worker->lender : worker;
+
+    pthread_mutex_lock( &owner->lock );
+
+    if( worker->lender ) { owner->lent = 0; }
+    else { owner->running = 0; }
+
+    pthread_mutex_unlock( &owner->lock );
+}
+
+/**
+ * \brief   Wakes up a sleeping worker, preferably the `preferred` one
+ * \note    Must be called with the dispatcher lock held.
+ */
+static void xi_dispatcher_wake( struct xi_dispatcher_s* dispatcher, size_t preferred )
+{
+    for( size_t i = 0; i < dispatcher->worker_count; ++i )
+    {
+        xi_dispatcher_worker_t* worker
+            = &dispatcher->workers[ ( preferred + i ) % dispatcher->worker_count ];
+
+        if( worker->idle )
+        {
+            worker->idle = 0;
+            pthread_cond_signal( &worker->wake );
+            return;
+        }
+    }
+}
+
+static void xi_dispatcher_run( xi_dispatcher_worker_t* worker, xi_dispatch_request_t* req )
+{
+    const xi_response_t* response = 0;
+
+    switch( req->kind )
+    {
+        case XI_DISPATCH_FEED_UPDATE:
+            response = xi_feed_update( worker->context, req->feed );
+            break;
+        case XI_DISPATCH_DATASTREAM_UPDATE:
+            response = xi_datastream_update( worker->context, req->feed_id
+                , req->datastream_id, &req->value );
+            break;
+    }
+
+    if( req->callback ) { req->callback( worker->context, response, req->user_data ); }
+}
+
+static void* xi_dispatcher_worker( void* arg )
+{
+    xi_dispatcher_worker_t* worker      = ( xi_dispatcher_worker_t* ) arg;
+    struct xi_dispatcher_s* dispatcher  = worker->dispatcher;
+
+    for( ;; )
+    {
+        // what's been queued or finished since might be taken
+        pthread_mutex_lock( &dispatcher->lock );
+        size_t events = dispatcher->events;
+        pthread_mutex_unlock( &dispatcher->lock );
+
+        xi_dispatch_request_t* req = xi_dispatcher_take( worker );
+
+        if( req == 0 )
+        {
+            pthread_mutex_lock( &dispatcher->lock );
+
+            while( dispatcher->events == events && !( dispatcher->stopping
+                && __atomic_load_n( &dispatcher->queued, __ATOMIC_ACQUIRE ) == 0 ) )
+            {
+                worker->idle = 1;
+                pthread_cond_wait( &worker->wake, &dispatcher->lock );
+            }
+
+            worker->idle = 0;
+
+            int stop = dispatcher->stopping
+                && __atomic_load_n( &dispatcher->queued, __ATOMIC_ACQUIRE ) == 0;
+
+            pthread_mutex_unlock( &dispatcher->lock );
+
+            if( stop ) { break; }
+
+            continue;
+        }
+
+        if( __atomic_load_n( &dispatcher->queued, __ATOMIC_ACQUIRE ) > 0 )
+        {
+            pthread_mutex_lock( &dispatcher->lock );
+            xi_dispatcher_wake( dispatcher, ( size_t ) ( worker - dispatcher->workers ) + 1 );
+            pthread_mutex_unlock( &dispatcher->lock );
+        }
+
+        xi_dispatcher_run( worker, req );
+        xi_dispatcher_release( worker );
+
+        XI_SAFE_FREE( req->feed );
+        XI_SAFE_FREE( req );
+
+        pthread_mutex_lock( &dispatcher->lock );
+
+        dispatcher->events += 1;
+
+        // the owner may be waiting for the feed it has lent, and those
+        // waiting to stop for the last request
+        for( size_t i = 0; i < dispatcher->worker_count; ++i )
+        {
+            xi_dispatcher_worker_t* other = &dispatcher->workers[ i ];
+
+            if( other->idle && ( other == worker->lender || dispatcher->stopping ) )
+            {
+                other->idle = 0;
+                pthread_cond_signal( &other->wake );
+            }
+        }
+
+        if( --dispatcher->unfinished == 0 ) { pthread_cond_broadcast( &dispatcher->done ); }
+
+        pthread_mutex_unlock( &dispatcher->lock );
+    }
+
+    return 0;
+}
+
+/**
+ * \brief   Queues the request to the worker of its feed
+ */
+static int xi_dispatcher_queue( struct xi_dispatcher_s* dispatcher, xi_dispatch_request_t* req )
+{
+    size_t home = req->feed_id % dispatcher->worker_count;
+
+    xi_dispatcher_worker_t* worker = &dispatcher->workers[ home ];
+
+    // held all along, so the request can't finish before it's counted
+    pthread_mutex_lock( &dispatcher->lock );
+    pthread_mutex_lock( &worker->lock );
+
+    if( worker->count == XI_DISPATCHER_QUEUE_SIZE )
+    {
+        pthread_mutex_unlock( &worker->lock );
+        pthread_mutex_unlock( &dispatcher->lock );
+        xi_set_err( XI_DISPATCHER_QUEUE_FULL );
+        return -1;
+    }
+
+    worker->queue[ ( worker->front + worker->count ) % XI_DISPATCHER_QUEUE_SIZE ] = req;
+    worker->count += 1;
+
+    __atomic_add_fetch( &dispatcher->queued, 1, __ATOMIC_ACQ_REL );
+
+    pthread_mutex_unlock( &worker->lock );
+
+    dispatcher->unfinished += 1;
+    dispatcher->events += 1;
+    xi_dispatcher_wake( dispatcher, home );
+
+    pthread_mutex_unlock( &dispatcher->lock );
+
+    return 0;
+}
+
+xi_dispatcher_t* xi_create_dispatcher(
+          xi_protocol_t protocol
+        , const char* api_key
+        , size_t worker_count )
+{
+    // PRECONDITIONS
+    assert( api_key != 0 );
+    assert( worker_count > 0 );
+
+    xi_dispatcher_t* dispatcher = ( xi_dispatcher_t* ) xi_alloc( sizeof( xi_dispatcher_t ) );
+
+    XI_CHECK_MEMORY( dispatcher );
+
+    memset( dispatcher, 0, sizeof( xi_dispatcher_t ) );
+
+    pthread_mutex_init( &dispatcher->lock, 0 );
+    pthread_cond_init( &dispatcher->done, 0 );
+
+    dispatcher->workers = ( xi_dispatcher_worker_t* ) xi_alloc(
+        worker_count * sizeof( xi_dispatcher_worker_t ) );
+
+    XI_CHECK_MEMORY( dispatcher->workers );
+
+    memset( dispatcher->workers, 0, worker_count * sizeof( xi_dispatcher_worker_t ) );
+
+    // all of them are set up before any starts stealing from the others
+    for( size_t i = 0; i < worker_count; ++i )
+    {
+        xi_dispatcher_worker_t* worker = &dispatcher->workers[ i ];
+
+        worker->dispatcher  = dispatcher;
+        worker->context     = xi_create_context( protocol, api_key, 0 );
+
+        if( worker->context == 0 ) { goto err_handling; }
+
+        pthread_mutex_init( &worker->lock, 0 );
+        pthread_cond_init( &worker->wake, 0 );
+
+        dispatcher->worker_count += 1;
+    }
+
+    for( size_t i = 0; i < worker_count; ++i )
+    {
+        xi_dispatcher_worker_t* worker = &dispatcher->workers[ i ];
+
+        if( pthread_create( &worker->thread, 0, &xi_dispatcher_worker, worker ) != 0 )
+        {
+            xi_set_err( XI_DISPATCHER_THREAD_ERROR );
+            goto err_handling;
+        }
+
+        // those started so far are stopped by xi_delete_dispatcher()
+        dispatcher->started_count += 1;
+    }
+
+    return dispatcher;
+
+err_handling:
+    if( dispatcher )
+    {
+        if( dispatcher->workers ) { xi_delete_dispatcher( dispatcher ); }
+        else { XI_SAFE_FREE( dispatcher ); }
+    }
+
+    return 0;
+}
+
+void xi_delete_dispatcher( xi_dispatcher_t* dispatcher )
+{
+    // PRECONDITIONS
+    assert( dispatcher != 0 );
+
+    pthread_mutex_lock( &dispatcher->lock );
+
+    dispatcher->stopping = 1;
+
+    for( size_t i = 0; i < dispatcher->worker_count; ++i )
+    {
+        pthread_cond_signal( &dispatcher->workers[ i ].wake );
+    }
+
+    pthread_mutex_unlock( &dispatcher->lock );
+
+    // the ones still running may steal from any other until they stop
+    for( size_t i = 0; i < dispatcher->started_count; ++i )
+    {
+        pthread_join( dispatcher->workers[ i ].thread, 0 );
+    }
+
+    for( size_t i = 0; i < dispatcher->worker_count; ++i )
+    {
+        xi_dispatcher_worker_t* worker = &dispatcher->workers[ i ];
+
+        pthread_mutex_destroy( &worker->lock );
+        pthread_cond_destroy( &worker->wake );
+        xi_delete_context( worker->context );
+    }
+
+    pthread_mutex_destroy( &dispatcher->lock );
+    pthread_cond_destroy( &dispatcher->done );
+
+    XI_SAFE_FREE( dispatcher->workers );
+    XI_SAFE_FREE( dispatcher );
+}
+
+int xi_dispatch_feed_update(
+          xi_dispatcher_t* dispatcher
+        , const xi_feed_t* feed
+        , xi_response_callback_t callback, void* user_data )
+{
+    // PRECONDITIONS
+    assert( dispatcher != 0 );
+    assert( feed != 0 );
+
+    xi_dispatch_request_t* req
+        = ( xi_dispatch_request_t* ) xi_alloc( sizeof( xi_dispatch_request_t ) );
+
+    XI_CHECK_MEMORY( req );
+
+    memset( req, 0, sizeof( xi_dispatch_request_t ) );
+
+    req->kind       = XI_DISPATCH_FEED_UPDATE;
+    req->feed_id    = feed->feed_id;
+    req->callback   = callback;
+    req->user_data  = user_data;
+    req->feed       = ( xi_feed_t* ) xi_alloc( sizeof( xi_feed_t ) );
+
+    XI_CHECK_MEMORY( req->feed );
+
+    memcpy( req->feed, feed, sizeof( xi_feed_t ) );
+
+    if( xi_dispatcher_queue( dispatcher, req ) == -1 ) { goto err_handling; }
+
+    return 0;
+
+err_handling:
+    if( req ) { XI_SAFE_FREE( req->feed ); }
+    XI_SAFE_FREE( req );
+    return -1;
+}
+
+int xi_dispatch_datastream_update(
+          xi_dispatcher_t* dispatcher, xi_feed_id_t feed_id
+        , const char* datastream_id
+        , const xi_datapoint_t* value
+        , xi_response_callback_t callback, void* user_data )
+{
+    // PRECONDITIONS
+    assert( dispatcher != 0 );
+    assert( datastream_id != 0 );
+    assert( value != 0 );
+
+    xi_dispatch_request_t* req
+        = ( xi_dispatch_request_t* ) xi_alloc( sizeof( xi_dispatch_request_t ) );
+
+    XI_CHECK_MEMORY( req );
+
+    memset( req, 0, sizeof( xi_dispatch_request_t ) );
+
+    req->kind       = XI_DISPATCH_DATASTREAM_UPDATE;
+    req->feed_id    = feed_id;
+    req->callback   = callback;
+    req->user_data  = user_data;
+
+    XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME
+        , XI_HTTP_ENCODE_UPDATE_DATASTREAM );
+
+    strcpy( req->datastream_id, datastream_id );
+    memcpy( &req->value, value, sizeof( xi_datapoint_t ) );
+
+    if( xi_dispatcher_queue( dispatcher, req ) == -1 ) { goto err_handling; }
+
+    return 0;
+
+err_handling:
+    XI_SAFE_FREE( req );
+    return -1;
+}
+
+void xi_dispatcher_wait( xi_dispatcher_t* dispatcher )
+{
+    // PRECONDITIONS
+    assert( dispatcher != 0 );
+
+    pthread_mutex_lock( &dispatcher->lock );
+
+    while( dispatcher->unfinished > 0 )
+    {
+        pthread_cond_wait( &dispatcher->done, &dispatcher->lock );
+    }
+
+    pthread_mutex_unlock( &dispatcher->lock );
+}
+
+size_t xi_dispatcher_stolen( const xi_dispatcher_t* dispatcher )
+{
+    // PRECONDITIONS
+    assert( dispatcher != 0 );
+
+    return __atomic_load_n( &dispatcher->stolen, __ATOMIC_RELAXED );
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XI_DISPATCHER_PTHREAD
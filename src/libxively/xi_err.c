@@ -11,7 +11,7 @@
 #include "xi_macros.h"
 #include "xi_config.h"
 
-static xi_err_t xi_err = XI_NO_ERR;
+static XI_THREAD_LOCAL xi_err_t xi_err = XI_NO_ERR;
 
 #ifndef XI_OPT_NO_ERROR_STRINGS
 const char* xi_err_string[ XI_ERR_COUNT ] =
@@ -43,6 +43,30 @@ const char* xi_err_string[ XI_ERR_COUNT ] =
         , "XI_SOCKET_READ_ERROR"                       // XI_SOCKET_READ_ERROR
         , "XI_SOCKET_CLOSE_ERROR"                      // XI_SOCKET_CLOSE_ERROR
         , "XI_DATAPOINT_VALUE_BUFFER_OVERFLOW"         // XI_DATAPOINT_VALUE_BUFFER_OVERFLOW
+        , "XI_CONNECTION_POOL_EXHAUSTED"               // XI_CONNECTION_POOL_EXHAUSTED
+        , "XI_HTTP_RESPONSE_TOO_LARGE"                 // XI_HTTP_RESPONSE_TOO_LARGE
+        , "XI_REQUEST_TOO_MANY_SEGMENTS"               // XI_REQUEST_TOO_MANY_SEGMENTS
+        , "XI_PIPELINE_FULL"                           // XI_PIPELINE_FULL
+        , "XI_TCP_ENCODE_REQUEST"                      // XI_TCP_ENCODE_REQUEST
+        , "XI_TCP_PARSE_ERROR"                         // XI_TCP_PARSE_ERROR
+        , "XI_WS_HANDSHAKE_ERROR"                      // XI_WS_HANDSHAKE_ERROR
+        , "XI_WS_FRAME_ERROR"                          // XI_WS_FRAME_ERROR
+        , "XI_SOCKET_TIMEOUT_ERROR"                    // XI_SOCKET_TIMEOUT_ERROR
+        , "XI_SUBSCRIPTIONS_NOT_SUPPORTED"             // XI_SUBSCRIPTIONS_NOT_SUPPORTED
+        , "XI_SUBSCRIPTIONS_FULL"                      // XI_SUBSCRIPTIONS_FULL
+        , "XI_TLS_NOT_SUPPORTED"                       // XI_TLS_NOT_SUPPORTED
+        , "XI_TLS_INITIALIZATION_ERROR"                // XI_TLS_INITIALIZATION_ERROR
+        , "XI_TLS_HANDSHAKE_ERROR"                     // XI_TLS_HANDSHAKE_ERROR
+        , "XI_DISPATCHER_QUEUE_FULL"                   // XI_DISPATCHER_QUEUE_FULL
+        , "XI_DISPATCHER_THREAD_ERROR"                 // XI_DISPATCHER_THREAD_ERROR
+        , "XI_JSON_ENCODE_BUFFER_OVERRUN"              // XI_JSON_ENCODE_BUFFER_OVERRUN
+        , "XI_JSON_DECODE_FEED_PARSER_ERROR"           // XI_JSON_DECODE_FEED_PARSER_ERROR
+        , "XI_JSON_DECODE_DATAPOINT_PARSER_ERROR"      // XI_JSON_DECODE_DATAPOINT_PARSER_ERROR
+        , "XI_CBOR_ENCODE_BUFFER_OVERRUN"              // XI_CBOR_ENCODE_BUFFER_OVERRUN
+        , "XI_CBOR_DECODE_FEED_PARSER_ERROR"           // XI_CBOR_DECODE_FEED_PARSER_ERROR
+        , "XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR"      // XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR
+        , "XI_HTTP_ENCODE_GET_DATASTREAM_HISTORY"      // XI_HTTP_ENCODE_GET_DATASTREAM_HISTORY
+        , "XI_HISTORY_NOT_SUPPORTED"                   // XI_HISTORY_NOT_SUPPORTED
 };
 #endif /* XI_OPT_NO_ERROR_STRINGS */
 
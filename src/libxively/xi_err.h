@@ -49,6 +49,30 @@ typedef enum
     , XI_SOCKET_READ_ERROR
     , XI_SOCKET_CLOSE_ERROR
     , XI_DATAPOINT_VALUE_BUFFER_OVERFLOW
+    , XI_CONNECTION_POOL_EXHAUSTED
+    , XI_HTTP_RESPONSE_TOO_LARGE
+    , XI_REQUEST_TOO_MANY_SEGMENTS
+    , XI_PIPELINE_FULL
+    , XI_TCP_ENCODE_REQUEST
+    , XI_TCP_PARSE_ERROR
+    , XI_WS_HANDSHAKE_ERROR
+    , XI_WS_FRAME_ERROR
+    , XI_SOCKET_TIMEOUT_ERROR
+    , XI_SUBSCRIPTIONS_NOT_SUPPORTED
+    , XI_SUBSCRIPTIONS_FULL
+    , XI_TLS_NOT_SUPPORTED
+    , XI_TLS_INITIALIZATION_ERROR
+    , XI_TLS_HANDSHAKE_ERROR
+    , XI_DISPATCHER_QUEUE_FULL
+    , XI_DISPATCHER_THREAD_ERROR
+    , XI_JSON_ENCODE_BUFFER_OVERRUN
+    , XI_JSON_DECODE_FEED_PARSER_ERROR
+    , XI_JSON_DECODE_DATAPOINT_PARSER_ERROR
+    , XI_CBOR_ENCODE_BUFFER_OVERRUN
+    , XI_CBOR_DECODE_FEED_PARSER_ERROR
+    , XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR
+    , XI_HTTP_ENCODE_GET_DATASTREAM_HISTORY
+    , XI_HISTORY_NOT_SUPPORTED
     , XI_ERR_COUNT
 } xi_err_t;
 
@@ -74,8 +98,8 @@ extern xi_err_t xi_get_last_error( void );
 
 /**
  * \brief   Error setter for the library itself
- * \note    Current implementation used a global state variable (_errno_), which is not thread-safe.
- *          If thread-safety is required, than _errno_ should be made thread-local.
+ * \note    The last error is kept in a global state variable (_errno_), which is thread-local
+ *          wherever `XI_THREAD_LOCAL` is available [see xi_config.h].
  */
 extern void xi_set_err( xi_err_t e );
 
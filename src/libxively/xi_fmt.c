@@ -0,0 +1,485 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_fmt.c
+ * \brief   Formats the values of the datapoints as text [see xi_fmt.h]
+ *
+ *    The shortest digits of a float are found as in Ulf Adams, "Ryu: Fast
+ *    Float-to-String Conversion" (PLDI 2018): the float and the halfway points
+ *    to its neighbours are scaled by a power of ten, taken from the tables
+ *    below, and the digits are dropped for as long as the result still lies
+ *    between the halfway points. All of it is done in integers, so the output
+ *    doesn't depend on the rounding mode or the `printf` of the platform.
+ */
+
+#include <string.h>
+
+#include "xi_fmt.h"
+#include "xi_debug.h"
+
+#define XI_FMT_MANTISSA_BITS    23
+#define XI_FMT_EXPONENT_BITS    8
+#define XI_FMT_BIAS             127
+
+#define XI_FMT_POW5_INV_BITCOUNT    59
+#define XI_FMT_POW5_BITCOUNT        61
+
+//! the floats from here on are written with an exponent, as in JavaScript
+#define XI_FMT_MAX_FIXED_EXPONENT   21
+#define XI_FMT_MIN_FIXED_EXPONENT   -7
+
+static const char XI_FMT_DIGIT_PAIRS[ 200 ] = {
+      '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9'
+    , '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9'
+    , '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9'
+    , '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9'
+    , '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9'
+    , '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9'
+    , '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9'
+    , '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9'
+    , '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9'
+    , '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+//! 2^k / 5^q, rounded up, for q = 0..30
+static const uint64_t XI_FMT_POW5_INV_SPLIT[ 31 ] = {
+      0x0800000000000001ull, 0x0666666666666667ull, 0x051eb851eb851eb9ull, 0x04189374bc6a7efaull
+    , 0x068db8bac710cb2aull, 0x053e2d6238da3c22ull, 0x0431bde82d7b634eull, 0x06b5fca6af2bd216ull
+    , 0x055e63b88c230e78ull, 0x044b82fa09b5a52dull, 0x06df37f675ef6eaeull, 0x057f5ff85e592558ull
+    , 0x0465e6604b7a8447ull, 0x0709709a125da071ull, 0x05a126e1a84ae6c1ull, 0x0480ebe7b9d58567ull
+    , 0x0734aca5f6226f0bull, 0x05c3bd5191b525a3ull, 0x049c97747490eae9ull, 0x0760f253edb4ab0eull
+    , 0x05e72843249088d8ull, 0x04b8ed0283a6d3e0ull, 0x078e480405d7b966ull, 0x060b6cd004ac9452ull
+    , 0x04d5f0a66a23a9dbull, 0x07bcb43d769f762bull, 0x063090312bb2c4efull, 0x04f3a68dbc8f03f3ull
+    , 0x07ec3daf94180651ull, 0x065697bfa9acd1daull, 0x051212ffbaf0a7e2ull
+};
+
+//! 5^i / 2^k, the top 61 bits, for i = 0..46
+static const uint64_t XI_FMT_POW5_SPLIT[ 47 ] = {
+      0x1000000000000000ull, 0x1400000000000000ull, 0x1900000000000000ull, 0x1f40000000000000ull
+    , 0x1388000000000000ull, 0x186a000000000000ull, 0x1e84800000000000ull, 0x1312d00000000000ull
+    , 0x17d7840000000000ull, 0x1dcd650000000000ull, 0x12a05f2000000000ull, 0x174876e800000000ull
+    , 0x1d1a94a200000000ull, 0x12309ce540000000ull, 0x16bcc41e90000000ull, 0x1c6bf52634000000ull
+    , 0x11c37937e0800000ull, 0x16345785d8a00000ull, 0x1bc16d674ec80000ull, 0x1158e460913d0000ull
+    , 0x15af1d78b58c4000ull, 0x1b1ae4d6e2ef5000ull, 0x10f0cf064dd59200ull, 0x152d02c7e14af680ull
+    , 0x1a784379d99db420ull, 0x108b2a2c28029094ull, 0x14adf4b7320334b9ull, 0x19d971e4fe8401e7ull
+    , 0x1027e72f1f128130ull, 0x1431e0fae6d7217cull, 0x193e5939a08ce9dbull, 0x1f8def8808b02452ull
+    , 0x13b8b5b5056e16b3ull, 0x18a6e32246c99c60ull, 0x1ed09bead87c0378ull, 0x13426172c74d822bull
+    , 0x1812f9cf7920e2b6ull, 0x1e17b84357691b64ull, 0x12ced32a16a1b11eull, 0x178287f49c4a1d66ull
+    , 0x1d6329f1c35ca4bfull, 0x125dfa371a19e6f7ull, 0x16f578c4e0a060b5ull, 0x1cb2d6f618c878e3ull
+    , 0x11efc659cf7d4b8dull, 0x166bb7f0435c9e71ull, 0x1c06a5ec5433c60dull
+};
+
+//-----------------------------------------------------------------------
+// INTEGERS
+//-----------------------------------------------------------------------
+
+static inline int xi_fmt_u32_length( uint32_t value )
+{
+    if( value < 10 )            { return 1; }
+    if( value < 100 )           { return 2; }
+    if( value < 1000 )          { return 3; }
+    if( value < 10000 )         { return 4; }
+    if( value < 100000 )        { return 5; }
+    if( value < 1000000 )       { return 6; }
+    if( value < 10000000 )      { return 7; }
+    if( value < 100000000 )     { return 8; }
+    if( value < 1000000000 )    { return 9; }
+    return 10;
+}
+
+/**
+ * \brief   Writes the digits backwards, so that the last one lands right
+ *          before the `end`
+ */
+static inline void xi_fmt_u32_digits( char* end, uint32_t value )
+{
+    while( value >= 100 )
+    {
+        const uint32_t pair = ( value % 100 ) * 2;
+        value /= 100;
+        end -= 2;
+        end[ 0 ] = XI_FMT_DIGIT_PAIRS[ pair ];
+        end[ 1 ] = XI_FMT_DIGIT_PAIRS[ pair + 1 ];
+    }
+
+    if( value >= 10 )
+    {
+        end -= 2;
+        end[ 0 ] = XI_FMT_DIGIT_PAIRS[ value * 2 ];
+        end[ 1 ] = XI_FMT_DIGIT_PAIRS[ value * 2 + 1 ];
+    }
+    else
+    {
+        *--end = ( char ) ( '0' + value );
+    }
+}
+
+int xi_fmt_i32( char* buffer, size_t buffer_size, int32_t value )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+
+    const int negative      = value < 0;
+    const uint32_t absolute = negative ? 0u - ( uint32_t ) value : ( uint32_t ) value;
+    const int length        = negative + xi_fmt_u32_length( absolute );
+
+    if( ( size_t ) length >= buffer_size ) { return -1; }
+
+    buffer[ 0 ] = '-';
+    xi_fmt_u32_digits( buffer + length, absolute );
+    buffer[ length ] = '\0';
+
+    return length;
+}
+
+void xi_fmt_u32_fixed( char* buffer, uint32_t value, size_t width )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+
+    char* dst = buffer + width;
+
+    while( dst - buffer >= 2 )
+    {
+        const uint32_t pair = ( value % 100 ) * 2;
+        value /= 100;
+        dst -= 2;
+        dst[ 0 ] = XI_FMT_DIGIT_PAIRS[ pair ];
+        dst[ 1 ] = XI_FMT_DIGIT_PAIRS[ pair + 1 ];
+    }
+
+    if( dst != buffer )
+    {
+        *--dst = ( char ) ( '0' + value % 10 );
+    }
+}
+
+//-----------------------------------------------------------------------
+// FLOATS
+//-----------------------------------------------------------------------
+
+//! ceil( log2( 5^e ) ), for 0 <= e <= 3528
+static inline int32_t xi_fmt_pow5bits( int32_t e )
+{
+    return ( int32_t ) ( ( ( uint32_t ) e * 1217359 ) >> 19 ) + 1;
+}
+
+//! floor( log10( 2^e ) ), for 0 <= e <= 1650
+static inline uint32_t xi_fmt_log10_pow2( int32_t e )
+{
+    return ( ( uint32_t ) e * 78913 ) >> 18;
+}
+
+//! floor( log10( 5^e ) ), for 0 <= e <= 2620
+static inline uint32_t xi_fmt_log10_pow5( int32_t e )
+{
+    return ( ( uint32_t ) e * 732923 ) >> 20;
+}
+
+static inline int xi_fmt_multiple_of_pow5( uint32_t value, uint32_t p )
+{
+    uint32_t count = 0;
+
+    while( value % 5 == 0 )
+    {
+        value /= 5;
+        ++count;
+    }
+
+    return count >= p;
+}
+
+static inline int xi_fmt_multiple_of_pow2( uint32_t value, uint32_t p )
+{
+    return ( value & ( ( 1u << p ) - 1 ) ) == 0;
+}
+
+//! ( m * factor ) >> shift, for shift > 32, without a 128 bit product
+static inline uint32_t xi_fmt_mul_shift( uint32_t m, uint64_t factor, int32_t shift )
+{
+    const uint64_t low  = ( uint64_t ) m * ( uint32_t ) factor;
+    const uint64_t high = ( uint64_t ) m * ( uint32_t ) ( factor >> 32 );
+    const uint64_t sum  = ( low >> 32 ) + high;
+
+    return ( uint32_t ) ( sum >> ( shift - 32 ) );
+}
+
+/**
+ * \brief   Finds the shortest `digits * 10^exponent` which rounds to the float
+ *          given by its fields, it mustn't be a zero, an infinity nor a NaN
+ */
+static void xi_fmt_f32_shortest(
+      uint32_t ieee_mantissa
+    , uint32_t ieee_exponent
+    , uint32_t* digits
+    , int32_t* exponent )
+{
+    int32_t e2              = 0;
+    uint32_t m2             = 0;
+
+    if( ieee_exponent == 0 )
+    {
+        e2 = 1 - XI_FMT_BIAS - XI_FMT_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    }
+    else
+    {
+        e2 = ( int32_t ) ieee_exponent - XI_FMT_BIAS - XI_FMT_MANTISSA_BITS - 2;
+        m2 = ( 1u << XI_FMT_MANTISSA_BITS ) | ieee_mantissa;
+    }
+
+    // the halfway points belong to the float if its mantissa is even
+    const int accept_bounds = ( m2 & 1 ) == 0;
+
+    // the float and the halfway points to its neighbours, scaled by four, the
+    // lower one lies closer if the float is the first of its binade
+    const uint32_t mv       = 4 * m2;
+    const uint32_t mp       = 4 * m2 + 2;
+    const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    const uint32_t mm       = 4 * m2 - 1 - mm_shift;
+
+    uint32_t vr = 0, vp = 0, vm = 0;
+    int32_t e10                 = 0;
+    int vm_is_trailing_zeros    = 0;
+    int vr_is_trailing_zeros    = 0;
+    uint32_t last_removed_digit = 0;
+
+    if( e2 >= 0 )
+    {
+        const uint32_t q    = xi_fmt_log10_pow2( e2 );
+        const int32_t k     = XI_FMT_POW5_INV_BITCOUNT + xi_fmt_pow5bits( ( int32_t ) q ) - 1;
+        const int32_t i     = -e2 + ( int32_t ) q + k;
+
+        e10 = ( int32_t ) q;
+        vr  = xi_fmt_mul_shift( mv, XI_FMT_POW5_INV_SPLIT[ q ], i );
+        vp  = xi_fmt_mul_shift( mp, XI_FMT_POW5_INV_SPLIT[ q ], i );
+        vm  = xi_fmt_mul_shift( mm, XI_FMT_POW5_INV_SPLIT[ q ], i );
+
+        if( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            // the digit dropped by the scaling decides the rounding below
+            const int32_t l = XI_FMT_POW5_INV_BITCOUNT + xi_fmt_pow5bits( ( int32_t ) ( q - 1 ) ) - 1;
+            last_removed_digit = xi_fmt_mul_shift(
+                  mv, XI_FMT_POW5_INV_SPLIT[ q - 1 ]
+                , -e2 + ( int32_t ) q - 1 + l ) % 10;
+        }
+
+        if( q <= 9 )
+        {
+            if( mv % 5 == 0 )
+            {
+                vr_is_trailing_zeros = xi_fmt_multiple_of_pow5( mv, q );
+            }
+            else if( accept_bounds )
+            {
+                vm_is_trailing_zeros = xi_fmt_multiple_of_pow5( mm, q );
+            }
+            else
+            {
+                vp -= xi_fmt_multiple_of_pow5( mp, q );
+            }
+        }
+    }
+    else
+    {
+        const uint32_t q    = xi_fmt_log10_pow5( -e2 );
+        const int32_t i     = -e2 - ( int32_t ) q;
+        const int32_t k     = xi_fmt_pow5bits( i ) - XI_FMT_POW5_BITCOUNT;
+        int32_t j           = ( int32_t ) q - k;
+
+        e10 = ( int32_t ) q + e2;
+        vr  = xi_fmt_mul_shift( mv, XI_FMT_POW5_SPLIT[ i ], j );
+        vp  = xi_fmt_mul_shift( mp, XI_FMT_POW5_SPLIT[ i ], j );
+        vm  = xi_fmt_mul_shift( mm, XI_FMT_POW5_SPLIT[ i ], j );
+
+        if( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            j = ( int32_t ) q - 1 - ( xi_fmt_pow5bits( i + 1 ) - XI_FMT_POW5_BITCOUNT );
+            last_removed_digit = xi_fmt_mul_shift( mv, XI_FMT_POW5_SPLIT[ i + 1 ], j ) % 10;
+        }
+
+        if( q <= 1 )
+        {
+            vr_is_trailing_zeros = 1;
+
+            if( accept_bounds )
+            {
+                vm_is_trailing_zeros = mm_shift == 1;
+            }
+            else
+            {
+                --vp;
+            }
+        }
+        else if( q < 31 )
+        {
+            vr_is_trailing_zeros = xi_fmt_multiple_of_pow2( mv, q - 1 );
+        }
+    }
+
+    // drops the digits for as long as the result stays within the bounds
+    int32_t removed = 0;
+
+    if( vm_is_trailing_zeros || vr_is_trailing_zeros )
+    {
+        while( vp / 10 > vm / 10 )
+        {
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = vr % 10;
+            vr /= 10; vp /= 10; vm /= 10;
+            ++removed;
+        }
+
+        if( vm_is_trailing_zeros )
+        {
+            while( vm % 10 == 0 )
+            {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = vr % 10;
+                vr /= 10; vp /= 10; vm /= 10;
+                ++removed;
+            }
+        }
+
+        // an exact half rounds to even
+        if( vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0 )
+        {
+            last_removed_digit = 4;
+        }
+
+        *digits = vr + ( ( vr == vm && ( !accept_bounds || !vm_is_trailing_zeros ) )
+                        || last_removed_digit >= 5 );
+    }
+    else
+    {
+        while( vp / 10 > vm / 10 )
+        {
+            last_removed_digit = vr % 10;
+            vr /= 10; vp /= 10; vm /= 10;
+            ++removed;
+        }
+
+        *digits = vr + ( vr == vm || last_removed_digit >= 5 );
+    }
+
+    *exponent = e10 + removed;
+}
+
+int xi_fmt_f32( char* buffer, size_t buffer_size, float value )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+
+    char out[ XI_FMT_F32_MAX_SIZE ];
+    char* dst       = out;
+    uint32_t bits   = 0;
+
+    memcpy( &bits, &value, sizeof( bits ) );
+
+    const int negative              = ( bits >> 31 ) != 0;
+    const uint32_t ieee_mantissa    = bits & ( ( 1u << XI_FMT_MANTISSA_BITS ) - 1 );
+    const uint32_t ieee_exponent    =
+        ( bits >> XI_FMT_MANTISSA_BITS ) & ( ( 1u << XI_FMT_EXPONENT_BITS ) - 1 );
+
+    if( ieee_exponent == ( 1u << XI_FMT_EXPONENT_BITS ) - 1 )
+    {
+        const char* special = ieee_mantissa != 0 ? "nan" : ( negative ? "-inf" : "inf" );
+        const size_t length = strlen( special );
+
+        if( length >= buffer_size ) { return -1; }
+
+        memcpy( buffer, special, length + 1 );
+
+        return ( int ) length;
+    }
+
+    if( negative ) { *dst++ = '-'; }
+
+    if( ieee_exponent == 0 && ieee_mantissa == 0 )
+    {
+        memcpy( dst, "0.0", 3 );
+        dst += 3;
+    }
+    else
+    {
+        uint32_t digits     = 0;
+        int32_t exponent    = 0;
+
+        xi_fmt_f32_shortest( ieee_mantissa, ieee_exponent, &digits, &exponent );
+
+        char text[ 10 ];
+        const int32_t length    = xi_fmt_u32_length( digits );
+        const int32_t point     = length + exponent;
+
+        xi_fmt_u32_digits( text + length, digits );
+
+        if( point - 1 >= XI_FMT_MIN_FIXED_EXPONENT && point - 1 < XI_FMT_MAX_FIXED_EXPONENT )
+        {
+            if( point <= 0 )
+            {
+                // 0.000ddd
+                *dst++ = '0';
+                *dst++ = '.';
+                memset( dst, '0', -point );
+                dst += -point;
+                memcpy( dst, text, length );
+                dst += length;
+            }
+            else if( point >= length )
+            {
+                // ddd000.0
+                memcpy( dst, text, length );
+                dst += length;
+                memset( dst, '0', point - length );
+                dst += point - length;
+                *dst++ = '.';
+                *dst++ = '0';
+            }
+            else
+            {
+                // dd.ddd
+                memcpy( dst, text, point );
+                dst += point;
+                *dst++ = '.';
+                memcpy( dst, text + point, length - point );
+                dst += length - point;
+            }
+        }
+        else
+        {
+            // d.ddde-dd
+            int32_t scientific = point - 1;
+
+            *dst++ = text[ 0 ];
+
+            if( length > 1 )
+            {
+                *dst++ = '.';
+                memcpy( dst, text + 1, length - 1 );
+                dst += length - 1;
+            }
+
+            *dst++ = 'e';
+
+            if( scientific < 0 )
+            {
+                *dst++ = '-';
+                scientific = -scientific;
+            }
+
+            dst += xi_fmt_u32_length( scientific );
+            xi_fmt_u32_digits( dst, scientific );
+        }
+    }
+
+    const size_t length = dst - out;
+
+    if( length >= buffer_size ) { return -1; }
+
+    memcpy( buffer, out, length );
+    buffer[ length ] = '\0';
+
+    return ( int ) length;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_fmt.h
+ * \brief   Formats the values of the datapoints as text, faster and shorter than `snprintf`
+ *
+ *    The integers are written two digits at a time. The floats are written with
+ *    the fewest digits which read back as the same float (the Ryu algorithm), so
+ *    `1.5f` becomes `1.5`, not `1.500000`, and no digits of the float are lost.
+ */
+
+#ifndef __XI_FMT_H__
+#define __XI_FMT_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! the room the longest integer takes, with the terminator
+#define XI_FMT_I32_MAX_SIZE     12
+
+//! the room the longest float takes, with the terminator
+#define XI_FMT_F32_MAX_SIZE     26
+
+/**
+ * \brief   Writes the integer in decimal and terminates it
+ *
+ * \return  Number of characters written, without the terminator, or `-1`
+ *          if they don't fit.
+ */
+int xi_fmt_i32( char* buffer, size_t buffer_size, int32_t value );
+
+/**
+ * \brief   Writes exactly `width` digits of the value, padded with zeros
+ *          and not terminated, as the fixed width fields of the timestamps
+ *
+ * \note    The digits which don't fit in the `width` are dropped.
+ */
+void xi_fmt_u32_fixed( char* buffer, uint32_t value, size_t width );
+
+/**
+ * \brief   Writes the shortest decimal which reads back as the same float
+ *          and terminates it
+ *
+ *    Between `1e-7` and `1e21` the float is written with a point and at least
+ *    one digit after it, e.g. `21.5`, `2.0` or `0.001`, so it isn't taken for
+ *    an integer when it's read back, otherwise it's written with an exponent,
+ *    e.g. `1.5e30`. `nan`, `inf` and `-inf` are written as `printf` does.
+ *
+ * \return  Number of characters written, without the terminator, or `-1`
+ *          if they don't fit.
+ */
+int xi_fmt_f32( char* buffer, size_t buffer_size, float value );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_FMT_H__
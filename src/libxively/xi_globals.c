@@ -8,5 +8,12 @@
  */
 
 #include "xi_globals.h"
+#include "xi_config.h"
 
-xi_globals_t xi_globals = { 1500 };
+xi_globals_t xi_globals =
+{
+      1500
+    , XI_CONNECTION_POOL_SIZE
+    , XI_CONNECTION_IDLE_TIMEOUT
+    , XI_CONNECTION_MAX_REQUESTS
+};
@@ -23,6 +23,9 @@ extern "C" {
 typedef struct
 {
     uint32_t network_timeout; //!< the network timeout (default: 1500 milliseconds)
+    uint32_t connection_pool_size; //!< max number of pooled connections, `0` disables pooling (default: `XI_CONNECTION_POOL_SIZE`)
+    uint32_t connection_idle_timeout; //!< seconds after which an idle connection is closed (default: `XI_CONNECTION_IDLE_TIMEOUT`)
+    uint32_t connection_max_requests; //!< requests after which a connection is closed, `0` means no limit (default: `XI_CONNECTION_MAX_REQUESTS`)
 } xi_globals_t;
 
 extern xi_globals_t xi_globals; //!< global instance of `xi_globals_t`
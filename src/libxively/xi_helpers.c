@@ -15,6 +15,8 @@
 #include "xi_debug.h"
 #include "xi_helpers.h"
 #include "xi_allocator.h"
+#include "xi_err.h"
+#include "xi_scan.h"
 
 char* xi_str_dup( const char* s )
 {
@@ -28,6 +30,72 @@ char* xi_str_dup( const char* s )
     return ret;
 }
 
+int xi_buffer_reserve( char** buffer, size_t* size, size_t needed, size_t max_size )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( size != 0 );
+
+    if( *buffer && needed <= *size ) { return 0; }
+    if( needed > max_size ) { return -1; }
+
+    size_t new_size = *buffer ? *size * 2 : needed;
+
+    if( new_size < needed )     { new_size = needed; }
+    if( new_size > max_size )   { new_size = max_size; }
+
+    char* ret = xi_alloc( new_size );
+    if( ret == 0 ) { return -1; }
+
+    if( *buffer )
+    {
+        memcpy( ret, *buffer, *size );
+        xi_free( *buffer );
+    }
+
+    *buffer = ret;
+    *size   = new_size;
+
+    return 0;
+}
+
+long xi_prepare_read( char** buffer, size_t* buffer_size
+    , size_t start, size_t received
+    , long ( *response_size )( struct xi_frame_s* frame, const char* data, size_t size )
+    , struct xi_frame_s* frame )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( buffer_size != 0 );
+    assert( start <= received );
+    assert( response_size != 0 );
+    assert( frame != 0 );
+
+    long total = received > start
+        ? response_size( frame, *buffer + start, received - start ) : -1;
+
+    if( total > 0 && received - start >= ( size_t ) total ) { return 0; }
+
+    // until the length is known, read as much as fits
+    size_t needed = total > 0 ? start + ( size_t ) total + 1 : received + 2;
+
+    if( needed < start + XI_HTTP_MAX_CONTENT_SIZE )
+    {
+        needed = start + XI_HTTP_MAX_CONTENT_SIZE;
+    }
+
+    if( xi_buffer_reserve( buffer, buffer_size
+        , needed, start + XI_HTTP_MAX_RESPONSE_SIZE + 1 ) == -1 )
+    {
+        xi_set_err( XI_HTTP_RESPONSE_TOO_LARGE );
+        return -1;
+    }
+
+    return total > 0
+        ? ( long ) ( start + total - received )
+        : ( long ) ( *buffer_size - 1 - received );
+}
+
 int xi_str_copy_untiln( char* dst, size_t dst_size, const char* src, char delim )
 {
     // PRECONDITIONS
@@ -35,16 +103,17 @@ int xi_str_copy_untiln( char* dst, size_t dst_size, const char* src, char delim
     assert( dst_size > 1 );
     assert( src != 0 );
 
-    size_t counter = 0;
     size_t real_size = dst_size - 1;
 
-    while( *src != delim && counter < real_size && *src != '\0' )
-    {
-        *dst++ = *src++;
-        counter++;
-    }
+    // the scan stops at the delimiter, the terminator or the end of the room
+    xi_scan_t scan;
+    xi_scan_init( &scan, src, real_size, delim, delim );
+
+    size_t counter = xi_scan_next( &scan ) - src;
+
+    memcpy( dst, src, counter );
+    dst[ counter ] = '\0';
 
-    *dst = '\0';
     return counter;
 }
 
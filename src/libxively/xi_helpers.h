@@ -17,6 +17,8 @@
 extern "C" {
 #endif
 
+struct xi_frame_s;
+
 
 /**
  * \note    Needed to avoid using `strdup()` which can cause some problems with `free()`,
@@ -33,6 +35,35 @@ char* xi_str_dup( const char* s );
  */
 int xi_str_copy_untiln( char* dst, size_t dst_size, const char* src, char delim );
 
+/**
+ * \brief   Makes sure the buffer can hold `needed` bytes, it's reallocated
+ *          (at least doubling it's size) but never beyond `max_size` bytes
+ *
+ * \note    It doesn't use `realloc()` for the same reasons as `xi_str_dup()`.
+ *
+ * \return  0 on success or -1 if more than `max_size` bytes are needed or the
+ *          memory allocation has failed.
+ */
+int xi_buffer_reserve( char** buffer, size_t* size, size_t needed, size_t max_size );
+
+/**
+ * \brief   Prepares the buffer for reading more of a response which begins
+ *          at `start`, `received` bytes are already in the buffer
+ *
+ *    The buffer grows as needed, up to `XI_HTTP_MAX_RESPONSE_SIZE` bytes past
+ *    `start` (plus the terminating zero). Once `response_size` knows how long
+ *    the response is, only the rest of it is asked for, so nothing that
+ *    follows it gets consumed [see transport_layer_t]. The frame keeps how far
+ *    the response has been looked at, it's zeroed for each new one.
+ *
+ * \return  Number of bytes to read next, `0` if the response is complete or
+ *          `-1` if it's too large or the memory allocation has failed.
+ */
+long xi_prepare_read( char** buffer, size_t* buffer_size
+    , size_t start, size_t received
+    , long ( *response_size )( struct xi_frame_s* frame, const char* data, size_t size )
+    , struct xi_frame_s* frame );
+
 /**
  * \brief   Replaces `p` with `r` for every `p` in `buffer`
  *
@@ -0,0 +1,61 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_iovec.c
+ * \brief   Helpers for the segmented requests [see xi_iovec.h]
+ */
+
+#include "xi_iovec.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+int xi_request_append( xi_request_t* request, const char* data, size_t size )
+{
+    // PRECONDITIONS
+    assert( request != 0 );
+
+    if( data == 0 || size == 0 ) { return 0; }
+
+    if( request->count == XI_REQUEST_MAX_SEGMENTS )
+    {
+        xi_set_err( XI_REQUEST_TOO_MANY_SEGMENTS );
+        return -1;
+    }
+
+    request->segments[ request->count ].data = data;
+    request->segments[ request->count ].size = size;
+    request->count += 1;
+
+    return 0;
+}
+
+size_t xi_iovec_size( const xi_iovec_t* iov, size_t count )
+{
+    size_t size = 0;
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        size += iov[ i ].size;
+    }
+
+    return size;
+}
+
+size_t xi_iovec_consume( xi_iovec_t* iov, size_t count, size_t bytes )
+{
+    size_t i = 0;
+
+    for( ; i < count && bytes >= iov[ i ].size; ++i )
+    {
+        bytes -= iov[ i ].size;
+    }
+
+    if( i < count )
+    {
+        iov[ i ].data += bytes;
+        iov[ i ].size -= bytes;
+    }
+
+    return i;
+}
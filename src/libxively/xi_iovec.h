@@ -0,0 +1,65 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_iovec.h
+ * \brief   Defines `xi_iovec_t` and `xi_request_t`, which are used to pass the
+ *          requests from the _transport layer_ to the _communication layer_
+ *          without copying them into a single buffer
+ */
+
+#ifndef __XI_IOVEC_H__
+#define __XI_IOVEC_H__
+
+#include <stdlib.h>
+
+#include "xi_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   A segment of data to be sent, it isn't owned by the structure
+ */
+typedef struct {
+    const char* data;
+    size_t      size;
+} xi_iovec_t;
+
+/**
+ * \brief   A request, as encoded by the _transport layer_
+ *
+ *    The segments point to the buffers the parts of the request have been
+ *    encoded into, so they only stay valid until the next request is encoded.
+ */
+typedef struct {
+    xi_iovec_t  segments[ XI_REQUEST_MAX_SEGMENTS ];
+    size_t      count;
+} xi_request_t;
+
+/**
+ * \brief   Appends a segment to the request, empty ones are skipped
+ *
+ * \return  `0` on success or `-1` if there's no room for it.
+ */
+int xi_request_append( xi_request_t* request, const char* data, size_t size );
+
+/**
+ * \return  Number of bytes in all of the segments.
+ */
+size_t xi_iovec_size( const xi_iovec_t* iov, size_t count );
+
+/**
+ * \brief   Skips the bytes that have been sent, a segment which has only been
+ *          sent in part is updated to point to the rest of it
+ *
+ * \return  Number of the segments that have been sent completely.
+ */
+size_t xi_iovec_consume( xi_iovec_t* iov, size_t count, size_t bytes );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_IOVEC_H__
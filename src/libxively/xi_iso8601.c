@@ -0,0 +1,191 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_iso8601.c
+ * \brief   Writes and reads the timestamps of the API [see xi_iso8601.h]
+ *
+ *    A feed or a history carries many timestamps of the same day. The date of
+ *    the last one written, `YYYY-MM-DDT`, and the midnight of the last one
+ *    read are kept per thread, so `xi_gmtime_r` and `xi_mktime` run when the
+ *    day changes and the rest is a division of the seconds of the day.
+ */
+
+#include <string.h>
+#include <limits.h>
+
+#include "xi_iso8601.h"
+#include "xi_fmt.h"
+#include "xi_time.h"
+#include "xi_debug.h"
+#include "xi_config.h"
+
+#define XI_ISO8601_DATE_SIZE    11
+#define XI_ISO8601_SECS_DAY     ( 24UL * 60UL * 60UL )
+
+//! the day whose date is in `XI_ISO8601_ENCODED_DATE`, none at first
+static XI_THREAD_LOCAL unsigned long XI_ISO8601_ENCODED_DAY = ULONG_MAX;
+static XI_THREAD_LOCAL char XI_ISO8601_ENCODED_DATE[ XI_ISO8601_DATE_SIZE ];
+
+//! the date last read, as `YYYYMMDD`, and the seconds of its midnight
+static XI_THREAD_LOCAL long XI_ISO8601_DECODED_DATE = -1;
+static XI_THREAD_LOCAL xi_time_t XI_ISO8601_DECODED_MIDNIGHT;
+
+int xi_iso8601_encode(
+      char* buffer
+    , size_t buffer_size
+    , const xi_timestamp_t* timestamp )
+{
+    // PRECONDITIONS
+    assert( buffer != 0 );
+    assert( timestamp != 0 );
+
+    if( buffer_size <= XI_ISO8601_SIZE
+        || timestamp->micro < 0 || timestamp->micro > 999999 )
+    {
+        return -1;
+    }
+
+    // the same as xi_gmtime does
+    const unsigned long seconds = ( unsigned long ) timestamp->timestamp;
+    const unsigned long day     = seconds / XI_ISO8601_SECS_DAY;
+    const uint32_t clock        = ( uint32_t ) ( seconds % XI_ISO8601_SECS_DAY );
+
+    if( day != XI_ISO8601_ENCODED_DAY )
+    {
+        const xi_time_t midnight    = ( xi_time_t ) ( day * XI_ISO8601_SECS_DAY );
+        char* date                  = XI_ISO8601_ENCODED_DATE;
+        struct xi_tm tm;
+        const struct xi_tm* ptm     = xi_gmtime_r( &midnight, &tm );
+
+        if( ptm->tm_year + 1900 > 9999 ) { return -1; }
+
+        xi_fmt_u32_fixed( date, ptm->tm_year + 1900, 4 );
+        date[ 4 ] = '-';
+        xi_fmt_u32_fixed( date + 5, ptm->tm_mon + 1, 2 );
+        date[ 7 ] = '-';
+        xi_fmt_u32_fixed( date + 8, ptm->tm_mday, 2 );
+        date[ 10 ] = 'T';
+
+        XI_ISO8601_ENCODED_DAY = day;
+    }
+
+    memcpy( buffer, XI_ISO8601_ENCODED_DATE, XI_ISO8601_DATE_SIZE );
+    xi_fmt_u32_fixed( buffer + 11, clock / 3600, 2 );
+    buffer[ 13 ] = ':';
+    xi_fmt_u32_fixed( buffer + 14, clock / 60 % 60, 2 );
+    buffer[ 16 ] = ':';
+    xi_fmt_u32_fixed( buffer + 17, clock % 60, 2 );
+    buffer[ 19 ] = '.';
+    xi_fmt_u32_fixed( buffer + 20, ( uint32_t ) timestamp->micro, 6 );
+    buffer[ 26 ] = 'Z';
+    buffer[ 27 ] = '\0';
+
+    return XI_ISO8601_SIZE;
+}
+
+static inline int xi_iso8601_is_digit( char c )
+{
+    return ( unsigned ) ( c - '0' ) <= 9;
+}
+
+/**
+ * \return  The value of the `count` digits or `-1` if any of them isn't one.
+ */
+static inline long xi_iso8601_digits( const char* text, size_t count )
+{
+    long value = 0;
+
+    for( ; count > 0; --count, ++text )
+    {
+        if( !xi_iso8601_is_digit( *text ) ) { return -1; }
+
+        value = value * 10 + ( *text - '0' );
+    }
+
+    return value;
+}
+
+int xi_iso8601_decode(
+      const char* text
+    , size_t text_size
+    , xi_timestamp_t* timestamp )
+{
+    // PRECONDITIONS
+    assert( text != 0 );
+    assert( timestamp != 0 );
+
+    size_t n = 0;
+
+    // the year, up to four digits as %04d took them
+    while( n < 4 && n < text_size && xi_iso8601_is_digit( text[ n ] ) ) { ++n; }
+
+    // MM-DDThh:mm:ss follows it
+    if( n == 0 || text_size - n < 15 ) { return -1; }
+
+    const char* p       = text + n;
+    const long year     = xi_iso8601_digits( text, n );
+    const long month    = xi_iso8601_digits( p + 1, 2 );
+    const long day      = xi_iso8601_digits( p + 4, 2 );
+    const long hour     = xi_iso8601_digits( p + 7, 2 );
+    const long minute   = xi_iso8601_digits( p + 10, 2 );
+    const long second   = xi_iso8601_digits( p + 13, 2 );
+
+    if( p[ 0 ] != '-' || p[ 3 ] != '-' || p[ 6 ] != 'T' || p[ 9 ] != ':' || p[ 12 ] != ':'
+        || ( month | day | hour | minute | second ) < 0 )
+    {
+        return -1;
+    }
+
+    n += 15;
+
+    // the fraction, scaled to the microseconds
+    long micro = 0;
+
+    if( n < text_size && text[ n ] == '.' )
+    {
+        long scale  = 100000;
+        size_t i    = ++n;
+
+        for( ; i < text_size && xi_iso8601_is_digit( text[ i ] ); ++i )
+        {
+            micro += ( text[ i ] - '0' ) * scale;
+            scale /= 10;
+        }
+
+        if( i == n ) { return -1; }
+
+        n = i;
+    }
+
+    if( n < text_size && text[ n ] == 'Z' ) { ++n; }
+
+    // only the day is given to xi_mktime, the rest is added to its midnight
+    const long date = ( year * 100 + month ) * 100 + day;
+
+    if( date != XI_ISO8601_DECODED_DATE )
+    {
+        struct xi_tm timeinfo;
+
+        memset( &timeinfo, 0, sizeof( timeinfo ) );
+        timeinfo.tm_year   = ( int ) year - 1900;
+        timeinfo.tm_mon    = ( int ) month - 1;
+        timeinfo.tm_mday   = ( int ) day;
+
+        const xi_time_t midnight = xi_mktime( &timeinfo );
+
+        if( midnight == ( xi_time_t ) -1 ) { return -2; }
+
+        XI_ISO8601_DECODED_MIDNIGHT = midnight;
+        XI_ISO8601_DECODED_DATE     = date;
+    }
+
+    const long clock = ( hour * 60 + minute ) * 60 + second;
+
+    if( XI_ISO8601_DECODED_MIDNIGHT > LONG_MAX - clock ) { return -2; }
+
+    timestamp->timestamp    = XI_ISO8601_DECODED_MIDNIGHT + clock;
+    timestamp->micro        = micro;
+
+    return ( int ) n;
+}
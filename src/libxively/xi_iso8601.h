@@ -0,0 +1,57 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_iso8601.h
+ * \brief   Writes and reads the timestamps of the API, `2013-01-01T18:44:21.423452Z`
+ *
+ *    The layout is fixed, so the fields are written and read at their offsets
+ *    without `snprintf` or `sscanf`. The date is converted once a day, the
+ *    timestamps of the same day only differ in their time, which is simple
+ *    arithmetic [see xi_iso8601.c].
+ */
+
+#ifndef __XI_ISO8601_H__
+#define __XI_ISO8601_H__
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! the length of `YYYY-MM-DDThh:mm:ss.uuuuuuZ`, without the terminator
+#define XI_ISO8601_SIZE     27
+
+/**
+ * \brief   Writes the timestamp with the microseconds and the zone and
+ *          terminates it
+ *
+ * \return  `XI_ISO8601_SIZE` or `-1` if it doesn't fit, the microseconds are
+ *          out of their range or the year takes more than four digits.
+ */
+int xi_iso8601_encode(
+      char* buffer
+    , size_t buffer_size
+    , const xi_timestamp_t* timestamp );
+
+/**
+ * \brief   Reads the timestamp at the beginning of the text
+ *
+ *    The year takes up to four digits, the rest of the fields two, the
+ *    fraction of the second and the `Z` may be left out. The digits of the
+ *    fraction past the microseconds are skipped.
+ *
+ * \return  Number of characters read, `-1` if they aren't a timestamp or
+ *          `-2` if the time it gives can't be held by `xi_time_t`.
+ */
+int xi_iso8601_decode(
+      const char* text
+    , size_t text_size
+    , xi_timestamp_t* timestamp );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_ISO8601_H__
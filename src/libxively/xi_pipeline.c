@@ -0,0 +1,88 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_pipeline.c
+ * \brief   Queues the requests that are pipelined over the keep-alive
+ *          connection of a context [see xi_pipeline.h]
+ */
+
+#include <string.h>
+
+#include "xi_pipeline.h"
+#include "xi_allocator.h"
+#include "xi_helpers.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+xi_pipeline_t* xi_pipeline_create( void )
+{
+    xi_pipeline_t* ret = ( xi_pipeline_t* ) xi_alloc( sizeof( xi_pipeline_t ) );
+
+    XI_CHECK_MEMORY( ret );
+
+    memset( ret, 0, sizeof( xi_pipeline_t ) );
+
+    return ret;
+
+err_handling:
+    return 0;
+}
+
+void xi_pipeline_destroy( xi_pipeline_t* pipeline )
+{
+    if( pipeline )
+    {
+        XI_SAFE_FREE( pipeline->data );
+        XI_SAFE_FREE( pipeline->buffer );
+    }
+    XI_SAFE_FREE( pipeline );
+}
+
+int xi_pipeline_submit(
+      xi_pipeline_t* pipeline
+    , const xi_request_t* request
+    , xi_async_decode_t decode
+    , void* output
+    , xi_response_callback_t callback
+    , void* user_data )
+{
+    // PRECONDITIONS
+    assert( pipeline != 0 );
+    assert( request != 0 );
+    assert( callback != 0 );
+
+    XI_CHECK_CND( pipeline->count == XI_PIPELINE_MAX_REQUESTS
+        , XI_PIPELINE_FULL );
+
+    {
+        size_t size = xi_iovec_size( request->segments, request->count );
+
+        // the segments point to the buffers of the transport layer, which
+        // the next request is encoded into, so they're copied right away
+        XI_CHECK_CND( xi_buffer_reserve( &pipeline->data, &pipeline->data_capacity
+            , pipeline->data_size + size, ( size_t ) -1 ) == -1, XI_OUT_OF_MEMORY );
+
+        for( size_t i = 0; i < request->count; ++i )
+        {
+            memcpy( pipeline->data + pipeline->data_size
+                , request->segments[ i ].data, request->segments[ i ].size );
+            pipeline->data_size += request->segments[ i ].size;
+        }
+    }
+
+    {
+        xi_pipeline_entry_t* entry = &pipeline->entries[ pipeline->count++ ];
+
+        entry->decode       = decode;
+        entry->output       = output;
+        entry->callback     = callback;
+        entry->user_data    = user_data;
+    }
+
+    return 0;
+
+err_handling:
+    return -1;
+}
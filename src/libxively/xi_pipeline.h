@@ -0,0 +1,67 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_pipeline.h
+ * \brief   Queues the requests that are pipelined over the keep-alive
+ *          connection of a context [see xi_pipeline_begin()]
+ */
+
+#ifndef __XI_PIPELINE_H__
+#define __XI_PIPELINE_H__
+
+#include "xively.h"
+#include "xi_async.h"
+#include "xi_iovec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   What to do with the response to a queued request
+ */
+typedef struct {
+    xi_async_decode_t       decode;
+    void*                   output;
+    xi_response_callback_t  callback;
+    void*                   user_data;
+} xi_pipeline_entry_t;
+
+/**
+ * \brief   The queued requests, which are kept back to back in `data`
+ *          exactly as they are going to be sent
+ */
+typedef struct xi_pipeline_s {
+    xi_pipeline_entry_t entries[ XI_PIPELINE_MAX_REQUESTS ];
+    size_t              count;
+    char*               data;
+    size_t              data_size;
+    size_t              data_capacity;
+    char*               buffer;         //!< the responses are read into it
+    size_t              buffer_size;
+} xi_pipeline_t;
+
+xi_pipeline_t* xi_pipeline_create( void );
+
+void xi_pipeline_destroy( xi_pipeline_t* pipeline );
+
+/**
+ * \brief   Takes a copy of the encoded request and queues it
+ *
+ * \return  `0` on success or `-1` in case of an error, in which case the
+ *          callback is never called.
+ */
+int xi_pipeline_submit(
+      xi_pipeline_t* pipeline
+    , const xi_request_t* request
+    , xi_async_decode_t decode
+    , void* output
+    , xi_response_callback_t callback
+    , void* user_data );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_PIPELINE_H__
@@ -0,0 +1,202 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_scan.c
+ * \brief   Finds the delimiters of the text in a single pass [see xi_scan.h]
+ *
+ *    With the vector instructions a block of 32 bytes is compared with the
+ *    delimiters and the terminator at once, into a mask with a bit per byte,
+ *    and the delimiters are handed out from the mask, lowest bit first. The
+ *    blocks are aligned, so a block never spans two pages and reading the
+ *    bytes of the block past the end of the text can't fault. The instructions
+ *    are chosen when the library is compiled, e.g. `-mavx2` picks AVX2, and
+ *    `XI_SCAN_SIMD` set to 0 [see xi_config.h] leaves the byte by byte scan.
+ */
+
+#include "xi_scan.h"
+#include "xi_config.h"
+#include "xi_debug.h"
+
+#if XI_SCAN_SIMD && defined( __AVX2__ )
+    #include <immintrin.h>
+    #define XI_SCAN_AVX2
+#elif XI_SCAN_SIMD && defined( __SSE2__ )
+    #include <emmintrin.h>
+    #define XI_SCAN_SSE2
+#elif XI_SCAN_SIMD && defined( __ARM_NEON ) && defined( __aarch64__ )
+    #include <arm_neon.h>
+    #define XI_SCAN_NEON
+#endif
+
+#if defined( XI_SCAN_AVX2 ) || defined( XI_SCAN_SSE2 ) || defined( XI_SCAN_NEON )
+
+#define XI_SCAN_BLOCK_SIZE      32
+
+// the bytes of the block past the end of the text are read on purpose
+#if defined( __SANITIZE_ADDRESS__ )
+    #define XI_SCAN_WHOLE_BLOCK __attribute__(( no_sanitize_address, noinline ))
+#elif defined( __has_feature )
+    #if __has_feature( address_sanitizer )
+        #define XI_SCAN_WHOLE_BLOCK __attribute__(( no_sanitize_address, noinline ))
+    #endif
+#endif
+
+#ifndef XI_SCAN_WHOLE_BLOCK
+    #define XI_SCAN_WHOLE_BLOCK
+#endif
+
+/**
+ * \return  The mask of the bytes of the aligned block which are either of the
+ *          delimiters or the terminator, the first byte in the lowest bit.
+ */
+XI_SCAN_WHOLE_BLOCK
+static uint32_t xi_scan_block( const char* block, char first, char second )
+{
+#if defined( XI_SCAN_AVX2 )
+    const __m256i bytes = _mm256_load_si256( ( const __m256i* ) block );
+    const __m256i found = _mm256_or_si256(
+          _mm256_or_si256(
+              _mm256_cmpeq_epi8( bytes, _mm256_set1_epi8( first ) )
+            , _mm256_cmpeq_epi8( bytes, _mm256_set1_epi8( second ) ) )
+        , _mm256_cmpeq_epi8( bytes, _mm256_setzero_si256() ) );
+
+    return ( uint32_t ) _mm256_movemask_epi8( found );
+#elif defined( XI_SCAN_SSE2 )
+    const __m128i a     = _mm_set1_epi8( first );
+    const __m128i b     = _mm_set1_epi8( second );
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i low   = _mm_load_si128( ( const __m128i* ) block );
+    const __m128i high  = _mm_load_si128( ( const __m128i* ) block + 1 );
+
+    const __m128i found_low = _mm_or_si128(
+          _mm_or_si128( _mm_cmpeq_epi8( low, a ), _mm_cmpeq_epi8( low, b ) )
+        , _mm_cmpeq_epi8( low, zero ) );
+    const __m128i found_high = _mm_or_si128(
+          _mm_or_si128( _mm_cmpeq_epi8( high, a ), _mm_cmpeq_epi8( high, b ) )
+        , _mm_cmpeq_epi8( high, zero ) );
+
+    return ( uint32_t ) _mm_movemask_epi8( found_low )
+        | ( ( uint32_t ) _mm_movemask_epi8( found_high ) << 16 );
+#else
+    // there's no movemask, each byte keeps its own bit of the mask and the
+    // neighbours are added up until a byte holds the bits of eight of them
+    static const uint8_t bits[ 16 ] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+
+    const uint8x16_t weights    = vld1q_u8( bits );
+    const uint8x16_t a          = vdupq_n_u8( ( uint8_t ) first );
+    const uint8x16_t b          = vdupq_n_u8( ( uint8_t ) second );
+    const uint8x16_t low        = vld1q_u8( ( const uint8_t* ) block );
+    const uint8x16_t high       = vld1q_u8( ( const uint8_t* ) block + 16 );
+
+    const uint8x16_t found_low = vorrq_u8(
+          vorrq_u8( vceqq_u8( low, a ), vceqq_u8( low, b ) )
+        , vceqzq_u8( low ) );
+    const uint8x16_t found_high = vorrq_u8(
+          vorrq_u8( vceqq_u8( high, a ), vceqq_u8( high, b ) )
+        , vceqzq_u8( high ) );
+
+    uint8x16_t sum = vpaddq_u8( vandq_u8( found_low, weights ), vandq_u8( found_high, weights ) );
+    sum = vpaddq_u8( sum, sum );
+    sum = vpaddq_u8( sum, sum );
+
+    return vgetq_lane_u32( vreinterpretq_u32_u8( sum ), 0 );
+#endif
+}
+
+void xi_scan_init(
+      xi_scan_t* scan
+    , const char* data
+    , size_t size
+    , char first
+    , char second )
+{
+    // PRECONDITIONS
+    assert( scan != 0 );
+    assert( data != 0 );
+
+    scan->data      = data;
+    scan->size      = size;
+    scan->first     = first;
+    scan->second    = second;
+    scan->block     = ( const char* ) ( ( uintptr_t ) data
+                    & ~( uintptr_t ) ( XI_SCAN_BLOCK_SIZE - 1 ) );
+
+    // what's before the text in its first block isn't handed out
+    scan->mask      = xi_scan_block( scan->block, first, second )
+                    & ( 0xFFFFFFFFu << ( data - scan->block ) );
+}
+
+const char* xi_scan_next( xi_scan_t* scan )
+{
+    // PRECONDITIONS
+    assert( scan != 0 );
+
+    while( scan->mask == 0 )
+    {
+        scan->block += XI_SCAN_BLOCK_SIZE;
+
+        if( ( size_t ) ( scan->block - scan->data ) >= scan->size )
+        {
+            return scan->data + scan->size;
+        }
+
+        scan->mask = xi_scan_block( scan->block, scan->first, scan->second );
+    }
+
+    const char* found = scan->block + __builtin_ctz( scan->mask );
+
+    if( ( size_t ) ( found - scan->data ) >= scan->size )
+    {
+        return scan->data + scan->size;
+    }
+
+    // the terminator stays in the mask, so it's found from then on
+    if( *found != '\0' ) { scan->mask &= scan->mask - 1; }
+
+    return found;
+}
+
+#else // byte by byte
+
+void xi_scan_init(
+      xi_scan_t* scan
+    , const char* data
+    , size_t size
+    , char first
+    , char second )
+{
+    // PRECONDITIONS
+    assert( scan != 0 );
+    assert( data != 0 );
+
+    scan->data      = data;
+    scan->size      = size;
+    scan->first     = first;
+    scan->second    = second;
+    scan->block     = data;
+    scan->mask      = 0;
+}
+
+const char* xi_scan_next( xi_scan_t* scan )
+{
+    // PRECONDITIONS
+    assert( scan != 0 );
+
+    const char* p       = scan->block;
+    const char first    = scan->first;
+    const char second   = scan->second;
+
+    while( ( size_t ) ( p - scan->data ) < scan->size
+        && *p != first && *p != second && *p != '\0' )
+    {
+        ++p;
+    }
+
+    // the terminator and the end aren't passed, so they're found from then on
+    scan->block = ( ( size_t ) ( p - scan->data ) < scan->size && *p != '\0' ) ? p + 1 : p;
+
+    return p;
+}
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_scan.h
+ * \brief   Finds the delimiters of the text in a single pass
+ *
+ *    The parsers split the text on a couple of characters, e.g. the HTTP
+ *    headers on `:` and `\n` and the CSV on `,` and `\n`. The scan compares a
+ *    block of the text with both of them and the terminator at once and hands
+ *    out what it's found one at a time, so every byte is looked at once, no
+ *    matter how many times the parser asks [see xi_scan.c].
+ */
+
+#ifndef __XI_SCAN_H__
+#define __XI_SCAN_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! the size given to the scan of a text which is only terminated
+#define XI_SCAN_TERMINATED      ( ( size_t ) -1 )
+
+/**
+ * \brief   Where the scan is, it's only read and written by the functions below
+ */
+typedef struct {
+    const char* data;       //!< where the scan has begun
+    size_t      size;       //!< how far it may go from there
+    const char* block;      //!< the block the mask is for, or the next byte
+    uint32_t    mask;       //!< the delimiters of the block not handed out yet
+    char        first;      //!< the delimiters
+    char        second;
+} xi_scan_t;
+
+/**
+ * \brief   Begins the scan of the text for either of the two delimiters
+ *
+ * \note    The text is read in whole aligned blocks, which can't cross a page,
+ *          so up to a block past its end or its terminator may be read, but
+ *          nothing past them is handed out.
+ */
+void xi_scan_init(
+      xi_scan_t* scan
+    , const char* data
+    , size_t size
+    , char first
+    , char second );
+
+/**
+ * \brief   Finds the next delimiter
+ *
+ * \return  Pointer to the next of the delimiters, or to the terminator or the
+ *          end of the text, which are returned from then on.
+ */
+const char* xi_scan_next( xi_scan_t* scan );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_SCAN_H__
@@ -0,0 +1,118 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_subscriptions.c
+ * \brief   Keeps the datastreams a context has subscribed to
+ *          [see xi_subscriptions.h]
+ */
+
+#include <string.h>
+
+#include "xi_subscriptions.h"
+#include "xi_allocator.h"
+#include "xi_macros.h"
+#include "xi_debug.h"
+#include "xi_err.h"
+
+xi_subscriptions_t* xi_subscriptions_create( void )
+{
+    xi_subscriptions_t* ret
+        = ( xi_subscriptions_t* ) xi_alloc( sizeof( xi_subscriptions_t ) );
+
+    XI_CHECK_MEMORY( ret );
+
+    memset( ret, 0, sizeof( xi_subscriptions_t ) );
+
+    return ret;
+
+err_handling:
+    return 0;
+}
+
+void xi_subscriptions_destroy( xi_subscriptions_t* subscriptions )
+{
+    XI_SAFE_FREE( subscriptions );
+}
+
+xi_subscription_t* xi_subscriptions_find(
+      xi_subscriptions_t* subscriptions
+    , xi_feed_id_t feed_id
+    , const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( subscriptions != 0 );
+    assert( datastream_id != 0 );
+
+    for( size_t i = 0; i < subscriptions->count; ++i )
+    {
+        xi_subscription_t* subscription = &subscriptions->entries[ i ];
+
+        if( subscription->feed_id == feed_id
+            && strcmp( subscription->datastream_id, datastream_id ) == 0 )
+        {
+            return subscription;
+        }
+    }
+
+    return 0;
+}
+
+int xi_subscriptions_add(
+      xi_subscriptions_t* subscriptions
+    , xi_feed_id_t feed_id
+    , const char* datastream_id
+    , xi_update_callback_t callback
+    , void* user_data )
+{
+    // PRECONDITIONS
+    assert( subscriptions != 0 );
+    assert( datastream_id != 0 );
+    assert( callback != 0 );
+
+    xi_subscription_t* subscription
+        = xi_subscriptions_find( subscriptions, feed_id, datastream_id );
+
+    if( subscription == 0 )
+    {
+        XI_CHECK_CND( subscriptions->count == XI_MAX_SUBSCRIPTIONS
+            , XI_SUBSCRIPTIONS_FULL );
+
+        // the updates of a longer one couldn't be matched anyway
+        XI_CHECK_CND( strlen( datastream_id ) >= XI_MAX_DATASTREAM_NAME
+            , XI_SUBSCRIPTIONS_FULL );
+
+        subscription = &subscriptions->entries[ subscriptions->count++ ];
+
+        subscription->feed_id = feed_id;
+        strcpy( subscription->datastream_id, datastream_id );
+    }
+
+    subscription->callback  = callback;
+    subscription->user_data = user_data;
+
+    return 0;
+
+err_handling:
+    return -1;
+}
+
+void xi_subscriptions_remove(
+      xi_subscriptions_t* subscriptions
+    , xi_feed_id_t feed_id
+    , const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( subscriptions != 0 );
+    assert( datastream_id != 0 );
+
+    xi_subscription_t* subscription
+        = xi_subscriptions_find( subscriptions, feed_id, datastream_id );
+
+    if( subscription == 0 ) { return; }
+
+    // the order doesn't matter, so the last one takes its place
+    *subscription = subscriptions->entries[ --subscriptions->count ];
+
+    if( subscriptions->count == 0 ) { subscriptions->renew = 0; }
+}
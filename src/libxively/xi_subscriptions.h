@@ -0,0 +1,68 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    xi_subscriptions.h
+ * \brief   Keeps the datastreams a context has subscribed to
+ *          [see xi_datastream_subscribe()]
+ */
+
+#ifndef __XI_SUBSCRIPTIONS_H__
+#define __XI_SUBSCRIPTIONS_H__
+
+#include "xively.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Where the updates of a datastream go
+ */
+typedef struct {
+    xi_feed_id_t            feed_id;
+    char                    datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_update_callback_t    callback;
+    void*                   user_data;
+} xi_subscription_t;
+
+typedef struct xi_subscriptions_s {
+    xi_subscription_t   entries[ XI_MAX_SUBSCRIPTIONS ];
+    size_t              count;
+    int                 renew;  //!< the connection they've been made on is lost
+} xi_subscriptions_t;
+
+xi_subscriptions_t* xi_subscriptions_create( void );
+
+void xi_subscriptions_destroy( xi_subscriptions_t* subscriptions );
+
+/**
+ * \return  The subscription to the datastream or `0` if there's none.
+ */
+xi_subscription_t* xi_subscriptions_find(
+      xi_subscriptions_t* subscriptions
+    , xi_feed_id_t feed_id
+    , const char* datastream_id );
+
+/**
+ * \brief   Adds the subscription, the callback of an existing one is replaced
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+int xi_subscriptions_add(
+      xi_subscriptions_t* subscriptions
+    , xi_feed_id_t feed_id
+    , const char* datastream_id
+    , xi_update_callback_t callback
+    , void* user_data );
+
+void xi_subscriptions_remove(
+      xi_subscriptions_t* subscriptions
+    , xi_feed_id_t feed_id
+    , const char* datastream_id );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __XI_SUBSCRIPTIONS_H__
@@ -1,4 +1,7 @@
+#include <time.h>
+
 #include "xi_time.h"
+#include "xi_config.h"
 
 // used by the xi_mktime and xi_gmtime
 #define YEAR0               1900  /* the first year */
@@ -11,16 +14,49 @@
 #define TIME_MAX            ULONG_MAX
 #define ABB_LEN             3
 
-// used by the xi_mktime and xi_gmtime
-static const int _ytab[2][12] = {
-    { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 },
-      { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 } };
+/**
+ * \brief   Counts the days from 1970-01-01 to the date, the month is [1-12]
+ *
+ *    Howard Hinnant, "chrono-Compatible Low-Level Date Algorithms": the years
+ *    are counted from the 1st of March, so the leap day is the last day of
+ *    the year, and grouped into the eras of the calendar, which repeats itself
+ *    every 400 years, so none of it loops over the years or the months.
+ */
+static long days_from_civil( long y, int m, int d )
+{
+    y -= m <= 2;
+
+    const long era  = ( y >= 0 ? y : y - 399 ) / 400;
+    const long yoe  = y - era * 400;                                        /* [0, 399] */
+    const long doy  = ( 153 * ( m > 2 ? m - 3 : m + 9 ) + 2 ) / 5 + d - 1;  /* [0, 365] */
+    const long doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy;                /* [0, 146096] */
+
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * \brief   The inverse of `days_from_civil()`
+ */
+static void civil_from_days( long z, long* y, int* m, int* d )
+{
+    z += 719468;
+
+    const long era  = ( z >= 0 ? z : z - 146096 ) / 146097;
+    const long doe  = z - era * 146097;                                             /* [0, 146096] */
+    const long yoe  = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;      /* [0, 399] */
+    const long doy  = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );                    /* [0, 365] */
+    const long mp   = ( 5 * doy + 2 ) / 153;                                        /* [0, 11] */
+
+    *d = ( int ) ( doy - ( 153 * mp + 2 ) / 5 + 1 );
+    *m = ( int ) ( mp < 10 ? mp + 3 : mp - 9 );
+    *y = yoe + era * 400 + ( *m <= 2 );
+}
 
 xi_time_t xi_mktime(register struct xi_tm *timep)
 {
     register long day, year;
     register int tm_year;
-    int yday, month;
+    int yday;
     register signed long seconds;
     int overflow;
 
@@ -49,56 +85,31 @@ xi_time_t xi_mktime(register struct xi_tm *timep)
          timep->tm_year--;
     }
     day += (timep->tm_mday - 1);
-    while (day < 0) {
-         if(--timep->tm_mon < 0) {
-                 timep->tm_year--;
-                 timep->tm_mon = 11;
-         }
-         day += _ytab[LEAPYEAR(YEAR0 + timep->tm_year)][timep->tm_mon];
-    }
-    while (day >= _ytab[LEAPYEAR(YEAR0 + timep->tm_year)][timep->tm_mon]) {
-         day -= _ytab[LEAPYEAR(YEAR0 + timep->tm_year)][timep->tm_mon];
-         if (++(timep->tm_mon) == 12) {
-                 timep->tm_mon = 0;
-                 timep->tm_year++;
-         }
+
+    /* the days past the month carry into the months and the years at once */
+    day += days_from_civil(YEAR0 + timep->tm_year, timep->tm_mon + 1, 1);
+    {
+        long civil_year;
+        int civil_month, civil_day;
+
+        civil_from_days(day, &civil_year, &civil_month, &civil_day);
+
+        timep->tm_year = (int) (civil_year - YEAR0);
+        timep->tm_mon = civil_month - 1;
+        timep->tm_mday = civil_day;
     }
-    timep->tm_mday = day + 1;
+
     year = EPOCH_YR;
     if (timep->tm_year < year - YEAR0) return (xi_time_t)-1;
     seconds = 0;
-    day = 0;
     overflow = 0;
 
-    /*
-     * Assume that when day becomes negative, there will certainly be overflow on seconds.
-     * The check for overflow needs not to be done for leapyears divisible by 400.
-     * The code only works when year (1970) is not a leapyear.
-     */
-    #if EPOCH_YR != 1970
-    #error EPOCH_YR != 1970
-    #endif
-
     tm_year = timep->tm_year + YEAR0;
 
-    if (LONG_MAX / 365 < tm_year - year) overflow++;
-    day = (tm_year - year) * 365;
-    if (LONG_MAX - day < (tm_year - year) / 4 + 1) overflow++;
-    day += (tm_year - year) / 4
-         + ((tm_year % 4) && tm_year % 4 < year % 4);
-    day -= (tm_year - year) / 100
-         + ((tm_year % 100) && tm_year % 100 < year % 100);
-    day += (tm_year - year) / 400
-         + ((tm_year % 400) && tm_year % 400 < year % 400);
-
-    yday = month = 0;
-    while (month < timep->tm_mon) {
-         yday += _ytab[LEAPYEAR(tm_year)][month];
-         month++;
-    }
-    yday += (timep->tm_mday - 1);
-    if (day + yday < 0) overflow++;
-    day += yday;
+    if (LONG_MAX / 366 < tm_year - year) overflow++;
+
+    /* day is already counted from the epoch */
+    yday = (int) (day - days_from_civil(tm_year, 1, 1));
 
     timep->tm_yday = yday;
     timep->tm_wday = (day + 4) % 7;
@@ -114,38 +125,48 @@ xi_time_t xi_mktime(register struct xi_tm *timep)
     return ( xi_time_t ) seconds;
 }
 
-struct xi_tm* xi_gmtime( register const xi_time_t *timer )
+struct xi_tm* xi_gmtime_r( const xi_time_t *timer, struct xi_tm *timep )
 {
-    static struct xi_tm br_time;
-    register struct xi_tm *timep = &br_time;
-    xi_time_t time = *timer;
-    register unsigned long dayclock, dayno;
-    int year = EPOCH_YR;
+    unsigned long time = (unsigned long)*timer;
+    unsigned long dayclock, dayno;
+    long year;
+    int month, mday;
 
-    dayclock = (unsigned long)time % SECS_DAY;
-    dayno = (unsigned long)time / SECS_DAY;
+    dayclock = time % SECS_DAY;
+    dayno = time / SECS_DAY;
 
     timep->tm_sec = dayclock % 60;
     timep->tm_min = (dayclock % 3600) / 60;
     timep->tm_hour = dayclock / 3600;
     timep->tm_wday = (dayno + 4) % 7;       /* day 0 was a thursday */
 
-    while (dayno >= YEARSIZE(year)) {
-            dayno -= YEARSIZE(year);
-            year++;
-    }
-
-    timep->tm_year = year - YEAR0;
-    timep->tm_yday = dayno;
-    timep->tm_mon = 0;
+    civil_from_days((long)dayno, &year, &month, &mday);
 
-    while (dayno >= _ytab[LEAPYEAR(year)][timep->tm_mon]) {
-            dayno -= _ytab[LEAPYEAR(year)][timep->tm_mon];
-            timep->tm_mon++;
-    }
-
-    timep->tm_mday = dayno + 1;
+    timep->tm_year = (int) (year - YEAR0);
+    timep->tm_yday = (int) ((long)dayno - days_from_civil(year, 1, 1));
+    timep->tm_mon = month - 1;
+    timep->tm_mday = mday;
     timep->tm_isdst = 0;
 
     return timep;
 }
+
+struct xi_tm* xi_gmtime( register const xi_time_t *timer )
+{
+    static XI_THREAD_LOCAL struct xi_tm br_time;
+
+    return xi_gmtime_r( timer, &br_time );
+}
+
+uint64_t xi_get_time_us( void )
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if( clock_gettime( CLOCK_MONOTONIC, &ts ) == 0 )
+    {
+        return ( uint64_t ) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+#endif
+    return ( uint64_t ) time( 0 ) * 1000000;
+}
@@ -11,6 +11,7 @@
 #define __XI_TIME_H__
 
 #include <limits.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,10 +51,28 @@ struct xi_tm {
 xi_time_t xi_mktime( struct xi_tm* t );
 
 /**
- * \brief   This just wraps system's `gmtime()`, it a facade for future use
+ * \brief   Converts from `xi_time_t` to `tm`, in UTC
+ *
+ * \note    The result is kept per thread and overwritten by the next call,
+ *          use `xi_gmtime_r()` to keep it.
  */
 struct xi_tm* xi_gmtime( register const xi_time_t* t );
 
+/**
+ * \brief   Converts from `xi_time_t` to `tm`, in UTC, into the given `tm`
+ *
+ * \return  The given `tm`.
+ */
+struct xi_tm* xi_gmtime_r( const xi_time_t* t, struct xi_tm* tm );
+
+/**
+ * \brief   Reads a clock which never goes back, in microseconds
+ *
+ * \note    The monotonic clock is used where the platform has one, otherwise
+ *          it falls back to `time()`, which is only precise to a second.
+ */
+uint64_t xi_get_time_us( void );
+
 #ifdef __cplusplus
 }
 #endif
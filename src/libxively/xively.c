@@ -13,7 +13,15 @@
 #include "xi_allocator.h"
 #include "xively.h"
 #include "http_transport.h"
+#include "tcp_transport.h"
+#include "ws_transport.h"
 #include "csv_data_layer.h"
+#include "json_data_layer.h"
+#include "cbor_data_layer.h"
+#include "http_layer_parser.h"
+#include "xi_async.h"
+#include "xi_pipeline.h"
+#include "xi_subscriptions.h"
 #include "xi_macros.h"
 #include "xi_debug.h"
 #include "xi_helpers.h"
@@ -40,49 +48,853 @@ const comm_layer_t* get_comm_layer( void );
 // HELPER MACROS
 //-----------------------------------------------------------------------
 
-#define XI_FUNCTION_VARIABLES connection_t* conn = 0;\
-    const comm_layer_t* comm_layer = 0;\
+#define XI_LAYER_VARIABLES const comm_layer_t* comm_layer = 0;\
     const transport_layer_t* transport_layer = 0;\
-    const data_layer_t* data_layer = 0;\
-    char  buffer[ XI_HTTP_MAX_CONTENT_SIZE ];\
+    const data_layer_t* data_layer = 0;
+
+#define XI_FUNCTION_VARIABLES XI_LAYER_VARIABLES\
     const xi_response_t* response = 0;\
-    int sent = 0;\
     int recv = 0;
 
-#define XI_FUNCTION_PROLOGUE  XI_FUNCTION_VARIABLES\
-    xi_debug_logger( "Getting the comm layer..." );\
-    comm_layer = get_comm_layer();\
-    xi_debug_logger( "Getting the transport layer..." );\
-    transport_layer = get_http_transport_layer();\
-    xi_debug_logger( "Getting the data layer...");\
-    data_layer = get_csv_data_layer();\
-
-#define XI_FUNCTION_GET_RESPONSE if( data == 0 ) { goto err_handling; }\
-    xi_debug_logger( "Connecting to the endpoint..." );\
-    conn = comm_layer->open_connection( XI_HOST, XI_PORT );\
-    if( conn == 0 ) { goto err_handling; }\
-    xi_debug_logger( "Sending data:" );\
-    xi_debug_printf( "%s\r\n", data );\
-    sent = comm_layer->send_data( conn, data, strlen( data ) );\
-    if( sent == -1 ) { goto err_handling; }\
-    xi_debug_printf( "Sent: %d\r\n", ( int ) sent );\
-    xi_debug_logger( "Reading data..." );\
-    recv = comm_layer->read_data( conn, buffer, XI_HTTP_MAX_CONTENT_SIZE );\
-    if( recv == -1 ) { goto err_handling; }\
-    xi_debug_printf( "Received: %d\r\n", ( int ) recv );\
-    xi_debug_logger( "Response:" );\
-    xi_debug_printf( "%s\r\n", buffer );\
-    response = transport_layer->decode_reply(\
-        data_layer, buffer );\
-    if( response == 0 ) { goto err_handling; }\
+#define XI_FUNCTION_GET_LAYERS\
+    xi_debug_logger( "Getting the comm layer..." );\
+    comm_layer = get_comm_layer();\
+    xi_debug_logger( "Getting the transport layer..." );\
+    transport_layer = xi_get_transport_layer( xi->protocol );\
+    xi_debug_logger( "Getting the data layer...");\
+    data_layer = xi_get_data_layer( xi );\
+
+#define XI_FUNCTION_BEGIN_STATS if( xi->stats ) { xi_stats_begin( xi ); }
+
+#define XI_FUNCTION_PROLOGUE XI_FUNCTION_VARIABLES XI_FUNCTION_GET_LAYERS\
+    XI_FUNCTION_BEGIN_STATS
+
+#define XI_ASYNC_FUNCTION_PROLOGUE XI_LAYER_VARIABLES XI_FUNCTION_GET_LAYERS
+
+#define XI_ASYNC_FUNCTION_SUBMIT( decode, output ) if( request == 0 ) { return -1; }\
+    if( xi->pipeline ) { return xi_pipeline_submit( xi->pipeline\
+        , request, decode, output, callback, user_data ); }\
+    return xi_async_submit( xi, comm_layer, transport_layer, data_layer\
+        , request, decode, output, callback, user_data );
+
+#define XI_FUNCTION_GET_RESPONSE if( request == 0 ) { goto err_handling; }\
+    recv = xi_send_and_receive( xi, comm_layer, transport_layer, data_layer, request );\
+    if( recv == -1 ) { goto err_handling; }\
+    xi_debug_printf( "Received: %d\r\n", ( int ) recv );\
+    xi_debug_logger( "Response:" );\
+    xi_debug_printf( "%s\r\n", xi->response_buffer );\
+    response = transport_layer->decode_reply(\
+        data_layer, xi->response_buffer );\
+    if( response == 0 ) { goto err_handling; }\
+
+#define XI_FUNCTION_EPILOGUE err_handling:\
+    if( xi->stats ) { xi_stats_end( xi, recv > 0 ); }\
+    xi_release_connection( xi, comm_layer\
+        , response != 0 && http_is_keep_alive( &response->http ) );\
+    return response;\
+
+//-----------------------------------------------------------------------
+// REQUEST STATS
+//-----------------------------------------------------------------------
+
+// they are only called if the context has a record, so that measuring
+// costs nothing when nobody is looking
+
+/**
+ * \brief   Clears the record of the context as the call begins
+ */
+static void xi_stats_begin( xi_context_t* xi )
+{
+    memset( xi->stats, 0, sizeof( xi_request_stats_t ) );
+
+    xi->stats_mark          = xi_get_time_us();
+    xi->stats_first_byte    = 0;
+}
+
+/**
+ * \brief   Adds the time since the mark to the phase, the next phase begins
+ */
+static void xi_stats_phase( xi_context_t* xi, uint32_t* phase )
+{
+    uint64_t now = xi_get_time_us();
+
+    *phase += ( uint32_t ) ( now - xi->stats_mark );
+    xi->stats_mark = now;
+}
+
+/**
+ * \brief   Accounts for acquiring the connection, the address lookup is only
+ *          known for the new ones which have been opened successfully
+ */
+static void xi_stats_connected( xi_context_t* xi, int reused )
+{
+    uint32_t connect = 0;
+
+    xi_stats_phase( xi, &connect );
+
+    if( reused == 1 ) { return; }
+
+    uint32_t dns = xi->conn ? xi->conn->dns_us : 0;
+
+    // both come from the same clock, but it may be a coarse one
+    if( dns > connect ) { dns = connect; }
+
+    xi->stats->dns_us       += dns;
+    xi->stats->connect_us   += connect - dns;
+}
+
+/**
+ * \brief   Splits the time spent reading the reply at its first byte
+ */
+static void xi_stats_received( xi_context_t* xi )
+{
+    uint64_t now    = xi_get_time_us();
+    uint64_t first  = xi->stats_first_byte ? xi->stats_first_byte : now;
+
+    xi->stats->first_byte_us    += ( uint32_t ) ( first - xi->stats_mark );
+    xi->stats->receive_us       += ( uint32_t ) ( now - first );
+    xi->stats_mark = now;
+}
+
+/**
+ * \brief   Completes the record as the call ends, the error is left for
+ *          `xi_get_last_error()` as well
+ */
+static void xi_stats_end( xi_context_t* xi, int parsed )
+{
+    if( parsed ) { xi_stats_phase( xi, &xi->stats->parse_us ); }
+
+    xi->stats->error = xi_get_last_error();
+    xi_set_err( xi->stats->error );
+
+    xi->stats_mark = 0;
+}
+
+//-----------------------------------------------------------------------
+// CONNECTION MANAGEMENT
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Picks the _transport layer_ which speaks the protocol of the context
+ */
+static const transport_layer_t* xi_get_transport_layer( xi_protocol_t protocol )
+{
+    switch( protocol )
+    {
+        case XI_HTTPS:
+            return get_https_transport_layer();
+        case XI_TCP:
+            return get_tcp_transport_layer();
+        case XI_TCPS:
+            return get_tcps_transport_layer();
+        case XI_WS:
+            return get_ws_transport_layer();
+        case XI_WSS:
+            return get_wss_transport_layer();
+        default:
+            return get_http_transport_layer();
+    }
+}
+
+/**
+ * \brief   Picks the _data layer_ which speaks the format of the context
+ */
+static const data_layer_t* xi_get_data_layer( const xi_context_t* xi )
+{
+    // the other protocols carry the data as a CSV string
+    if( xi->protocol != XI_HTTP && xi->protocol != XI_HTTPS )
+    {
+        return get_csv_data_layer();
+    }
+
+    switch( xi->format )
+    {
+        case XI_JSON:
+            return get_json_data_layer();
+        case XI_CBOR:
+            return get_cbor_data_layer();
+        default:
+            return get_csv_data_layer();
+    }
+}
+
+static void xi_drop_connection(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer )
+{
+    if( xi->conn )
+    {
+        comm_layer->close_connection( xi->conn );
+        xi->conn = 0;
+    }
+
+    // whatever has been read from it is of no use now
+    xi->response_size       = 0;
+    xi->response_received   = 0;
+
+    memset( xi->response_frame, 0, sizeof( xi_frame_t ) );
+
+    // the server forgets the subscriptions along with the connection
+    if( xi->subscriptions && xi->subscriptions->count )
+    {
+        xi->subscriptions->renew = 1;
+    }
+}
+
+/**
+ * \brief   The updates come over the connection the subscriptions have been
+ *          made on, so the context keeps it as long as there are any
+ */
+static size_t xi_subscription_count( const xi_context_t* xi )
+{
+    return xi->subscriptions ? xi->subscriptions->count : 0;
+}
+
+/**
+ * \brief   Gives the connection back to the layer or closes it if it
+ *          can't be used for another request
+ */
+static void xi_release_connection(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , int keep_alive )
+{
+    if( xi->conn == 0 ) { return; }
+
+    if( !keep_alive )
+    {
+        xi_debug_logger( "Closing connection..." );
+        xi_drop_connection( xi, comm_layer );
+    }
+    else if( xi_subscription_count( xi ) == 0
+        && comm_layer->checkin_connection( xi->conn ) )
+    {
+        // it's been taken over by the pool
+        xi->conn = 0;
+    }
+}
+
+/**
+ * \brief   Sends all segments of the request, whatever is left after
+ *          a partial write is sent by the next call
+ *
+ * \return  Number of bytes sent or `-1` in case of an error.
+ */
+static int xi_send_request(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const xi_request_t* request )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( comm_layer != 0 );
+    assert( request != 0 );
+
+    xi_iovec_t segments[ XI_REQUEST_MAX_SEGMENTS ];
+    xi_iovec_t* iov = segments;
+    size_t count    = request->count;
+    int sent        = 0;
+
+    memcpy( segments, request->segments, count * sizeof( xi_iovec_t ) );
+
+    xi_debug_logger( "Sending data:" );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        xi_debug_printf( "%.*s", ( int ) iov[ i ].size, iov[ i ].data );
+    }
+
+    while( count )
+    {
+        int s = comm_layer->send_datav
+            ? comm_layer->send_datav( xi->conn, iov, count )
+            : comm_layer->send_data( xi->conn, iov->data, iov->size );
+
+        if( s == -1 ) { return -1; }
+
+        if( xi->stats && xi->stats_mark ) { xi->stats->bytes_sent += s; }
+
+        // nothing has been sent, trying again would not help
+        if( s == 0 )
+        {
+            xi_set_err( XI_SOCKET_WRITE_ERROR );
+            return -1;
+        }
+
+        sent += s;
+
+        size_t done = xi_iovec_consume( iov, count, s );
+
+        iov     += done;
+        count   -= done;
+    }
+
+    return sent;
+}
+
+/**
+ * \brief   Drops the message at the front of the buffer of the context,
+ *          whatever has been read past it moves to the front
+ */
+static void xi_consume_message( xi_context_t* xi )
+{
+    if( xi->response_size == 0 ) { return; }
+
+    size_t left = xi->response_received - xi->response_size;
+
+    if( left )
+    {
+        xi->response_buffer[ xi->response_size ] = xi->response_next;
+        memmove( xi->response_buffer
+            , xi->response_buffer + xi->response_size, left );
+        xi->response_buffer[ left ] = '\0';
+    }
+
+    xi->response_size       = 0;
+    xi->response_received   = left;
+
+    // the next message is looked at from its beginning
+    memset( xi->response_frame, 0, sizeof( xi_frame_t ) );
+}
+
+/**
+ * \brief   Reads the next message into the buffer of the context
+ *
+ *    The reads go on until the length given by the transport layer is
+ *    reached or the server closes the connection, whatever the size of the
+ *    segments the message arrives in. The frame of the context keeps how far
+ *    the transport layer has got, so each segment is looked at once. Anything
+ *    read past its end is kept for the next call, e.g. an update that has
+ *    followed the reply.
+ *
+ * \return  `1` if the message is at the front of the buffer, terminated,
+ *          `0` if the server has closed the connection without sending one
+ *          or `-1` in case of an error.
+ */
+static int xi_read_message(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( comm_layer != 0 );
+    assert( transport_layer != 0 );
+
+    xi_consume_message( xi );
+
+    for( ;; )
+    {
+        long wanted = xi_prepare_read( &xi->response_buffer
+            , &xi->response_buffer_size, 0, xi->response_received
+            , transport_layer->response_size, xi->response_frame );
+
+        if( wanted == -1 )  { return -1; }
+        if( wanted == 0 )   { break; }
+
+        int recv = comm_layer->read_data(
+            xi->conn, xi->response_buffer + xi->response_received, wanted );
+
+        if( recv == -1 )    { return -1; }
+
+        if( recv == 0 )
+        {
+            // closing the connection ends a message without length, the
+            // one that's been cut short would be decoded past its end
+            if( xi->response_received > 0 && transport_layer->response_size(
+                xi->response_frame, xi->response_buffer, xi->response_received ) > 0 )
+            {
+                xi_set_err( XI_SOCKET_READ_ERROR );
+                return -1;
+            }
+
+            xi->response_size = xi->response_received;
+            return xi->response_received > 0;
+        }
+
+        if( xi->stats && xi->stats_mark )
+        {
+            if( xi->stats_first_byte == 0 ) { xi->stats_first_byte = xi_get_time_us(); }
+            xi->stats->bytes_received += recv;
+        }
+
+        xi->response_received += recv;
+        xi->response_buffer[ xi->response_received ] = '\0';
+    }
+
+    xi->response_size = transport_layer->response_size(
+        xi->response_frame, xi->response_buffer, xi->response_received );
+
+    // the byte is put back once the message has been consumed
+    xi->response_next = xi->response_buffer[ xi->response_size ];
+    xi->response_buffer[ xi->response_size ] = '\0';
+
+    return 1;
+}
+
+/**
+ * \brief   Tells whether the next message has been read already
+ */
+static int xi_message_pending(
+      xi_context_t* xi
+    , const transport_layer_t* transport_layer )
+{
+    xi_consume_message( xi );
+
+    if( xi->response_received == 0 ) { return 0; }
+
+    long size = transport_layer->response_size(
+        xi->response_frame, xi->response_buffer, xi->response_received );
+
+    return size > 0 && ( size_t ) size <= xi->response_received;
+}
+
+/**
+ * \brief   Moves whatever has been read past the last message into another
+ *          buffer, which grows as needed
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int xi_take_pending(
+      xi_context_t* xi
+    , char** buffer
+    , size_t* buffer_size
+    , size_t* received )
+{
+    xi_consume_message( xi );
+
+    *received = xi->response_received;
+
+    if( *received == 0 ) { return 0; }
+
+    if( xi_buffer_reserve( buffer, buffer_size
+        , *received + 1, XI_HTTP_MAX_RESPONSE_SIZE + 1 ) == -1 )
+    {
+        xi_set_err( XI_HTTP_RESPONSE_TOO_LARGE );
+        return -1;
+    }
+
+    memcpy( *buffer, xi->response_buffer, *received );
+    ( *buffer )[ *received ] = '\0';
+
+    xi->response_received = 0;
+
+    memset( xi->response_frame, 0, sizeof( xi_frame_t ) );
+
+    return 0;
+}
+
+/**
+ * \brief   Leaves the data for the next message to be read by the context
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int xi_put_pending(
+      xi_context_t* xi
+    , const char* data
+    , size_t size )
+{
+    xi_consume_message( xi );
+
+    if( xi_buffer_reserve( &xi->response_buffer, &xi->response_buffer_size
+        , xi->response_received + size + 1, XI_HTTP_MAX_RESPONSE_SIZE + 1 ) == -1 )
+    {
+        xi_set_err( XI_HTTP_RESPONSE_TOO_LARGE );
+        return -1;
+    }
+
+    memcpy( xi->response_buffer + xi->response_received, data, size );
+    xi->response_received += size;
+    xi->response_buffer[ xi->response_received ] = '\0';
+
+    return 0;
+}
+
+/**
+ * \brief   Passes the message to the callback of the subscription if it
+ *          turns out to be an update, the ping is answered right away
+ *
+ * \return  What the message is, `XI_MESSAGE_CLOSE` also if the ping
+ *          couldn't be answered, the connection is of no use either way.
+ */
+static xi_message_type_t xi_dispatch_update(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , char* message )
+{
+    if( transport_layer->decode_update == 0 ) { return XI_MESSAGE_REPLY; }
+
+    xi_feed_id_t feed_id = 0;
+    char datastream_id[ XI_MAX_DATASTREAM_NAME ];
+    xi_datapoint_t datapoint;
+
+    memset( &datapoint, 0, sizeof( xi_datapoint_t ) );
+
+    xi_message_type_t type = transport_layer->decode_update(
+          data_layer, message, &feed_id
+        , datastream_id, sizeof( datastream_id ), &datapoint );
+
+    if( type == XI_MESSAGE_PING )
+    {
+        const xi_request_t* pong = transport_layer->encode_pong
+            ? transport_layer->encode_pong( message ) : 0;
+
+        xi_debug_logger( "Answering the ping..." );
+
+        if( pong == 0 || xi_send_request( xi, comm_layer, pong ) == -1 )
+        {
+            return XI_MESSAGE_CLOSE;
+        }
+    }
+    else if( type == XI_MESSAGE_UPDATE )
+    {
+        // it may have been unsubscribed from in the meantime
+        const xi_subscription_t* subscription = xi->subscriptions
+            ? xi_subscriptions_find( xi->subscriptions, feed_id, datastream_id )
+            : 0;
+
+        if( subscription )
+        {
+            xi_debug_printf( "Update of %s\r\n", datastream_id );
+            subscription->callback( xi, feed_id, datastream_id
+                , &datapoint, subscription->user_data );
+        }
+    }
+
+    return type;
+}
+
+/**
+ * \brief   Reads the reply to the request that has been sent, the updates
+ *          which arrive before it are passed on to the subscriptions
+ *
+ * \return  `1` if the reply is at the front of the buffer, `0` if the server
+ *          has closed the connection without replying or `-1` in case of an
+ *          error.
+ */
+static int xi_read_response(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer )
+{
+    for( ;; )
+    {
+        int r = xi_read_message( xi, comm_layer, transport_layer );
+
+        if( r != 1 ) { return r; }
+
+        xi_message_type_t type = xi_dispatch_update( xi, comm_layer
+            , transport_layer, data_layer, xi->response_buffer );
+
+        if( type == XI_MESSAGE_REPLY ) { return 1; }
+
+        // the server has closed the connection without replying
+        if( type == XI_MESSAGE_CLOSE ) { return 0; }
+    }
+}
+
+/**
+ * \brief   Sends the handshake the protocol needs over a new connection and
+ *          checks the reply
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int xi_handshake(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer )
+{
+    const xi_request_t* request = transport_layer->encode_handshake( XI_HOST );
+
+    if( request == 0 ) { return -1; }
+
+    if( xi_send_request( xi, comm_layer, request ) == -1 ) { return -1; }
+
+    int r = xi_read_message( xi, comm_layer, transport_layer );
+
+    if( r == 0 ) { xi_set_err( XI_SOCKET_READ_ERROR ); }
+    if( r != 1 ) { return -1; }
+
+    return transport_layer->decode_handshake( request, xi->response_buffer );
+}
+
+/**
+ * \brief   Passes the updates the server has pushed in between the requests
+ *          on to the subscriptions, so the connection can carry the next one
+ *
+ *    Only what's already arrived is read, the message which has begun to
+ *    arrive is waited for until it's complete.
+ *
+ * \return  What probing the connection has found once they've been read,
+ *          `XI_CONNECTION_STALE` if it's been closed in the meantime.
+ */
+static int xi_take_pushed(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer )
+{
+    int state = XI_CONNECTION_PENDING;
+
+    while( state == XI_CONNECTION_PENDING )
+    {
+        xi_debug_logger( "Taking the pushed update..." );
+
+        if( xi_read_message( xi, comm_layer, transport_layer ) != 1
+            || xi_dispatch_update( xi, comm_layer, transport_layer
+                , data_layer, xi->response_buffer ) == XI_MESSAGE_CLOSE )
+        {
+            return XI_CONNECTION_STALE;
+        }
+
+        xi_consume_message( xi );
+
+        state = comm_layer->is_connection_alive( xi->conn );
+    }
+
+    return state;
+}
+
+/**
+ * \brief   Makes sure the context has a connection, the one it keeps is
+ *          probed first and a new one is opened (or checked out of the pool
+ *          of the layer) if needed
+ *
+ * \return  `1` if the connection has carried requests before, `0` if it's
+ *          a new one or `-1` in case of an error.
+ */
+static int xi_acquire_connection(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer )
+{
+    int state = xi->conn
+        ? comm_layer->is_connection_alive( xi->conn ) : XI_CONNECTION_ALIVE;
+
+    // what's arrived is stale unless it's an update the server has pushed
+    if( state == XI_CONNECTION_PENDING && xi_subscription_count( xi ) > 0 )
+    {
+        state = xi_take_pushed( xi, comm_layer, transport_layer, data_layer );
+    }
+
+    if( xi->conn && state != XI_CONNECTION_ALIVE )
+    {
+        xi_drop_connection( xi, comm_layer );
+    }
+
+    if( xi->conn == 0 )
+    {
+        xi_debug_logger( "Connecting to the endpoint..." );
+        xi->conn = xi_open_connection( comm_layer, transport_layer );
+        if( xi->conn == 0 ) { return -1; }
+    }
+
+    // a pooled connection may have been used by another context
+    int reused = xi->conn->requests > 0;
+
+    if( !reused && transport_layer->encode_handshake )
+    {
+        xi_debug_logger( "Handshaking..." );
+
+        if( xi_handshake( xi, comm_layer, transport_layer ) == -1 )
+        {
+            xi_drop_connection( xi, comm_layer );
+            return -1;
+        }
+    }
+
+    if( reused )
+    {
+        xi_debug_logger( "Reusing the keep-alive connection..." );
+        xi->connections_reused += 1;
+    }
+    else
+    {
+        xi->connections_opened += 1;
+
+        if( xi->conn->session_resumed ) { xi->sessions_resumed += 1; }
+    }
+
+    return reused;
+}
+
+/**
+ * \brief   Sends the request and reads the reply using the keep-alive
+ *          connection of the context, a new one is opened (or checked out of
+ *          the pool of the layer) if needed
+ *
+ *    The connection kept by the context is probed before it's reused. If it
+ *    turns out that the server has closed it in the meantime (i.e. sending
+ *    or reading fails), the request is repeated once over a fresh connection.
+ *
+ * \return  Number of bytes read or `-1` in case of an error.
+ */
+static int xi_send_and_receive(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , const xi_request_t* request )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( comm_layer != 0 );
+    assert( request != 0 );
+
+    int attempts = 2;
+
+    while( attempts-- )
+    {
+        if( xi->stats ) { xi->stats_mark = xi_get_time_us(); }
+
+        int reused = xi_acquire_connection( xi, comm_layer
+            , transport_layer, data_layer );
+
+        if( xi->stats ) { xi_stats_connected( xi, reused ); }
+
+        if( reused == -1 ) { return -1; }
+
+        xi->conn->requests += 1;
+
+        int sent = xi_send_request( xi, comm_layer, request );
+        xi_debug_printf( "Sent: %d\r\n", ( int ) sent );
+
+        if( xi->stats )
+        {
+            xi_stats_phase( xi, &xi->stats->send_us );
+            xi->stats_first_byte = 0;
+        }
+
+        if( sent != -1 )
+        {
+            xi_debug_logger( "Reading data..." );
+
+            int r = xi_read_response( xi, comm_layer, transport_layer, data_layer );
+
+            if( xi->stats ) { xi_stats_received( xi ); }
+
+            if( r == 1 ) { return ( int ) xi->response_size; }
+
+            // the peer has closed the connection without replying
+            if( r == 0 ) { xi_set_err( XI_SOCKET_READ_ERROR ); }
+        }
+
+        size_t received = xi->response_received;
+
+        xi_drop_connection( xi, comm_layer );
+
+        // only a reused connection deserves a retry, as it could have
+        // been closed by the server while we were not looking, once
+        // the server has replied there's no point in asking again
+        if( !reused || received > 0 ) { break; }
+
+        xi_debug_logger( "The keep-alive connection has gone, retrying..." );
+        xi_set_err( XI_NO_ERR );
+    }
+
+    return -1;
+}
 
-#define XI_FUNCTION_EPILOGUE xi_debug_logger( "Closing connection..." );\
-err_handling:\
-    if( conn )\
-    {\
-        comm_layer->close_connection( conn );\
-    }\
-    return response;\
+/**
+ * \brief   Reads the responses to the pipelined requests, one after another,
+ *          into the buffer of the pipeline, the updates in between are passed
+ *          on to the subscriptions and dropped
+ *
+ * \return  Number of complete responses, `ends` tells where each of them ends
+ *          and `received` how much has been read in total, including what
+ *          had been read before the call.
+ */
+static size_t xi_pipeline_receive(
+      xi_context_t* xi
+    , const comm_layer_t* comm_layer
+    , const transport_layer_t* transport_layer
+    , const data_layer_t* data_layer
+    , xi_pipeline_t* pipeline
+    , size_t* ends
+    , size_t* received )
+{
+    size_t count = 0;
+    size_t start = 0;
+
+    // how far the response at `start` has been looked at
+    xi_frame_t frame;
+    memset( &frame, 0, sizeof( xi_frame_t ) );
+
+    while( count < pipeline->count )
+    {
+        long wanted = xi_prepare_read( &pipeline->buffer
+            , &pipeline->buffer_size, start, *received
+            , transport_layer->response_size, &frame );
+
+        if( wanted == -1 ) { break; }
+
+        // the bytes past the end belong to the next response
+        if( wanted == 0 )
+        {
+            size_t end = start + transport_layer->response_size(
+                &frame, pipeline->buffer + start, *received - start );
+            char next = pipeline->buffer[ end ];
+
+            memset( &frame, 0, sizeof( xi_frame_t ) );
+
+            pipeline->buffer[ end ] = '\0';
+
+            xi_message_type_t type = xi_dispatch_update( xi, comm_layer
+                , transport_layer, data_layer, pipeline->buffer + start );
+
+            pipeline->buffer[ end ] = next;
+
+            // the responses that are still expected won't come
+            if( type == XI_MESSAGE_CLOSE )
+            {
+                xi_set_err( XI_SOCKET_READ_ERROR );
+                break;
+            }
+
+            if( type == XI_MESSAGE_REPLY )
+            {
+                start = end;
+                ends[ count++ ] = start;
+                continue;
+            }
+
+            memmove( pipeline->buffer + start
+                , pipeline->buffer + end, *received - end );
+            *received -= end - start;
+            pipeline->buffer[ *received ] = '\0';
+            continue;
+        }
+
+        int recv = comm_layer->read_data(
+            xi->conn, pipeline->buffer + *received, wanted );
+
+        if( recv == -1 ) { break; }
+
+        if( recv == 0 )
+        {
+            // closing the connection ends a response without length
+            if( *received > start && transport_layer->response_size(
+                &frame, pipeline->buffer + start, *received - start ) == 0 )
+            {
+                ends[ count++ ] = *received;
+            }
+            else
+            {
+                xi_set_err( XI_SOCKET_READ_ERROR );
+            }
+            break;
+        }
+
+        *received += recv;
+        pipeline->buffer[ *received ] = '\0';
+    }
+
+    return count;
+}
 
 //-----------------------------------------------------------------------
 // HELPER FUNCTIONS
@@ -216,6 +1028,16 @@ uint32_t xi_get_network_timeout( void )
     return xi_globals.network_timeout;
 }
 
+void xi_set_connection_pool(
+      uint32_t max_connections
+    , uint32_t idle_timeout
+    , uint32_t max_requests )
+{
+    xi_globals.connection_pool_size     = max_connections;
+    xi_globals.connection_idle_timeout  = idle_timeout;
+    xi_globals.connection_max_requests  = max_requests;
+}
+
 //-----------------------------------------------------------------------
 // MAIN LIBRARY FUNCTIONS
 //-----------------------------------------------------------------------
@@ -232,6 +1054,32 @@ xi_context_t* xi_create_context(
     // copy given numeric parameters as is
     ret->protocol       = protocol;
     ret->feed_id        = feed_id;
+    ret->format         = XI_CSV;
+
+    // the connection is only opened by the first request
+    ret->conn                   = 0;
+    ret->connections_opened     = 0;
+    ret->connections_reused     = 0;
+    ret->sessions_resumed       = 0;
+
+    // the response buffer grows with the responses
+    ret->response_buffer        = 0;
+    ret->response_buffer_size   = 0;
+    ret->response_size          = 0;
+    ret->response_received      = 0;
+    ret->response_next          = '\0';
+    ret->response_frame         = ( xi_frame_t* ) xi_alloc( sizeof( xi_frame_t ) );
+    ret->pipeline               = 0;
+    ret->subscriptions          = 0;
+
+    XI_CHECK_MEMORY( ret->response_frame );
+
+    memset( ret->response_frame, 0, sizeof( xi_frame_t ) );
+
+    // nothing is measured until the caller asks for it
+    ret->stats                  = 0;
+    ret->stats_mark             = 0;
+    ret->stats_first_byte       = 0;
 
     // copy string parameters carefully
     if( api_key )
@@ -251,6 +1099,7 @@ xi_context_t* xi_create_context(
 err_handling:
     if( ret )
     {
+        XI_SAFE_FREE( ret->response_frame );
         XI_SAFE_FREE( ret );
     }
 
@@ -261,7 +1110,12 @@ void xi_delete_context( xi_context_t* context )
 {
     if( context )
     {
+        xi_drop_connection( context, get_comm_layer() );
         XI_SAFE_FREE( context->api_key );
+        XI_SAFE_FREE( context->response_buffer );
+        XI_SAFE_FREE( context->response_frame );
+        xi_pipeline_destroy( context->pipeline );
+        xi_subscriptions_destroy( context->subscriptions );
     }
     XI_SAFE_FREE( context );
 }
@@ -272,14 +1126,15 @@ const xi_response_t* xi_feed_get(
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_get_feed(
+    const xi_request_t* request = transport_layer->encode_get_feed(
               data_layer
             , xi->api_key
             , feed );
 
     XI_FUNCTION_GET_RESPONSE
 
-    feed = data_layer->decode_feed( response->http.http_content, feed );
+    feed = data_layer->decode_feed( response->http.http_content
+        , response->http.http_content_size, feed );
     if( feed == 0 ) { goto err_handling; }
 
     XI_FUNCTION_EPILOGUE
@@ -291,7 +1146,7 @@ const xi_response_t* xi_feed_update(
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_update_feed(
+    const xi_request_t* request = transport_layer->encode_update_feed(
               data_layer
             , xi->api_key
             , feed );
@@ -307,7 +1162,7 @@ const xi_response_t* xi_datastream_get(
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_get_datastream(
+    const xi_request_t* request = transport_layer->encode_get_datastream(
               data_layer
             , xi->api_key
             , feed_id
@@ -316,13 +1171,49 @@ const xi_response_t* xi_datastream_get(
     XI_FUNCTION_GET_RESPONSE
 
     o = data_layer->decode_datapoint(
-        response->http.http_content, o );
+        response->http.http_content, response->http.http_content_size, o );
 
     if( o == 0 ) { goto err_handling; }
 
     XI_FUNCTION_EPILOGUE
 }
 
+const xi_response_t* xi_datastream_get_history(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id, const xi_timestamp_t* after
+          , xi_datastream_t* datastream, int* truncated )
+{
+    XI_FUNCTION_PROLOGUE
+
+    long total = 0;
+    const xi_request_t* request = 0;
+
+    XI_CHECK_ZERO( transport_layer->encode_get_datastream_history
+        , XI_HISTORY_NOT_SUPPORTED );
+
+    request = transport_layer->encode_get_datastream_history(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id
+            , after
+            , XI_MAX_DATAPOINTS + 1 );
+
+    XI_FUNCTION_GET_RESPONSE
+
+    total = data_layer->decode_datastream_history( response->http.http_content
+        , response->http.http_content_size, datastream );
+
+    if( total == -1 ) { goto err_handling; }
+
+    xi_str_copy_untiln( datastream->datastream_id
+        , sizeof( datastream->datastream_id ), datastream_id, '\0' );
+
+    if( truncated ) { *truncated = total > ( long ) datastream->datapoint_count; }
+
+    XI_FUNCTION_EPILOGUE
+}
+
 
 const xi_response_t* xi_datastream_create(
             xi_context_t* xi, xi_feed_id_t feed_id
@@ -331,7 +1222,7 @@ const xi_response_t* xi_datastream_create(
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_create_datastream(
+    const xi_request_t* request = transport_layer->encode_create_datastream(
               data_layer
             , xi->api_key
             , feed_id
@@ -350,7 +1241,7 @@ const xi_response_t* xi_datastream_update(
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_update_datastream(
+    const xi_request_t* request = transport_layer->encode_update_datastream(
               data_layer
             , xi->api_key
             , feed_id
@@ -367,7 +1258,7 @@ const xi_response_t* xi_datastream_delete(
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_delete_datastream(
+    const xi_request_t* request = transport_layer->encode_delete_datastream(
               data_layer
             , xi->api_key
             , feed_id
@@ -379,13 +1270,13 @@ const xi_response_t* xi_datastream_delete(
 }
 
 const xi_response_t* xi_datapoint_delete(
-          const xi_context_t* xi, xi_feed_id_t feed_id
+          xi_context_t* xi, xi_feed_id_t feed_id
         , const char * datastream_id
         , const xi_datapoint_t* o )
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_delete_datapoint(
+    const xi_request_t* request = transport_layer->encode_delete_datapoint(
               data_layer
             , xi->api_key
             , feed_id
@@ -398,14 +1289,156 @@ const xi_response_t* xi_datapoint_delete(
 }
 
 extern const xi_response_t* xi_datapoint_delete_range(
-            const xi_context_t* xi, xi_feed_id_t feed_id
+            xi_context_t* xi, xi_feed_id_t feed_id
           , const char * datastream_id
           , const xi_timestamp_t* start
           , const xi_timestamp_t* end )
 {
     XI_FUNCTION_PROLOGUE
 
-    const char* data = transport_layer->encode_datapoint_delete_range(
+    const xi_request_t* request = transport_layer->encode_datapoint_delete_range(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id
+            , start
+            , end );
+
+    XI_FUNCTION_GET_RESPONSE
+
+    XI_FUNCTION_EPILOGUE
+}
+
+//-----------------------------------------------------------------------
+// ASYNCHRONOUS FUNCTIONS
+//-----------------------------------------------------------------------
+
+int xi_feed_get_async(
+          xi_context_t* xi
+        , xi_feed_t* feed
+        , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_get_feed(
+              data_layer
+            , xi->api_key
+            , feed );
+
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_FEED, feed )
+}
+
+int xi_feed_update_async(
+          xi_context_t* xi
+        , const xi_feed_t* feed
+        , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_update_feed(
+              data_layer
+            , xi->api_key
+            , feed );
+
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_NONE, 0 )
+}
+
+int xi_datastream_get_async(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id, xi_datapoint_t* o
+          , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_get_datastream(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id );
+
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_DATAPOINT, o )
+}
+
+int xi_datastream_create_async(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id
+          , const xi_datapoint_t* datapoint
+          , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_create_datastream(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id
+            , datapoint );
+
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_NONE, 0 )
+}
+
+int xi_datastream_update_async(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id
+        , const xi_datapoint_t* datapoint
+        , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_update_datastream(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id
+            , datapoint );
+
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_NONE, 0 )
+}
+
+int xi_datastream_delete_async(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id
+          , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_delete_datastream(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id );
+
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_NONE, 0 )
+}
+
+int xi_datapoint_delete_async(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id
+        , const xi_datapoint_t* o
+        , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_delete_datapoint(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id
+            , o );
+
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_NONE, 0 )
+}
+
+int xi_datapoint_delete_range_async(
+            xi_context_t* xi, xi_feed_id_t feed_id
+          , const char * datastream_id
+          , const xi_timestamp_t* start
+          , const xi_timestamp_t* end
+          , xi_response_callback_t callback, void* user_data )
+{
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_datapoint_delete_range(
               data_layer
             , xi->api_key
             , feed_id
@@ -413,11 +1446,328 @@ extern const xi_response_t* xi_datapoint_delete_range(
             , start
             , end );
 
+    XI_ASYNC_FUNCTION_SUBMIT( XI_ASYNC_DECODE_NONE, 0 )
+}
+
+int xi_poll( uint32_t timeout )
+{
+    return xi_async_poll( get_comm_layer(), timeout );
+}
+
+int xi_pipeline_begin( xi_context_t* xi )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+
+    if( xi->pipeline ) { return 0; }
+
+    xi->pipeline = xi_pipeline_create();
+
+    return xi->pipeline ? 0 : -1;
+}
+
+int xi_pipeline_flush( xi_context_t* xi )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+
+    XI_ASYNC_FUNCTION_PROLOGUE
+
+    xi_pipeline_t* pipeline = xi->pipeline;
+
+    size_t ends[ XI_PIPELINE_MAX_REQUESTS ];
+    size_t answered = 0;
+    int keep_alive  = 0;
+    int attempts    = 2;
+
+    if( pipeline == 0 ) { return 0; }
+
+    // the callbacks may start the next batch
+    xi->pipeline = 0;
+
+    if( pipeline->count == 0 )
+    {
+        xi_pipeline_destroy( pipeline );
+        return 0;
+    }
+
+    while( attempts-- )
+    {
+        int reused = xi_acquire_connection( xi, comm_layer
+            , transport_layer, data_layer );
+        if( reused == -1 ) { break; }
+
+        // the other requests follow the first one over the same connection
+        xi->conn->requests          += pipeline->count;
+        xi->connections_reused      += pipeline->count - 1;
+
+        xi_request_t request;
+
+        request.count = 0;
+        xi_request_append( &request, pipeline->data, pipeline->data_size );
+
+        size_t received = 0;
+
+        // an update may have begun to arrive before
+        if( xi_take_pending( xi, &pipeline->buffer
+            , &pipeline->buffer_size, &received ) == -1 )
+        {
+            break;
+        }
+
+        if( xi_send_request( xi, comm_layer, &request ) != -1 )
+        {
+            xi_debug_logger( "Reading the pipelined responses..." );
+            answered = xi_pipeline_receive( xi, comm_layer
+                , transport_layer, data_layer, pipeline, ends, &received );
+        }
+
+        if( answered == pipeline->count )
+        {
+            // the last response tells whether the server keeps the connection
+            size_t begin = answered > 1 ? ends[ answered - 2 ] : 0;
+            char next = pipeline->buffer[ ends[ answered - 1 ] ];
+
+            pipeline->buffer[ ends[ answered - 1 ] ] = '\0';
+            xi_set_err( XI_NO_ERR );
+
+            const xi_response_t* last = transport_layer->decode_reply(
+                data_layer, pipeline->buffer + begin );
+
+            keep_alive = last != 0 && http_is_keep_alive( &last->http );
+
+            pipeline->buffer[ ends[ answered - 1 ] ] = next;
+
+            // anything past the last response is only expected from the
+            // servers which push updates, it's left for the next read
+            if( received > ends[ answered - 1 ] )
+            {
+                keep_alive = keep_alive && transport_layer->decode_update
+                    && xi_put_pending( xi, pipeline->buffer + ends[ answered - 1 ]
+                        , received - ends[ answered - 1 ] ) == 0;
+            }
+            break;
+        }
+
+        xi_drop_connection( xi, comm_layer );
+
+        // same as for a single request, only a reused connection that
+        // has gone before replying deserves a retry
+        if( !reused || received > 0 ) { break; }
+
+        xi_debug_logger( "The keep-alive connection has gone, retrying..." );
+        xi_set_err( XI_NO_ERR );
+    }
+
+    xi_release_connection( xi, comm_layer, keep_alive );
+
+    {
+        // those which haven't been answered share the error
+        xi_err_t err = xi_get_last_error();
+
+        for( size_t i = 0; i < pipeline->count; ++i )
+        {
+            xi_pipeline_entry_t* entry = &pipeline->entries[ i ];
+
+            if( i < answered )
+            {
+                size_t begin = i ? ends[ i - 1 ] : 0;
+                char next = pipeline->buffer[ ends[ i ] ];
+
+                // each response is decoded where it's been read
+                pipeline->buffer[ ends[ i ] ] = '\0';
+
+                const xi_response_t* response = xi_async_decode(
+                      transport_layer, data_layer, pipeline->buffer + begin
+                    , entry->decode, entry->output );
+
+                entry->callback( xi, response, entry->user_data );
+
+                pipeline->buffer[ ends[ i ] ] = next;
+            }
+            else
+            {
+                xi_set_err( err == XI_NO_ERR ? XI_SOCKET_READ_ERROR : err );
+                entry->callback( xi, 0, entry->user_data );
+            }
+        }
+    }
+
+    xi_pipeline_destroy( pipeline );
+
+    return ( int ) answered;
+}
+
+//-----------------------------------------------------------------------
+// SUBSCRIPTIONS
+//-----------------------------------------------------------------------
+
+static const xi_response_t* xi_send_subscription(
+      xi_context_t* xi, xi_feed_id_t feed_id
+    , const char* datastream_id
+    , int subscribe )
+{
+    XI_FUNCTION_PROLOGUE
+
+    const xi_request_t* request = transport_layer->encode_subscribe(
+              data_layer
+            , xi->api_key
+            , feed_id
+            , datastream_id
+            , subscribe );
+
     XI_FUNCTION_GET_RESPONSE
 
     XI_FUNCTION_EPILOGUE
 }
 
+/**
+ * \brief   Makes the subscriptions again over a new connection, the ones made
+ *          over the lost one are gone
+ *
+ * \return  `0` on success or `-1` in case of an error.
+ */
+static int xi_resubscribe( xi_context_t* xi )
+{
+    xi_subscriptions_t* subscriptions = xi->subscriptions;
+
+    xi_debug_logger( "Subscribing again..." );
+
+    for( size_t i = 0; i < subscriptions->count; ++i )
+    {
+        const xi_subscription_t* subscription = &subscriptions->entries[ i ];
+
+        if( xi_send_subscription( xi, subscription->feed_id
+            , subscription->datastream_id, 1 ) == 0 )
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+const xi_response_t* xi_datastream_subscribe(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char* datastream_id
+        , xi_update_callback_t callback, void* user_data )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( datastream_id != 0 );
+    assert( callback != 0 );
+
+    const xi_response_t* response = 0;
+
+    XI_CHECK_ZERO( xi_get_transport_layer( xi->protocol )->encode_subscribe
+        , XI_SUBSCRIPTIONS_NOT_SUPPORTED );
+
+    if( xi->subscriptions == 0 )
+    {
+        xi->subscriptions = xi_subscriptions_create();
+        if( xi->subscriptions == 0 ) { goto err_handling; }
+    }
+
+    // it's there before the reply, as the first update may follow right away
+    if( xi_subscriptions_add( xi->subscriptions
+        , feed_id, datastream_id, callback, user_data ) == -1 )
+    {
+        goto err_handling;
+    }
+
+    response = xi_send_subscription( xi, feed_id, datastream_id, 1 );
+
+    if( response == 0 || response->http.http_status / 100 != 2 )
+    {
+        xi_subscriptions_remove( xi->subscriptions, feed_id, datastream_id );
+    }
+
+    return response;
+
+err_handling:
+    return 0;
+}
+
+const xi_response_t* xi_datastream_unsubscribe(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char* datastream_id )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+    assert( datastream_id != 0 );
+
+    XI_CHECK_ZERO( xi_get_transport_layer( xi->protocol )->encode_subscribe
+        , XI_SUBSCRIPTIONS_NOT_SUPPORTED );
+
+    if( xi->subscriptions )
+    {
+        xi_subscriptions_remove( xi->subscriptions, feed_id, datastream_id );
+    }
+
+    return xi_send_subscription( xi, feed_id, datastream_id, 0 );
+
+err_handling:
+    return 0;
+}
+
+int xi_process_updates( xi_context_t* xi )
+{
+    // PRECONDITIONS
+    assert( xi != 0 );
+
+    XI_LAYER_VARIABLES
+    XI_FUNCTION_GET_LAYERS
+
+    int updates = 0;
+
+    if( xi_subscription_count( xi ) == 0 ) { return 0; }
+
+    if( xi->subscriptions->renew )
+    {
+        // a failure marks them again
+        xi->subscriptions->renew = 0;
+        if( xi_resubscribe( xi ) == -1 ) { return -1; }
+    }
+
+    for( ;; )
+    {
+        // once there's been some, only those which have arrived are taken
+        if( updates > 0 && !xi_message_pending( xi, transport_layer ) )
+        {
+            break;
+        }
+
+        int r = xi_read_message( xi, comm_layer, transport_layer );
+
+        if( r == 1 )
+        {
+            xi_message_type_t type = xi_dispatch_update( xi, comm_layer
+                , transport_layer, data_layer, xi->response_buffer );
+
+            // a stray reply is of no interest here
+            if( type == XI_MESSAGE_UPDATE ) { updates += 1; }
+
+            if( type != XI_MESSAGE_CLOSE ) { continue; }
+
+            // as if the server has closed the connection
+            r = 0;
+        }
+
+        xi_err_t err = xi_get_last_error();
+
+        // nothing has arrived in time, what has is kept for the next call
+        if( r == -1 && err == XI_SOCKET_TIMEOUT_ERROR ) { break; }
+
+        xi_drop_connection( xi, comm_layer );
+
+        if( updates > 0 ) { break; }
+
+        xi_set_err( r == 0 ? XI_SOCKET_READ_ERROR : err );
+        return -1;
+    }
+
+    return updates;
+}
 
 #ifdef __cplusplus
 }
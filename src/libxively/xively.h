@@ -14,6 +14,7 @@
 
 #include "comm_layer.h"
 #include "xi_config.h"
+#include "xi_err.h"
 #include "xi_time.h"
 
 #ifdef __cplusplus
@@ -27,6 +28,8 @@ extern "C" {
 /**
  * \brief    The protocols currently supported by Xively
  * \note     See source code for details of what's implemented.
+ * \note     The secure ones need a _communication layer_ which supports TLS,
+ *           i.e. `posix` built with `XI_TLS=openssl`.
  */
 typedef enum {
     /** `http://api.xively.com` */
@@ -43,8 +46,43 @@ typedef enum {
     XI_WSS,
 } xi_protocol_t;
 
+/**
+ * \brief    The formats the data can be exchanged in
+ * \note     JSON and CBOR are only spoken over HTTP, the other protocols carry
+ *           the data as a CSV string whatever the context asks for.
+ */
+typedef enum {
+    /** `.csv`, a datapoint per line */
+    XI_CSV,
+    /** `.json`, the whole state of a feed fits in a single document */
+    XI_JSON,
+    /** `.cbor`, binary, the timestamps and the values keep their native width */
+    XI_CBOR,
+} xi_format_t;
+
 typedef uint32_t xi_feed_id_t;
 
+/**
+ * \brief   Where the time of a call has gone, the blocking calls fill it in
+ *          if the context points at one
+ *
+ *    The durations are in microseconds, a phase which has not taken place
+ *    (e.g. connecting, when the keep-alive connection has been reused) is `0`.
+ *    If the request has been repeated over a fresh connection, both attempts
+ *    are counted.
+ */
+typedef struct {
+    xi_err_t error; /** The error the call has ended with, `XI_NO_ERR` on success */
+    uint32_t dns_us; /** Resolving the address of the server, if the _communication layer_ tells, otherwise it's part of connecting */
+    uint32_t connect_us; /** Opening the connection, the TLS and protocol handshakes included */
+    uint32_t send_us; /** Sending the request */
+    uint32_t first_byte_us; /** Waiting for the first byte of the reply, once the request has been sent */
+    uint32_t receive_us; /** Reading the rest of the reply */
+    uint32_t parse_us; /** Decoding the reply */
+    size_t bytes_sent; /** Written to the connection, the handshake included */
+    size_t bytes_received; /** Read from the connection, the handshake and the updates included */
+} xi_request_stats_t;
+
 /**
  * \brief   _The context structure_ - it's the first agument for all functions
  *          that communicate with Xively API (_i.e. not helpers or utilities_)
@@ -52,7 +90,23 @@ typedef uint32_t xi_feed_id_t;
 typedef struct {
     char *api_key; /** Xively API key */
     xi_protocol_t protocol; /** Xively protocol */
+    xi_format_t format; /** How the data is encoded, `XI_CSV` unless it's changed */
     xi_feed_id_t feed_id; /** Xively feed ID */
+    connection_t* conn; /** Keep-alive connection reused across calls, managed by the library */
+    size_t connections_opened; /** How many times a new connection had to be opened */
+    size_t connections_reused; /** How many times the keep-alive connection had been reused */
+    size_t sessions_resumed; /** How many of the opened connections have resumed a TLS session, skipping the full handshake */
+    char* response_buffer; /** Holds the last response, it grows up to `XI_HTTP_MAX_RESPONSE_SIZE` */
+    size_t response_buffer_size;
+    size_t response_size; /** Length of the message at the front of the buffer */
+    size_t response_received; /** What has been read into the buffer, it may go past the message */
+    char response_next; /** The byte the message terminator has replaced */
+    struct xi_frame_s* response_frame; /** How far the message at the front of the buffer has been looked at */
+    struct xi_pipeline_s* pipeline; /** Requests queued since `xi_pipeline_begin()`, if any */
+    struct xi_subscriptions_s* subscriptions; /** Datastreams subscribed to, if any */
+    xi_request_stats_t* stats; /** Filled in by each blocking call if set, it's owned by the caller */
+    uint64_t stats_mark; /** When the phase being timed has begun, `0` outside of a call */
+    uint64_t stats_first_byte; /** When the first byte of the reply has been read */
 } xi_context_t;
 
 /**
@@ -78,6 +132,12 @@ typedef enum
     XI_HTTP_HEADER_COUNT,
     /** `Age` */
     XI_HTTP_HEADER_AGE,
+    /** `Transfer-Encoding` */
+    XI_HTTP_HEADER_TRANSFER_ENCODING,
+    /** `Content-Encoding` */
+    XI_HTTP_HEADER_CONTENT_ENCODING,
+    /** `ETag` */
+    XI_HTTP_HEADER_ETAG,
     // must go before the last here
     XI_HTTP_HEADER_UNKNOWN,
     // must be the last here
@@ -109,7 +169,9 @@ typedef struct {
     http_header_t*  http_headers_checklist[ XI_HTTP_HEADERS_COUNT ];
     http_header_t   http_headers[ XI_HTTP_MAX_HEADERS ];
     size_t          http_headers_size;
-    char            http_content[ XI_HTTP_MAX_CONTENT_SIZE ];
+    const char*     http_content;       //!< points into the buffer the response has been read into
+    size_t          http_content_size;
+    int             http_chunked;       //!< the content is still sent in chunks, as the parser has found
 } http_response_t;
 
 /**
@@ -167,6 +229,30 @@ typedef struct {
     xi_datastream_t   datastreams[ XI_MAX_DATASTREAMS ];
 } xi_feed_t;
 
+/**
+ * \brief   Called once a request made with one of the `xi_*_async()`
+ *          functions has finished
+ * \note    The `response` is `0` if the request has failed (see
+ *          `xi_get_last_error()`) and it's only valid during the call.
+ */
+typedef void ( *xi_response_callback_t )(
+      xi_context_t* xi
+    , const xi_response_t* response
+    , void* user_data );
+
+/**
+ * \brief   Called with each update of a datastream the context has
+ *          subscribed to [see xi_datastream_subscribe()]
+ * \note    The `datastream_id` and `datapoint` are only valid during the call
+ *          and no requests may be made on the same context from it.
+ */
+typedef void ( *xi_update_callback_t )(
+      xi_context_t* xi
+    , xi_feed_id_t feed_id
+    , const char* datastream_id
+    , const xi_datapoint_t* datapoint
+    , void* user_data );
+
 //-----------------------------------------------------------------------
 // HELPER FUNCTIONS
 //-----------------------------------------------------------------------
@@ -286,6 +372,23 @@ extern void xi_set_network_timeout( uint32_t milliseconds );
  */
 extern uint32_t xi_get_network_timeout( void );
 
+/**
+ * \brief   Sets the limits for connections shared by all contexts
+ *
+ * \note    Communication layers that pool connections (e.g. POSIX) let
+ *          contexts check connections out for a request and back in once
+ *          it's done, so many contexts talking to the same host can share a
+ *          few sockets. At most `max_connections` sockets are kept open, `0`
+ *          disables pooling and each context keeps its own connection. Any
+ *          connection idle for longer than `idle_timeout` seconds is closed
+ *          and so is one which has served `max_requests` requests (`0` means
+ *          no limit).
+ */
+extern void xi_set_connection_pool(
+          uint32_t max_connections
+        , uint32_t idle_timeout
+        , uint32_t max_requests );
+
 //-----------------------------------------------------------------------
 // MAIN LIBRARY FUNCTIONS
 //-----------------------------------------------------------------------
@@ -296,6 +399,16 @@ extern uint32_t xi_get_network_timeout( void );
  *   The purpose of this function is to allocate memory and initialise the
  *   data structures needed in order to use any other library functions.
  *
+ * \note    Different contexts may be used by different threads at the same
+ *          time, as long as `XI_THREAD_LOCAL` is available [see xi_config.h].
+ *          The response returned by a call is valid until the next call made
+ *          by the same thread. The asynchronous functions are the exception,
+ *          all of them have to be called from the thread calling `xi_poll()`.
+ *
+ * \note    Setting `stats` of the context to a caller owned record makes each
+ *          blocking call fill it in, instead of leaving only the error behind
+ *          [see xi_request_stats_t].
+ *
  * \return  Initialised context structure or `0` if an error occurred
  */
 extern xi_context_t* xi_create_context(
@@ -348,6 +461,22 @@ extern const xi_response_t* xi_datastream_get(
           xi_context_t* xi, xi_feed_id_t feed_id
         , const char * datastream_id, xi_datapoint_t* dp );
 
+/**
+ * \brief   Retrieve the datapoints of a given datastream newer than `after`,
+ *          oldest first, in a single request
+ *
+ *    One more datapoint than `XI_MAX_DATAPOINTS` is asked for, so that it can be
+ *    told whether there are more of them. If `truncated` is set, the history goes
+ *    on past the last datapoint, pass its timestamp as `after` to resume from it.
+ *
+ * \note    It's only supported over HTTP, the other protocols fail with
+ *          `XI_HISTORY_NOT_SUPPORTED`.
+ */
+extern const xi_response_t* xi_datastream_get_history(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id, const xi_timestamp_t* after
+        , xi_datastream_t* datastream, int* truncated );
+
 /**
  * \brief   Delete datastream
  * \warning This function destroys the data in Xively and there is no way to restore it!
@@ -365,7 +494,7 @@ extern const xi_response_t* xi_datastream_delete(
  *          `xi_datapoint_delete_range()` with short range instead.
  */
 extern const xi_response_t* xi_datapoint_delete(
-          const xi_context_t* xi, xi_feed_id_t feed_id
+          xi_context_t* xi, xi_feed_id_t feed_id
         , const char * datastream_id
         , const xi_datapoint_t* dp );
 
@@ -374,9 +503,280 @@ extern const xi_response_t* xi_datapoint_delete(
  * \warning This function destroys the data in Xively and there is no way to restore it!
  */
 extern const xi_response_t* xi_datapoint_delete_range(
-          const xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
+          xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
         , const xi_timestamp_t* start, const xi_timestamp_t* end );
 
+//-----------------------------------------------------------------------
+// ASYNCHRONOUS FUNCTIONS
+//-----------------------------------------------------------------------
+
+/**
+ *    These make the same requests as the functions above, but return as soon
+ *    as the request has been started. The `callback` is called from `xi_poll()`
+ *    once the response has arrived, so a single thread can keep many requests
+ *    in flight with a non-blocking _communication layer_ (e.g. epoll). With a
+ *    blocking one, the requests are simply run one by one by `xi_poll()`.
+ *
+ *    The context and any structure given to be filled in with the response
+ *    (e.g. the feed of `xi_feed_get_async()`) must stay valid until then.
+ *
+ *    They return `0` if the request has been started or `-1` if an error
+ *    occurred, in which case the callback will never be called.
+ *
+ *    The requests in flight are shared by all the contexts of the process,
+ *    so these and `xi_poll()` have to be called from one and the same thread,
+ *    which means they can't be used from the callbacks of a dispatcher.
+ */
+
+/**
+ * \brief   Update Xively feed asynchronously [see xi_feed_update()]
+ */
+extern int xi_feed_update_async(
+          xi_context_t* xi
+        , const xi_feed_t* value
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Retrieve Xively feed asynchronously [see xi_feed_get()]
+ */
+extern int xi_feed_get_async(
+          xi_context_t* xi
+        , xi_feed_t* value
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Create a datastream asynchronously [see xi_datastream_create()]
+ */
+extern int xi_datastream_create_async(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id
+        , const xi_datapoint_t* value
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Update a datastream asynchronously [see xi_datastream_update()]
+ */
+extern int xi_datastream_update_async(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id
+        , const xi_datapoint_t* value
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Retrieve latest datapoint asynchronously [see xi_datastream_get()]
+ */
+extern int xi_datastream_get_async(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id, xi_datapoint_t* dp
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Delete datastream asynchronously [see xi_datastream_delete()]
+ * \warning This function destroys the data in Xively and there is no way to restore it!
+ */
+extern int xi_datastream_delete_async(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char* datastream_id
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Delete datapoint asynchronously [see xi_datapoint_delete()]
+ * \warning This function destroys the data in Xively and there is no way to restore it!
+ */
+extern int xi_datapoint_delete_async(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char * datastream_id
+        , const xi_datapoint_t* dp
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Delete datapoints in given time range asynchronously [see xi_datapoint_delete_range()]
+ * \warning This function destroys the data in Xively and there is no way to restore it!
+ */
+extern int xi_datapoint_delete_range_async(
+          xi_context_t* xi, xi_feed_id_t feed_id, const char * datastream_id
+        , const xi_timestamp_t* start, const xi_timestamp_t* end
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * \brief   Waits up to `timeout` milliseconds for the asynchronous requests
+ *          to make progress and calls the callbacks of those which have finished
+ *
+ * **Example** \code
+  while( xi_poll( 100 ) > 0 ) {
+    // do something else in the meantime
+  } \endcode
+ *
+ * \return  Number of requests still in flight or `-1` if an error occurred
+ */
+extern int xi_poll( uint32_t timeout );
+
+//-----------------------------------------------------------------------
+// PIPELINING
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Starts queueing the requests made with the `xi_*_async()`
+ *          functions on this context instead of running them, until
+ *          `xi_pipeline_flush()` is called
+ * \note    There's room for `XI_PIPELINE_MAX_REQUESTS` requests, queueing
+ *          another one fails with `XI_PIPELINE_FULL`.
+ * \note    Only idempotent requests (i.e. updates, gets and deletes) are
+ *          safe to pipeline, a connection closed by the server half way
+ *          through fails all the requests that haven't been answered yet.
+ *
+ * **Example** \code
+  xi_pipeline_begin( xi );
+  xi_datastream_update_async( xi, feed_id, "temperature", &t, on_update, 0 );
+  xi_datastream_update_async( xi, feed_id, "humidity", &h, on_update, 0 );
+  xi_pipeline_flush( xi ); \endcode
+ *
+ * \return  `0` on success or `-1` if an error occurred
+ */
+extern int xi_pipeline_begin( xi_context_t* xi );
+
+/**
+ * \brief   Writes all the queued requests back-to-back over the keep-alive
+ *          connection and reads the responses in order, calling the callback
+ *          of each request with it's own response
+ * \note    It blocks until all of the responses have arrived, so a burst of
+ *          requests only waits for about a single round trip. The context is
+ *          no longer pipelining afterwards.
+ *
+ * \return  Number of requests that got a response, the callbacks of the
+ *          others have been called with `0`
+ */
+extern int xi_pipeline_flush( xi_context_t* xi );
+
+//-----------------------------------------------------------------------
+// SUBSCRIPTIONS
+//-----------------------------------------------------------------------
+
+/**
+ * \brief   Asks the server to push each new datapoint of the datastream
+ *          over the connection of the context, which it keeps open from now on
+ * \note    Only the `XI_TCP` and `XI_WS` protocols have subscriptions, with
+ *          the others it fails with `XI_SUBSCRIPTIONS_NOT_SUPPORTED`. There's
+ *          room for `XI_MAX_SUBSCRIPTIONS` of them.
+ * \note    The updates are passed to the `callback` by `xi_process_updates()`
+ *          and by any other request that has to wait for them to be read
+ *          before its reply. They're made again over a new connection if the
+ *          old one gets lost.
+ *
+ * **Example** \code
+  xi_datastream_subscribe( xi, feed_id, "temperature", on_update, 0 );
+  while( xi_process_updates( xi ) >= 0 ) {
+    // do something else in the meantime
+  } \endcode
+ *
+ * \return  The reply of the server or `0` if an error occurred
+ */
+extern const xi_response_t* xi_datastream_subscribe(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char* datastream_id
+        , xi_update_callback_t callback, void* user_data );
+
+/**
+ * \brief   Stops the updates of the datastream, the connection goes back to
+ *          the pool after the next request once there are no subscriptions left
+ *
+ * \return  The reply of the server or `0` if an error occurred
+ */
+extern const xi_response_t* xi_datastream_unsubscribe(
+          xi_context_t* xi, xi_feed_id_t feed_id
+        , const char* datastream_id );
+
+/**
+ * \brief   Waits up to the network timeout for updates and passes those that
+ *          have arrived to the callbacks of the subscriptions
+ * \note    The wait is bounded with the `posix` and `epoll` _communication
+ *          layers_ only [see xi_set_network_timeout()].
+ *
+ * \return  Number of updates passed on, `0` if none has arrived in time or
+ *          `-1` if an error occurred (e.g. the connection has been lost)
+ */
+extern int xi_process_updates( xi_context_t* xi );
+
+//-----------------------------------------------------------------------
+// DISPATCHER
+//-----------------------------------------------------------------------
+
+/**
+ *    A dispatcher runs the updates on a pool of worker threads, so a single
+ *    gateway process can keep all the cores busy. Each worker has its own
+ *    context, its own connections and its own queue. A request is queued to
+ *    the worker its feed belongs to, so the requests for a feed keep reusing
+ *    the same connection, while a worker that runs out of requests takes
+ *    them from the back of the queues of the others.
+ *
+ *    The callbacks are called from the worker threads, with the context of
+ *    the worker. A stolen request may finish before the earlier ones for
+ *    the same feed.
+ *
+ * 
+ote    Only available with `XI_DISPATCHER=pthread` builds.
+ */
+
+typedef struct xi_dispatcher_s xi_dispatcher_t;
+
+/**
+ * rief   Starts `worker_count` workers, which make their requests with the
+ *          `protocol` and `api_key` given
+ *
+ * 
+eturn  The dispatcher or `0` if an error occurred
+ */
+extern xi_dispatcher_t* xi_create_dispatcher(
+          xi_protocol_t protocol
+        , const char* api_key
+        , size_t worker_count );
+
+/**
+ * rief   Runs the requests still queued, then stops the workers and frees
+ *          the dispatcher
+ */
+extern void xi_delete_dispatcher( xi_dispatcher_t* dispatcher );
+
+/**
+ * rief   Queues a feed update [see xi_feed_update()], the `feed` is copied
+ * 
+ote    Each worker queues up to `XI_DISPATCHER_QUEUE_SIZE` requests, when
+ *          that of the feed is full it fails with `XI_DISPATCHER_QUEUE_FULL`.
+ *
+ * 
+eturn  `0` if the request has been queued or `-1` if an error occurred,
+ *          in which case the callback will never be called
+ */
+extern int xi_dispatch_feed_update(
+          xi_dispatcher_t* dispatcher
+        , const xi_feed_t* feed
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * rief   Queues a datastream update [see xi_datastream_update()], the
+ *          arguments are copied
+ *
+ * 
+eturn  `0` if the request has been queued or `-1` if an error occurred,
+ *          in which case the callback will never be called
+ */
+extern int xi_dispatch_datastream_update(
+          xi_dispatcher_t* dispatcher, xi_feed_id_t feed_id
+        , const char* datastream_id
+        , const xi_datapoint_t* value
+        , xi_response_callback_t callback, void* user_data );
+
+/**
+ * rief   Blocks until all the requests queued so far have finished
+ */
+extern void xi_dispatcher_wait( xi_dispatcher_t* dispatcher );
+
+/**
+ * rief   Tells how many requests have been run by another worker than the
+ *          one their feed belongs to
+ */
+extern size_t xi_dispatcher_stolen( const xi_dispatcher_t* dispatcher );
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,13 +8,23 @@
 #include "xi_err.h"
 #include "http_layer_parser.h"
 #include "http_layer_queries.h"
+#include "http_transport.h"
+#include "ws_transport_layer.h"
+#include "csv_data_layer.h"
+#include "json_data.h"
+#include "cbor_data.h"
 #include "xi_helpers.h"
+#include "xi_fmt.h"
+#include "xi_iso8601.h"
+#include "xi_time.h"
+#include "xi_scan.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#include <assert.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // HTTP PARSER TESTS
@@ -167,6 +177,43 @@ void test_parse_http_header(void *data)
     memset( &response, 0, sizeof( http_response_t ) );
     xi_set_err( XI_NO_ERR );
 
+    // each of the known ones, whatever the case, and the unknown ones
+    // which hash to the same slots
+    {
+        static const struct { const char* line; http_header_type_t type; } headers[] =
+        {
+              { "Date: 0\r\n",                  XI_HTTP_HEADER_DATE }
+            , { "content-type: 0\r\n",          XI_HTTP_HEADER_CONTENT_TYPE }
+            , { "CONTENT-LENGTH: 0\r\n",        XI_HTTP_HEADER_CONTENT_LENGTH }
+            , { "Connection: 0\r\n",            XI_HTTP_HEADER_CONNECTION }
+            , { "X-Request-Id: 0\r\n",          XI_HTTP_HEADER_X_REQUEST_ID }
+            , { "Cache-Control: 0\r\n",         XI_HTTP_HEADER_CACHE_CONTROL }
+            , { "Vary: 0\r\n",                  XI_HTTP_HEADER_VARY }
+            , { "Count: 0\r\n",                 XI_HTTP_HEADER_COUNT }
+            , { "Age: 0\r\n",                   XI_HTTP_HEADER_AGE }
+            , { "Transfer-Encoding: 0\r\n",     XI_HTTP_HEADER_TRANSFER_ENCODING }
+            , { "Content-Encoding: 0\r\n",      XI_HTTP_HEADER_CONTENT_ENCODING }
+            , { "ETag: 0\r\n",                  XI_HTTP_HEADER_ETAG }
+            , { "Dame: 0\r\n",                  XI_HTTP_HEADER_UNKNOWN }
+            , { "Content-Typo: 0\r\n",          XI_HTTP_HEADER_UNKNOWN }
+            , { "Ag: 0\r\n",                    XI_HTTP_HEADER_UNKNOWN }
+            , { ": 0\r\n",                      XI_HTTP_HEADER_UNKNOWN }
+        };
+
+        size_t i = 0;
+
+        for( ; i < sizeof( headers ) / sizeof( headers[ 0 ] ); ++i )
+        {
+            memset( &response, 0, sizeof( http_response_t ) );
+
+            tt_assert( parse_http_header( &response, headers[ i ].line ) != 0 );
+            tt_assert( response.http_headers[ 0 ].header_type == headers[ i ].type );
+        }
+    }
+
+    memset( &response, 0, sizeof( http_response_t ) );
+    xi_set_err( XI_NO_ERR );
+
     // malformed
     {
         const char test_header1[] =
@@ -260,6 +307,96 @@ void test_parse_http(void* data)
 // HTTP CONSTRUCT TEST
 ///////////////////////////////////////////////////////////////////////////////
 
+static void test_http_parser_on_body( void* user, const char* data, size_t size )
+{
+    char* body = ( char* ) user;
+    strncat( body, data, size );
+}
+
+void test_http_parser(void* data)
+{
+    (void)(data);
+
+    static const char test_response[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/csv\r\n"
+        "Content-Length: 32\r\n"
+        "Connection: keep-alive\r\n\r\n"
+        "2013-01-01T18:44:21.423452Z,217\n"
+        "HTTP/1.1 204 No Content\r\n\r\n";
+
+    const size_t first_size = sizeof( test_response ) - 1 - 27;
+
+    http_response_t response;
+    http_parser_t parser;
+    char body[ 64 ];
+
+    // the same whichever the piece the first response arrives in, one at a
+    // time, and the second response is left for the next parser
+    size_t piece = 1;
+
+    for( ; piece <= sizeof( test_response ) - 1; ++piece )
+    {
+        http_parser_init( &parser, &response );
+        parser.on_body  = &test_http_parser_on_body;
+        parser.user     = body;
+        body[ 0 ]       = '\0';
+
+        size_t offset = 0;
+
+        while( parser.state != XI_HTTP_PARSER_DONE )
+        {
+            size_t size = XI_MIN( piece, sizeof( test_response ) - 1 - offset );
+            long taken  = http_parser_feed( &parser, test_response + offset, size );
+
+            tt_assert( taken >= 0 && ( size_t ) taken <= size );
+            offset += taken;
+        }
+
+        tt_assert( offset == first_size );
+        tt_assert( response.http_status == 200 );
+        tt_assert( response.http_headers_size == 3 );
+        tt_assert( response.http_content_size == 32 );
+        tt_assert( strcmp( body, "2013-01-01T18:44:21.423452Z,217\n" ) == 0 );
+        tt_assert( strcmp( response.http_headers_checklist[ XI_HTTP_HEADER_CONNECTION ]->value, "keep-alive" ) == 0 );
+
+        http_parser_init( &parser, &response );
+        tt_assert( http_parser_feed( &parser, test_response + offset, sizeof( test_response ) - 1 - offset ) == 27 );
+        tt_assert( parser.state == XI_HTTP_PARSER_DONE );
+        tt_assert( response.http_status == 204 );
+    }
+
+    { // the body without length ends with the connection
+        static const char until_close[] = "HTTP/1.0 200 OK\r\n\r\nabc";
+
+        http_parser_init( &parser, &response );
+        tt_assert( http_parser_feed( &parser, until_close, sizeof( until_close ) - 1 ) == sizeof( until_close ) - 1 );
+        tt_assert( parser.state == XI_HTTP_PARSER_BODY );
+        tt_assert( http_parser_finish( &parser ) == 0 );
+    }
+
+    { // the one that's cut short
+        http_parser_init( &parser, &response );
+        tt_assert( http_parser_feed( &parser, test_response, 40 ) == 40 );
+        tt_assert( http_parser_finish( &parser ) == -1 );
+    }
+
+    { // the line too long to be kept
+        char line[ XI_HTTP_PARSER_LINE_SIZE + 8 ];
+        memset( line, 'a', sizeof( line ) );
+
+        http_parser_init( &parser, &response );
+        tt_assert( http_parser_feed( &parser, "HTTP/1.1 200 OK\r\nX-Long: ", 26 ) == 26 );
+        tt_assert( http_parser_feed( &parser, line, sizeof( line ) ) == -1 );
+        tt_assert( xi_get_last_error() == XI_HTTP_HEADER_PARSE_ERROR );
+        tt_assert( http_parser_feed( &parser, "\r\n", 2 ) == -1 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
 void test_http_construct_request(void *data)
 {
     (void)(data);
@@ -274,7 +411,7 @@ void test_http_construct_request(void *data)
             "X-ApiKey: apikey\r\n";
 
         xi_feed_id_t feed_id = 128;
-        const char* ret = http_construct_request_datastream( "GET", &feed_id, "test", "apikey" );
+        const char* ret = http_construct_request_datastream( "GET", &feed_id, "test", "csv", "apikey", 0 );
         tt_assert( strcmp( expected, ret ) == 0 );
     }
 
@@ -288,7 +425,7 @@ void test_http_construct_request(void *data)
             "X-ApiKey: apikey\r\n";
 
         xi_feed_id_t feed_id = 128;
-        const char* ret = http_construct_request_datastream( "GET", &feed_id, 0, "apikey" );
+        const char* ret = http_construct_request_datastream( "GET", &feed_id, 0, "csv", "apikey", 0 );
         tt_assert( strcmp( expected, ret ) == 0 );
     }
 
@@ -307,7 +444,7 @@ void test_http_construct_content(void *data)
             "Content-Type: text/plain\r\n"
             "Content-Length: 128\r\n";
 
-        const char* ret = http_construct_content( 128 );
+        const char* ret = http_construct_content( "text/plain", 128 );
         tt_assert( strcmp( expected, ret ) == 0 );
     }
 
@@ -316,6 +453,60 @@ void test_http_construct_content(void *data)
     ;
 }
 
+void test_http_encode_request_segments(void *data)
+{
+    (void)(data);
+
+    const char expected[] =
+        "PUT /v2/feeds/128/datastreams/test.csv HTTP/1.1\r\n"
+        "Host: " XI_HOST "\r\n"
+        "User-Agent: " XI_USER_AGENT "\r\n"
+        "Accept: */*\r\n"
+        "X-ApiKey: apikey\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 4\r\n"
+        "\r\n"
+        "216\n";
+
+    char buffer[ sizeof( expected ) ];
+    size_t offset = 0;
+
+    xi_datapoint_t dp;
+    xi_set_value_i32( &dp, 216 );
+    dp.timestamp.timestamp = 0;
+
+    const xi_request_t* request = get_http_transport_layer()->encode_update_datastream(
+        get_csv_data_layer(), "apikey", 128, "test", &dp );
+
+    tt_assert( request != 0 );
+
+    // query, content headers, the blank line and the body
+    tt_assert( request->count == 4 );
+    tt_assert( xi_iovec_size( request->segments, request->count ) == sizeof( expected ) - 1 );
+
+    for( size_t i = 0; i < request->count; ++i )
+    {
+        memcpy( buffer + offset, request->segments[ i ].data, request->segments[ i ].size );
+        offset += request->segments[ i ].size;
+    }
+
+    tt_assert( memcmp( buffer, expected, sizeof( expected ) - 1 ) == 0 );
+
+    // a partial write leaves the rest of the segment
+    {
+        xi_iovec_t iov[ 2 ] = { { "abc", 3 }, { "de", 2 } };
+
+        tt_assert( xi_iovec_consume( iov, 2, 2 ) == 0 );
+        tt_assert( iov[ 0 ].size == 1 && *iov[ 0 ].data == 'c' );
+        tt_assert( xi_iovec_consume( iov, 2, 2 ) == 1 );
+        tt_assert( iov[ 1 ].size == 1 && *iov[ 1 ].data == 'e' );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // CSV TESTS
 ///////////////////////////////////////////////////////////////////////////////
@@ -332,7 +523,7 @@ void test_csv_decode_datapoint(void *data)
     const char test_data[] = "2013-01-01T18:44:21.423452Z,216";
 
     // test
-    const xi_datapoint_t* o = csv_decode_datapoint( test_data, &data_point );
+    const xi_datapoint_t* o = csv_decode_datapoint( test_data, strlen( test_data ), &data_point );
 
     // test
     tt_assert( o != 0 );
@@ -360,7 +551,7 @@ void test_csv_decode_datapoint_error( void * data )
         const char test_data[] = "213-01-01T18:44:21.423452Z,216";
 
         // call function
-        const xi_datapoint_t* o = csv_decode_datapoint( test_data, &data_point );
+        const xi_datapoint_t* o = csv_decode_datapoint( test_data, strlen( test_data ), &data_point );
 
         // test values
         tt_assert( o == 0 );
@@ -372,7 +563,7 @@ void test_csv_decode_datapoint_error( void * data )
         const char test_data[] = "2013-01-01T18:44:21,216";
 
         // call function
-        const xi_datapoint_t* o = csv_decode_datapoint( test_data, &data_point );
+        const xi_datapoint_t* o = csv_decode_datapoint( test_data, strlen( test_data ), &data_point );
 
         // test values
         tt_assert( o == 0 );
@@ -386,6 +577,36 @@ void test_csv_decode_datapoint_error( void * data )
     ;
 }
 
+void test_csv_decode_feed( void* data )
+{
+    (void)(data);
+
+    static const char text[] =
+        "temp,2013-01-01T18:44:21.423452Z,21.5\n"
+        "status,2013-01-01T18:44:22.000000Z,on, all well\n"
+        "count,2013-01-01T18:44:23.000000Z,7";
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( feed ) );
+
+    tt_assert( csv_decode_feed( text, sizeof( text ) - 1, &feed ) == &feed );
+    tt_assert( feed.datastream_count == 3 );
+    tt_assert( strcmp( feed.datastreams[ 0 ].datastream_id, "temp" ) == 0 );
+    tt_assert( feed.datastreams[ 0 ].datapoint_count == 1 );
+    tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].timestamp.timestamp == 1357065861 );
+    tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].value.f32_value == 21.5f );
+    tt_assert( strcmp( feed.datastreams[ 1 ].datastream_id, "status" ) == 0 );
+    tt_assert( strcmp( feed.datastreams[ 1 ].datapoints[ 0 ].value.str_value, "on, all well" ) == 0 );
+    tt_assert( strcmp( feed.datastreams[ 2 ].datastream_id, "count" ) == 0 );
+    tt_assert( feed.datastreams[ 2 ].datapoints[ 0 ].value.i32_value == 7 );
+
+    // a line without the id
+    tt_assert( csv_decode_feed( "2013-01-01T18:44:21.423452Z\n", 28, &feed ) == 0 );
+
+ end:
+    ;
+}
+
 void test_csv_encode_create_datastream( void* data )
 {
     (void)(data);
@@ -474,6 +695,15 @@ void test_csv_encode_datapoint( void* data )
         tt_assert( strcmp( o, "216\n" ) == 0 );
     }
 
+    // floats take as many digits as it takes to read them back
+    {
+        xi_set_value_f32( &data_point, 1.5f );
+        const char* o = csv_encode_datapoint( &data_point );
+
+        tt_assert( o != 0 );
+        tt_assert( strcmp( o, "1.5\n" ) == 0 );
+    }
+
     /* Every test-case function needs to finish with an "end:"
        label and (optionally) code to clean up local variables. */
  end:
@@ -481,6 +711,269 @@ void test_csv_encode_datapoint( void* data )
     ;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// JSON TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+void test_json_decode_feed( void* data )
+{
+    (void)(data);
+
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+
+    {
+        // the members that aren't known are skipped, whatever is nested in them
+        const char test_data[] =
+            "{\"id\":128,\"title\":\"test\",\"datastreams\":["
+                "{\"id\":\"temp\",\"current_value\":\"21.5\""
+                    ",\"at\":\"2013-01-01T18:44:21.423452Z\""
+                    ",\"tags\":[\"a\",\"b\"],\"unit\":{\"label\":\"C\"}},"
+                "{\"id\":\"history\",\"current_value\":\"9\",\"datapoints\":["
+                    "{\"at\":\"2013-01-01T18:44:21.000001Z\",\"value\":\"1\"},"
+                    "{\"value\":\"two\",\"at\":\"2013-01-01T18:44:22Z\"}]},"
+                "{\"id\":\"q\\\"s\",\"current_value\":\"a\\tb\\u00e9\"}"
+            "],\"private\":false,\"location\":null}";
+
+        const xi_feed_t* o = json_decode_feed( test_data, strlen( test_data ), &feed );
+
+        tt_assert( o != 0 );
+        tt_assert( feed.datastream_count == 3 );
+
+        tt_want_str_op( feed.datastreams[ 0 ].datastream_id, ==, "temp" );
+        tt_assert( feed.datastreams[ 0 ].datapoint_count == 1 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].value_type == XI_VALUE_TYPE_F32 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].value.f32_value == 21.5f );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].timestamp.timestamp == 1357065861 );
+        tt_assert( feed.datastreams[ 0 ].datapoints[ 0 ].timestamp.micro == 423452 );
+
+        // the history takes precedence over the current value
+        tt_assert( feed.datastreams[ 1 ].datapoint_count == 2 );
+        tt_assert( feed.datastreams[ 1 ].datapoints[ 0 ].value.i32_value == 1 );
+        tt_assert( feed.datastreams[ 1 ].datapoints[ 0 ].timestamp.micro == 1 );
+        tt_want_str_op( feed.datastreams[ 1 ].datapoints[ 1 ].value.str_value, ==, "two" );
+        tt_assert( feed.datastreams[ 1 ].datapoints[ 1 ].timestamp.timestamp == 1357065862 );
+
+        tt_want_str_op( feed.datastreams[ 2 ].datastream_id, ==, "q\"s" );
+        tt_want_str_op( feed.datastreams[ 2 ].datapoints[ 0 ].value.str_value, ==, "a\tb\xc3\xa9" );
+    }
+
+    { // the document ends too early
+        const char test_data[] = "{\"datastreams\":[{\"id\":\"temp\"";
+
+        tt_assert( json_decode_feed( test_data, strlen( test_data ), &feed ) == 0 );
+        tt_assert( XI_JSON_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+    }
+
+    { // a single datapoint
+        xi_datapoint_t datapoint;
+        const char test_data[] =
+            "{\"id\":\"temp\",\"at\":\"2013-01-01T18:44:21.423452Z\",\"current_value\":\"-3\"}";
+
+        tt_assert( json_decode_datapoint( test_data, strlen( test_data ), &datapoint ) != 0 );
+        tt_assert( datapoint.value_type == XI_VALUE_TYPE_I32 );
+        tt_assert( datapoint.value.i32_value == -3 );
+        tt_assert( datapoint.timestamp.micro == 423452 );
+
+        tt_assert( json_decode_datapoint( "{\"id\":\"temp\"}", 13, &datapoint ) == 0 );
+        tt_assert( XI_JSON_DECODE_DATAPOINT_PARSER_ERROR == xi_get_last_error() );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+void test_json_encode_feed( void* data )
+{
+    (void)(data);
+
+    char buffer[ 256 ];
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+
+    feed.datastream_count = 2;
+
+    strcpy( feed.datastreams[ 0 ].datastream_id, "a" );
+    feed.datastreams[ 0 ].datapoint_count = 1;
+    xi_set_value_i32( &feed.datastreams[ 0 ].datapoints[ 0 ], 1 );
+
+    strcpy( feed.datastreams[ 1 ].datastream_id, "b" );
+    feed.datastreams[ 1 ].datapoint_count = 2;
+    xi_set_value_str( &feed.datastreams[ 1 ].datapoints[ 0 ], "x\"y" );
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 1 ], 2 );
+    feed.datastreams[ 1 ].datapoints[ 1 ].timestamp.timestamp = 1357065861;
+    feed.datastreams[ 1 ].datapoints[ 1 ].timestamp.micro = 5;
+
+    {
+        const char expected[] =
+            "{\"version\":\"1.0.0\",\"datastreams\":["
+                "{\"id\":\"a\",\"current_value\":\"1\"},"
+                "{\"id\":\"b\",\"datapoints\":["
+                    "{\"value\":\"x\\\"y\"},"
+                    "{\"value\":\"2\",\"at\":\"2013-01-01T18:44:21.000005Z\"}]}]}";
+
+        int s = json_encode_feed_in_place( buffer, sizeof( buffer ), &feed );
+
+        tt_assert( s == ( int ) sizeof( expected ) - 1 );
+        tt_want_str_op( buffer, ==, expected );
+    }
+
+    { // what's been encoded decodes back
+        xi_feed_t decoded;
+
+        tt_assert( json_decode_feed( buffer, strlen( buffer ), &decoded ) != 0 );
+        tt_assert( decoded.datastream_count == 2 );
+        tt_want_str_op( decoded.datastreams[ 1 ].datapoints[ 0 ].value.str_value, ==, "x\"y" );
+        tt_assert( decoded.datastreams[ 1 ].datapoints[ 1 ].timestamp.timestamp == 1357065861 );
+    }
+
+    {
+        tt_assert( json_encode_feed_in_place( buffer, 32, &feed ) == -1 );
+        tt_assert( XI_JSON_ENCODE_BUFFER_OVERRUN == xi_get_last_error() );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CBOR TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+void test_cbor_encode_decode( void* data )
+{
+    (void)(data);
+
+    char buffer[ 256 ];
+    xi_datapoint_t dp;
+    xi_feed_t feed;
+    memset( &feed, 0, sizeof( xi_feed_t ) );
+
+    { // the timestamp and the value take their native width
+        const char expected[] =
+            "\xa3\x01\x18\xd8\x02\xc1\x1a\x50\xe3\x2e\x85\x03\x1a\x00\x06\x76\x1c";
+
+        xi_set_value_i32( &dp, 216 );
+        dp.timestamp.timestamp = 1357065861;
+        dp.timestamp.micro = 423452;
+
+        int s = cbor_encode_datapoint_in_place( buffer, sizeof( buffer ), &dp );
+
+        tt_assert( s == ( int ) sizeof( expected ) - 1 );
+        tt_assert( memcmp( buffer, expected, s ) == 0 );
+
+        // CSV spends almost twice as much on the same datapoint
+        tt_assert( csv_encode_datapoint_in_place( buffer, sizeof( buffer ), &dp ) > s + s / 2 );
+    }
+
+    feed.datastream_count = 2;
+
+    strcpy( feed.datastreams[ 0 ].datastream_id, "a" );
+    feed.datastreams[ 0 ].datapoint_count = 1;
+    xi_set_value_f32( &feed.datastreams[ 0 ].datapoints[ 0 ], -21.5f );
+
+    strcpy( feed.datastreams[ 1 ].datastream_id, "b" );
+    feed.datastreams[ 1 ].datapoint_count = 3;
+    xi_set_value_str( &feed.datastreams[ 1 ].datapoints[ 0 ], "x\0y" );
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 1 ], INT32_MIN );
+    feed.datastreams[ 1 ].datapoints[ 1 ].timestamp.timestamp = 1357065861;
+    xi_set_value_i32( &feed.datastreams[ 1 ].datapoints[ 2 ], 0 );
+    feed.datastreams[ 1 ].datapoints[ 2 ].timestamp.timestamp = 1357065862;
+    feed.datastreams[ 1 ].datapoints[ 2 ].timestamp.micro = 5;
+
+    { // what's been encoded decodes back, the zeros don't end it
+        xi_feed_t decoded;
+
+        int s = cbor_encode_feed_in_place( buffer, sizeof( buffer ), &feed );
+
+        tt_assert( s > 0 );
+        tt_assert( cbor_decode_feed( buffer, s, &decoded ) != 0 );
+        tt_assert( decoded.datastream_count == 2 );
+
+        tt_want_str_op( decoded.datastreams[ 0 ].datastream_id, ==, "a" );
+        tt_assert( decoded.datastreams[ 0 ].datapoint_count == 1 );
+        tt_assert( decoded.datastreams[ 0 ].datapoints[ 0 ].value_type == XI_VALUE_TYPE_F32 );
+        tt_assert( decoded.datastreams[ 0 ].datapoints[ 0 ].value.f32_value == -21.5f );
+
+        tt_assert( decoded.datastreams[ 1 ].datapoint_count == 3 );
+        tt_want_str_op( decoded.datastreams[ 1 ].datapoints[ 0 ].value.str_value, ==, "x" );
+        tt_assert( decoded.datastreams[ 1 ].datapoints[ 1 ].value.i32_value == INT32_MIN );
+        tt_assert( decoded.datastreams[ 1 ].datapoints[ 1 ].timestamp.timestamp == 1357065861 );
+        tt_assert( decoded.datastreams[ 1 ].datapoints[ 2 ].value_type == XI_VALUE_TYPE_I32 );
+        tt_assert( decoded.datastreams[ 1 ].datapoints[ 2 ].timestamp.micro == 5 );
+
+        // a cut one is rejected wherever it ends
+        for( int i = 0; i < s; ++i )
+        {
+            tt_assert( cbor_decode_feed( buffer, i, &decoded ) == 0 );
+        }
+
+        tt_assert( XI_CBOR_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+
+        tt_assert( cbor_encode_feed_in_place( buffer, 16, &feed ) == -1 );
+        tt_assert( XI_CBOR_ENCODE_BUFFER_OVERRUN == xi_get_last_error() );
+    }
+
+    { // the datastreams key repeated can't give more than fit in the feed
+        xi_feed_t full;
+        char document[ 512 ];
+
+        memset( &full, 0, sizeof( xi_feed_t ) );
+        full.datastream_count = XI_MAX_DATASTREAMS;
+
+        for( int i = 0; i < XI_MAX_DATASTREAMS; ++i )
+        {
+            strcpy( full.datastreams[ i ].datastream_id, "a" );
+        }
+
+        int s = cbor_encode_feed_in_place( buffer, sizeof( buffer ), &full );
+
+        tt_assert( s > 0 );
+        tt_assert( ( unsigned char ) buffer[ 0 ] == 0xa1 );
+        tt_assert( cbor_decode_feed( buffer, s, &full ) != 0 );
+        tt_assert( full.datastream_count == XI_MAX_DATASTREAMS );
+
+        // {5: [...], 5: [...]}
+        document[ 0 ] = ( char ) 0xa2;
+        memcpy( document + 1, buffer + 1, s - 1 );
+        memcpy( document + s, buffer + 1, s - 1 );
+
+        tt_assert( cbor_decode_feed( document, 2 * s - 1, &full ) == 0 );
+        tt_assert( XI_CBOR_DECODE_FEED_PARSER_ERROR == xi_get_last_error() );
+    }
+
+    { // the keys that aren't known are skipped, the floats may be shortened
+        // {"x": [1, {}], 0: "t", 9: 1, 1: 1.5 (half)}
+        const char test_data[] =
+            "\xa4\x61\x78\x82\x01\xa0\x00\x61\x74\x09\x01\x01\xf9\x3e\x00";
+
+        tt_assert( cbor_decode_datapoint( test_data, sizeof( test_data ) - 1, &dp ) != 0 );
+        tt_assert( dp.value_type == XI_VALUE_TYPE_F32 );
+        tt_assert( dp.value.f32_value == 1.5f );
+
+        // {0: "t"} has no value
+        tt_assert( cbor_decode_datapoint( "\xa1\x00\x61\x74", 4, &dp ) == 0 );
+        tt_assert( XI_CBOR_DECODE_DATAPOINT_PARSER_ERROR == xi_get_last_error() );
+    }
+
+    { // the size of what's been returned is measured, it has zeros in it
+        xi_set_value_i32( &dp, 0 );
+        dp.timestamp.timestamp = 0;
+
+        const char* encoded = cbor_encode_create_datastream( "t", &dp );
+
+        tt_assert( encoded != 0 );
+        tt_assert( cbor_encoded_size( encoded ) == 9 );
+        tt_assert( memcmp( encoded, "\xa1\x05\x81\xa2\x00\x61\x74\x01\x00", 9 ) == 0 );
+    }
+
+ end:
+    xi_set_err( XI_NO_ERR );
+    ;
+}
+
 void test_helpers_copy_until( void* data )
 {
     (void)(data);
@@ -572,96 +1065,1644 @@ void test_helpers_decode_value( void* data )
     tt_assert( p.value_type         == XI_VALUE_TYPE_F32 );
     tt_assert( p.value.f32_value     == -.123f );
 
+    // the loose minus or dot leaves a string
+    tt_assert( csv_decode_value( "-.", &p ) == &p );
+    tt_assert( p.value_type         == XI_VALUE_TYPE_STR );
+    tt_assert( strcmp( p.value.str_value, "-." ) == 0 );
+
+    // the float whose digits aren't exact as a double is rounded as by atof
+    csv_decode_value( "0.10000000000000000555111512312", &p );
+    tt_assert( p.value_type         == XI_VALUE_TYPE_F32 );
+    tt_assert( p.value.f32_value     == ( float ) atof( "0.10000000000000000555111512312" ) );
+
+    // the longest value which fits with its terminator
+    tt_assert( csv_decode_value( "0123456789012345678901234567890", &p ) == &p );
+    tt_assert( csv_decode_value( "01234567890123456789012345678901", &p ) == 0 );
+    tt_assert( xi_get_last_error() == XI_DATAPOINT_VALUE_BUFFER_OVERFLOW );
+
  end:
     ;
 }
 
-void test_create_and_delete_context(void* data)
+void test_helpers_format_value( void* data )
 {
-  (void)(data);
+    (void)(data);
 
-#define TEST_API_KEY_STRING "abcXYZ2398138172jckajf39djas_dasd-TyX"
-#define TEST_FEED_ID_NUMBER 123456
+    char buffer[ XI_FMT_F32_MAX_SIZE ];
 
-  xi_context_t* xi_context
-      = xi_create_context( XI_HTTP
-              , TEST_API_KEY_STRING
-              , TEST_FEED_ID_NUMBER );
+    { // the integers, to both of their ends
+        const int32_t values[]      = { 0, 7, -7, 10, 99, 100, -1000, 123456, 2147483647, -2147483647 - 1 };
+        const char* const texts[]   = { "0", "7", "-7", "10", "99", "100", "-1000", "123456", "2147483647", "-2147483648" };
+        size_t i = 0;
 
-  tt_assert( xi_context != 0 );
-  tt_assert( strcmp( xi_context->api_key, TEST_API_KEY_STRING ) == 0 );
-  tt_assert( xi_context->feed_id == TEST_FEED_ID_NUMBER );
+        for( ; i < sizeof( values ) / sizeof( values[ 0 ] ); ++i )
+        {
+            tt_assert( xi_fmt_i32( buffer, sizeof( buffer ), values[ i ] ) == ( int ) strlen( texts[ i ] ) );
+            tt_assert( strcmp( buffer, texts[ i ] ) == 0 );
+        }
+    }
 
-  xi_delete_context( xi_context );
+    { // the floats, the shortest digits which read back the same
+        const float values[]        = { 0.0f, -0.0f, 1.0f, 1.5f, -21.5f, 0.1f, 0.3f, 0.001f, 123.123f
+                                      , 16777216.0f, 1e-7f, 1e-8f, 1e20f, 1e21f, 3.4028235e38f, 1.4e-45f };
+        const char* const texts[]   = { "0.0", "-0.0", "1.0", "1.5", "-21.5", "0.1", "0.3", "0.001", "123.123"
+                                      , "16777216.0", "0.0000001", "1e-8", "100000000000000000000.0", "1e21"
+                                      , "3.4028235e38", "1e-45" };
+        size_t i = 0;
+
+        for( ; i < sizeof( values ) / sizeof( values[ 0 ] ); ++i )
+        {
+            tt_assert( xi_fmt_f32( buffer, sizeof( buffer ), values[ i ] ) == ( int ) strlen( texts[ i ] ) );
+            tt_assert( strcmp( buffer, texts[ i ] ) == 0 );
+            tt_assert( strtof( buffer, 0 ) == values[ i ] );
+        }
+    }
 
-end:
-   xi_set_err( XI_NO_ERR );
-   ;
+    { // what the decoder takes for a float is still written as one
+        xi_datapoint_t p;
+
+        xi_fmt_f32( buffer, sizeof( buffer ), 2.0f );
+        csv_decode_value( buffer, &p );
+        tt_assert( p.value_type         == XI_VALUE_TYPE_F32 );
+        tt_assert( p.value.f32_value    == 2.0f );
+    }
+
+    { // nothing is written past the buffer
+        tt_assert( xi_fmt_i32( buffer, 3, 100 ) == -1 );
+        tt_assert( xi_fmt_i32( buffer, 4, 100 ) == 3 );
+        tt_assert( xi_fmt_f32( buffer, 3, 1.5f ) == -1 );
+        tt_assert( xi_fmt_f32( buffer, 4, 1.5f ) == 3 );
+        tt_assert( xi_fmt_f32( buffer, 3, -1.0f / 0.0f ) == -1 );
+    }
+
+ end:
+    ;
 }
 
-void test_datapoint_value_setters_and_getters(void* data)
+void test_helpers_iso8601( void* data )
 {
-  (void)(data);
+    (void)(data);
 
-  void * ret;
+    char buffer[ XI_ISO8601_SIZE + 1 ];
+    xi_timestamp_t timestamp = { 1357065861, 423452 };
 
-  xi_datapoint_t dp;
+    { // the same day, then the next one, then the same day again
+        tt_assert( xi_iso8601_encode( buffer, sizeof( buffer ), &timestamp ) == XI_ISO8601_SIZE );
+        tt_assert( strcmp( buffer, "2013-01-01T18:44:21.423452Z" ) == 0 );
 
-  ret = xi_set_value_i32( &dp, 320 );
+        timestamp.timestamp += ( 5 * 60 + 15 ) * 60 + 38;
+        timestamp.micro      = 7;
+        tt_assert( xi_iso8601_encode( buffer, sizeof( buffer ), &timestamp ) == XI_ISO8601_SIZE );
+        tt_assert( strcmp( buffer, "2013-01-01T23:59:59.000007Z" ) == 0 );
 
-  tt_assert( ret != 0 );
+        timestamp.timestamp += 1;
+        tt_assert( xi_iso8601_encode( buffer, sizeof( buffer ), &timestamp ) == XI_ISO8601_SIZE );
+        tt_assert( strcmp( buffer, "2013-01-02T00:00:00.000007Z" ) == 0 );
 
-  tt_assert( xi_get_value_i32( &dp ) == 320 );
+        timestamp.timestamp = 1357065861;
+        tt_assert( xi_iso8601_encode( buffer, sizeof( buffer ), &timestamp ) == XI_ISO8601_SIZE );
+        tt_assert( strcmp( buffer, "2013-01-01T18:44:21.000007Z" ) == 0 );
+    }
 
-  tt_assert( xi_get_value_type( &dp ) == XI_VALUE_TYPE_I32 );
+    { // what doesn't fit isn't written
+        tt_assert( xi_iso8601_encode( buffer, XI_ISO8601_SIZE, &timestamp ) == -1 );
 
-  tt_assert( xi_value_pointer_i32( &dp ) != 0 &&
-             xi_value_pointer_f32( &dp ) == 0 &&
-             xi_value_pointer_str( &dp ) == 0 );
+        timestamp.micro = 1000000;
+        tt_assert( xi_iso8601_encode( buffer, sizeof( buffer ), &timestamp ) == -1 );
+    }
 
-  ret = xi_set_value_f32( &dp, (320.0/10) );
+    { // the text is read up to where the timestamp ends
+        const char text[] = "2013-01-01T18:44:21.423452Z,216";
 
-  tt_assert( ret != 0 );
+        tt_assert( xi_iso8601_decode( text, sizeof( text ) - 1, &timestamp ) == XI_ISO8601_SIZE );
+        tt_assert( timestamp.timestamp == 1357065861 );
+        tt_assert( timestamp.micro == 423452 );
+    }
 
-  tt_assert( xi_get_value_f32( &dp ) == (320.0/10) );
+    { // the fraction is scaled to the microseconds, the zone can be left out
+        tt_assert( xi_iso8601_decode( "2013-01-02T00:00:01.5", 21, &timestamp ) == 21 );
+        tt_assert( timestamp.timestamp == 1357084801 );
+        tt_assert( timestamp.micro == 500000 );
 
-  tt_assert( xi_get_value_type( &dp ) == XI_VALUE_TYPE_F32 );
+        tt_assert( xi_iso8601_decode( "2013-01-02T00:00:01.123456789Z", 30, &timestamp ) == 30 );
+        tt_assert( timestamp.micro == 123456 );
 
-  tt_assert( xi_value_pointer_i32( &dp ) == 0 &&
-             xi_value_pointer_f32( &dp ) != 0 &&
-             xi_value_pointer_str( &dp ) == 0 );
+        tt_assert( xi_iso8601_decode( "2013-01-02T00:00:01Z", 20, &timestamp ) == 20 );
+        tt_assert( timestamp.micro == 0 );
+    }
 
-  ret = xi_set_value_str( &dp, "Let's test everything!" );
+    { // what isn't a timestamp or can't be held
+        tt_assert( xi_iso8601_decode( "2013-01-01T18:44", 16, &timestamp ) == -1 );
+        tt_assert( xi_iso8601_decode( "2013-01-01 18:44:21Z", 20, &timestamp ) == -1 );
+        tt_assert( xi_iso8601_decode( "2013-01-01T18:44:21.Z", 21, &timestamp ) == -1 );
+        tt_assert( xi_iso8601_decode( "1969-12-31T23:59:59Z", 20, &timestamp ) == -2 );
+    }
 
-  tt_assert( ret != 0 );
+ end:
+    ;
+}
 
-  char s[XI_VALUE_STRING_MAX_SIZE+100];
-  for (size_t i = 0; i < sizeof(s); i++) {
-    s[i] = 'a';
-  }
+void test_helpers_time( void* data )
+{
+    (void)(data);
 
-  ret = xi_set_value_str( &dp, s );
+    struct xi_tm tm;
 
-  tt_assert( ret != 0 )
+    { // the leap days, of the years divisible by 4 and by 400, and not by 100
+        const xi_time_t leap_day = 1330473600; // 2012-02-29
+        tt_assert( xi_gmtime_r( &leap_day, &tm ) == &tm );
+        tt_assert( tm.tm_year == 112 && tm.tm_mon == 1 && tm.tm_mday == 29 );
+        tt_assert( tm.tm_yday == 59 && tm.tm_wday == 3 );
 
-  tt_assert( xi_get_value_type( &dp ) == XI_VALUE_TYPE_STR );
+        const xi_time_t end_of_2000 = 978307199; // 2000-12-31T23:59:59
+        xi_gmtime_r( &end_of_2000, &tm );
+        tt_assert( tm.tm_year == 100 && tm.tm_mon == 11 && tm.tm_mday == 31 );
+        tt_assert( tm.tm_yday == 365 && tm.tm_hour == 23 && tm.tm_sec == 59 );
 
-  tt_assert( xi_value_pointer_i32( &dp ) == 0 &&
-             xi_value_pointer_f32( &dp ) == 0 &&
-             xi_value_pointer_str( &dp ) != 0 );
+        const xi_time_t march_2100 = ( xi_time_t ) 4107542400UL; // 2100-03-01
+        xi_gmtime_r( &march_2100, &tm );
+        tt_assert( tm.tm_year == 200 && tm.tm_mon == 2 && tm.tm_mday == 1 );
+        tt_assert( tm.tm_yday == 59 );
+    }
 
-  char * x = xi_value_pointer_str( &dp );
+    { // the fields past their ranges carry over
+        memset( &tm, 0, sizeof( tm ) );
+        tm.tm_year  = 112;
+        tm.tm_mon   = 13;   // February of the next year
+        tm.tm_mday  = 0;    // the last day of January
+        tm.tm_hour  = 25;
 
-  tt_assert( strlen(s) > strlen(x) );
-  tt_assert( strlen(x) == XI_VALUE_STRING_MAX_SIZE-1 );
+        tt_assert( xi_mktime( &tm ) == 1359680400 ); // 2013-02-01T01:00:00
+        tt_assert( tm.tm_year == 113 && tm.tm_mon == 1 && tm.tm_mday == 1 );
+        tt_assert( tm.tm_hour == 1 && tm.tm_yday == 31 && tm.tm_wday == 5 );
+    }
 
-  s[XI_VALUE_STRING_MAX_SIZE-5] = '\0';
+    { // before the epoch
+        memset( &tm, 0, sizeof( tm ) );
+        tm.tm_year  = 69;
+        tm.tm_mon   = 11;
+        tm.tm_mday  = 31;
 
-  ret = xi_set_value_str( &dp, s );
+        tt_assert( xi_mktime( &tm ) == ( xi_time_t ) -1 );
+    }
 
-  tt_assert( ret != 0 );
+ end:
+    ;
+}
 
-  tt_assert( strlen(s) == strlen(x) );
+void test_helpers_scan( void* data )
+{
+    (void)(data);
+
+    // a block and a half of text at every offset of the block, so the
+    // delimiters, the terminator and the end fall on each of its bytes
+    static const char text[] = "Host: api.xively.com\r\nX-Request-Id: a:b:c\r\n\r\n{}";
+    char buffer[ 2 * 32 + sizeof( text ) ];
+
+    size_t offset = 0;
+
+    for( ; offset < 32; ++offset )
+    {
+        char* copy = buffer + offset;
+        memcpy( copy, text, sizeof( text ) );
+
+        size_t size = 0;
+
+        for( ; size <= sizeof( text ); ++size )
+        {
+            xi_scan_t scan;
+            xi_scan_init( &scan, copy, size, ':', '\n' );
+
+            size_t i = 0;
+
+            for( ; i < size && text[ i ] != '\0'; ++i )
+            {
+                if( text[ i ] == ':' || text[ i ] == '\n' )
+                {
+                    tt_assert( xi_scan_next( &scan ) == copy + i );
+                }
+            }
+
+            // the end or the terminator stays where it is
+            tt_assert( xi_scan_next( &scan ) == copy + i );
+            tt_assert( xi_scan_next( &scan ) == copy + i );
+        }
+    }
+
+    { // both delimiters the same
+        xi_scan_t scan;
+        xi_scan_init( &scan, text, XI_SCAN_TERMINATED, ' ', ' ' );
+        tt_assert( xi_scan_next( &scan ) == text + 5 );
+        tt_assert( xi_scan_next( &scan ) == strchr( text + 6, ' ' ) );
+        tt_assert( xi_scan_next( &scan ) == text + sizeof( text ) - 1 );
+    }
+
+ end:
+    ;
+}
+
+void test_create_and_delete_context(void* data)
+{
+  (void)(data);
+
+#define TEST_API_KEY_STRING "abcXYZ2398138172jckajf39djas_dasd-TyX"
+#define TEST_FEED_ID_NUMBER 123456
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP
+              , TEST_API_KEY_STRING
+              , TEST_FEED_ID_NUMBER );
+
+  tt_assert( xi_context != 0 );
+  tt_assert( strcmp( xi_context->api_key, TEST_API_KEY_STRING ) == 0 );
+  tt_assert( xi_context->feed_id == TEST_FEED_ID_NUMBER );
+
+  xi_delete_context( xi_context );
+
+end:
+   xi_set_err( XI_NO_ERR );
+   ;
+}
+
+// decl
+void dummy_comm_push( const char* data );
+void dummy_comm_set_reply( const char* reply );
+void dummy_comm_set_replies( const char* const* replies );
+void dummy_comm_set_responder(
+    const char* ( *responder )( const char* request, size_t size ) );
+void dummy_comm_set_binary_reply( const char* reply, size_t size );
+const char* dummy_comm_last_request( void );
+size_t dummy_comm_last_request_size( void );
+
+void test_keep_alive_connection_reuse(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+  tt_assert( xi_context->conn == 0 );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 0\r\n\r\n" );
+
+  // the first request opens the connection
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_status == 200 );
+  tt_assert( xi_context->conn != 0 );
+  tt_assert( xi_context->connections_opened == 1 );
+  tt_assert( xi_context->connections_reused == 0 );
+
+  // the second one goes over the same connection
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_context->connections_opened == 1 );
+  tt_assert( xi_context->connections_reused == 1 );
+
+  // server asks to close the connection
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Connection: close\r\n"
+      "Content-Length: 0\r\n\r\n" );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_context->conn == 0 );
+  tt_assert( xi_context->connections_reused == 2 );
+
+  // so the next request has to reconnect
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_context->connections_opened == 2 );
+
+  // HTTP/1.0 doesn't keep the connection unless asked to
+  dummy_comm_set_reply(
+      "HTTP/1.0 200 OK\r\n"
+      "Content-Length: 0\r\n\r\n" );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_context->conn == 0 );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_read_whole_response(void* data)
+{
+  (void)(data);
+
+  static char reply[ 2 * XI_HTTP_MAX_CONTENT_SIZE ];
+  xi_datapoint_t dp;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+
+  // a body that doesn't fit into a single read
+  int header_size = sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n"
+      , ( int ) sizeof( reply ) / 2 );
+
+  memset( reply + header_size, 'x', sizeof( reply ) / 2 );
+  strcpy( reply + header_size + sizeof( reply ) / 2, "trailing" );
+
+  dummy_comm_set_reply( reply );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_status == 200 );
+
+  // nothing that follows the response is read
+  tt_assert( response->http.http_content_size == sizeof( reply ) / 2 );
+  tt_assert( response->http.http_content[ sizeof( reply ) / 2 - 1 ] == 'x' );
+
+  // but nothing larger than the limit is accepted
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: " XI_STR( XI_HTTP_MAX_RESPONSE_SIZE ) "\r\n\r\n" );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response == 0 );
+  tt_assert( xi_get_last_error() == XI_HTTP_RESPONSE_TOO_LARGE );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_request_stats(void* data)
+{
+  (void)(data);
+
+  static const char reply[] =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 3\r\n\r\n"
+      "abc";
+
+  xi_datapoint_t dp;
+  xi_request_stats_t stats;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+  tt_assert( xi_context->stats == 0 );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+
+  dummy_comm_set_reply( reply );
+
+  memset( &stats, 0xff, sizeof( stats ) );
+  xi_context->stats = &stats;
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( stats.error == XI_NO_ERR );
+  tt_assert( stats.bytes_sent == dummy_comm_last_request_size() );
+  tt_assert( stats.bytes_received == sizeof( reply ) - 1 );
+
+  // the keep-alive connection costs nothing to acquire
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_context->connections_reused == 1 );
+  tt_assert( stats.dns_us == 0 );
+  tt_assert( stats.connect_us == 0 );
+
+  // the error stays in the record and is still reported the old way
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: " XI_STR( XI_HTTP_MAX_RESPONSE_SIZE ) "\r\n\r\n" );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response == 0 );
+  tt_assert( stats.error == XI_HTTP_RESPONSE_TOO_LARGE );
+  tt_assert( stats.parse_us == 0 );
+  tt_assert( xi_get_last_error() == XI_HTTP_RESPONSE_TOO_LARGE );
+
+  // nothing is touched once the record has been taken away
+  xi_context->stats = 0;
+  dummy_comm_set_reply( reply );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( stats.error == XI_HTTP_RESPONSE_TOO_LARGE );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_json_format(void* data)
+{
+  (void)(data);
+
+  xi_feed_t feed;
+  xi_datapoint_t dp;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+  tt_assert( xi_context->format == XI_CSV );
+
+  xi_context->format = XI_JSON;
+
+  memset( &feed, 0, sizeof( xi_feed_t ) );
+  feed.feed_id = 128;
+
+  // the whole feed comes in one reply, with the history of the datastreams
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 129\r\n\r\n"
+      "{\"id\":128,\"datastreams\":["
+      "{\"id\":\"a\",\"current_value\":\"1\"},"
+      "{\"id\":\"b\",\"datapoints\":[{\"value\":\"2\"},{\"value\":\"3\"}]}"
+      "],\"version\":\"1.0.0\"}" );
+
+  response = xi_feed_get( xi_context, &feed );
+
+  tt_assert( response != 0 );
+  tt_assert( strncmp( dummy_comm_last_request()
+      , "GET /v2/feeds/128.json HTTP/1.1\r\n", 33 ) == 0 );
+  tt_assert( feed.datastream_count == 2 );
+  tt_assert( feed.datastreams[ 1 ].datapoint_count == 2 );
+  tt_assert( feed.datastreams[ 1 ].datapoints[ 1 ].value.i32_value == 3 );
+
+  // the bodies that are sent are JSON as well
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 0\r\n\r\n" );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( strstr( dummy_comm_last_request()
+      , "PUT /v2/feeds/128/datastreams/test.json HTTP/1.1\r\n" ) != 0 );
+  tt_assert( strstr( dummy_comm_last_request()
+      , "Content-Type: application/json\r\n" ) != 0 );
+  tt_assert( strstr( dummy_comm_last_request()
+      , "\r\n\r\n{\"current_value\":\"216\"}" ) != 0 );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_cbor_format(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  xi_context->format = XI_CBOR;
+
+  // the body is cut at the length the header gives, not at the first zero
+  // {0: "a", 1: 0, 2: 1(1357065861)}
+  const char reply[] =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 13\r\n\r\n"
+      "\xa3\x00\x61\x61\x01\x00\x02\xc1\x1a\x50\xe3\x2e\x85";
+
+  dummy_comm_set_binary_reply( reply, sizeof( reply ) - 1 );
+
+  response = xi_datastream_get( xi_context, 128, "a", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( strncmp( dummy_comm_last_request()
+      , "GET /v2/feeds/128/datastreams/a.cbor HTTP/1.1\r\n", 47 ) == 0 );
+  tt_assert( response->http.http_content_size == 13 );
+  tt_assert( dp.value_type == XI_VALUE_TYPE_I32 );
+  tt_assert( dp.value.i32_value == 0 );
+  tt_assert( dp.timestamp.timestamp == 1357065861 );
+
+  // the bodies that are sent are measured, not terminated
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 0\r\n\r\n" );
+
+  xi_set_value_i32( &dp, 0 );
+  dp.timestamp.timestamp = 0;
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+
+  {
+      const char* request = dummy_comm_last_request();
+      const size_t size   = dummy_comm_last_request_size();
+
+      tt_assert( strstr( request, "Content-Type: application/cbor\r\n" ) != 0 );
+      tt_assert( strstr( request, "Content-Length: 3\r\n" ) != 0 );
+      tt_assert( size > 3 && memcmp( request + size - 3, "\xa1\x01\x00", 3 ) == 0 );
+  }
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_datastream_history(void* data)
+{
+  (void)(data);
+
+  xi_datastream_t datastream;
+  xi_timestamp_t after = { 1357065861, 999999 };
+  int truncated = 0;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  // one more line than fits, the history goes on
+  static char reply[ 2048 ];
+  char expected[ 128 ];
+  int offset = sprintf( reply, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n"
+      , ( XI_MAX_DATAPOINTS + 1 ) * 32 );
+
+  for( int i = 0; i <= XI_MAX_DATAPOINTS; ++i )
+  {
+      offset += sprintf( reply + offset, "2013-01-01T18:44:%02d.000001Z,%d\n", 22 + i, 100 + i );
+  }
+
+  dummy_comm_set_reply( reply );
+
+  response = xi_datastream_get_history( xi_context, 128, "temp"
+      , &after, &datastream, &truncated );
+
+  tt_assert( response != 0 );
+  sprintf( expected, "GET /v2/feeds/128/datastreams/temp.csv"
+      "?start=2013-01-01T18:44:22.000000Z&interval=0&limit=%d HTTP/1.1\r\n"
+      , XI_MAX_DATAPOINTS + 1 );
+
+  tt_assert( strncmp( dummy_comm_last_request(), expected, strlen( expected ) ) == 0 );
+  tt_want_str_op( datastream.datastream_id, ==, "temp" );
+  tt_assert( datastream.datapoint_count == XI_MAX_DATAPOINTS );
+  tt_assert( truncated == 1 );
+  tt_assert( datastream.datapoints[ 0 ].value.i32_value == 100 );
+  tt_assert( datastream.datapoints[ 0 ].timestamp.timestamp == 1357065862 );
+  tt_assert( datastream.datapoints[ XI_MAX_DATAPOINTS - 1 ].value.i32_value
+      == 99 + XI_MAX_DATAPOINTS );
+
+  // the rest is asked for from the last one on, it all fits
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 30\r\n\r\n"
+      "2013-01-01T18:45:00.000000Z,1\n" );
+
+  response = xi_datastream_get_history( xi_context, 128, "temp"
+      , &datastream.datapoints[ datastream.datapoint_count - 1 ].timestamp
+      , &datastream, &truncated );
+
+  tt_assert( response != 0 );
+  tt_assert( strstr( dummy_comm_last_request(), "?start=2013-01-01T18:44:37.000002Z&" ) != 0 );
+  tt_assert( datastream.datapoint_count == 1 );
+  tt_assert( truncated == 0 );
+
+  { // the other formats count what doesn't fit the same way
+      char json[ 512 ] = "{\"id\":\"temp\",\"current_value\":\"1\",\"datapoints\":[";
+
+      for( int i = 0; i <= XI_MAX_DATAPOINTS; ++i )
+      {
+          strcat( json, i == 0 ? "{\"value\":\"1\"}" : ",{\"value\":\"1\"}" );
+      }
+
+      strcat( json, "]}" );
+
+      tt_assert( json_decode_datastream_history( json, strlen( json ), &datastream )
+          == XI_MAX_DATAPOINTS + 1 );
+      tt_assert( datastream.datapoint_count == XI_MAX_DATAPOINTS );
+
+      // the current value isn't a part of the history
+      tt_assert( json_decode_datastream_history( "{\"current_value\":\"1\"}", 21
+          , &datastream ) == 0 );
+      tt_assert( datastream.datapoint_count == 0 );
+  }
+
+  xi_delete_context( xi_context );
+  xi_context = xi_create_context( XI_TCP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+  tt_assert( xi_datastream_get_history( xi_context, 128, "temp"
+      , &after, &datastream, &truncated ) == 0 );
+  tt_assert( XI_HISTORY_NOT_SUPPORTED == xi_get_last_error() );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_http_is_response_complete(void* data)
+{
+  (void)(data);
+
+  const char headers[] = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\n";
+  const char full[]    = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\n216";
+  const char no_body[] = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+  const char no_length[] = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n216";
+
+  tt_assert( http_is_response_complete( headers, 10 ) == 0 );
+  tt_assert( http_is_response_complete( headers, sizeof( headers ) - 1 ) == 0 );
+  tt_assert( http_is_response_complete( full, sizeof( full ) - 2 ) == 0 );
+  tt_assert( http_is_response_complete( full, sizeof( full ) - 1 ) == 1 );
+  tt_assert( http_is_response_complete( no_body, sizeof( no_body ) - 1 ) == 1 );
+
+  // the body ends when the server closes the connection
+  tt_assert( http_is_response_complete( no_length, sizeof( no_length ) - 1 ) == 0 );
+
+  { // the response that arrives byte by byte is looked at once
+    http_parser_t parser;
+    size_t i = 1;
+
+    http_parser_init( &parser, 0 );
+
+    for( ; i < sizeof( headers ) - 1; ++i )
+    {
+      tt_assert( http_response_size( &parser, full, i ) == -1 );
+      tt_assert( parser.size == i );
+    }
+
+    // the length is known once the headers are complete
+    for( ; i < sizeof( full ) - 1; ++i )
+    {
+      tt_assert( http_response_size( &parser, full, i ) == ( long ) sizeof( full ) - 1 );
+      tt_assert( parser.size == i );
+    }
+
+    // what follows it belongs to the next one
+    tt_assert( http_response_size( &parser, full, sizeof( full ) ) == ( long ) sizeof( full ) - 1 );
+  }
+
+  { // the chunks override the length
+    const char chunked[] = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n3\r\n216\r\n0\r\n\r\n";
+    http_parser_t parser;
+
+    http_parser_init( &parser, 0 );
+
+    tt_assert( http_response_size( &parser, chunked, sizeof( chunked ) - 1 ) == ( long ) sizeof( chunked ) - 1 );
+  }
+
+  { // the malformed one ends where it's got to, so that it fails to be decoded
+    const char malformed[] = "HTTP/1.1 2OO OK\r\nContent-Length: 3\r\n";
+    http_parser_t parser;
+
+    http_parser_init( &parser, 0 );
+
+    tt_assert( http_response_size( &parser, malformed, sizeof( malformed ) - 1 ) == ( long ) sizeof( malformed ) - 1 );
+  }
+
+end:
+  ;
+}
+
+typedef struct {
+  int calls;
+  int status;
+} async_result_t;
+
+static void async_callback( xi_context_t* xi, const xi_response_t* response, void* user_data )
+{
+  (void)(xi);
+
+  async_result_t* result = ( async_result_t* ) user_data;
+
+  result->calls += 1;
+  result->status = response ? response->http.http_status : -1;
+}
+
+void test_http_chunked_response(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp;
+  const xi_response_t* response = 0;
+  xi_context_t* xi_context = 0;
+
+  // the value is split across the chunks, the first one has an extension
+  // and the last one a trailer
+  static const char reply[] =
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "1b;name=value\r\n"
+      "2013-01-01T18:44:21.423452Z\r\n"
+      "5\r\n"
+      ",217\n\r\n"
+      "0\r\n"
+      "X-Checksum: 0\r\n\r\n";
+
+  { // the size is worked out from where the last call has stopped
+    http_parser_t parser;
+    http_parser_init( &parser, 0 );
+
+    tt_assert( http_response_size( &parser, reply, sizeof( reply ) - 20 ) == -1 );
+    tt_assert( parser.size == sizeof( reply ) - 20 );
+    tt_assert( http_response_size( &parser, reply, sizeof( reply ) - 3 ) == -1 );
+    tt_assert( http_response_size( &parser, reply, sizeof( reply ) - 1 ) == ( long ) sizeof( reply ) - 1 );
+    tt_assert( http_response_size( &parser, reply, sizeof( reply ) - 1 ) == ( long ) sizeof( reply ) - 1 );
+  }
+
+  { // the parser hands over the data of the chunks only, whatever the pieces
+    http_response_t http;
+    http_parser_t parser;
+    char body[ 64 ];
+    size_t i = 0;
+
+    http_parser_init( &parser, &http );
+    parser.on_body  = &test_http_parser_on_body;
+    parser.user     = body;
+    body[ 0 ]       = '\0';
+
+    for( ; i < sizeof( reply ) - 1; ++i )
+    {
+        tt_assert( http_parser_feed( &parser, reply + i, 1 ) == 1 );
+    }
+
+    tt_assert( parser.state == XI_HTTP_PARSER_DONE );
+    tt_assert( http.http_content_size == 32 );
+    tt_assert( strcmp( body, "2013-01-01T18:44:21.423452Z,217\n" ) == 0 );
+  }
+
+  xi_context = xi_create_context( XI_HTTP, "apikey", 128 );
+  tt_assert( xi_context != 0 );
+
+  dummy_comm_set_reply( reply );
+
+  response = xi_datastream_get( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_content_size == 32 );
+  tt_assert( dp.value_type == XI_VALUE_TYPE_I32 );
+  tt_assert( dp.value.i32_value == 217 );
+  tt_assert( dp.timestamp.timestamp == 1357065861 );
+
+  // the chunks override the length
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 3\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "1b\r\n"
+      "2013-01-01T18:44:21.423452Z\r\n"
+      "5\r\n"
+      ",218\n\r\n"
+      "0\r\n\r\n" );
+
+  response = xi_datastream_get( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_content_size == 32 );
+  tt_assert( dp.value.i32_value == 218 );
+
+  // the chunk that's longer than its size says
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "2\r\n"
+      "217\r\n"
+      "0\r\n\r\n" );
+
+  response = xi_datastream_get( xi_context, 128, "test", &dp );
+
+  tt_assert( response == 0 );
+
+  // the response without a body isn't chunked, whatever the header says
+  dummy_comm_set_reply(
+      "HTTP/1.1 204 No Content\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n" );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_status == 204 );
+  tt_assert( response->http.http_content_size == 0 );
+  tt_assert( !http_is_chunked( &response->http ) );
+
+end:
+  dummy_comm_set_reply( 0 );
+  if( xi_context ) { xi_delete_context( xi_context ); }
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_async_requests(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp, out;
+  async_result_t update = { 0, 0 }, get = { 0, 0 };
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+  memset( &out, 0, sizeof( out ) );
+
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 31\r\n\r\n"
+      "2013-01-01T18:44:21.423452Z,216" );
+
+  tt_assert( xi_datastream_update_async( xi_context, 128, "test", &dp
+      , async_callback, &update ) == 0 );
+  tt_assert( xi_datastream_get_async( xi_context, 128, "test", &out
+      , async_callback, &get ) == 0 );
+
+  // nothing happens until polled
+  tt_assert( update.calls == 0 );
+  tt_assert( get.calls == 0 );
+
+  // the dummy layer blocks, so a single poll runs both of them
+  tt_assert( xi_poll( 0 ) == 0 );
+
+  tt_assert( update.calls == 1 );
+  tt_assert( update.status == 200 );
+  tt_assert( get.calls == 1 );
+  tt_assert( get.status == 200 );
+  tt_assert( xi_get_value_i32( &out ) == 216 );
+  tt_assert( xi_context->connections_opened == 1 );
+  tt_assert( xi_context->connections_reused == 1 );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_pipelined_requests(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp, out;
+  async_result_t first = { 0, 0 }, second = { 0, 0 }, third = { 0, 0 };
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+  memset( &out, 0, sizeof( out ) );
+
+  // all of the responses arrive in a single read
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 0\r\n\r\n"
+      "HTTP/1.1 404 Not Found\r\n"
+      "Content-Length: 9\r\n\r\n"
+      "Not Found"
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 31\r\n\r\n"
+      "2013-01-01T18:44:21.423452Z,217" );
+
+  tt_assert( xi_pipeline_begin( xi_context ) == 0 );
+  tt_assert( xi_datastream_update_async( xi_context, 128, "test", &dp
+      , async_callback, &first ) == 0 );
+  tt_assert( xi_datastream_update_async( xi_context, 128, "missing", &dp
+      , async_callback, &second ) == 0 );
+  tt_assert( xi_datastream_get_async( xi_context, 128, "test", &out
+      , async_callback, &third ) == 0 );
+
+  // they're only queued
+  tt_assert( xi_poll( 0 ) == 0 );
+  tt_assert( first.calls == 0 );
+
+  tt_assert( xi_pipeline_flush( xi_context ) == 3 );
+
+  // each gets it's own response, in order
+  tt_assert( first.calls == 1 && first.status == 200 );
+  tt_assert( second.calls == 1 && second.status == 404 );
+  tt_assert( third.calls == 1 && third.status == 200 );
+  tt_assert( xi_get_value_i32( &out ) == 217 );
+
+  // over a single connection
+  tt_assert( xi_context->connections_opened == 1 );
+  tt_assert( xi_context->connections_reused == 2 );
+  tt_assert( xi_context->conn != 0 );
+
+  // the requests the server doesn't answer fail
+  tt_assert( xi_pipeline_begin( xi_context ) == 0 );
+  tt_assert( xi_datastream_update_async( xi_context, 128, "test", &dp
+      , async_callback, &first ) == 0 );
+  tt_assert( xi_datastream_update_async( xi_context, 128, "test", &dp
+      , async_callback, &second ) == 0 );
+
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 0\r\n\r\n" );
+
+  tt_assert( xi_pipeline_flush( xi_context ) == 1 );
+  tt_assert( first.calls == 2 && first.status == 200 );
+  tt_assert( second.calls == 2 && second.status == -1 );
+  tt_assert( xi_context->conn == 0 );
+
+  // nothing is left queued
+  tt_assert( xi_pipeline_flush( xi_context ) == 0 );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_tcp_transport(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp, out;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_TCP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+  memset( &out, 0, sizeof( out ) );
+
+  dummy_comm_set_reply(
+      "{\"status\":200,\"resource\":\"/feeds/128/datastreams/test.csv\"}\n" );
+
+  // the body is carried as a JSON string
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_status == 200 );
+  tt_want_str_op( dummy_comm_last_request(), ==,
+      "{\"method\":\"put\",\"resource\":\"/feeds/128/datastreams/test.csv\""
+      ",\"headers\":{\"X-ApiKey\":\"apikey\"},\"body\":\"216\\n\"}\n" );
+
+  // the connection is opened on the socket API port and kept open
+  tt_assert( xi_context->conn != 0 );
+  tt_assert( xi_context->conn->port == XI_TCP_PORT );
+
+  dummy_comm_set_reply(
+      "{\"status\":200,\"resource\":\"/feeds/128/datastreams/test.csv\""
+      ",\"body\":\"2013-01-01T18:44:21.423452Z,217\\n\"}\n" );
+
+  response = xi_datastream_get( xi_context, 128, "test", &out );
+
+  tt_assert( response != 0 );
+  tt_want_str_op( dummy_comm_last_request(), ==,
+      "{\"method\":\"get\",\"resource\":\"/feeds/128/datastreams/test.csv\""
+      ",\"headers\":{\"X-ApiKey\":\"apikey\"}}\n" );
+  tt_assert( xi_get_value_i32( &out ) == 217 );
+  tt_assert( xi_context->connections_opened == 1 );
+  tt_assert( xi_context->connections_reused == 1 );
+
+  // errors come back with a status as well
+  dummy_comm_set_reply( "{\"status\": 404, \"body\": \"Not \\\"found\\\"\"}\n" );
+
+  response = xi_datastream_delete( xi_context, 128, "test" );
+
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_status == 404 );
+  tt_want_str_op( response->http.http_content, ==, "Not \"found\"" );
+
+  // it's a parse error if there's no status
+  dummy_comm_set_reply( "{\"body\":\"\"}\n" );
+
+  response = xi_datastream_delete( xi_context, 128, "test" );
+
+  tt_assert( response == 0 );
+  tt_assert( xi_get_last_error() == XI_TCP_PARSE_ERROR );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+typedef struct {
+  int           calls;
+  xi_feed_id_t  feed_id;
+  char          datastream_id[ XI_MAX_DATASTREAM_NAME ];
+  int32_t       value;
+} test_update_t;
+
+static void test_on_update( xi_context_t* xi, xi_feed_id_t feed_id
+    , const char* datastream_id, const xi_datapoint_t* datapoint, void* user_data )
+{
+  (void)(xi);
+
+  test_update_t* update = ( test_update_t* ) user_data;
+
+  update->calls  += 1;
+  update->feed_id = feed_id;
+  update->value   = datapoint->value.i32_value;
+  strcpy( update->datastream_id, datastream_id );
+}
+
+// appends an unmasked text frame, as the server sends them
+static char* test_ws_frame( char* out, const char* payload )
+{
+  size_t size = strlen( payload );
+
+  // short ones only, so the frame has no zeros in it
+  assert( size > 0 && size < 126 );
+
+  out += strlen( out );
+  *out++ = ( char ) 0x81;
+  *out++ = ( char ) size;
+  strcpy( out, payload );
+
+  return out + size;
+}
+
+// unmasks the payload of the frame sent by the client, `first` is its first
+// byte, the final bit and the opcode
+static int test_ws_unmask( unsigned char first, char* out, size_t out_size )
+{
+  const unsigned char* frame = ( const unsigned char* ) dummy_comm_last_request();
+  size_t size                = dummy_comm_last_request_size();
+
+  if( size < 2 || frame[ 0 ] != first || ( frame[ 1 ] & 0x80 ) == 0 ) { return -1; }
+
+  size_t header       = 2;
+  size_t payload_size = frame[ 1 ] & 0x7f;
+
+  if( payload_size == 126 )
+  {
+    payload_size = ( frame[ 2 ] << 8 ) | frame[ 3 ];
+    header       = 4;
+  }
+
+  if( header + 4 + payload_size != size || payload_size >= out_size ) { return -1; }
+
+  for( size_t i = 0; i < payload_size; ++i )
+  {
+    out[ i ] = ( char ) ( frame[ header + 4 + i ] ^ frame[ header + i % 4 ] );
+  }
+
+  out[ payload_size ] = '\0';
+
+  return 0;
+}
+
+// answers the handshake with the key it has sent, which is a random one
+static const char* test_ws_accept( const char* request, size_t size )
+{
+  static char reply[ 256 ];
+  static const char header[] = "Sec-WebSocket-Key: ";
+
+  const char* key = strstr( request, header );
+
+  if( strncmp( request, "GET ", 4 ) != 0 || key == 0 ) { return 0; }
+
+  key += sizeof( header ) - 1;
+
+  char accept[ XI_WS_ACCEPT_SIZE ];
+  ws_accept_key( key, strcspn( key, "\r" ), accept );
+
+  snprintf( reply, sizeof( reply ),
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: %s\r\n\r\n", accept );
+
+  (void)(size);
+
+  return reply;
+}
+
+void test_ws_transport(void* data)
+{
+  (void)(data);
+
+  // the example of RFC 6455, it can't match the key which is sent
+  static const char handshake[] =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n";
+  // the ping and the close frames, neither is masked by the server
+  static const char ping[]  = "\x89\x02hi";
+  static const char close[] = "\x88\x02\x03\xe8";
+  static const char subscribed[] =
+      "{\"status\":200,\"resource\":\"/feeds/128/datastreams/temp.csv\"}\n";
+  static const char update[] =
+      "{\"resource\":\"/feeds/128/datastreams/temp.csv\""
+      ",\"body\":\"2013-01-01T18:44:21.423452Z,42\\n\"}\n";
+  static const char got[] =
+      "{\"status\":200,\"body\":\"2013-01-01T18:44:21.423452Z,43\\n\"}\n";
+
+  char frames[ 3 ][ 256 ];
+  char payload[ 256 ];
+  char accept[ XI_WS_ACCEPT_SIZE ];
+  const char* replies[ 6 ];
+  xi_datapoint_t out;
+  test_update_t updates;
+  const xi_response_t* response = 0;
+
+  memset( frames, 0, sizeof( frames ) );
+  memset( &updates, 0, sizeof( updates ) );
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  ws_accept_key( "dGhlIHNhbXBsZSBub25jZQ==", 24, accept );
+  tt_want_str_op( accept, ==, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=" );
+
+  // there are no subscriptions over HTTP
+  tt_assert( xi_datastream_subscribe( xi_context, 128, "temp"
+      , &test_on_update, &updates ) == 0 );
+  tt_assert( xi_get_last_error() == XI_SUBSCRIPTIONS_NOT_SUPPORTED );
+
+  xi_delete_context( xi_context );
+  xi_context = xi_create_context( XI_WS, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  // the reply to the subscription is followed by the first update, the
+  // next one arrives ahead of the reply to a get, which is followed by
+  // a ping, the server closes the connection after the pong
+  test_ws_frame( frames[ 0 ], subscribed );
+  test_ws_frame( test_ws_frame( frames[ 1 ], subscribed ), update );
+  test_ws_frame( test_ws_frame( frames[ 2 ], update ), got );
+  strcat( frames[ 2 ], ping );
+
+  replies[ 0 ] = handshake;
+  replies[ 1 ] = frames[ 0 ];
+  replies[ 2 ] = frames[ 1 ];
+  replies[ 3 ] = frames[ 2 ];
+  replies[ 4 ] = close;
+  replies[ 5 ] = 0;
+
+  dummy_comm_set_replies( replies );
+  dummy_comm_set_responder( &test_ws_accept );
+
+  response = xi_datastream_subscribe( xi_context, 128, "temp"
+      , &test_on_update, &updates );
+
+  // the connection has been upgraded first
+  tt_assert( response != 0 );
+  tt_assert( response->http.http_status == 200 );
+  tt_assert( xi_context->conn != 0 );
+  tt_assert( xi_context->conn->port == XI_WS_PORT );
+  tt_assert( test_ws_unmask( 0x81, payload, sizeof( payload ) ) == 0 );
+  tt_want_str_op( payload, ==,
+      "{\"method\":\"subscribe\",\"resource\":\"/feeds/128/datastreams/temp.csv\""
+      ",\"headers\":{\"X-ApiKey\":\"apikey\"}}\n" );
+  tt_assert( updates.calls == 0 );
+
+  // subscribing again just replaces the callback, the update follows the reply
+  response = xi_datastream_subscribe( xi_context, 128, "temp"
+      , &test_on_update, &updates );
+
+  tt_assert( response != 0 );
+  tt_assert( updates.calls == 0 );
+
+  tt_assert( xi_process_updates( xi_context ) == 1 );
+  tt_assert( updates.calls == 1 );
+  tt_assert( updates.feed_id == 128 );
+  tt_want_str_op( updates.datastream_id, ==, "temp" );
+  tt_assert( updates.value == 42 );
+
+  // the update which comes ahead of the reply is passed on first
+  memset( &out, 0, sizeof( out ) );
+
+  response = xi_datastream_get( xi_context, 128, "temp", &out );
+
+  tt_assert( response != 0 );
+  tt_assert( updates.calls == 2 );
+  tt_assert( xi_get_value_i32( &out ) == 43 );
+  tt_assert( xi_context->connections_opened == 1 );
+
+  // the ping is answered with the same payload, the close frame drops
+  // the connection
+  tt_assert( xi_process_updates( xi_context ) == -1 );
+  tt_assert( xi_get_last_error() == XI_SOCKET_READ_ERROR );
+  tt_assert( xi_context->conn == 0 );
+  tt_assert( test_ws_unmask( 0x8a, payload, sizeof( payload ) ) == 0 );
+  tt_want_str_op( payload, ==, "hi" );
+  tt_assert( updates.calls == 2 );
+
+  // so is a fresh connection which isn't answered or can't be upgraded
+  dummy_comm_set_responder( 0 );
+  dummy_comm_set_reply( 0 );
+
+  tt_assert( xi_process_updates( xi_context ) == -1 );
+  tt_assert( xi_context->conn == 0 );
+
+  dummy_comm_set_reply( "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n" );
+
+  tt_assert( xi_process_updates( xi_context ) == -1 );
+  tt_assert( xi_get_last_error() == XI_WS_HANDSHAKE_ERROR );
+
+  // as is the one which doesn't answer the key that's been sent
+  dummy_comm_set_reply( handshake );
+
+  tt_assert( xi_process_updates( xi_context ) == -1 );
+  tt_assert( xi_get_last_error() == XI_WS_HANDSHAKE_ERROR );
+
+  // there's nothing to wait for without subscriptions
+  response = xi_datastream_unsubscribe( xi_context, 128, "temp" );
+
+  tt_assert( response == 0 );
+  tt_assert( xi_process_updates( xi_context ) == 0 );
+
+end:
+  dummy_comm_set_responder( 0 );
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_pushed_update(void* data)
+{
+  (void)(data);
+
+  static const char update[] =
+      "{\"resource\":\"/feeds/128/datastreams/temp.csv\""
+      ",\"body\":\"2013-01-01T18:44:21.423452Z,42\\n\"}\n";
+  static const char* const replies[] = {
+      "{\"status\":200,\"resource\":\"/feeds/128/datastreams/temp.csv\"}\n"
+    , "{\"status\":200,\"body\":\"2013-01-01T18:44:21.423452Z,43\\n\"}\n"
+    , 0 };
+
+  xi_datapoint_t out;
+  test_update_t updates;
+  const xi_response_t* response = 0;
+
+  memset( &out, 0, sizeof( out ) );
+  memset( &updates, 0, sizeof( updates ) );
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_TCP, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  dummy_comm_set_replies( replies );
+
+  response = xi_datastream_subscribe( xi_context, 128, "temp"
+      , &test_on_update, &updates );
+
+  tt_assert( response != 0 );
+  tt_assert( updates.calls == 0 );
+
+  // the update arrives in between the requests, it's passed on before the
+  // next request is sent over the same connection
+  dummy_comm_push( update );
+
+  response = xi_datastream_get( xi_context, 128, "temp", &out );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_get_value_i32( &out ) == 43 );
+  tt_assert( updates.calls == 1 );
+  tt_assert( updates.value == 42 );
+  tt_want_str_op( updates.datastream_id, ==, "temp" );
+  tt_assert( xi_context->conn != 0 );
+  tt_assert( xi_context->connections_opened == 1 );
+  tt_assert( xi_context->connections_reused == 1 );
+
+  // without subscriptions whatever has arrived is stale, the connection
+  // is replaced
+  dummy_comm_set_reply( replies[ 0 ] );
+
+  response = xi_datastream_unsubscribe( xi_context, 128, "temp" );
+
+  tt_assert( response != 0 );
+
+  dummy_comm_set_reply( replies[ 1 ] );
+  dummy_comm_push( update );
+
+  response = xi_datastream_get( xi_context, 128, "temp", &out );
+
+  tt_assert( response != 0 );
+  tt_assert( updates.calls == 1 );
+  tt_assert( xi_context->connections_opened == 2 );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+void test_secure_protocols(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp;
+  const xi_response_t* response = 0;
+
+  xi_context_t* xi_context
+      = xi_create_context( XI_HTTPS, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  xi_set_value_i32( &dp, 1 );
+  dp.timestamp.timestamp = 0;
+
+  dummy_comm_set_reply( "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n" );
+
+  // the same requests, just over the secure port
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_context->conn != 0 );
+  tt_assert( xi_context->conn->port == XI_HTTPS_PORT );
+  tt_assert( strncmp( dummy_comm_last_request(), "PUT /v2/feeds/128/datastreams/test.csv", 38 ) == 0 );
+
+  xi_delete_context( xi_context );
+  xi_context = xi_create_context( XI_TCPS, "apikey", 128 );
+
+  tt_assert( xi_context != 0 );
+
+  dummy_comm_set_reply( "{\"status\":200}\n" );
+
+  response = xi_datastream_update( xi_context, 128, "test", &dp );
+
+  tt_assert( response != 0 );
+  tt_assert( xi_context->conn->port == XI_TCPS_PORT );
+  tt_assert( xi_context->sessions_resumed == 0 );
+
+end:
+  dummy_comm_set_reply( 0 );
+  xi_delete_context( xi_context );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+#ifdef XI_DISPATCHER_PTHREAD
+#include <unistd.h>
+
+typedef struct {
+  int               calls;
+  int               ok;
+  xi_dispatcher_t*  dispatcher;
+} dispatch_result_t;
+
+static void dispatch_callback( xi_context_t* xi, const xi_response_t* response, void* user_data )
+{
+  (void)(xi);
+
+  dispatch_result_t* result = ( dispatch_result_t* ) user_data;
+
+  // the first one holds up its worker until another one has stolen from it
+  if( __atomic_add_fetch( &result->calls, 1, __ATOMIC_ACQ_REL ) == 1 )
+  {
+    for( int i = 0; i < 2000 && xi_dispatcher_stolen( result->dispatcher ) == 0; ++i )
+    {
+      usleep( 1000 );
+    }
+  }
+
+  if( response && response->http.http_status == 200 )
+  {
+    __atomic_add_fetch( &result->ok, 1, __ATOMIC_ACQ_REL );
+  }
+}
+
+void test_dispatcher(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp;
+  xi_feed_t feed;
+  dispatch_result_t result = { 0, 0, 0 };
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+
+  memset( &feed, 0, sizeof( feed ) );
+  feed.feed_id                                = 128;
+  feed.datastream_count                       = 1;
+  feed.datastreams[ 0 ].datapoint_count       = 1;
+  feed.datastreams[ 0 ].datapoints[ 0 ]       = dp;
+  strcpy( feed.datastreams[ 0 ].datastream_id, "test" );
+
+  dummy_comm_set_reply(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 31\r\n\r\n"
+      "2013-01-01T18:44:21.423452Z,216" );
+
+  xi_dispatcher_t* dispatcher = xi_create_dispatcher( XI_HTTP, "apikey", 4 );
+
+  tt_assert( dispatcher != 0 );
+
+  result.dispatcher = dispatcher;
+
+  // all of them go to the worker of feed 128, the others have to steal
+  // the feeds it isn't running
+  for( int i = 0; i < 16; ++i )
+  {
+    tt_assert( xi_dispatch_datastream_update( dispatcher, 128 + 4 * ( i % 4 )
+        , "test", &dp, dispatch_callback, &result ) == 0 );
+  }
+
+  tt_assert( xi_dispatch_feed_update( dispatcher, &feed
+      , dispatch_callback, &result ) == 0 );
+
+  xi_dispatcher_wait( dispatcher );
+
+  tt_assert( result.calls == 17 );
+  tt_assert( result.ok == 17 );
+  tt_assert( xi_dispatcher_stolen( dispatcher ) > 0 );
+
+  // the arguments have to fit in the request
+  tt_assert( xi_dispatch_datastream_update( dispatcher, 128
+      , "a datastream id that is too long", &dp, dispatch_callback, &result ) == -1 );
+
+end:
+  if( dispatcher ) { xi_delete_dispatcher( dispatcher ); }
+  dummy_comm_set_reply( 0 );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+
+typedef struct {
+  int done[ 8 ];
+  int count;
+} dispatch_order_t;
+
+typedef struct {
+  dispatch_order_t* order;
+  int               index;
+} dispatch_step_t;
+
+static void dispatch_order_callback( xi_context_t* xi, const xi_response_t* response, void* user_data )
+{
+  (void)(xi);
+  (void)(response);
+
+  dispatch_step_t* step = ( dispatch_step_t* ) user_data;
+
+  // the first one holds up its worker, a thief would overtake it
+  if( step->index == 0 ) { usleep( 50000 ); }
+
+  step->order->done[ __atomic_fetch_add( &step->order->count, 1, __ATOMIC_ACQ_REL ) ]
+      = step->index;
+}
+
+void test_dispatcher_feed_order(void* data)
+{
+  (void)(data);
+
+  xi_datapoint_t dp;
+  dispatch_order_t order;
+  dispatch_step_t steps[ 8 ];
+
+  memset( &order, 0, sizeof( order ) );
+
+  xi_set_value_i32( &dp, 216 );
+  dp.timestamp.timestamp = 0;
+
+  dummy_comm_set_reply( "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n" );
+
+  xi_dispatcher_t* dispatcher = xi_create_dispatcher( XI_HTTP, "apikey", 2 );
+
+  tt_assert( dispatcher != 0 );
+
+  // the other worker is idle all along, yet the updates of the feed
+  // finish in the order they've been made
+  for( int i = 0; i < 8; ++i )
+  {
+    steps[ i ].order = &order;
+    steps[ i ].index = i;
+
+    tt_assert( xi_dispatch_datastream_update( dispatcher, 128, "test", &dp
+        , dispatch_order_callback, &steps[ i ] ) == 0 );
+  }
+
+  xi_dispatcher_wait( dispatcher );
+
+  tt_assert( order.count == 8 );
+
+  for( int i = 0; i < 8; ++i ) { tt_assert( order.done[ i ] == i ); }
+
+end:
+  if( dispatcher ) { xi_delete_dispatcher( dispatcher ); }
+  dummy_comm_set_reply( 0 );
+  xi_set_err( XI_NO_ERR );
+  ;
+}
+#endif
+
+void test_datapoint_value_setters_and_getters(void* data)
+{
+  (void)(data);
+
+  void * ret;
+
+  xi_datapoint_t dp;
+
+  ret = xi_set_value_i32( &dp, 320 );
+
+  tt_assert( ret != 0 );
+
+  tt_assert( xi_get_value_i32( &dp ) == 320 );
+
+  tt_assert( xi_get_value_type( &dp ) == XI_VALUE_TYPE_I32 );
+
+  tt_assert( xi_value_pointer_i32( &dp ) != 0 &&
+             xi_value_pointer_f32( &dp ) == 0 &&
+             xi_value_pointer_str( &dp ) == 0 );
+
+  ret = xi_set_value_f32( &dp, (320.0/10) );
+
+  tt_assert( ret != 0 );
+
+  tt_assert( xi_get_value_f32( &dp ) == (320.0/10) );
+
+  tt_assert( xi_get_value_type( &dp ) == XI_VALUE_TYPE_F32 );
+
+  tt_assert( xi_value_pointer_i32( &dp ) == 0 &&
+             xi_value_pointer_f32( &dp ) != 0 &&
+             xi_value_pointer_str( &dp ) == 0 );
+
+  ret = xi_set_value_str( &dp, "Let's test everything!" );
+
+  tt_assert( ret != 0 );
+
+  char s[XI_VALUE_STRING_MAX_SIZE+100];
+  for (size_t i = 0; i < sizeof(s); i++) {
+    s[i] = 'a';
+  }
+
+  ret = xi_set_value_str( &dp, s );
+
+  tt_assert( ret != 0 )
+
+  tt_assert( xi_get_value_type( &dp ) == XI_VALUE_TYPE_STR );
+
+  tt_assert( xi_value_pointer_i32( &dp ) == 0 &&
+             xi_value_pointer_f32( &dp ) == 0 &&
+             xi_value_pointer_str( &dp ) != 0 );
+
+  char * x = xi_value_pointer_str( &dp );
+
+  tt_assert( strlen(s) > strlen(x) );
+  tt_assert( strlen(x) == XI_VALUE_STRING_MAX_SIZE-1 );
+
+  s[XI_VALUE_STRING_MAX_SIZE-5] = '\0';
+
+  ret = xi_set_value_str( &dp, s );
+
+  tt_assert( ret != 0 );
+
+  tt_assert( strlen(s) == strlen(x) );
   tt_assert( strlen(x) == XI_VALUE_STRING_MAX_SIZE-5 );
 
 end:
@@ -675,21 +2716,49 @@ struct testcase_t core_tests[] = {
     { "test_parse_http_status", test_parse_http_status, TT_ENABLED_, 0, 0 },
     { "test_parse_http_header", test_parse_http_header, TT_ENABLED_, 0, 0 },
     { "test_parse_http", test_parse_http, TT_ENABLED_, 0, 0 },
+    { "test_http_parser", test_http_parser, TT_ENABLED_, 0, 0 },
 
     { "test_http_construct_request", test_http_construct_request, TT_ENABLED_, 0, 0 },
     { "test_http_construct_content", test_http_construct_content, TT_ENABLED_, 0, 0 },
+    { "test_http_encode_request_segments", test_http_encode_request_segments, TT_ENABLED_, 0, 0 },
 
     { "test_csv_decode_datapoint", test_csv_decode_datapoint, TT_ENABLED_, 0, 0 },
     { "test_csv_decode_datapoint_error", test_csv_decode_datapoint_error, TT_ENABLED_, 0, 0 },
+    { "test_csv_decode_feed", test_csv_decode_feed, TT_ENABLED_, 0, 0 },
     { "test_csv_encode_create_datastream", test_csv_encode_create_datastream, TT_ENABLED_, 0, 0 },
     { "test_csv_encode_create_datastream_error", test_csv_encode_create_datastream_error, TT_ENABLED_, 0, 0 },
     { "test_csv_encode_datapoint", test_csv_encode_datapoint, TT_ENABLED_, 0, 0 },
+    { "test_json_decode_feed", test_json_decode_feed, TT_ENABLED_, 0, 0 },
+    { "test_json_encode_feed", test_json_encode_feed, TT_ENABLED_, 0, 0 },
+    { "test_cbor_encode_decode", test_cbor_encode_decode, TT_ENABLED_, 0, 0 },
 
     { "test_helpers_copy_until", test_helpers_copy_until, TT_ENABLED_, 0, 0 },
     { "test_helpers_decode_value", test_helpers_decode_value, TT_ENABLED_, 0, 0 },
+    { "test_helpers_format_value", test_helpers_format_value, TT_ENABLED_, 0, 0 },
+    { "test_helpers_iso8601", test_helpers_iso8601, TT_ENABLED_, 0, 0 },
+    { "test_helpers_time", test_helpers_time, TT_ENABLED_, 0, 0 },
+    { "test_helpers_scan", test_helpers_scan, TT_ENABLED_, 0, 0 },
 
     { "test_create_and_delete_context", test_create_and_delete_context, TT_ENABLED_, 0, 0 },
     { "test_datapoint_value_setters_and_getters", test_datapoint_value_setters_and_getters, TT_ENABLED_, 0, 0 },
+    { "test_keep_alive_connection_reuse", test_keep_alive_connection_reuse, TT_ENABLED_, 0, 0 },
+    { "test_read_whole_response", test_read_whole_response, TT_ENABLED_, 0, 0 },
+    { "test_request_stats", test_request_stats, TT_ENABLED_, 0, 0 },
+    { "test_json_format", test_json_format, TT_ENABLED_, 0, 0 },
+    { "test_cbor_format", test_cbor_format, TT_ENABLED_, 0, 0 },
+    { "test_datastream_history", test_datastream_history, TT_ENABLED_, 0, 0 },
+    { "test_http_is_response_complete", test_http_is_response_complete, TT_ENABLED_, 0, 0 },
+    { "test_http_chunked_response", test_http_chunked_response, TT_ENABLED_, 0, 0 },
+    { "test_async_requests", test_async_requests, TT_ENABLED_, 0, 0 },
+    { "test_pipelined_requests", test_pipelined_requests, TT_ENABLED_, 0, 0 },
+    { "test_tcp_transport", test_tcp_transport, TT_ENABLED_, 0, 0 },
+    { "test_ws_transport", test_ws_transport, TT_ENABLED_, 0, 0 },
+    { "test_pushed_update", test_pushed_update, TT_ENABLED_, 0, 0 },
+    { "test_secure_protocols", test_secure_protocols, TT_ENABLED_, 0, 0 },
+#ifdef XI_DISPATCHER_PTHREAD
+    { "test_dispatcher", test_dispatcher, TT_ENABLED_, 0, 0 },
+    { "test_dispatcher_feed_order", test_dispatcher_feed_order, TT_ENABLED_, 0, 0 },
+#endif
     /* The array has to end with END_OF_TESTCASES. */
     END_OF_TESTCASES
 };
@@ -0,0 +1,156 @@
+// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.
+// This is part of Xively C library, it is under the BSD 3-Clause license.
+
+/**
+ * \file    http_header_hash.c
+ * \brief   Generates the perfect hash of the HTTP headers the parser knows
+ *
+ *    The headers are told apart by their length and their first and last
+ *    characters, case folded, which the hash combines with the multipliers
+ *    found here, so each of them gets a slot of its own. The parser computes
+ *    it, looks the slot up and compares the name once [see http_layer_parser.c].
+ *
+ *    To add a header, add it to `http_header_type_t` [see xively.h] and to
+ *    the table below, then run `make -C src http_headers`.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xively.h"
+
+static const struct
+{
+    http_header_type_t  type;
+    const char*         name;
+} XI_HTTP_HEADERS[] =
+{
+      { XI_HTTP_HEADER_DATE,                "date" }
+    , { XI_HTTP_HEADER_CONTENT_TYPE,        "content-type" }
+    , { XI_HTTP_HEADER_CONTENT_LENGTH,      "content-length" }
+    , { XI_HTTP_HEADER_CONNECTION,          "connection" }
+    , { XI_HTTP_HEADER_X_REQUEST_ID,        "x-request-id" }
+    , { XI_HTTP_HEADER_CACHE_CONTROL,       "cache-control" }
+    , { XI_HTTP_HEADER_VARY,                "vary" }
+    , { XI_HTTP_HEADER_COUNT,               "count" }
+    , { XI_HTTP_HEADER_AGE,                 "age" }
+    , { XI_HTTP_HEADER_TRANSFER_ENCODING,   "transfer-encoding" }
+    , { XI_HTTP_HEADER_CONTENT_ENCODING,    "content-encoding" }
+    , { XI_HTTP_HEADER_ETAG,                "etag" }
+};
+
+#define XI_HTTP_HEADERS_SIZE    ( sizeof( XI_HTTP_HEADERS ) / sizeof( XI_HTTP_HEADERS[ 0 ] ) )
+#define XI_HTTP_HASH_MAX_SIZE   256
+
+static unsigned http_header_hash(
+      const char* name
+    , unsigned length_factor
+    , unsigned first_factor
+    , unsigned size )
+{
+    const size_t length = strlen( name );
+
+    return ( ( unsigned ) length * length_factor
+        + ( unsigned char ) name[ 0 ] * first_factor
+        + ( unsigned char ) name[ length - 1 ] ) % size;
+}
+
+int main( void )
+{
+    const char* names[ XI_HTTP_HEADER_UNKNOWN ] = { 0 };
+
+    // each of the known headers has to be here, once
+    for( size_t i = 0; i < XI_HTTP_HEADERS_SIZE; ++i )
+    {
+        const http_header_type_t type = XI_HTTP_HEADERS[ i ].type;
+
+        if( type >= XI_HTTP_HEADER_UNKNOWN || names[ type ] != 0 )
+        {
+            fprintf( stderr, "%s: listed twice or unknown\n", XI_HTTP_HEADERS[ i ].name );
+            return 1;
+        }
+
+        names[ type ] = XI_HTTP_HEADERS[ i ].name;
+    }
+
+    for( int type = 0; type < XI_HTTP_HEADER_UNKNOWN; ++type )
+    {
+        if( names[ type ] == 0 )
+        {
+            fprintf( stderr, "header %d: missing from the table\n", type );
+            return 1;
+        }
+    }
+
+    // the smallest table first, then the smallest multipliers
+    for( unsigned size = XI_HTTP_HEADER_UNKNOWN; size <= XI_HTTP_HASH_MAX_SIZE; ++size )
+    {
+        for( unsigned length_factor = 1; length_factor < size; ++length_factor )
+        {
+            for( unsigned first_factor = 1; first_factor < size; ++first_factor )
+            {
+                int slots[ XI_HTTP_HASH_MAX_SIZE ];
+                int type = 0;
+
+                for( unsigned i = 0; i < size; ++i ) { slots[ i ] = XI_HTTP_HEADER_UNKNOWN; }
+
+                for( ; type < XI_HTTP_HEADER_UNKNOWN; ++type )
+                {
+                    unsigned slot = http_header_hash(
+                        names[ type ], length_factor, first_factor, size );
+
+                    if( slots[ slot ] != XI_HTTP_HEADER_UNKNOWN ) { break; }
+
+                    slots[ slot ] = type;
+                }
+
+                if( type < XI_HTTP_HEADER_UNKNOWN ) { continue; }
+
+                printf( "// Copyright (c) 2003-2013, LogMeIn, Inc. All rights reserved.\n" );
+                printf( "// This is part of Xively C library, it is under the BSD 3-Clause license.\n\n" );
+                printf( "/**\n" );
+                printf( " * \\file    http_header_hash.h\n" );
+                printf( " * \\brief   The perfect hash of the known HTTP headers, generated by\n" );
+                printf( " *          `make -C src http_headers` [see src/tools/http_header_hash.c]\n" );
+                printf( " */\n\n" );
+                printf( "#ifndef __HTTP_HEADER_HASH_H__\n" );
+                printf( "#define __HTTP_HEADER_HASH_H__\n\n" );
+                printf( "#define XI_HTTP_HEADER_HASH_SIZE       %u\n", size );
+                printf( "#define XI_HTTP_HEADER_HASH_LENGTH     %u\n", length_factor );
+                printf( "#define XI_HTTP_HEADER_HASH_FIRST      %u\n\n", first_factor );
+                printf( "//! the header in each slot of the hash\n" );
+                printf( "static const unsigned char XI_HTTP_HEADER_HASH_SLOTS[ XI_HTTP_HEADER_HASH_SIZE ] =\n{\n" );
+
+                for( unsigned i = 0; i < size; ++i )
+                {
+                    if( slots[ i ] == XI_HTTP_HEADER_UNKNOWN )
+                    {
+                        printf( "    %c %2d\n", i ? ',' : ' ', slots[ i ] );
+                    }
+                    else
+                    {
+                        printf( "    %c %2d  // %s\n", i ? ',' : ' ', slots[ i ], names[ slots[ i ] ] );
+                    }
+                }
+
+                printf( "};\n\n" );
+                printf( "//! the names of the headers, case folded\n" );
+                printf( "static const char* const XI_HTTP_HEADER_NAMES[ XI_HTTP_HEADER_UNKNOWN ] =\n{\n" );
+
+                for( type = 0; type < XI_HTTP_HEADER_UNKNOWN; ++type )
+                {
+                    printf( "    %c \"%s\"\n", type ? ',' : ' ', names[ type ] );
+                }
+
+                printf( "};\n\n" );
+                printf( "#endif // __HTTP_HEADER_HASH_H__\n" );
+
+                return 0;
+            }
+        }
+    }
+
+    fprintf( stderr, "no perfect hash up to %d slots\n", XI_HTTP_HASH_MAX_SIZE );
+    return 1;
+}